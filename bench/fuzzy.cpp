@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/fuzzy.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+/*
+ * Microbenchmark for the fuzzy matcher. Generates given number of random
+ * URLs (one million by default) and measures how long it takes to find the
+ * best matches for a set of patterns with each available byte scanning
+ * implementation.
+ */
+
+using selain::fuzzy::Implementation;
+
+static const std::size_t DEFAULT_CANDIDATE_COUNT = 1000000;
+static const std::size_t RESULT_LIMIT = 50;
+static const int ITERATION_COUNT = 15;
+
+static const char* words[] =
+{
+  "account", "api", "archive", "article", "blog", "browser", "build",
+  "cache", "changelog", "commit", "config", "docs", "download", "editor",
+  "feature", "forum", "github", "guide", "help", "index", "issues", "kernel",
+  "login", "mail", "manual", "news", "package", "performance", "profile",
+  "project", "pull", "release", "search", "settings", "source", "status",
+  "support", "tutorial", "user", "video", "webkit", "wiki",
+};
+
+static const char* top_level_domains[] =
+{
+  "com", "org", "net", "io", "fi", "de", "dev",
+};
+
+static const char* patterns[] =
+{
+  "g",
+  "git",
+  "wiki",
+  "ghwebkit",
+  "docs/perf",
+  "newsrelease",
+  "zzqx",
+};
+
+template<class T, std::size_t N>
+static const T&
+pick(const T (&array)[N], std::mt19937& generator)
+{
+  return array[std::uniform_int_distribution<std::size_t>(0, N - 1)(
+    generator
+  )];
+}
+
+static std::string
+generate_url(std::mt19937& generator)
+{
+  std::string url(generator() % 4 ? "https://" : "http://");
+  const auto segment_count = 1 + generator() % 4;
+
+  if (generator() % 3 == 0)
+  {
+    url += pick(words, generator);
+    url += '.';
+  }
+  url += pick(words, generator);
+  url += pick(words, generator);
+  url += '.';
+  url += pick(top_level_domains, generator);
+  for (unsigned int i = 0; i < segment_count; ++i)
+  {
+    url += '/';
+    url += pick(words, generator);
+    if (generator() % 2)
+    {
+      url += '-';
+      url += std::to_string(generator() % 10000);
+    }
+  }
+  if (generator() % 4 == 0)
+  {
+    url += "?id=";
+    url += std::to_string(generator());
+  }
+
+  return url;
+}
+
+static const char*
+get_implementation_name(Implementation implementation)
+{
+  switch (implementation)
+  {
+    case Implementation::SCALAR:
+      return "scalar";
+
+    case Implementation::SSE2:
+      return "sse2";
+
+    case Implementation::AVX2:
+      return "avx2";
+  }
+
+  return "unknown";
+}
+
+int
+main(int argc, char** argv)
+{
+  const auto candidate_count = argc > 1
+    ? static_cast<std::size_t>(std::strtoul(argv[1], nullptr, 10))
+    : DEFAULT_CANDIDATE_COUNT;
+  std::mt19937 generator(42);
+  selain::fuzzy::Arena arena;
+  std::vector<selain::fuzzy::Match> results;
+  std::size_t total_bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  arena.reserve(candidate_count, candidate_count * 64);
+  for (std::size_t i = 0; i < candidate_count; ++i)
+  {
+    const auto url = generate_url(generator);
+
+    total_bytes += url.length();
+    arena.add(url);
+  }
+  std::printf(
+    "Generated %zu candidates (%.1f MB) in %.1f ms\n\n",
+    candidate_count,
+    static_cast<double>(total_bytes) / (1024.0 * 1024.0),
+    std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start
+    ).count()
+  );
+  results.reserve(RESULT_LIMIT);
+
+  for (const auto implementation : {
+    Implementation::SCALAR,
+    Implementation::SSE2,
+    Implementation::AVX2
+  })
+  {
+    if (!selain::fuzzy::set_implementation(implementation))
+    {
+      std::printf("%s: not supported\n\n", get_implementation_name(
+        implementation
+      ));
+      continue;
+    }
+    std::printf("%s:\n", get_implementation_name(implementation));
+    for (const auto pattern_text : patterns)
+    {
+      const selain::fuzzy::Pattern pattern(pattern_text);
+      std::vector<double> timings;
+
+      for (int i = 0; i < ITERATION_COUNT; ++i)
+      {
+        start = std::chrono::steady_clock::now();
+        selain::fuzzy::match(pattern, arena, RESULT_LIMIT, results);
+        timings.push_back(std::chrono::duration<double, std::milli>(
+          std::chrono::steady_clock::now() - start
+        ).count());
+      }
+      std::sort(std::begin(timings), std::end(timings));
+      std::printf(
+        "  %-12s median %7.2f ms  min %7.2f ms  best: %s\n",
+        pattern_text,
+        timings[timings.size() / 2],
+        timings.front(),
+        results.empty()
+          ? "-"
+          : std::string(
+              arena.get_data(results.front().index),
+              arena.get_length(results.front().index)
+            ).c_str()
+      );
+    }
+    std::printf("\n");
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_BOOKMARKS_HPP_GUARD
+#define SELAIN_BOOKMARKS_HPP_GUARD
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glibmm.h>
+
+namespace selain
+{
+  /**
+   * Single bookmarked page.
+   */
+  struct Bookmark
+  {
+    std::string uri;
+    std::string title;
+    std::vector<std::string> tags;
+    /** Time when the bookmark was added, in seconds since the Unix epoch. */
+    std::int64_t added;
+  };
+
+  /**
+   * Persistent bookmark and quickmark store.
+   *
+   * Bookmarks are stored in a versioned binary file which is mapped into
+   * memory as it is, so opening the store does not require parsing the
+   * whole file. The file contains an URI index sorted by URI and a tag
+   * index with posting lists, which are searched directly from the mapped
+   * memory. Changes are kept in memory on top of the mapped file and
+   * appended into a write-ahead log next to the file by a background thread,
+   * which also writes them into a new version of the file in a checkpoint
+   * once the log grows large enough. Changes made before the store has been
+   * opened are queued until then.
+   *
+   * All methods are thread safe.
+   */
+  class Bookmarks
+  {
+  public:
+    using import_callback_type = std::function<void(
+      std::size_t,
+      const std::string&
+    )>;
+    using quickmark_type = std::pair<std::string, std::string>;
+
+    explicit Bookmarks();
+    ~Bookmarks();
+
+    Bookmarks(const Bookmarks&) = delete;
+    Bookmarks& operator=(const Bookmarks&) = delete;
+
+    /**
+     * Maps bookmark file from given path into memory, replays changes
+     * recorded in it's write-ahead log and starts the background thread
+     * which appends new changes into it.
+     */
+    void open(const std::string& path);
+
+    /**
+     * Adds given bookmark, replacing existing bookmark with the same URI.
+     */
+    void add(const Bookmark& bookmark);
+
+    /**
+     * Removes bookmark with given URI. Returns false if there is no such
+     * bookmark.
+     */
+    bool remove(const std::string& uri);
+
+    /**
+     * Looks up bookmark with given URI.
+     */
+    bool find(const std::string& uri, Bookmark& result) const;
+
+    /**
+     * Returns all bookmarks which have given tag.
+     */
+    std::vector<Bookmark> find_by_tag(const std::string& tag) const;
+
+    /**
+     * Iterates all bookmarks in URI order until the callback returns false.
+     * The lock is not held while the callback is invoked, so changes made
+     * during the iteration may or may not be seen by it.
+     */
+    void for_each(const std::function<bool(const Bookmark&)>& callback) const;
+
+    /**
+     * Returns total number of bookmarks.
+     */
+    std::size_t size() const;
+
+    /**
+     * Assigns given URI to quickmark with given name. Empty URI removes the
+     * quickmark.
+     */
+    void set_quickmark(const std::string& name, const std::string& uri);
+
+    /**
+     * Looks up URI of quickmark with given name.
+     */
+    bool find_quickmark(const std::string& name, std::string& uri) const;
+
+    /**
+     * Returns names and URIs of all quickmarks, sorted by name.
+     */
+    std::vector<quickmark_type> get_quickmarks() const;
+
+    /**
+     * Imports bookmarks from an HTML bookmark export file in a background
+     * thread. Bookmarks which already exist are skipped. Callback is invoked
+     * in the main loop with number of imported bookmarks and an error
+     * message, which is empty on success. Only one import can be running at
+     * a time. Must be called from the main thread.
+     */
+    void import(
+      const std::string& path,
+      const import_callback_type& callback
+    );
+
+  private:
+    struct PendingBookmark
+    {
+      bool removed;
+      Bookmark bookmark;
+    };
+
+    bool map_file();
+    void unmap_file();
+    void replay_log();
+    void apply_record(const std::string& payload);
+    void append_log(const std::string& record);
+    void write_log(const std::vector<std::string>& records);
+    bool checkpoint();
+    void run();
+    void on_import_finished();
+
+    std::uint32_t find_mapped(const std::string& uri) const;
+    std::uint32_t upper_bound_mapped(const std::string& uri) const;
+    bool exists(const std::string& uri) const;
+    void read_mapped(std::uint32_t index, Bookmark& result) const;
+    bool for_each_locked(
+      const std::function<bool(const Bookmark&)>& callback
+    ) const;
+    std::vector<quickmark_type> get_quickmarks_locked() const;
+
+  private:
+    std::string m_path;
+    ::GMappedFile* m_mapped_file;
+    const char* m_data;
+    std::size_t m_length;
+    std::map<std::string, PendingBookmark> m_pending;
+    std::unordered_map<std::string, std::string> m_pending_quickmarks;
+    std::size_t m_size;
+    /** Only accessed by the background thread once it has been started. */
+    std::FILE* m_log;
+    std::size_t m_log_record_count;
+    /** Records waiting to be appended into the log. */
+    std::vector<std::string> m_log_queue;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::thread m_thread;
+    bool m_running;
+    std::thread m_import_thread;
+    Glib::Dispatcher m_import_dispatcher;
+    import_callback_type m_import_callback;
+    std::size_t m_import_count;
+    std::string m_import_error;
+  };
+}
+
+#endif /* !SELAIN_BOOKMARKS_HPP_GUARD */
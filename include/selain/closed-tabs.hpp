@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_CLOSED_TABS_HPP_GUARD
+#define SELAIN_CLOSED_TABS_HPP_GUARD
+
+#include <cstddef>
+#include <deque>
+#include <string>
+
+#include <glibmm.h>
+
+#include <selain/web-settings.hpp>
+
+namespace selain
+{
+  /**
+   * State of a closed tab, from which the tab can be reopened.
+   */
+  struct ClosedTab
+  {
+    /** Identifier of the entry, which is unique within the stack. */
+    ::guint id;
+    std::string uri;
+    std::string title;
+    SettingsProfile profile;
+    int scroll_x;
+    int scroll_y;
+    /** Whether the scroll position is still being received from the page. */
+    bool scroll_pending;
+    /** Serialized WebKit session state, with the back/forward history. */
+    std::string session_state;
+  };
+
+  /**
+   * Bounded stack of recently closed tabs. Session states are stored
+   * compressed, and once either the number of the tabs or the total size of
+   * the compressed states exceeds it's limit, the oldest tabs are dropped.
+   */
+  class ClosedTabStack
+  {
+  public:
+    using scroll_position_received_signal_type = sigc::signal<void, ::guint>;
+
+    static constexpr std::size_t DEFAULT_MAX_COUNT = 25;
+    static constexpr std::size_t DEFAULT_MAX_BYTES = 8 * 1024 * 1024;
+
+    explicit ClosedTabStack(
+      std::size_t max_count = DEFAULT_MAX_COUNT,
+      std::size_t max_bytes = DEFAULT_MAX_BYTES
+    );
+
+    ClosedTabStack(const ClosedTabStack&) = delete;
+    ClosedTabStack& operator=(const ClosedTabStack&) = delete;
+
+    inline bool empty() const
+    {
+      return m_entries.empty();
+    }
+
+    inline std::size_t size() const
+    {
+      return m_entries.size();
+    }
+
+    /**
+     * Pushes given tab on top of the stack and returns identifier assigned
+     * to it. Identifier of the tab is ignored.
+     */
+    ::guint push(ClosedTab&& tab);
+
+    /**
+     * Removes the most recently closed tab from the stack and stores it into
+     * given tab. Returns false if the stack is empty.
+     */
+    bool pop(ClosedTab& tab);
+
+    /**
+     * Returns true if scroll position of the most recently closed tab has
+     * not been received yet.
+     */
+    bool is_scroll_pending() const;
+
+    /**
+     * Sets scroll position of the tab with given identifier, if it's still
+     * in the stack. Scroll position is received from the page only after the
+     * tab has already been closed, so the tab is pushed with the position
+     * pending. Zero position is set if it could not be received.
+     */
+    void set_scroll_position(::guint id, int x, int y);
+
+    /**
+     * Signal which is emitted when scroll position of a closed tab has been
+     * received.
+     */
+    inline scroll_position_received_signal_type&
+    signal_scroll_position_received()
+    {
+      return m_signal_scroll_position_received;
+    }
+
+  private:
+    void trim();
+
+  private:
+    /** Tabs where the session state is compressed, newest last. */
+    std::deque<ClosedTab> m_entries;
+    const std::size_t m_max_count;
+    const std::size_t m_max_bytes;
+    std::size_t m_bytes;
+    ::guint m_last_id;
+    scroll_position_received_signal_type m_signal_scroll_position_received;
+  };
+}
+
+#endif /* !SELAIN_CLOSED_TABS_HPP_GUARD */
@@ -46,6 +46,7 @@ namespace selain
       void,
       const Glib::ustring&
     >;
+    using signal_changed_type = Glib::SignalProxy<void>;
 
     explicit CommandEntry();
 
@@ -82,6 +83,14 @@ namespace selain
       return m_signal_command_received;
     }
 
+    /**
+     * Signal emitted whenever text of the command line changes.
+     */
+    inline signal_changed_type signal_changed()
+    {
+      return m_entry.signal_changed();
+    }
+
   private:
     void show_notification(const Notification& notification);
     void on_activate();
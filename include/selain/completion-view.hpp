@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_COMPLETION_VIEW_HPP_GUARD
+#define SELAIN_COMPLETION_VIEW_HPP_GUARD
+
+#include <gtkmm.h>
+
+#include <selain/completion.hpp>
+
+namespace selain
+{
+  /**
+   * GTK widget which displays list of completion candidates above the
+   * command line.
+   */
+  class CompletionView : public Gtk::ScrolledWindow
+  {
+  public:
+    explicit CompletionView();
+
+    /**
+     * Replaces the displayed candidates. The view is hidden when there are
+     * no candidates.
+     */
+    void set_items(const std::vector<CompletionItem>& items);
+
+    /**
+     * Removes all candidates and hides the view.
+     */
+    void clear();
+
+    /**
+     * Selects the next candidate and returns it's value, or empty string if
+     * there are no candidates.
+     */
+    Glib::ustring select_next();
+
+    /**
+     * Selects the previous candidate and returns it's value, or empty string
+     * if there are no candidates.
+     */
+    Glib::ustring select_prev();
+
+  private:
+    Glib::ustring select(int offset);
+
+  private:
+    class Columns : public Gtk::TreeModel::ColumnRecord
+    {
+    public:
+      explicit Columns();
+
+      Gtk::TreeModelColumn<Glib::ustring> value;
+      Gtk::TreeModelColumn<Glib::ustring> description;
+    };
+
+    Columns m_columns;
+    Glib::RefPtr<Gtk::ListStore> m_store;
+    Gtk::TreeView m_tree_view;
+  };
+}
+
+#endif /* !SELAIN_COMPLETION_VIEW_HPP_GUARD */
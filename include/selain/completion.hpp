@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_COMPLETION_HPP_GUARD
+#define SELAIN_COMPLETION_HPP_GUARD
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <glibmm.h>
+
+#include <selain/command.hpp>
+#include <selain/fuzzy.hpp>
+
+namespace selain
+{
+  class Bookmarks;
+  class History;
+
+  /**
+   * Single candidate offered by the completion engine.
+   */
+  struct CompletionItem
+  {
+    /** Text which replaces the argument of the command being completed. */
+    std::string value;
+    /** Additional information displayed next to the value. */
+    std::string description;
+    double score;
+  };
+
+  /**
+   * Single completion request, which is being passed to the completion
+   * sources in a worker thread. Keeps track of given number of candidates
+   * with the highest scores.
+   */
+  class CompletionQuery
+  {
+  public:
+    using publish_callback_type = std::function<void(const CompletionQuery&)>;
+
+    explicit CompletionQuery(
+      const std::string& command,
+      const std::string& argument,
+      unsigned int generation,
+      const std::atomic<unsigned int>& current_generation,
+      const publish_callback_type& publish_callback
+    );
+
+    /**
+     * Returns canonical name of the command whose argument is being
+     * completed, or empty string if name of the command itself is being
+     * completed.
+     */
+    inline const std::string& get_command() const
+    {
+      return m_command;
+    }
+
+    /**
+     * Returns the text being completed.
+     */
+    inline const std::string& get_argument() const
+    {
+      return m_argument;
+    }
+
+    /**
+     * Returns the text being completed, compiled for the fuzzy matcher.
+     */
+    inline const fuzzy::Pattern& get_pattern() const
+    {
+      return m_pattern;
+    }
+
+    inline unsigned int get_generation() const
+    {
+      return m_generation;
+    }
+
+    /**
+     * Returns true if a newer query has been started after this one, in
+     * which case the sources should stop processing the query as soon as
+     * possible.
+     */
+    inline bool is_cancelled() const
+    {
+      return m_current_generation.load(std::memory_order_relaxed)
+        != m_generation;
+    }
+
+    /**
+     * Adds candidate into results of the query, unless there already are
+     * enough candidates with higher scores.
+     */
+    void add(CompletionItem&& item);
+
+    /**
+     * Passes current results to the user interface, without waiting for the
+     * query to be finished.
+     */
+    void publish();
+
+    /**
+     * Returns current results of the query, sorted by their score.
+     */
+    std::vector<CompletionItem> get_results() const;
+
+  private:
+    const std::string m_command;
+    const std::string m_argument;
+    const fuzzy::Pattern m_pattern;
+    const unsigned int m_generation;
+    const std::atomic<unsigned int>& m_current_generation;
+    const publish_callback_type m_publish_callback;
+    std::vector<CompletionItem> m_items;
+  };
+
+  /**
+   * Provider of completion candidates. Candidates are collected in a worker
+   * thread, so implementations must be thread safe.
+   */
+  class CompletionSource
+  {
+  public:
+    virtual ~CompletionSource() = default;
+
+    /**
+     * Returns true if this source provides candidates for arguments of given
+     * command. Empty string stands for names of the commands.
+     */
+    virtual bool accepts(const std::string& command) const = 0;
+
+    /**
+     * Adds matching candidates into given query.
+     */
+    virtual void complete(CompletionQuery& query) = 0;
+  };
+
+  /**
+   * Completion source for names of the browser commands.
+   */
+  class CommandCompletionSource : public CompletionSource
+  {
+  public:
+    explicit CommandCompletionSource(
+      const std::unordered_map<std::string, Command>& mapping
+    );
+
+    bool accepts(const std::string& command) const;
+    void complete(CompletionQuery& query);
+
+  private:
+    std::vector<CompletionItem> m_commands;
+  };
+
+  /**
+   * Completion source for URIs of pages in the browsing history.
+   */
+  class HistoryCompletionSource : public CompletionSource
+  {
+  public:
+    explicit HistoryCompletionSource(const History& history);
+
+    bool accepts(const std::string& command) const;
+    void complete(CompletionQuery& query);
+
+  private:
+    const History& m_history;
+  };
+
+  /**
+   * Completion source for URIs of the bookmarks and names of the
+   * quickmarks. Argument beginning with a tag prefixed with `#` limits the
+   * candidates to bookmarks with that tag.
+   */
+  class BookmarkCompletionSource : public CompletionSource
+  {
+  public:
+    explicit BookmarkCompletionSource(const Bookmarks& bookmarks);
+
+    bool accepts(const std::string& command) const;
+    void complete(CompletionQuery& query);
+
+  private:
+    void complete_quickmarks(CompletionQuery& query);
+
+  private:
+    const Bookmarks& m_bookmarks;
+  };
+
+  /**
+   * Completion source for URIs of the open tabs. Also completes arguments of
+   * the `:buffer` command with numbers of the tabs whose title or URI match
+   * the argument. Titles and URIs are copied into an arena when the list of
+   * tabs is set, so filtering does not touch the tabs themselves.
+   */
+  class TabCompletionSource : public CompletionSource
+  {
+  public:
+    struct TabInfo
+    {
+      int index;
+      std::string uri;
+      std::string title;
+    };
+
+    bool accepts(const std::string& command) const;
+    void complete(CompletionQuery& query);
+
+    /**
+     * Replaces the list of tabs offered by this source.
+     */
+    void set_tabs(std::vector<TabInfo>&& tabs);
+
+    /**
+     * Returns index of the tab whose title or URI best matches given query,
+     * or -1 if no tab matches it.
+     */
+    int find(const std::string& query);
+
+  private:
+    void complete_buffer(CompletionQuery& query);
+
+  private:
+    std::vector<TabInfo> m_tabs;
+    fuzzy::Arena m_arena;
+    std::vector<fuzzy::Match> m_matches;
+    std::mutex m_mutex;
+  };
+
+  /**
+   * Completion engine for the command line. Queries are processed by a
+   * worker thread and each new query cancels the previous one. Results are
+   * delivered to the main loop while the query is still being processed.
+   */
+  class Completion
+  {
+  public:
+    using signal_results_type = sigc::signal<
+      void,
+      const std::vector<CompletionItem>&
+    >;
+
+    explicit Completion();
+    ~Completion();
+
+    Completion(const Completion&) = delete;
+    Completion& operator=(const Completion&) = delete;
+
+    void add_source(const std::shared_ptr<CompletionSource>& source);
+
+    /**
+     * Sets the mapping which is used to resolve command shortcuts into
+     * canonical command names.
+     */
+    void set_command_mapping(
+      const std::unordered_map<std::string, Command>& mapping
+    );
+
+    /**
+     * Starts completing given command line text, cancelling the previous
+     * query.
+     */
+    void complete(const Glib::ustring& text);
+
+    /**
+     * Cancels the current query.
+     */
+    void cancel();
+
+    /**
+     * Returns the part of the command line text which precedes the text being
+     * completed in the current query.
+     */
+    inline const Glib::ustring& get_prefix() const
+    {
+      return m_prefix;
+    }
+
+    inline signal_results_type& signal_results()
+    {
+      return m_signal_results;
+    }
+
+  private:
+    struct Request
+    {
+      std::string command;
+      std::string argument;
+      unsigned int generation;
+    };
+
+    void run();
+    void on_results_available();
+
+  private:
+    std::vector<std::shared_ptr<CompletionSource>> m_sources;
+    std::unordered_map<std::string, std::string> m_command_names;
+    Glib::ustring m_prefix;
+    std::atomic<unsigned int> m_generation;
+    std::unique_ptr<Request> m_request;
+    std::vector<CompletionItem> m_results;
+    unsigned int m_results_generation;
+    bool m_running;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    Glib::Dispatcher m_dispatcher;
+    signal_results_type m_signal_results;
+    std::thread m_thread;
+  };
+}
+
+#endif /* !SELAIN_COMPLETION_HPP_GUARD */
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_CONFIG_HPP_GUARD
+#define SELAIN_CONFIG_HPP_GUARD
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glibmm.h>
+#include <gio/gio.h>
+
+namespace selain
+{
+  /**
+   * Configuration file in the GKeyFile format, which is watched for changes
+   * while the browser is running. Whenever the file changes, it's parsed
+   * again and only the options whose values have changed are reported, so
+   * that unrelated settings are not needlessly applied again.
+   */
+  class Config
+  {
+  public:
+    /**
+     * Signal which is emitted with group, key and value of each option that
+     * has been added or changed. Removed options are reported with an empty
+     * value, which means that the default value should be used.
+     */
+    using changed_signal_type = sigc::signal<
+      void,
+      const std::string&,
+      const std::string&,
+      const std::string&
+    >;
+
+    explicit Config();
+    ~Config();
+
+    Config(const Config&) = delete;
+    Config& operator=(const Config&) = delete;
+
+    /**
+     * Returns path of the default configuration file, which is "config"
+     * inside the configuration directory of Selain.
+     */
+    static std::string get_default_path();
+
+    /**
+     * Loads configuration from file in given path and starts watching it
+     * for changes. The file does not have to exist yet.
+     */
+    void open(const std::string& path);
+
+    /**
+     * Returns value of given option, or an empty string if the option has
+     * not been set.
+     */
+    std::string get(const std::string& group, const std::string& key) const;
+
+    /**
+     * Returns keys and values of all options in given group.
+     */
+    std::vector<std::pair<std::string, std::string>> get_group(
+      const std::string& group
+    ) const;
+
+    /**
+     * Signal which is emitted when an option is added, changed or removed.
+     */
+    inline changed_signal_type& signal_changed()
+    {
+      return m_signal_changed;
+    }
+
+  private:
+    void load();
+    bool on_reload_timeout();
+
+    static void on_file_changed(
+      ::GFileMonitor* monitor,
+      ::GFile* file,
+      ::GFile* other_file,
+      ::GFileMonitorEvent event,
+      ::gpointer data
+    );
+
+  private:
+    std::string m_path;
+    ::GFileMonitor* m_monitor;
+    std::map<std::pair<std::string, std::string>, std::string> m_values;
+    sigc::connection m_reload_connection;
+    changed_signal_type m_signal_changed;
+  };
+}
+
+#endif /* !SELAIN_CONFIG_HPP_GUARD */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_CONTENT_FILTER_HPP_GUARD
+#define SELAIN_CONTENT_FILTER_HPP_GUARD
+
+#include <istream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glibmm.h>
+#include <webkit2/webkit2.h>
+
+namespace selain
+{
+  /**
+   * Blocks advertisements and trackers with EasyList style filter lists.
+   *
+   * The filter lists are read from the "filters" directory under the data
+   * directory of Selain, converted into WebKit content blocker rules in a
+   * background thread and compiled by WebKit. The compiled filter is stored
+   * on disk, so later startups only have to load it, unless the filter lists
+   * have changed in the meantime. Single compiled filter is shared by the
+   * user content managers of all web views.
+   */
+  class ContentFilter
+  {
+  public:
+    explicit ContentFilter();
+    ~ContentFilter();
+
+    ContentFilter(const ContentFilter&) = delete;
+    ContentFilter& operator=(const ContentFilter&) = delete;
+
+    /**
+     * Loads the compiled filter from disk, or compiles it from the filter
+     * lists if they have changed since it was compiled. Both are done
+     * asynchronously.
+     */
+    void load();
+
+    /**
+     * Attaches the filter to given user content manager. If the filter has
+     * not been loaded yet, it's attached once it has been.
+     */
+    void install(::WebKitUserContentManager* manager);
+
+    /**
+     * Enables or disables blocking of web fonts and media for given user
+     * content manager, which must have been passed to install() before.
+     * Used by tabs with the lite settings profile.
+     */
+    void set_lite(::WebKitUserContentManager* manager, bool lite);
+
+    /**
+     * Converts EasyList style filter list into JSON rules understood by the
+     * WebKit content blocker. Blocking and element hiding rules are appended
+     * to `rules` and exception rules to `exceptions`, as the exceptions only
+     * apply to rules preceding them. Filters which cannot be expressed as
+     * content blocker rules are skipped. At most `limit` rules are converted
+     * and their number is returned.
+     */
+    static std::size_t convert(
+      std::istream& input,
+      std::string& rules,
+      std::string& exceptions,
+      std::size_t limit
+    );
+
+  private:
+    void compile();
+    void apply(::WebKitUserContentFilter* filter);
+    void on_compiled();
+
+    static void on_load_finished(
+      ::GObject* source,
+      ::GAsyncResult* result,
+      ::gpointer data
+    );
+    static void on_save_finished(
+      ::GObject* source,
+      ::GAsyncResult* result,
+      ::gpointer data
+    );
+    static void on_lite_save_finished(
+      ::GObject* source,
+      ::GAsyncResult* result,
+      ::gpointer data
+    );
+    static void on_manager_finalized(::gpointer data, ::GObject* manager);
+
+  private:
+    ::WebKitUserContentFilterStore* m_store;
+    ::WebKitUserContentFilter* m_filter;
+    ::WebKitUserContentFilter* m_lite_filter;
+    std::string m_source_directory;
+    std::string m_version_path;
+    std::string m_version;
+    /** User content managers where the filter is installed. */
+    std::vector<::WebKitUserContentManager*> m_managers;
+    /** User content managers of the tabs using the lite profile. */
+    std::vector<::WebKitUserContentManager*> m_lite_managers;
+    /** Rules produced by the background thread. */
+    std::string m_rules;
+    Glib::Dispatcher m_dispatcher;
+    std::thread m_thread;
+  };
+}
+
+#endif /* !SELAIN_CONTENT_FILTER_HPP_GUARD */
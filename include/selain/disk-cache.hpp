@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_DISK_CACHE_HPP_GUARD
+#define SELAIN_DISK_CACHE_HPP_GUARD
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <glibmm.h>
+#include <webkit2/webkit2.h>
+
+namespace selain
+{
+  /**
+   * Statistics of the HTTP disk cache.
+   */
+  struct DiskCacheStats
+  {
+    /** Total size of the cached resources in bytes. */
+    std::uint64_t size;
+    /** Number of cached resources. */
+    std::size_t entry_count;
+    /** Number of sites which have resources in the cache. */
+    std::size_t site_count;
+    /** Number of resources loaded from the cache during this session. */
+    std::uint64_t hits;
+    /** Number of resources loaded from network during this session. */
+    std::uint64_t misses;
+  };
+
+  /**
+   * Enforces quota of the HTTP disk cache of a website data manager. WebKit
+   * does not limit size of the disk cache by itself, so cached data of the
+   * sites which have been least recently used is periodically removed
+   * until the cache fits into the quota.
+   */
+  class DiskCache
+  {
+  public:
+    using stats_callback_type = sigc::slot<void, const DiskCacheStats&>;
+
+    explicit DiskCache(::WebKitWebsiteDataManager* manager);
+    ~DiskCache();
+
+    DiskCache(const DiskCache&) = delete;
+    DiskCache& operator=(const DiskCache&) = delete;
+
+    /**
+     * Returns maximum size of the disk cache in bytes, or zero if the size
+     * is not limited.
+     */
+    inline std::uint64_t get_quota() const
+    {
+      return m_quota;
+    }
+
+    /**
+     * Sets maximum size of the disk cache in bytes and removes least
+     * recently used data if the cache is over the new quota. Zero removes
+     * the limit.
+     */
+    void set_quota(std::uint64_t quota);
+
+    /**
+     * Records that a resource has been requested from given URI, which
+     * marks cached data of it's site as recently used.
+     */
+    void record_access(const std::string& uri);
+
+    /**
+     * Records number of resources which a page loaded from the cache and
+     * from network.
+     */
+    void record_requests(std::uint64_t hits, std::uint64_t misses);
+
+    /**
+     * Removes least recently used data from the cache if it's over the
+     * quota. The data is removed asynchronously by WebKit.
+     */
+    void sweep();
+
+    /**
+     * Collects statistics of the cache asynchronously and passes them to
+     * given callback in the main loop. The callback is not called if it's
+     * slot has been invalidated in the meantime.
+     */
+    void get_stats(const stats_callback_type& callback);
+
+  private:
+    bool on_sweep_timeout();
+    void evict(::GList* website_data);
+    std::int64_t get_last_access(const std::string& site) const;
+    void load_access_times();
+    void merge_access_times();
+    void save_access_times() const;
+    void on_load_finished();
+    void on_stats_finished();
+
+    static void on_sweep_fetch_finished(
+      ::GObject* source,
+      ::GAsyncResult* result,
+      ::gpointer data
+    );
+    static void on_stats_fetch_finished(
+      ::GObject* source,
+      ::GAsyncResult* result,
+      ::gpointer data
+    );
+    static void on_remove_finished(
+      ::GObject* source,
+      ::GAsyncResult* result,
+      ::gpointer data
+    );
+
+  private:
+    ::WebKitWebsiteDataManager* m_manager;
+    std::string m_directory;
+    std::uint64_t m_quota;
+    bool m_sweeping;
+    bool m_sweep_pending;
+    std::uint64_t m_hits;
+    std::uint64_t m_misses;
+    /** Time of the latest request to each host. */
+    std::unordered_map<std::string, std::int64_t> m_access_times;
+    /** Access times read from disk by the loader thread. */
+    std::unordered_map<std::string, std::int64_t> m_loaded_access_times;
+    std::thread m_load_thread;
+    Glib::Dispatcher m_load_dispatcher;
+    /** Callbacks waiting for the statistics which are being collected. */
+    std::vector<stats_callback_type> m_stats_callbacks;
+    DiskCacheStats m_stats;
+    std::thread m_stats_thread;
+    Glib::Dispatcher m_stats_dispatcher;
+    sigc::connection m_sweep_connection;
+  };
+}
+
+#endif /* !SELAIN_DISK_CACHE_HPP_GUARD */
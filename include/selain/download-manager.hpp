@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_DOWNLOAD_MANAGER_HPP_GUARD
+#define SELAIN_DOWNLOAD_MANAGER_HPP_GUARD
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glibmm.h>
+#include <libsoup/soup.h>
+#include <webkit2/webkit2.h>
+
+namespace selain
+{
+  /**
+   * Enumeration of the states of a download.
+   */
+  enum class DownloadState
+  {
+    QUEUED,
+    RUNNING,
+    FINISHED,
+    FAILED,
+    CANCELLED
+  };
+
+  /**
+   * Snapshot of the progress of a download.
+   */
+  struct DownloadInfo
+  {
+    unsigned int id;
+    std::string uri;
+    /** Path of the downloaded file, or empty if not decided yet. */
+    std::string path;
+    DownloadState state;
+    /** Error message of a failed download. */
+    std::string error;
+    std::uint64_t received;
+    /** Size of the file, or zero if the server did not tell it. */
+    std::uint64_t total;
+    /** Current throughput in bytes per second. */
+    double speed;
+  };
+
+  /**
+   * Downloads files in background threads with libsoup. At most a few
+   * downloads run in parallel and the rest wait in a queue. Each download
+   * is streamed into a partial file next to the destination, which is
+   * preallocated once size of the file is known, and renamed over the
+   * destination once complete. Interrupted downloads are resumed with HTTP
+   * range requests.
+   *
+   * Downloads started by WebKit which cannot be repeated with a plain GET
+   * request, such as responses to forms, blob: and data: URIs or files
+   * behind HTTP authentication, are left to WebKit and only tracked here.
+   *
+   * Progress of the downloads is sampled periodically in the main loop, so
+   * that the user interface is not updated for every received chunk.
+   */
+  class DownloadManager
+  {
+  public:
+    using finished_signal_type = sigc::signal<void, const DownloadInfo&>;
+
+    explicit DownloadManager(::WebKitWebContext* context);
+    ~DownloadManager();
+
+    DownloadManager(const DownloadManager&) = delete;
+    DownloadManager& operator=(const DownloadManager&) = delete;
+
+    /**
+     * Starts downloading file from given URI. Cookies of the web context
+     * are sent along with the request. Returns identifier of the download.
+     */
+    unsigned int add(
+      const std::string& uri,
+      const std::string& referrer = std::string(),
+      const std::string& user_agent = std::string()
+    );
+
+    /**
+     * Cancels download with given identifier. The partial file is kept, so
+     * that the download can be resumed. Returns false if there is no such
+     * download or it has already finished.
+     */
+    bool cancel(unsigned int id);
+
+    /**
+     * Resumes failed or cancelled download with given identifier. Returns
+     * false if there is no such download or it cannot be resumed.
+     */
+    bool resume(unsigned int id);
+
+    /**
+     * Returns snapshots of all downloads, in the order they were added.
+     */
+    std::vector<DownloadInfo> get_downloads() const;
+
+    /**
+     * Returns combined throughput of all running downloads in bytes per
+     * second.
+     */
+    double get_speed() const;
+
+    /**
+     * Signal which is emitted in the main loop when a download finishes or
+     * fails.
+     */
+    inline finished_signal_type& signal_finished()
+    {
+      return m_signal_finished;
+    }
+
+  private:
+    struct Download;
+    struct CookieRequest;
+
+    void start(const std::shared_ptr<Download>& download);
+    void start_queued();
+    void start_progress_timer();
+    void track(::WebKitDownload* webkit_download);
+    void on_webkit_download_finished(Download& download);
+    void run(Download& download);
+    bool transfer(
+      Download& download,
+      ::SoupSession* session,
+      bool& retryable
+    );
+    bool on_progress_timeout();
+    void on_download_stopped();
+
+    static void on_download_started(
+      ::WebKitWebContext* context,
+      ::WebKitDownload* download,
+      DownloadManager* manager
+    );
+    static void on_cookies_received(
+      ::GObject* source,
+      ::GAsyncResult* result,
+      ::gpointer data
+    );
+    static ::gboolean on_decide_destination(
+      ::WebKitDownload* webkit_download,
+      const ::gchar* suggested_filename,
+      Download* download
+    );
+    static void on_received_data(
+      ::WebKitDownload* webkit_download,
+      ::guint64 data_length,
+      Download* download
+    );
+    static void on_failed(
+      ::WebKitDownload* webkit_download,
+      ::GError* error,
+      Download* download
+    );
+    static void on_finished(
+      ::WebKitDownload* webkit_download,
+      Download* download
+    );
+
+  private:
+    ::WebKitWebContext* m_context;
+    unsigned int m_last_id;
+    mutable std::mutex m_mutex;
+    std::vector<std::shared_ptr<Download>> m_downloads;
+    std::deque<std::shared_ptr<Download>> m_queue;
+    std::size_t m_running_count;
+    double m_speed;
+    std::int64_t m_last_sample_time;
+    sigc::connection m_progress_connection;
+    Glib::Dispatcher m_dispatcher;
+    finished_signal_type m_signal_finished;
+  };
+}
+
+#endif /* !SELAIN_DOWNLOAD_MANAGER_HPP_GUARD */
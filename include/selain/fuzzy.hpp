@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_FUZZY_HPP_GUARD
+#define SELAIN_FUZZY_HPP_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace selain
+{
+  namespace fuzzy
+  {
+    /**
+     * Enumeration of different implementations of the byte scanning used by
+     * the matcher.
+     */
+    enum class Implementation
+    {
+      SCALAR,
+      SSE2,
+      AVX2
+    };
+
+    /**
+     * Preprocessed search pattern. Matching is case insensitive for ASCII
+     * characters.
+     */
+    class Pattern
+    {
+    public:
+      explicit Pattern(const std::string& text = std::string());
+
+      inline bool empty() const
+      {
+        return m_text.empty();
+      }
+
+      inline std::size_t length() const
+      {
+        return m_text.length();
+      }
+
+      /**
+       * Returns the pattern with ASCII characters converted to lower case.
+       */
+      inline const std::string& get_text() const
+      {
+        return m_text;
+      }
+
+      /**
+       * Returns character set mask of the pattern. See get_mask().
+       */
+      inline std::uint64_t get_mask() const
+      {
+        return m_mask;
+      }
+
+    private:
+      std::string m_text;
+      std::uint64_t m_mask;
+    };
+
+    /**
+     * Contiguous storage of candidate strings, with precomputed character
+     * set masks used for rejecting candidates before they are scanned.
+     */
+    class Arena
+    {
+    public:
+      explicit Arena();
+
+      void reserve(std::size_t count, std::size_t bytes);
+
+      /**
+       * Appends new candidate to the arena and returns it's index.
+       */
+      std::uint32_t add(const char* data, std::size_t length);
+
+      inline std::uint32_t add(const std::string& candidate)
+      {
+        return add(candidate.data(), candidate.length());
+      }
+
+      void clear();
+
+      inline std::size_t size() const
+      {
+        return m_masks.size();
+      }
+
+      inline const char* get_data(std::size_t index) const
+      {
+        return m_data.data() + m_offsets[index];
+      }
+
+      inline std::size_t get_length(std::size_t index) const
+      {
+        return m_offsets[index + 1] - m_offsets[index];
+      }
+
+      inline std::uint64_t get_mask(std::size_t index) const
+      {
+        return m_masks[index];
+      }
+
+      /**
+       * Returns combined character set mask of all candidates in the arena.
+       */
+      inline std::uint64_t get_mask() const
+      {
+        return m_mask;
+      }
+
+    private:
+      // Number of zero bytes kept after the last candidate, so that it can
+      // be scanned in whole 64 byte windows.
+      static const std::size_t PADDING = 64;
+
+    private:
+      std::vector<char> m_data;
+      std::vector<std::uint32_t> m_offsets;
+      std::vector<std::uint64_t> m_masks;
+      std::uint64_t m_mask;
+    };
+
+    /**
+     * Candidate matched by match().
+     */
+    struct Match
+    {
+      std::uint32_t index;
+      int score;
+    };
+
+    /**
+     * Returns the implementation currently used for byte scanning. By default
+     * the fastest one supported by the CPU is selected.
+     */
+    Implementation get_implementation();
+
+    /**
+     * Overrides the byte scanning implementation. Returns false if given
+     * implementation is not supported by the CPU or by the compiler.
+     */
+    bool set_implementation(Implementation implementation);
+
+    /**
+     * Computes character set mask of given string. Every character maps into
+     * a single bit, so a candidate cannot match a pattern unless it's mask
+     * contains all the bits of the pattern's mask.
+     */
+    std::uint64_t get_mask(const char* data, std::size_t length);
+
+    /**
+     * Tests whether characters of the pattern appear in given candidate in
+     * the same order, and scores the match. Matches at word boundaries and
+     * consecutive matches are favored, while gaps between matched characters
+     * are penalized. Does not allocate memory.
+     *
+     * \param pattern Pattern to match.
+     * \param data    Candidate string.
+     * \param length  Length of the candidate string in bytes.
+     * \param result  Where the score is stored if the candidate matches.
+     * \return        True if the candidate matches the pattern.
+     */
+    bool score(
+      const Pattern& pattern,
+      const char* data,
+      std::size_t length,
+      int& result
+    );
+
+    inline bool score(
+      const Pattern& pattern,
+      const std::string& candidate,
+      int& result
+    )
+    {
+      return score(pattern, candidate.data(), candidate.length(), result);
+    }
+
+    /**
+     * Matches all candidates in the arena against the pattern and stores
+     * given number of best matches into the results, sorted by their score.
+     * Candidates with equal scores are ordered by their index. Memory is
+     * allocated only if the results vector does not already have enough
+     * capacity.
+     */
+    void match(
+      const Pattern& pattern,
+      const Arena& arena,
+      std::size_t limit,
+      std::vector<Match>& results
+    );
+  }
+}
+
+#endif /* !SELAIN_FUZZY_HPP_GUARD */
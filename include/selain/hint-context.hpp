@@ -33,10 +33,25 @@ namespace selain
 {
   class Tab;
 
+  /**
+   * Enumeration of where links activated in hint mode are opened.
+   */
+  enum class HintTarget
+  {
+    CURRENT_TAB,
+    NEW_TAB,
+    /** New tab using the lite settings profile. */
+    LITE_TAB,
+    /** Read-later queue instead of any tab. */
+    READ_LATER
+  };
+
   class HintContext : public Glib::Object
   {
   public:
-    static Glib::RefPtr<HintContext> create(bool open_in_new_tab = false);
+    static Glib::RefPtr<HintContext> create(
+      HintTarget target = HintTarget::CURRENT_TAB
+    );
 
     void install(Tab& tab);
     void uninstall(Tab& tab);
@@ -46,10 +61,10 @@ namespace selain
     void activate_current_match(Tab& tab);
 
   private:
-    explicit HintContext(bool open_in_new_tab);
+    explicit HintContext(HintTarget target);
 
   private:
-    const bool m_open_in_new_tab;
+    const HintTarget m_target;
   };
 }
 
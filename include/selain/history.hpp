@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_HISTORY_HPP_GUARD
+#define SELAIN_HISTORY_HPP_GUARD
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <glibmm.h>
+
+namespace selain
+{
+  /**
+   * Single page in the browsing history.
+   */
+  struct HistoryEntry
+  {
+    std::string uri;
+    std::string title;
+    /**
+     * Natural logarithm of sum of the visit weights, where weight of each
+     * visit grows exponentially with it's timestamp. Ordering entries by this
+     * value gives the same order as ordering them by their visit count
+     * decayed by recency, at any point of time.
+     */
+    double frecency;
+    std::uint32_t visit_count;
+    /** Timestamp of the latest visit, in seconds since the Unix epoch. */
+    std::int64_t last_visit;
+  };
+
+  /**
+   * Enumeration of browsers whose history databases can be imported.
+   */
+  enum class HistoryImportSource
+  {
+    FIREFOX,
+    CHROMIUM
+  };
+
+  /**
+   * Persistent browsing history. Visits are indexed in memory, ordered by
+   * their frecency, and appended into a log file on disk by a background
+   * thread, so that the main thread never has to wait for disk I/O.
+   *
+   * All methods are thread safe.
+   */
+  class History
+  {
+  public:
+    using import_callback_type = std::function<void(
+      std::size_t,
+      const std::string&
+    )>;
+
+    explicit History();
+    ~History();
+
+    History(const History&) = delete;
+    History& operator=(const History&) = delete;
+
+    /**
+     * Starts the background thread which loads previously recorded history
+     * from given file and appends new visits into it.
+     */
+    void open(const std::string& path);
+
+    /**
+     * Records visit to given URI. URIs with schemes other than HTTP(S), FTP
+     * and file are ignored.
+     *
+     * \param uri       URI of the visited page.
+     * \param timestamp Time of the visit in seconds since the Unix epoch, or
+     *                  zero for current time.
+     */
+    void add_visit(const std::string& uri, std::int64_t timestamp = 0);
+
+    /**
+     * Updates title of a previously visited page.
+     */
+    void set_title(const std::string& uri, const std::string& title);
+
+    /**
+     * Returns given number of entries with highest frecency.
+     */
+    std::vector<HistoryEntry> get_top(std::size_t count) const;
+
+    /**
+     * Iterates entries in order of their frecency, highest first, until the
+     * callback returns false. Entries are copied in chunks and the callback
+     * is invoked without holding the lock, so an entry whose frecency
+     * changes during the iteration may be seen twice or not at all.
+     */
+    void for_each(
+      const std::function<bool(const HistoryEntry&)>& callback
+    ) const;
+
+    /**
+     * Returns the frecency score of given entry at given point in time. Score
+     * of a single visit made at that time is one.
+     */
+    static double get_score(const HistoryEntry& entry, std::int64_t now);
+
+    /**
+     * Imports visits from history database of another browser in a
+     * background thread. Callback is invoked in the main loop with number of
+     * imported visits and an error message, which is empty on success. Only
+     * one import can be running at a time. Must be called from the main
+     * thread.
+     */
+    void import(
+      HistoryImportSource source,
+      const std::string& path,
+      const import_callback_type& callback
+    );
+
+  private:
+    struct Index
+    {
+      using ranking_type = std::set<
+        std::pair<double, std::size_t>,
+        std::greater<std::pair<double, std::size_t>>
+      >;
+
+      std::vector<HistoryEntry> entries;
+      std::unordered_map<std::string, std::size_t> uri_index;
+      ranking_type ranking;
+
+      void merge(const HistoryEntry& entry);
+      HistoryEntry* find(const std::string& uri);
+    };
+
+    void run();
+    std::size_t load();
+    void compact(std::size_t record_count);
+    void on_import_finished();
+
+  private:
+    std::string m_path;
+    Index m_index;
+    std::vector<std::string> m_queue;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::thread m_thread;
+    bool m_running;
+    /** Set when the log file cannot be opened and records are dropped. */
+    bool m_discarding;
+    std::thread m_import_thread;
+    Glib::Dispatcher m_import_dispatcher;
+    std::atomic<bool> m_import_cancelled;
+    import_callback_type m_import_callback;
+    std::size_t m_import_count;
+    std::string m_import_error;
+  };
+}
+
+#endif /* !SELAIN_HISTORY_HPP_GUARD */
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_INTERNAL_PAGE_HPP_GUARD
+#define SELAIN_INTERNAL_PAGE_HPP_GUARD
+
+#include <functional>
+#include <string>
+
+#include <glibmm.h>
+#include <webkit2/webkit2.h>
+
+namespace selain
+{
+  /**
+   * Body of a response to a request for an internal page. The body is built
+   * from chunks which are handed to WebKit as they are, without copying them
+   * into a single buffer.
+   */
+  class InternalResponse
+  {
+  public:
+    explicit InternalResponse();
+    ~InternalResponse();
+
+    InternalResponse(const InternalResponse&) = delete;
+    InternalResponse& operator=(const InternalResponse&) = delete;
+
+    /**
+     * Appends given chunk to the response. Ownership of the string is taken
+     * over by the response.
+     */
+    void append(std::string&& chunk);
+
+    /**
+     * Appends given string literal, or other string which outlives the
+     * response, to the response without copying it.
+     */
+    void append_static(const char* chunk);
+
+    /**
+     * Appends given text to the response with HTML special characters
+     * escaped.
+     */
+    void append_escaped(const Glib::ustring& text);
+
+    /**
+     * Appends contents of file from given path to the response. The file is
+     * memory mapped instead of being read. Returns false if the file cannot
+     * be mapped.
+     */
+    bool append_file(const std::string& path);
+
+    /**
+     * Returns the stream from which WebKit reads the response.
+     */
+    inline ::GInputStream* get_stream() const
+    {
+      return m_stream;
+    }
+
+  private:
+    ::GInputStream* m_stream;
+  };
+
+  /**
+   * Request for a page of the internal "selain:" URI scheme, such as
+   * "selain://start". Handlers of the pages may store copies of the request
+   * and finish it later, once the response is available.
+   */
+  class InternalRequest
+  {
+  public:
+    explicit InternalRequest(::WebKitURISchemeRequest* request);
+    InternalRequest(const InternalRequest& that);
+    ~InternalRequest();
+
+    InternalRequest& operator=(const InternalRequest&) = delete;
+
+    /**
+     * Returns name of the requested page, such as "start" for
+     * "selain://start?x=y".
+     */
+    std::string get_page() const;
+
+    /**
+     * Returns value of given query string parameter with percent encoding
+     * decoded, or empty string if the parameter is not present.
+     */
+    std::string get_parameter(const std::string& name) const;
+
+    /**
+     * Finishes the request with given response.
+     */
+    void finish(
+      const InternalResponse& response,
+      const char* content_type = "text/html; charset=utf-8"
+    ) const;
+
+    /**
+     * Finishes the request with an error, which WebKit displays instead of
+     * the page.
+     */
+    void finish_error(const std::string& message) const;
+
+  private:
+    ::WebKitURISchemeRequest* m_request;
+  };
+
+  using internal_page_handler_type = std::function<void(
+    const InternalRequest&
+  )>;
+}
+
+#endif /* !SELAIN_INTERNAL_PAGE_HPP_GUARD */
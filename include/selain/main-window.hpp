@@ -30,10 +30,22 @@
 
 #include <gtkmm.h>
 
+#include <selain/bookmarks.hpp>
+#include <selain/closed-tabs.hpp>
 #include <selain/command.hpp>
 #include <selain/command-entry.hpp>
+#include <selain/completion-view.hpp>
+#include <selain/config.hpp>
+#include <selain/history.hpp>
+#include <selain/performance-store.hpp>
+#include <selain/read-later.hpp>
+#include <selain/reader.hpp>
+#include <selain/site-rules.hpp>
 #include <selain/status-bar.hpp>
 #include <selain/tab.hpp>
+#include <selain/tab-overview.hpp>
+#include <selain/tab-strip.hpp>
+#include <selain/text-index.hpp>
 
 namespace selain
 {
@@ -108,6 +120,117 @@ namespace selain
       return m_command_entry;
     }
 
+    /**
+     * Returns URI of the page which is opened when the browser is started
+     * without arguments.
+     */
+    inline const Glib::ustring& get_home_page() const
+    {
+      return m_home_page;
+    }
+
+    /**
+     * Returns the web settings shared by all tabs using given profile.
+     */
+    inline const Glib::RefPtr<WebSettings>& get_web_settings(
+      SettingsProfile profile
+    ) const
+    {
+      return profile == SettingsProfile::LITE
+        ? m_lite_web_settings
+        : m_web_settings;
+    }
+
+    /**
+     * Returns web settings for a page loaded from given URI into a tab using
+     * given profile. These are the settings of the profile, unless a site
+     * rule matches the URI.
+     */
+    Glib::RefPtr<WebSettings> get_web_settings(
+      const Glib::ustring& uri,
+      SettingsProfile profile
+    );
+
+    /**
+     * Returns the web context shared by all tabs of the window.
+     */
+    inline const Glib::RefPtr<WebContext>& get_web_context() const
+    {
+      return m_web_context;
+    }
+
+    /**
+     * Returns the browsing history.
+     */
+    inline History& get_history()
+    {
+      return m_history;
+    }
+
+    /**
+     * Returns the browsing history.
+     */
+    inline const History& get_history() const
+    {
+      return m_history;
+    }
+
+    /**
+     * Returns the full-text index of visited pages.
+     */
+    inline TextIndex& get_text_index()
+    {
+      return m_text_index;
+    }
+
+    /**
+     * Returns the store of page performance metrics.
+     */
+    inline PerformanceStore& get_performance_store()
+    {
+      return m_performance_store;
+    }
+
+    /**
+     * Returns the articles displayed by reader views.
+     */
+    inline ReaderArticles& get_reader_articles()
+    {
+      return m_reader_articles;
+    }
+
+    /**
+     * Returns the queue of pages to be read later.
+     */
+    inline ReadLater& get_read_later()
+    {
+      return m_read_later;
+    }
+
+    /**
+     * Returns the cache of snapshots of the tabs.
+     */
+    inline TabSnapshots& get_tab_snapshots()
+    {
+      return m_tab_snapshots;
+    }
+
+    /**
+     * Returns the bookmarks and quickmarks.
+     */
+    inline Bookmarks& get_bookmarks()
+    {
+      return m_bookmarks;
+    }
+
+    /**
+     * Returns the bookmarks and quickmarks.
+     */
+    inline const Bookmarks& get_bookmarks() const
+    {
+      return m_bookmarks;
+    }
+
     /**
      * Returns pointer to the current tab, or null pointer if no tabs are open.
      */
@@ -130,35 +253,119 @@ namespace selain
      */
     const Tab* get_nth_tab(int index) const;
 
+    /**
+     * Returns pointer to tab with given identifier, or null pointer if no
+     * such tab is open.
+     */
+    Tab* get_tab_by_id(::guint id);
+
     Glib::RefPtr<Tab> open_tab(
       const Glib::ustring& uri = Glib::ustring(),
-      bool focus = true
+      bool focus = true,
+      SettingsProfile profile = SettingsProfile::NORMAL
     );
 
-    void close_tab(const Tab& tab);
+    /**
+     * Closes given tab. State of the tab is saved into the stack of closed
+     * tabs, from which it can be reopened with reopen_tab().
+     */
+    void close_tab(Tab& tab);
     void close_tab(const Glib::RefPtr<Tab>& tab);
 
+    /**
+     * Reopens the most recently closed tab, with it's back/forward history
+     * and scroll position. If the scroll position has not been received
+     * from the closed page yet, the tab is reopened once it has. Returns
+     * false if there are no closed tabs.
+     */
+    bool reopen_tab();
+
+    /**
+     * Returns index of the tab whose title or URI best matches given fuzzy
+     * query, or -1 if no tab matches it. Titles and URIs are matched as they
+     * were when the command line was opened.
+     */
+    int find_tab(const Glib::ustring& query);
+
     void set_current_tab(const Glib::RefPtr<Tab>& tab);
+    void set_current_tab(int index);
     void next_tab();
     void prev_tab();
 
+    /**
+     * Replaces the current tab with a grid of thumbnails of all open tabs,
+     * from which a tab can be switched to.
+     */
+    void show_tab_overview();
+    void hide_tab_overview();
+
   private:
     void initialize_commands();
+    void initialize_completion();
+    void initialize_internal_pages();
+    void initialize_deferred();
+    void update_completion();
+    void update_tab_completion();
+    bool reopen_closed_tab();
+    void reopen_pending_tabs();
 
+    bool on_first_draw(const Cairo::RefPtr<Cairo::Context>& context);
     bool on_command_entry_key_press(::GdkEventKey* event);
+    void on_command_entry_changed();
+    bool on_incremental_search_timeout();
     void on_command_received(const Glib::ustring& command);
+    void on_completion_results(const std::vector<CompletionItem>& items);
     void on_tab_status_change(Tab* tab, const Glib::ustring& status);
+    void on_tab_find_status_change(Tab* tab, const Glib::ustring& status);
+    void on_tab_blocked_count_change(Tab* tab, ::guint count);
+    void on_tab_switching(Gtk::Widget* widget, ::guint page_number);
     void on_tab_switch(Gtk::Widget* widget, ::guint page_number);
+    void on_tab_list_changed(Gtk::Widget* widget, ::guint page_number);
+    void on_tab_overview_activated(::guint id);
+    void on_closed_tab_scroll_position_received(::guint id);
+    bool on_reopen_timeout();
+    void on_download_finished(const DownloadInfo& info);
+    void on_config_changed(
+      const std::string& group,
+      const std::string& key,
+      const std::string& value
+    );
 
   private:
     command_mapping_type m_command_mapping;
     Glib::RefPtr<WebContext> m_web_context;
     Glib::RefPtr<WebSettings> m_web_settings;
+    Glib::RefPtr<WebSettings> m_lite_web_settings;
+    Config m_config;
+    SiteRules m_site_rules;
+    ClosedTabStack m_closed_tabs;
+    Glib::ustring m_home_page;
+    History m_history;
+    TextIndex m_text_index;
+    Bookmarks m_bookmarks;
+    PerformanceStore m_performance_store;
+    ReaderArticles m_reader_articles;
+    ReadLater m_read_later;
+    TabSnapshots m_tab_snapshots;
+    Completion m_completion;
+    std::shared_ptr<TabCompletionSource> m_tab_completion_source;
+    bool m_applying_completion;
+    /** Whether tabs have changed since tab completion was collected. */
+    bool m_tab_completion_stale;
+    /** Tabs waiting to be reopened until scroll position is received. */
+    unsigned int m_pending_reopen_count;
     Mode m_mode;
     Gtk::Box m_box;
+    Gtk::Box m_content_box;
     Gtk::Notebook m_notebook;
+    TabStrip m_tab_strip;
+    TabOverview m_tab_overview;
+    CompletionView m_completion_view;
     StatusBar m_status_bar;
     CommandEntry m_command_entry;
+    sigc::connection m_incremental_search_connection;
+    sigc::connection m_first_draw_connection;
+    sigc::connection m_reopen_timeout_connection;
   };
 }
 
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_METRICS_HPP_GUARD
+#define SELAIN_METRICS_HPP_GUARD
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <glib.h>
+
+namespace selain
+{
+  /**
+   * Registry of counters, gauges and latency histograms describing what the
+   * browser is doing internally. Metrics are defined as static objects next
+   * to the code which updates them, and they register themselves when
+   * constructed. Updating a metric never takes a lock, so they can be
+   * updated from any thread.
+   *
+   * Values can be viewed from `selain://stats` and written periodically
+   * into a file in the OpenMetrics text format.
+   */
+  namespace metrics
+  {
+    /** Number of shards a counter is split into. */
+    static constexpr std::size_t COUNTER_SHARDS = 8;
+
+    /** Number of finite buckets in a histogram. */
+    static constexpr std::size_t HISTOGRAM_BUCKETS = 12;
+
+    /**
+     * Upper bounds of the histogram buckets, in microseconds.
+     */
+    extern const std::int64_t histogram_bounds[HISTOGRAM_BUCKETS];
+
+    enum class Type
+    {
+      COUNTER,
+      GAUGE,
+      HISTOGRAM
+    };
+
+    /**
+     * Base class of all metrics, which links them into the registry.
+     */
+    class Metric
+    {
+    public:
+      Metric(const Metric&) = delete;
+      Metric& operator=(const Metric&) = delete;
+
+      inline const char* get_name() const
+      {
+        return m_name;
+      }
+
+      inline const char* get_help() const
+      {
+        return m_help;
+      }
+
+      inline Type get_type() const
+      {
+        return m_type;
+      }
+
+      inline const Metric* get_next() const
+      {
+        return m_next;
+      }
+
+    protected:
+      explicit Metric(const char* name, const char* help, Type type);
+
+    private:
+      const char* m_name;
+      const char* m_help;
+      const Type m_type;
+      const Metric* m_next;
+    };
+
+    /**
+     * Monotonically increasing count of events. Each thread increments
+     * it's own shard of the counter, so threads don't contend over the same
+     * cache line.
+     */
+    class Counter : public Metric
+    {
+    public:
+      explicit Counter(const char* name, const char* help);
+
+      void increment(std::uint64_t amount = 1);
+
+      std::uint64_t get() const;
+
+    private:
+      struct alignas(64) Shard
+      {
+        std::atomic<std::uint64_t> value;
+      };
+
+      Shard m_shards[COUNTER_SHARDS];
+    };
+
+    /**
+     * Value which can go up and down, such as the number of open tabs.
+     */
+    class Gauge : public Metric
+    {
+    public:
+      explicit Gauge(const char* name, const char* help);
+
+      inline void set(std::int64_t value)
+      {
+        m_value.store(value, std::memory_order_relaxed);
+      }
+
+      inline void add(std::int64_t amount)
+      {
+        m_value.fetch_add(amount, std::memory_order_relaxed);
+      }
+
+      inline std::int64_t get() const
+      {
+        return m_value.load(std::memory_order_relaxed);
+      }
+
+    private:
+      std::atomic<std::int64_t> m_value;
+    };
+
+    /**
+     * Distribution of durations over fixed buckets from 100 microseconds
+     * to ten seconds.
+     */
+    class Histogram : public Metric
+    {
+    public:
+      explicit Histogram(const char* name, const char* help);
+
+      /**
+       * Records duration given in microseconds.
+       */
+      void observe(std::int64_t duration);
+
+      /**
+       * Returns number of observations in given bucket. Bucket after the
+       * finite ones counts durations longer than any bound.
+       */
+      inline std::uint64_t get_bucket(std::size_t index) const
+      {
+        return m_buckets[index].load(std::memory_order_relaxed);
+      }
+
+      inline std::uint64_t get_count() const
+      {
+        return m_count.load(std::memory_order_relaxed);
+      }
+
+      /**
+       * Returns sum of all observed durations in microseconds.
+       */
+      inline std::uint64_t get_sum() const
+      {
+        return m_sum.load(std::memory_order_relaxed);
+      }
+
+    private:
+      std::atomic<std::uint64_t> m_buckets[HISTOGRAM_BUCKETS + 1];
+      std::atomic<std::uint64_t> m_count;
+      std::atomic<std::uint64_t> m_sum;
+    };
+
+    /**
+     * Records time from it's construction to it's destruction into a
+     * histogram.
+     */
+    class ScopedTimer
+    {
+    public:
+      explicit ScopedTimer(Histogram& histogram)
+        : m_histogram(histogram)
+        , m_start(::g_get_monotonic_time()) {}
+
+      ~ScopedTimer()
+      {
+        m_histogram.observe(::g_get_monotonic_time() - m_start);
+      }
+
+      ScopedTimer(const ScopedTimer&) = delete;
+      ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+      Histogram& m_histogram;
+      const std::int64_t m_start;
+    };
+
+    /**
+     * Returns the first registered metric. Rest of them are reached through
+     * Metric::get_next().
+     */
+    const Metric* get_first();
+
+    /**
+     * Returns values of all metrics in the OpenMetrics text format.
+     */
+    std::string format_openmetrics();
+
+    /**
+     * Sets file into which the metrics are written periodically. Empty
+     * path disables writing.
+     */
+    void set_dump_file(const std::string& path);
+
+    /**
+     * Sets how often the metrics are written into the dump file, in
+     * seconds.
+     */
+    void set_dump_interval(unsigned int interval);
+  }
+}
+
+#endif /* !SELAIN_METRICS_HPP_GUARD */
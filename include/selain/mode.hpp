@@ -42,7 +42,11 @@ namespace selain
     /** Hint mode where user can click elements with keyboard shortcuts. */
     HINT,
     /** Hint mode where links are opened into new tab. */
-    HINT_NEW_TAB
+    HINT_NEW_TAB,
+    /** Hint mode where links are opened into new tab using lite profile. */
+    HINT_LITE_TAB,
+    /** Hint mode where links are added into the read-later queue. */
+    HINT_READ_LATER
   };
 
   /**
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_PERFORMANCE_STORE_HPP_GUARD
+#define SELAIN_PERFORMANCE_STORE_HPP_GUARD
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glibmm.h>
+
+namespace selain
+{
+  /**
+   * Enumeration of the performance metrics collected from pages.
+   */
+  enum class PageMetric
+  {
+    TIME_TO_FIRST_BYTE,
+    FIRST_CONTENTFUL_PAINT,
+    LARGEST_CONTENTFUL_PAINT,
+    DOM_CONTENT_LOADED,
+    LOAD,
+    CUMULATIVE_LAYOUT_SHIFT,
+    LONG_TASK_TIME
+  };
+
+  static const std::size_t PAGE_METRIC_COUNT = 7;
+
+  /**
+   * Performance metrics of a single page load. Times are in milliseconds
+   * since the navigation started. Metrics which the page did not report,
+   * either because WebKit does not support them or because the page was
+   * left before they were available, are NaN.
+   */
+  struct PageMetrics
+  {
+    /** Time when the metrics were recorded, in seconds since the epoch. */
+    std::int64_t timestamp;
+    std::array<double, PAGE_METRIC_COUNT> values;
+  };
+
+  /**
+   * Percentiles of the performance metrics of an origin.
+   */
+  struct PerformanceSummary
+  {
+    std::string origin;
+    std::size_t sample_count;
+    std::array<double, PAGE_METRIC_COUNT> p50;
+    std::array<double, PAGE_METRIC_COUNT> p95;
+  };
+
+  /**
+   * Returns the name of given metric as used by the observer script, e.g.
+   * "timeToFirstByte".
+   */
+  const char* get_page_metric_name(PageMetric metric);
+
+  /**
+   * Rolling store of page performance metrics. The latest page loads of
+   * each origin are kept, and origins which have not been visited for a
+   * while are dropped. The store is loaded from disk when opened, and
+   * saved periodically while it has unsaved changes and when destroyed.
+   */
+  class PerformanceStore
+  {
+  public:
+    explicit PerformanceStore();
+    ~PerformanceStore();
+
+    PerformanceStore(const PerformanceStore&) = delete;
+    PerformanceStore& operator=(const PerformanceStore&) = delete;
+
+    /**
+     * Loads previously recorded metrics from file in given path. Metrics
+     * recorded before the store was opened are kept.
+     */
+    void open(const std::string& path);
+
+    /**
+     * Records metrics of a page load from given origin.
+     */
+    void add(const std::string& origin, const PageMetrics& metrics);
+
+    /**
+     * Calculates 50th and 95th percentiles of the metrics of each origin,
+     * ordered by number of recorded page loads. If a filter is given, only
+     * origins containing it are included.
+     */
+    std::vector<PerformanceSummary> summarize(
+      const std::string& filter = std::string()
+    ) const;
+
+  private:
+    void save() const;
+    void schedule_save();
+    bool on_save_timeout();
+
+  private:
+    std::string m_path;
+    std::unordered_map<std::string, std::deque<PageMetrics>> m_samples;
+    bool m_dirty;
+    sigc::connection m_save_connection;
+  };
+}
+
+#endif /* !SELAIN_PERFORMANCE_STORE_HPP_GUARD */
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_READ_LATER_HPP_GUARD
+#define SELAIN_READ_LATER_HPP_GUARD
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <selain/web-context.hpp>
+#include <selain/web-settings.hpp>
+
+namespace selain
+{
+  enum class ReadLaterState
+  {
+    /** Page is waiting to be fetched. */
+    QUEUED,
+    /** Page is being fetched by a hidden web view. */
+    FETCHING,
+    /** Page has been saved into the archive. */
+    SAVED,
+    /** Page could not be fetched or saved. */
+    FAILED
+  };
+
+  /**
+   * Single page in the read-later queue.
+   */
+  struct ReadLaterItem
+  {
+    ::guint id;
+    std::string uri;
+    std::string title;
+    /** Time when the page was queued, in seconds since the Unix epoch. */
+    std::int64_t added;
+    /** Size of the archived page in bytes. */
+    std::uint64_t size;
+    ReadLaterState state;
+  };
+
+  /**
+   * Queue of pages to be read later, possibly without network access.
+   *
+   * Queued pages are fetched in the background by hidden web views, a few
+   * at a time, once the user has not started loading any pages for a while.
+   * Fetched pages are saved as MHTML files into an archive directory, from
+   * which they can be opened offline. When the archive grows over it's
+   * quota, the oldest saved pages are removed.
+   */
+  class ReadLater
+  {
+  public:
+    /** Default maximum size of the archive. */
+    static constexpr std::uint64_t DEFAULT_DISK_QUOTA = 256 * 1024 * 1024;
+
+    /** Maximum number of pages fetched at the same time. */
+    static constexpr std::size_t MAX_CONCURRENT_FETCHES = 2;
+
+    explicit ReadLater(const Glib::RefPtr<WebContext>& context);
+    ~ReadLater();
+
+    ReadLater(const ReadLater&) = delete;
+    ReadLater& operator=(const ReadLater&) = delete;
+
+    /**
+     * Loads the queue from given archive directory, creating the directory
+     * if needed, and starts fetching the queued pages.
+     */
+    void open(const std::string& directory);
+
+    /**
+     * Sets the web settings used by the hidden web views.
+     */
+    void set_web_settings(const Glib::RefPtr<WebSettings>& settings);
+
+    /**
+     * Sets maximum size of the archive in bytes. Zero removes the limit.
+     */
+    void set_disk_quota(std::uint64_t quota);
+
+    /**
+     * Queues page from given URI and returns identifier assigned to it. If
+     * the page is already in the queue, it's identifier is returned.
+     */
+    ::guint add(const std::string& uri);
+
+    /**
+     * Removes page with given identifier from the queue and from the
+     * archive. Returns false if there is no such page.
+     */
+    bool remove(::guint id);
+
+    /**
+     * Returns all pages in the queue, oldest first.
+     */
+    inline const std::vector<ReadLaterItem>& get_items() const
+    {
+      return m_items;
+    }
+
+    /**
+     * Returns URI of the archived copy of given page, or empty string if the
+     * page has not been saved.
+     */
+    std::string get_archive_uri(::guint id) const;
+
+    /**
+     * Pauses fetching because the user is loading pages. Fetches in
+     * progress are stopped and queued again, and fetching is resumed once
+     * no pages have been loaded for a while.
+     */
+    void pause();
+
+  private:
+    struct Fetch;
+
+    ReadLaterItem* find_item(::guint id);
+    std::string get_archive_path(::guint id) const;
+    void schedule();
+    bool on_schedule();
+    void start_fetch(ReadLaterItem& item);
+    void finish_fetch(Fetch* fetch, ReadLaterState state);
+    void on_fetch_loaded(Fetch* fetch);
+    void on_fetch_saved(Fetch* fetch, bool success);
+    bool on_fetch_timeout(::guint id);
+    void enforce_quota();
+    void save_index();
+
+    static void on_load_changed(
+      ::WebKitWebView* web_view,
+      ::WebKitLoadEvent load_event,
+      Fetch* fetch
+    );
+    static ::gboolean on_load_failed(
+      ::WebKitWebView* web_view,
+      ::WebKitLoadEvent load_event,
+      ::gchar* failing_uri,
+      ::GError* error,
+      Fetch* fetch
+    );
+    static void on_save_finished(
+      ::GObject* web_view_object,
+      ::GAsyncResult* result,
+      ::gpointer data
+    );
+
+  private:
+    Glib::RefPtr<WebContext> m_context;
+    Glib::RefPtr<WebSettings> m_web_settings;
+    std::string m_directory;
+    std::uint64_t m_disk_quota;
+    std::vector<ReadLaterItem> m_items;
+    std::vector<std::unique_ptr<Fetch>> m_fetches;
+    ::guint m_last_id;
+    std::int64_t m_last_activity;
+    sigc::connection m_schedule_connection;
+  };
+}
+
+#endif /* !SELAIN_READ_LATER_HPP_GUARD */
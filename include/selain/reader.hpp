@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_READER_HPP_GUARD
+#define SELAIN_READER_HPP_GUARD
+
+#include <cstddef>
+#include <deque>
+#include <string>
+
+#include <glibmm.h>
+
+namespace selain
+{
+  /**
+   * Article content extracted from a page for the reader view. Content is
+   * HTML which has been reduced to elements and attributes needed for
+   * reading.
+   */
+  struct ReaderArticle
+  {
+    ::guint id;
+    std::string uri;
+    std::string title;
+    std::string byline;
+    std::string content;
+  };
+
+  /**
+   * Articles displayed by the reader view. Only the most recently extracted
+   * articles are kept, older ones have to be extracted again from their
+   * original page.
+   */
+  class ReaderArticles
+  {
+  public:
+    static constexpr std::size_t MAX_COUNT = 16;
+
+    explicit ReaderArticles();
+
+    ReaderArticles(const ReaderArticles&) = delete;
+    ReaderArticles& operator=(const ReaderArticles&) = delete;
+
+    /**
+     * Adds given article and returns identifier assigned to it.
+     */
+    ::guint add(ReaderArticle&& article);
+
+    /**
+     * Returns article with given identifier, or null pointer if it's no
+     * longer available.
+     */
+    const ReaderArticle* find(::guint id) const;
+
+  private:
+    std::deque<ReaderArticle> m_articles;
+    ::guint m_last_id;
+  };
+}
+
+#endif /* !SELAIN_READER_HPP_GUARD */
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_RESOURCE_LOG_HPP_GUARD
+#define SELAIN_RESOURCE_LOG_HPP_GUARD
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glibmm.h>
+#include <webkit2/webkit2.h>
+
+namespace selain
+{
+  /**
+   * Timing of a single resource loaded by a page. Times are in microseconds
+   * of the monotonic clock, and zero when the event has not happened (yet).
+   */
+  struct ResourceTiming
+  {
+    using header_list_type = std::vector<
+      std::pair<std::string, std::string>
+    >;
+
+    std::string uri;
+    std::string method;
+    std::string mime_type;
+    header_list_type request_headers;
+    header_list_type response_headers;
+    /** HTTP status code of the response, or zero if none was received. */
+    ::guint status;
+    /** Number of received bytes of the response body. */
+    std::uint64_t size;
+    /** Number of redirects followed before the final response. */
+    unsigned int redirect_count;
+    /** Wall clock time when the request was started, in microseconds. */
+    std::int64_t started_time;
+    std::int64_t started;
+    /** Time when the latest redirect was received. */
+    std::int64_t redirected;
+    std::int64_t response_received;
+    std::int64_t finished;
+    bool failed;
+  };
+
+  /**
+   * Records timing of the resources loaded by the page of a tab, from the
+   * signals of WebKitWebResource, into a ring buffer of fixed capacity. Once
+   * the buffer is full, the oldest resources are dropped.
+   */
+  class ResourceLog
+  {
+  public:
+    using save_callback_type = std::function<void(const std::string&)>;
+
+    explicit ResourceLog(std::size_t capacity);
+    ~ResourceLog();
+
+    ResourceLog(const ResourceLog&) = delete;
+    ResourceLog& operator=(const ResourceLog&) = delete;
+
+    /**
+     * Removes all recorded resources and starts recording resources of a
+     * new page.
+     */
+    void clear();
+
+    /**
+     * Starts recording given resource, which has just been requested.
+     */
+    void add(::WebKitWebResource* resource, ::WebKitURIRequest* request);
+
+    /**
+     * Returns time when the current page started loading, as wall clock
+     * time and as monotonic time, in microseconds.
+     */
+    inline std::int64_t get_page_started_time() const
+    {
+      return m_page_started_time;
+    }
+
+    inline std::int64_t get_page_started() const
+    {
+      return m_page_started;
+    }
+
+    /**
+     * Returns time when the current page finished loading, or zero if it
+     * has not finished loading yet.
+     */
+    inline std::int64_t get_page_finished() const
+    {
+      return m_page_finished;
+    }
+
+    void set_page_finished();
+
+    /**
+     * Returns number of resources currently in the buffer.
+     */
+    std::size_t size() const;
+
+    /**
+     * Returns number of resources of the current page which have been
+     * dropped from the buffer.
+     */
+    inline std::uint64_t get_dropped_count() const
+    {
+      return m_sequence > m_entries.size() ? m_sequence - m_entries.size() : 0;
+    }
+
+    /**
+     * Iterates recorded resources in the order they were requested.
+     */
+    void for_each(
+      const std::function<void(const ResourceTiming&)>& callback
+    ) const;
+
+    /**
+     * Returns the recorded resources in HTTP Archive (HAR) 1.2 format, as a
+     * single page with given URI and title.
+     */
+    std::string export_har(
+      const Glib::ustring& page_uri,
+      const Glib::ustring& page_title
+    ) const;
+
+    /**
+     * Exports the recorded resources in HAR format and writes them into
+     * given file in a background thread. Given callback is called in the
+     * main loop with an error message, which is empty on success. Only one
+     * export can be running at a time.
+     */
+    void save_har(
+      const std::string& path,
+      const Glib::ustring& page_uri,
+      const Glib::ustring& page_title,
+      const save_callback_type& callback
+    );
+
+  private:
+    void on_save_finished();
+
+    ResourceTiming* find(::WebKitWebResource* resource);
+
+    static void on_sent_request(
+      ::WebKitWebResource* resource,
+      ::WebKitURIRequest* request,
+      ::WebKitURIResponse* redirected_response,
+      ResourceLog* log
+    );
+    static void on_received_data(
+      ::WebKitWebResource* resource,
+      ::guint64 data_length,
+      ResourceLog* log
+    );
+    static void on_notify_response(
+      ::WebKitWebResource* resource,
+      ::GParamSpec* pspec,
+      ResourceLog* log
+    );
+    static void on_finished(::WebKitWebResource* resource, ResourceLog* log);
+    static void on_failed(
+      ::WebKitWebResource* resource,
+      ::GError* error,
+      ResourceLog* log
+    );
+
+  private:
+    const std::size_t m_capacity;
+    std::vector<ResourceTiming> m_entries;
+    /** Number of resources recorded since the log was cleared. */
+    std::uint64_t m_sequence;
+    /** Sequence numbers of the resources which are still loading. */
+    std::unordered_map<::WebKitWebResource*, std::uint64_t> m_loading;
+    std::int64_t m_page_started_time;
+    std::int64_t m_page_started;
+    std::int64_t m_page_finished;
+    std::thread m_save_thread;
+    Glib::Dispatcher m_save_dispatcher;
+    save_callback_type m_save_callback;
+    std::string m_save_error;
+  };
+}
+
+#endif /* !SELAIN_RESOURCE_LOG_HPP_GUARD */
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_SITE_RULES_HPP_GUARD
+#define SELAIN_SITE_RULES_HPP_GUARD
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <selain/web-settings.hpp>
+
+namespace selain
+{
+  /**
+   * Settings which apply to pages of a site.
+   */
+  struct SiteRule
+  {
+    /** Host pattern of the rule, e.g. "example.com" or "*". */
+    std::string pattern;
+    /** Options of the rule, which are WebKit settings or "profile". */
+    std::map<std::string, std::string> options;
+    /**
+     * Web settings built from the options, for both profiles which the tab
+     * can be using. Built on demand by the user of the rules.
+     */
+    Glib::RefPtr<WebSettings> settings[2];
+  };
+
+  /**
+   * Per-site settings rules. Host patterns are compiled into a trie of
+   * reversed domain name labels, so that the most specific rule for a host
+   * is found by walking the labels of the host once, regardless of how many
+   * rules there are.
+   *
+   * Pattern "example.com" matches the host example.com and all of it's
+   * subdomains, and "*" matches every host.
+   */
+  class SiteRules
+  {
+  public:
+    explicit SiteRules();
+
+    SiteRules(const SiteRules&) = delete;
+    SiteRules& operator=(const SiteRules&) = delete;
+
+    /**
+     * Sets option of the rule with given host pattern. Empty value removes
+     * the option, and the whole rule once it has no options left.
+     */
+    void set_option(
+      const std::string& pattern,
+      const std::string& key,
+      const std::string& value
+    );
+
+    /**
+     * Returns the most specific rule matching host of given URI, or null
+     * pointer if no rule matches it.
+     */
+    SiteRule* find(const std::string& uri);
+
+    /**
+     * Discards web settings built for the rules, so that they are built
+     * again with the current configuration.
+     */
+    void invalidate();
+
+  private:
+    struct Node
+    {
+      std::unordered_map<std::string, std::unique_ptr<Node>> children;
+      SiteRule* rule;
+    };
+
+    Node* get_node(const std::string& pattern);
+
+  private:
+    Node m_root;
+    std::unordered_map<std::string, std::unique_ptr<SiteRule>> m_rules;
+  };
+}
+
+#endif /* !SELAIN_SITE_RULES_HPP_GUARD */
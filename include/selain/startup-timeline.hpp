@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_STARTUP_TIMELINE_HPP_GUARD
+#define SELAIN_STARTUP_TIMELINE_HPP_GUARD
+
+namespace selain
+{
+  /**
+   * Records how long each phase of the browser startup takes, so that time
+   * to the first paint of the window can be tracked.
+   */
+  namespace startup_timeline
+  {
+    /**
+     * Enables printing of the timeline once startup has finished.
+     */
+    void enable();
+
+    /**
+     * Records that phase with given name has been completed. Time of the
+     * first recorded phase is used as starting point of the timeline.
+     */
+    void mark(const char* phase);
+
+    /**
+     * Records the final phase of the startup with given name and prints the
+     * timeline into standard error, if printing has been enabled. Later
+     * calls are ignored.
+     */
+    void finish(const char* phase);
+  }
+}
+
+#endif /* !SELAIN_STARTUP_TIMELINE_HPP_GUARD */
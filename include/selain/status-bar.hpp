@@ -43,9 +43,23 @@ namespace selain
     void set_mode(Mode mode);
     void set_status(const Glib::ustring& status);
 
+    /**
+     * Sets the text displaying position of the current search match and
+     * total number of matches, e.g. "3/42".
+     */
+    void set_find_status(const Glib::ustring& find_status);
+
+    /**
+     * Sets the number of requests of the current page blocked by the content
+     * filter. Nothing is displayed when no requests have been blocked.
+     */
+    void set_blocked_count(::guint count);
+
   private:
     Gtk::Label m_mode_label;
     Gtk::Label m_status_label;
+    Gtk::Label m_blocked_label;
+    Gtk::Label m_find_label;
   };
 }
 
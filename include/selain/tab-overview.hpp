@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_TAB_OVERVIEW_HPP_GUARD
+#define SELAIN_TAB_OVERVIEW_HPP_GUARD
+
+#include <vector>
+
+#include <selain/tab-snapshots.hpp>
+
+namespace selain
+{
+  /**
+   * GTK widget displaying the tabs of a notebook as a grid of thumbnails,
+   * made from the snapshot cache. Tiles are selected with the arrow keys or
+   * `h`, `j`, `k` and `l`, and activated with `Enter`. `Escape` closes the
+   * overview.
+   */
+  class TabOverview : public Gtk::ScrolledWindow
+  {
+  public:
+    using activated_signal_type = sigc::signal<void, ::guint>;
+    using closed_signal_type = sigc::signal<void>;
+
+    /** Size of a thumbnail in the grid, in pixels. */
+    static constexpr int THUMBNAIL_WIDTH = 240;
+    static constexpr int THUMBNAIL_HEIGHT = 150;
+
+    explicit TabOverview(Gtk::Notebook& notebook, TabSnapshots& snapshots);
+
+    TabOverview(const TabOverview&) = delete;
+    TabOverview& operator=(const TabOverview&) = delete;
+
+    /**
+     * Creates tiles for the tabs currently in the notebook and selects the
+     * current tab.
+     */
+    void populate();
+
+    /**
+     * Removes all tiles, releasing the thumbnails.
+     */
+    void clear();
+
+    /**
+     * Signal which is emitted with identifier of the tab whose tile has
+     * been activated.
+     */
+    inline activated_signal_type& signal_activated()
+    {
+      return m_signal_activated;
+    }
+
+    inline closed_signal_type& signal_closed()
+    {
+      return m_signal_closed;
+    }
+
+  protected:
+    bool on_key_press_event(::GdkEventKey* event) override;
+
+  private:
+    void update_thumbnail(std::size_t index);
+    void on_child_activated(Gtk::FlowBoxChild* child);
+    void on_snapshot_updated(::guint id);
+
+  private:
+    Gtk::Notebook& m_notebook;
+    TabSnapshots& m_snapshots;
+    Gtk::FlowBox m_flow_box;
+    /** Identifiers of the tabs, in the same order as the tiles. */
+    std::vector<::guint> m_ids;
+    std::vector<Gtk::Image*> m_thumbnails;
+  };
+}
+
+#endif /* !SELAIN_TAB_OVERVIEW_HPP_GUARD */
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_TAB_SNAPSHOTS_HPP_GUARD
+#define SELAIN_TAB_SNAPSHOTS_HPP_GUARD
+
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <gtkmm.h>
+
+namespace selain
+{
+  /**
+   * Memory bounded cache of downscaled snapshots of tabs, keyed by the
+   * identifiers of the tabs. Snapshots are displayed while a tab which has
+   * been in the background repaints itself, and in the tab overview.
+   *
+   * When the snapshots take more memory than allowed, the least recently
+   * used ones are discarded.
+   */
+  class TabSnapshots
+  {
+  public:
+    using surface_type = Cairo::RefPtr<Cairo::ImageSurface>;
+    using updated_signal_type = sigc::signal<void, ::guint>;
+
+    /** Default maximum memory used by the snapshots. */
+    static constexpr std::size_t DEFAULT_MEMORY_BUDGET = 48 * 1024 * 1024;
+
+    /** Maximum width of a snapshot, in pixels. */
+    static constexpr int MAX_WIDTH = 960;
+
+    TabSnapshots();
+    ~TabSnapshots();
+
+    TabSnapshots(const TabSnapshots&) = delete;
+    TabSnapshots& operator=(const TabSnapshots&) = delete;
+
+    inline std::size_t get_memory_usage() const
+    {
+      return m_memory_usage;
+    }
+
+    /**
+     * Sets maximum memory used by the snapshots, in bytes.
+     */
+    void set_memory_budget(std::size_t budget);
+
+    /**
+     * Marks snapshot of given tab as being captured. Snapshots which are
+     * received for tabs that have been removed in the meantime are ignored.
+     */
+    void begin(::guint id);
+
+    /**
+     * Downscales given snapshot of a tab in a background thread and stores
+     * it into the cache. Takes ownership of the surface.
+     */
+    void add(::guint id, ::cairo_surface_t* surface);
+
+    /**
+     * Returns snapshot of given tab, or null pointer if there isn't one.
+     */
+    surface_type get(::guint id);
+
+    /**
+     * Removes snapshot of given tab, which is being closed.
+     */
+    void remove(::guint id);
+
+    /**
+     * Signal which is emitted when a new snapshot has been stored for a tab.
+     */
+    inline updated_signal_type& signal_updated()
+    {
+      return m_signal_updated;
+    }
+
+  private:
+    struct Entry
+    {
+      ::guint id;
+      surface_type surface;
+      std::size_t size;
+    };
+
+    using job_list_type = std::vector<std::pair<::guint, ::cairo_surface_t*>>;
+
+    void store(::guint id, const surface_type& surface);
+    void evict();
+    void run();
+    void on_downscale_finished();
+
+  private:
+    std::size_t m_memory_budget;
+    std::size_t m_memory_usage;
+    /** Snapshots ordered from most recently used to least recently used. */
+    std::list<Entry> m_entries;
+    std::unordered_map<::guint, std::list<Entry>::iterator> m_index;
+    std::unordered_set<::guint> m_pending;
+    updated_signal_type m_signal_updated;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    /** Captured snapshots waiting to be downscaled. */
+    job_list_type m_queue;
+    /** Downscaled snapshots waiting to be stored in the main thread. */
+    job_list_type m_results;
+    bool m_running;
+    std::thread m_thread;
+    Glib::Dispatcher m_dispatcher;
+  };
+}
+
+#endif /* !SELAIN_TAB_SNAPSHOTS_HPP_GUARD */
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_TAB_STRIP_HPP_GUARD
+#define SELAIN_TAB_STRIP_HPP_GUARD
+
+#include <memory>
+#include <vector>
+
+#include <selain/tab-label.hpp>
+
+namespace selain
+{
+  class Tab;
+
+  /**
+   * GTK widget displaying labels of the tabs in a notebook, either as a
+   * horizontal bar or as a vertical list.
+   *
+   * Label widgets are created only for the tabs which fit into the strip,
+   * and they are recycled as the strip is scrolled or tabs are opened and
+   * closed, so the cost of switching tabs or resizing the window depends on
+   * the size of the strip instead of the number of open tabs.
+   */
+  class TabStrip : public Gtk::Layout
+  {
+  public:
+    explicit TabStrip(Gtk::Notebook& notebook);
+    ~TabStrip();
+
+    TabStrip(const TabStrip&) = delete;
+    TabStrip& operator=(const TabStrip&) = delete;
+
+    inline Gtk::Orientation get_orientation() const
+    {
+      return m_orientation;
+    }
+
+    void set_orientation(Gtk::Orientation orientation);
+
+    /**
+     * Updates the label of given tab, if it's currently visible.
+     */
+    void update_tab(Tab* tab);
+
+  protected:
+    void on_size_allocate(Gtk::Allocation& allocation) override;
+    bool on_scroll_event(::GdkEventScroll* event) override;
+
+  private:
+    struct Slot
+    {
+      Gtk::EventBox event_box;
+      TabLabel label;
+      Tab* tab;
+    };
+
+    int get_item_width() const;
+    void update_size_request();
+    bool update_slots();
+    void bind();
+    void scroll_to(int index);
+    void set_offset(int offset);
+    void on_page_added(Gtk::Widget* widget, ::guint page_number);
+    void on_page_removed(Gtk::Widget* widget, ::guint page_number);
+    void on_page_reordered(Gtk::Widget* widget, ::guint page_number);
+    void on_switch_page(Gtk::Widget* widget, ::guint page_number);
+    bool on_slot_button_press(::GdkEventButton* event, std::size_t index);
+    void on_slot_close_button_clicked(std::size_t index);
+
+  private:
+    Gtk::Notebook& m_notebook;
+    Gtk::Orientation m_orientation;
+    /** Tabs of the notebook, in the same order as they are displayed. */
+    std::vector<Tab*> m_tabs;
+    std::vector<std::unique_ptr<Slot>> m_slots;
+    int m_item_height;
+    int m_capacity;
+    int m_offset;
+    int m_current;
+    sigc::connection m_update_connection;
+  };
+}
+
+#endif /* !SELAIN_TAB_STRIP_HPP_GUARD */
@@ -26,8 +26,10 @@
 #ifndef SELAIN_TAB_HPP_GUARD
 #define SELAIN_TAB_HPP_GUARD
 
+#include <gtkmm.h>
+
 #include <selain/hint-context.hpp>
-#include <selain/tab-label.hpp>
+#include <selain/resource-log.hpp>
 #include <selain/web-context.hpp>
 #include <selain/web-settings.hpp>
 
@@ -46,6 +48,17 @@ namespace selain
       Tab*,
       const Glib::ustring&
     >;
+    using find_status_changed_signal_type = sigc::signal<
+      void,
+      Tab*,
+      const Glib::ustring&
+    >;
+    using blocked_count_changed_signal_type = sigc::signal<
+      void,
+      Tab*,
+      ::guint
+    >;
+    using label_changed_signal_type = sigc::signal<void, Tab*>;
 
     explicit Tab(
       const Glib::RefPtr<WebContext>& context,
@@ -64,6 +77,14 @@ namespace selain
 
     void set_hint_context(const Glib::RefPtr<HintContext>& hint_context);
 
+    /**
+     * Returns identifier of the tab, which is unique within the process.
+     */
+    inline ::guint get_id() const
+    {
+      return m_id;
+    }
+
     /**
      * Returns pointer to the main window where this tab is being displayed, or
      * null pointer if this tab isn't being displayed on a window.
@@ -77,22 +98,54 @@ namespace selain
     const MainWindow* get_main_window() const;
 
     /**
-     * Returns the GTK widget used as label for the tab.
+     * Returns the text displayed in the label of the tab.
      */
-    inline TabLabel& get_tab_label()
+    inline const Glib::ustring& get_label_text() const
     {
-      return m_tab_label;
+      return m_label_text;
     }
 
+    void set_label_text(const Glib::ustring& text);
+
     /**
-     * Returns the GTK widget used as label for the tab.
+     * Returns the icon displayed in the label of the tab, or null pointer if
+     * the page has no favicon.
      */
-    inline const TabLabel& get_tab_label() const
+    inline const Glib::RefPtr<Gdk::Pixbuf>& get_icon() const
     {
-      return m_tab_label;
+      return m_icon;
     }
 
+    void set_icon(const Glib::RefPtr<Gdk::Pixbuf>& icon);
+
     Glib::ustring get_uri() const;
+
+    /**
+     * Returns the settings profile selected for the tab. Site rules may
+     * override the settings of the profile.
+     */
+    inline SettingsProfile get_profile() const
+    {
+      return m_profile;
+    }
+
+    /**
+     * Switches the tab to given settings profile. If a page has already been
+     * loaded, it's reloaded so that the new settings take effect.
+     */
+    void set_profile(SettingsProfile profile);
+
+    /**
+     * Switches the tab to web settings of the site rules matching given
+     * URI, before a page from that URI is loaded.
+     */
+    void update_web_settings(const Glib::ustring& uri);
+
+    /**
+     * Returns title of the page, or empty string if the page has no title.
+     */
+    Glib::ustring get_title() const;
+
     void load_uri(const Glib::ustring& uri);
     void reload(bool bypass_cache = false);
     void stop_loading();
@@ -105,13 +158,127 @@ namespace selain
       void* user_data = nullptr
     );
 
+    /**
+     * Asks the page to report it's performance metrics now, instead of
+     * waiting for it to be hidden. Metrics of each page are reported only
+     * once.
+     */
+    void report_performance();
+
+    /**
+     * Extracts the main article of the page and opens it in a new tab, as a
+     * lightweight reader view using the lite profile. Returns false if the
+     * page is not a web page.
+     */
+    bool open_reader();
+
+    /**
+     * Captures snapshot of the visible part of the page into the snapshot
+     * cache of the main window, before the tab goes into the background.
+     */
+    void capture_snapshot();
+
+    /**
+     * Displays given snapshot over the web view until the web view has
+     * repainted itself after being switched to, or until the page has
+     * finished loading if it's still being loaded.
+     */
+    void show_snapshot(const Cairo::RefPtr<Cairo::ImageSurface>& snapshot);
+
+    /**
+     * Removes the snapshot displayed over the web view, if any.
+     */
+    void hide_snapshot();
+
     void go_back();
     void go_forward();
 
+    /**
+     * Returns serialized WebKit session state of the tab, which contains the
+     * back/forward history.
+     */
+    std::string get_session_state() const;
+
+    /**
+     * Restores serialized session state of a tab and goes to the current
+     * item of it's back/forward history, scrolled to given position once
+     * loaded. Given URI is loaded instead if the state cannot be restored.
+     */
+    void restore_session_state(
+      const std::string& session_state,
+      const Glib::ustring& uri,
+      int scroll_x,
+      int scroll_y
+    );
+
+    /**
+     * Searches the page for given text. Search is case insensitive unless the
+     * text contains upper case characters. If the text begins with `\v`, rest
+     * of it is treated as regular expression which is matched against text
+     * nodes of the page.
+     */
     void search(const Glib::ustring& text, bool forwards = true);
     void search_next();
     void search_prev();
 
+    /**
+     * Ends the current search and removes all match highlights from the page.
+     */
+    void search_finish();
+
+    /**
+     * Returns position of the current match and total number of matches as
+     * text, or empty string if no search is active.
+     */
+    Glib::ustring get_find_status() const;
+
+    /**
+     * Updates position of the current match and total number of matches of
+     * the active search.
+     *
+     * \param index    One based index of the current match.
+     * \param count    Total number of matches.
+     * \param complete Whether all matches have been counted.
+     */
+    void set_find_matches(::guint index, ::guint count, bool complete = true);
+
+    inline ::guint get_find_match_index() const
+    {
+      return m_find_match_index;
+    }
+
+    inline ::guint get_find_match_count() const
+    {
+      return m_find_match_count;
+    }
+
+    /**
+     * Returns timing of the resources loaded by the current page.
+     */
+    inline ResourceLog& get_resource_log()
+    {
+      return m_resource_log;
+    }
+
+    /**
+     * Returns timing of the resources loaded by the current page.
+     */
+    inline const ResourceLog& get_resource_log() const
+    {
+      return m_resource_log;
+    }
+
+    /**
+     * Returns the number of requests of the current page which have been
+     * blocked by the content filter.
+     */
+    inline ::guint get_blocked_count() const
+    {
+      return m_blocked_count;
+    }
+
+    void set_blocked_count(::guint count);
+
     void grab_focus();
 
     const Glib::ustring& get_status() const;
@@ -127,17 +294,74 @@ namespace selain
       return m_signal_status_changed;
     }
 
+    inline find_status_changed_signal_type& signal_find_status_changed()
+    {
+      return m_signal_find_status_changed;
+    }
+
+    inline const find_status_changed_signal_type&
+    signal_find_status_changed() const
+    {
+      return m_signal_find_status_changed;
+    }
+
+    inline blocked_count_changed_signal_type& signal_blocked_count_changed()
+    {
+      return m_signal_blocked_count_changed;
+    }
+
+    inline const blocked_count_changed_signal_type&
+    signal_blocked_count_changed() const
+    {
+      return m_signal_blocked_count_changed;
+    }
+
+    inline label_changed_signal_type& signal_label_changed()
+    {
+      return m_signal_label_changed;
+    }
+
+    inline const label_changed_signal_type& signal_label_changed() const
+    {
+      return m_signal_label_changed;
+    }
+
   private:
-    void on_close_button_clicked();
+    void install_web_settings(const Glib::RefPtr<WebSettings>& settings);
+    bool on_snapshot_draw(const Cairo::RefPtr<Cairo::Context>& cr);
+    bool on_web_view_draw(const Cairo::RefPtr<Cairo::Context>& cr);
+    void initialize_find();
+    void initialize_performance_observer();
 
   private:
+    const ::guint m_id;
     Glib::RefPtr<HintContext> m_hint_context;
-    TabLabel m_tab_label;
+    ResourceLog m_resource_log;
+    Glib::ustring m_label_text;
+    Glib::RefPtr<Gdk::Pixbuf> m_icon;
+    Glib::RefPtr<WebContext> m_web_context;
+    SettingsProfile m_profile;
+    Glib::RefPtr<WebSettings> m_web_settings;
     ::WebKitWebView* m_web_view;
     Glib::RefPtr<Gtk::Widget> m_web_view_widget;
+    Gtk::Overlay m_overlay;
+    Gtk::DrawingArea m_snapshot_area;
+    Cairo::RefPtr<Cairo::ImageSurface> m_snapshot;
+    sigc::connection m_web_view_draw_connection;
+    sigc::connection m_snapshot_idle_connection;
     Glib::ustring m_status;
     Glib::ustring m_permanent_status;
+    Glib::ustring m_find_text;
+    bool m_find_forwards;
+    bool m_find_regex;
+    bool m_find_complete;
+    ::guint m_find_match_index;
+    ::guint m_find_match_count;
+    ::guint m_blocked_count;
     status_changed_signal_type m_signal_status_changed;
+    find_status_changed_signal_type m_signal_find_status_changed;
+    blocked_count_changed_signal_type m_signal_blocked_count_changed;
+    label_changed_signal_type m_signal_label_changed;
   };
 }
 
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_TEXT_INDEX_HPP_GUARD
+#define SELAIN_TEXT_INDEX_HPP_GUARD
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <glibmm.h>
+
+namespace selain
+{
+  class TextIndexSegment;
+  class TextIndexSegmentWriter;
+
+  /**
+   * Single page matching a full-text search.
+   */
+  struct TextSearchResult
+  {
+    std::string uri;
+    std::string title;
+    double score;
+  };
+
+  /**
+   * Persistent full-text index of the contents of visited pages.
+   *
+   * Pages are tokenized by a background thread into an in-memory buffer,
+   * which is periodically written to disk as an immutable segment. Each
+   * segment contains a sorted term dictionary and delta and varint
+   * compressed posting lists with skip pointers. Small segments are merged
+   * into larger ones as they accumulate, and the oldest pages are dropped
+   * once the index exceeds it's disk budget. When a page is indexed again,
+   * it's previous version is dropped during the next merge.
+   *
+   * All methods are thread safe.
+   */
+  class TextIndex
+  {
+  public:
+    using search_callback_type = std::function<void(
+      const std::vector<TextSearchResult>&,
+      const std::string&
+    )>;
+
+    explicit TextIndex();
+    ~TextIndex();
+
+    TextIndex(const TextIndex&) = delete;
+    TextIndex& operator=(const TextIndex&) = delete;
+
+    /**
+     * Starts the background thread which loads segments from given
+     * directory and writes new ones into it.
+     *
+     * \param directory   Directory where the segments are stored.
+     * \param disk_budget Maximum total size of the segments in bytes.
+     */
+    void open(const std::string& directory, std::uint64_t disk_budget);
+
+    /**
+     * Schedules text content of given page to be indexed. Pages added
+     * before open() are indexed once the index has been opened.
+     */
+    void add_document(
+      const std::string& uri,
+      const std::string& title,
+      const std::string& text
+    );
+
+    /**
+     * Searches for pages which contain all words of given query, in a
+     * background thread. Callback is invoked in the main loop with given
+     * number of best matches, ordered by their relevance, and an error
+     * message which is empty on success. Searches made before open() are
+     * executed once the index has been opened.
+     */
+    void search(
+      const std::string& query,
+      std::size_t limit,
+      const search_callback_type& callback
+    );
+
+  private:
+    struct Document
+    {
+      std::uint32_t id;
+      std::uint32_t length;
+      std::string uri;
+      std::string title;
+    };
+
+    struct Posting
+    {
+      std::uint32_t document;
+      std::uint32_t frequency;
+    };
+
+    struct PendingDocument
+    {
+      std::string uri;
+      std::string title;
+      std::string text;
+    };
+
+    struct PendingSearch
+    {
+      std::string query;
+      std::size_t limit;
+      search_callback_type callback;
+    };
+
+    struct FinishedSearch
+    {
+      search_callback_type callback;
+      std::vector<TextSearchResult> results;
+      std::string error;
+    };
+
+    void run();
+    void on_search_finished();
+    void load();
+    void index_document(const PendingDocument& document);
+    std::vector<TextSearchResult> execute_search(
+      const std::string& query,
+      std::size_t limit
+    );
+    void flush();
+    void merge_segments();
+    void enforce_budget();
+    void write_buffer(TextIndexSegmentWriter& writer) const;
+    std::unique_ptr<TextIndexSegment> write_segment(
+      const std::function<void(TextIndexSegmentWriter&)>& callback
+    );
+    std::unique_ptr<TextIndexSegment> merge(
+      const std::vector<const TextIndexSegment*>& segments,
+      std::uint32_t min_document
+    );
+    void replace_segments(
+      std::size_t index,
+      std::size_t count,
+      std::unique_ptr<TextIndexSegment>&& replacement
+    );
+    void forget_documents(const TextIndexSegment& segment);
+    bool is_live(std::uint32_t document, const std::string& uri) const;
+
+  private:
+    std::string m_directory;
+    std::uint64_t m_disk_budget;
+    std::vector<std::unique_ptr<TextIndexSegment>> m_segments;
+    std::uint32_t m_next_generation;
+    std::uint32_t m_next_document;
+    /** Latest indexed version of each page. */
+    std::unordered_map<std::string, std::uint32_t> m_latest;
+    std::vector<Document> m_buffer_documents;
+    std::unordered_map<std::string, std::vector<Posting>> m_buffer_postings;
+    std::size_t m_buffer_size;
+    std::deque<PendingDocument> m_queue;
+    std::deque<PendingSearch> m_searches;
+    /** Results waiting to be delivered in the main loop. */
+    std::deque<FinishedSearch> m_results;
+    /** Whether segments could be loaded from the directory. */
+    bool m_loaded;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::thread m_thread;
+    Glib::Dispatcher m_dispatcher;
+    bool m_running;
+  };
+}
+
+#endif /* !SELAIN_TEXT_INDEX_HPP_GUARD */
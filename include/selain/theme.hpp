@@ -42,6 +42,8 @@ namespace selain
     extern const Gdk::RGBA mode_bar_normal_foreground;
     extern const Gdk::RGBA mode_bar_insert_background;
     extern const Gdk::RGBA mode_bar_insert_foreground;
+    extern const Gdk::RGBA tab_background;
+    extern const Gdk::RGBA tab_active_background;
 
     const Glib::RefPtr<Gtk::CssProvider>& get_status_bar_style_provider();
     const Glib::RefPtr<Gtk::CssProvider>& get_command_entry_style_provider();
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SELAIN_TRACE_HPP_GUARD
+#define SELAIN_TRACE_HPP_GUARD
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <glib.h>
+
+namespace selain
+{
+  /**
+   * Records spans of time spent in key parts of the UI process, which can
+   * be exported as Chrome trace event JSON and opened in a trace viewer.
+   *
+   * Each thread records into it's own ring buffer, so only the most recent
+   * events are kept. When tracing is disabled, a span costs a single atomic
+   * load.
+   */
+  namespace trace
+  {
+    /** Maximum number of events kept for each thread. */
+    static constexpr std::size_t BUFFER_CAPACITY = 65536;
+
+    extern std::atomic<bool> enabled;
+
+    inline bool is_enabled()
+    {
+      return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Starts recording events, discarding previously recorded ones.
+     */
+    void start();
+
+    /**
+     * Stops recording events. Recorded events are kept until tracing is
+     * started again.
+     */
+    void stop();
+
+    /**
+     * Records event with given name, which started at given monotonic time
+     * and lasted for given duration, both in microseconds. Name must be a
+     * string literal or otherwise outlive the trace.
+     */
+    void record(const char* name, std::int64_t start, std::int64_t duration);
+
+    /**
+     * Writes the recorded events into given file as Chrome trace event
+     * JSON. Returns false and sets the error message if the file cannot be
+     * written.
+     */
+    bool write(const std::string& path, std::string& error);
+
+    /**
+     * Starts tracing and writes the recorded events into given file when
+     * the process exits.
+     */
+    void write_on_exit(const std::string& path);
+
+    /**
+     * Records time from it's construction to it's destruction, if tracing
+     * is enabled when constructed.
+     */
+    class Span
+    {
+    public:
+      explicit Span(const char* name)
+        : m_name(is_enabled() ? name : nullptr)
+        , m_start(m_name ? ::g_get_monotonic_time() : 0) {}
+
+      ~Span()
+      {
+        if (m_name)
+        {
+          record(m_name, m_start, ::g_get_monotonic_time() - m_start);
+        }
+      }
+
+      Span(const Span&) = delete;
+      Span& operator=(const Span&) = delete;
+
+    private:
+      const char* m_name;
+      const std::int64_t m_start;
+    };
+  }
+}
+
+#endif /* !SELAIN_TRACE_HPP_GUARD */
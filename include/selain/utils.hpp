@@ -29,6 +29,8 @@
 #include <pangomm.h>
 
 #include <cctype>
+#include <cstdint>
+#include <string>
 
 namespace selain
 {
@@ -39,6 +41,37 @@ namespace selain
      */
     const Pango::FontDescription& get_monospace_font();
 
+    /**
+     * Converts given string into JavaScript string literal that can be safely
+     * embedded into script source code.
+     */
+    Glib::ustring js_quote(const Glib::ustring& input);
+
+    /**
+     * Returns path of a file with given name inside the directory where
+     * Selain stores it's persistent data. The directory is created if it does
+     * not exist yet.
+     */
+    std::string get_data_file_path(const std::string& name);
+
+    /**
+     * Replaces tilde in the beginning of given path with the home directory
+     * of the user.
+     */
+    std::string expand_path(const std::string& path);
+
+    /**
+     * Parses size in bytes from given string, which may be followed by one of
+     * the suffixes "K", "M" or "G" (binary multiples). Returns false if the
+     * string cannot be parsed.
+     */
+    bool parse_size(const std::string& input, std::uint64_t& result);
+
+    /**
+     * Formats given size in bytes into human readable form.
+     */
+    std::string format_size(std::uint64_t size);
+
     /**
      * Strips whitespace from beginning and of end of given string and returns
      * result.
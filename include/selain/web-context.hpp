@@ -26,8 +26,13 @@
 #ifndef SELAIN_WEB_CONTEXT_HPP_GUARD
 #define SELAIN_WEB_CONTEXT_HPP_GUARD
 
-#include <glibmm.h>
-#include <webkit2/webkit2.h>
+#include <memory>
+#include <unordered_map>
+
+#include <selain/content-filter.hpp>
+#include <selain/disk-cache.hpp>
+#include <selain/download-manager.hpp>
+#include <selain/internal-page.hpp>
 
 namespace selain
 {
@@ -37,21 +42,119 @@ namespace selain
   class WebContext : public Glib::ObjectBase
   {
   public:
+    /** Default maximum size of the HTTP disk cache. */
+    static constexpr std::uint64_t DEFAULT_DISK_CACHE_QUOTA =
+      256 * 1024 * 1024;
+
     /**
      * Constructs new web context instance.
      */
     static Glib::RefPtr<WebContext> create();
 
     /**
-     * Creates new web view using the wrapped web context.
+     * Performs initialization which is not needed before the first page is
+     * loaded: compiling or loading the content filter and checking the
+     * disk cache against it's quota.
+     */
+    void initialize_deferred();
+
+    /**
+     * Creates new web view using the wrapped web context. Each web view has
+     * it's own user content manager, with the content filter installed.
      */
     ::WebKitWebView* create_web_view();
 
+    /**
+     * Enables or disables blocking of web fonts and media in given web view,
+     * which must have been created by create_web_view(). Used by tabs with
+     * the lite settings profile.
+     */
+    void set_lite(::WebKitWebView* web_view, bool lite);
+
+    /**
+     * Registers handler for page of the internal "selain:" URI scheme with
+     * given name, e.g. "start" for "selain://start".
+     */
+    void register_internal_page(
+      const std::string& name,
+      const internal_page_handler_type& handler
+    );
+
+    /**
+     * Returns the cache model which determines how aggressively resources
+     * are cached in memory and on disk.
+     */
+    ::WebKitCacheModel get_cache_model() const;
+
+    /**
+     * Sets the cache model which determines how aggressively resources are
+     * cached in memory and on disk.
+     */
+    void set_cache_model(::WebKitCacheModel model);
+
+    /**
+     * Parses cache model from it's name, which is one of "document-viewer",
+     * "web-browser" or "document-browser". Returns false if the name is
+     * not recognized.
+     */
+    static bool parse_cache_model(
+      const std::string& name,
+      ::WebKitCacheModel& model
+    );
+
+    /**
+     * Returns name of given cache model.
+     */
+    static const char* get_cache_model_name(::WebKitCacheModel model);
+
+    /**
+     * Sets maximum size of the HTTP disk cache in bytes. Zero removes the
+     * limit. The quota is enforced once deferred initialization has been
+     * performed.
+     */
+    void set_disk_cache_quota(std::uint64_t quota);
+
+    /**
+     * Returns the HTTP disk cache of the web context.
+     */
+    inline DiskCache& get_disk_cache()
+    {
+      return *m_disk_cache;
+    }
+
+    /**
+     * Returns the HTTP disk cache of the web context.
+     */
+    inline const DiskCache& get_disk_cache() const
+    {
+      return *m_disk_cache;
+    }
+
+    /**
+     * Returns the download manager which takes care of downloads started
+     * from the web views of the web context.
+     */
+    inline DownloadManager& get_download_manager()
+    {
+      return *m_download_manager;
+    }
+
   private:
     explicit WebContext();
 
+    static void on_internal_request(
+      ::WebKitURISchemeRequest* request,
+      ::gpointer data
+    );
+
   private:
     ::WebKitWebContext* m_context;
+    std::unique_ptr<DiskCache> m_disk_cache;
+    std::unique_ptr<ContentFilter> m_content_filter;
+    std::unique_ptr<DownloadManager> m_download_manager;
+    std::uint64_t m_disk_cache_quota;
+    bool m_initialized;
+    std::unordered_map<std::string, internal_page_handler_type> m_pages;
   };
 }
 
@@ -26,11 +26,27 @@
 #ifndef SELAIN_WEB_SETTINGS_HPP_GUARD
 #define SELAIN_WEB_SETTINGS_HPP_GUARD
 
+#include <string>
+
 #include <glibmm.h>
 #include <webkit2/webkit2.h>
 
 namespace selain
 {
+  /**
+   * Enumeration of settings profiles which a tab can be using.
+   */
+  enum class SettingsProfile
+  {
+    /** Profile used by tabs by default. */
+    NORMAL,
+    /**
+     * Cheaper rendering mode where scripts of the page, images, web fonts,
+     * WebGL and media are disabled.
+     */
+    LITE
+  };
+
   /**
    * Wrapper for the WebKitSettings type.
    */
@@ -40,14 +56,35 @@ namespace selain
     /**
      * Constructs new web settings instance.
      */
-    static Glib::RefPtr<WebSettings> create();
+    static Glib::RefPtr<WebSettings> create(
+      SettingsProfile profile = SettingsProfile::NORMAL
+    );
+
+    /**
+     * Returns the profile of these settings.
+     */
+    inline SettingsProfile get_profile() const
+    {
+      return m_profile;
+    }
 
     void install(::WebKitWebView* view);
 
+    /**
+     * Sets property of the WebKit settings with given name, such as
+     * "enable-javascript" or "hardware-acceleration-policy", from it's
+     * textual representation. Empty value resets the property to the
+     * value it had when the settings were created. Returns false if there
+     * is no such property or the value is not valid for it. Properties
+     * forced by the profile are left untouched.
+     */
+    bool apply(const std::string& name, const std::string& value);
+
   private:
-    explicit WebSettings();
+    explicit WebSettings(SettingsProfile profile);
 
   private:
+    const SettingsProfile m_profile;
     ::WebKitSettings* m_settings;
   };
 }
@@ -0,0 +1,1727 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/bookmarks.hpp>
+#include <selain/utils.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <string_view>
+#include <thread>
+
+namespace selain
+{
+  static const char FILE_MAGIC[8] = { 'S', 'E', 'L', 'A', 'I', 'N', 'B', 'M' };
+
+  // Version of the bookmark file format. Files with other versions are
+  // ignored.
+  static const std::uint32_t FILE_VERSION = 1;
+
+  // Changes are written into a new version of the bookmark file once the
+  // write-ahead log contains this many records.
+  static const std::size_t CHECKPOINT_RECORDS = 512;
+
+  // Size of the chunks in which HTML bookmark exports are read.
+  static const std::size_t IMPORT_CHUNK_SIZE = 64 * 1024;
+
+  // Number of bookmarks copied at a time while iterating them.
+  static const std::size_t ITERATION_CHUNK_SIZE = 256;
+
+  static const std::uint32_t NOT_FOUND =
+    std::numeric_limits<std::uint32_t>::max();
+
+  namespace
+  {
+    /**
+     * Header of the bookmark file. Offsets of the sections are relative to
+     * the beginning of the file, while offsets of the strings are relative
+     * to the beginning of the string section.
+     */
+    struct FileHeader
+    {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t entry_count;
+      std::uint32_t tag_count;
+      std::uint32_t quickmark_count;
+      std::uint32_t entry_tag_count;
+      std::uint32_t posting_count;
+      std::uint64_t entries_offset;
+      /** Indexes of the entries, sorted by their URI. */
+      std::uint64_t uri_index_offset;
+      /** Indexes of the tags of each entry. */
+      std::uint64_t entry_tags_offset;
+      /** Tags sorted by their name. */
+      std::uint64_t tags_offset;
+      /** Indexes of the entries which have each tag. */
+      std::uint64_t postings_offset;
+      /** Quickmarks sorted by their name. */
+      std::uint64_t quickmarks_offset;
+      std::uint64_t strings_offset;
+      std::uint64_t strings_length;
+    };
+
+    struct FileEntry
+    {
+      std::uint32_t uri_offset;
+      std::uint32_t uri_length;
+      std::uint32_t title_offset;
+      std::uint32_t title_length;
+      std::uint32_t tags_offset;
+      std::uint32_t tag_count;
+      std::int64_t added;
+    };
+
+    struct FileTag
+    {
+      std::uint32_t name_offset;
+      std::uint32_t name_length;
+      std::uint32_t postings_offset;
+      std::uint32_t posting_count;
+    };
+
+    struct FileQuickmark
+    {
+      std::uint32_t name_offset;
+      std::uint32_t name_length;
+      std::uint32_t uri_offset;
+      std::uint32_t uri_length;
+    };
+  }
+
+  template<class T>
+  static inline const T*
+  get_section(const char* data, std::uint64_t offset)
+  {
+    return reinterpret_cast<const T*>(data + offset);
+  }
+
+  static inline const FileHeader*
+  get_header(const char* data)
+  {
+    return get_section<FileHeader>(data, 0);
+  }
+
+  static inline std::string_view
+  get_string(const char* data, std::uint32_t offset, std::uint32_t length)
+  {
+    const auto header = get_header(data);
+
+    if (static_cast<std::uint64_t>(offset) + length > header->strings_length)
+    {
+      return std::string_view();
+    }
+
+    return std::string_view(data + header->strings_offset + offset, length);
+  }
+
+  template<class T>
+  static inline bool
+  is_valid_section(std::size_t length,
+                   std::uint64_t offset,
+                   std::uint64_t count)
+  {
+    return offset <= length
+      && !(offset % alignof(T))
+      && count <= (length - offset) / sizeof(T);
+  }
+
+  /**
+   * Validates the header of a mapped bookmark file. Contents of the
+   * sections are validated lazily when they are accessed.
+   */
+  static bool
+  is_valid_file(const char* data, std::size_t length)
+  {
+    const FileHeader* header;
+
+    if (!data || length < sizeof(FileHeader))
+    {
+      return false;
+    }
+    header = get_header(data);
+
+    return !std::memcmp(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC))
+      && header->version == FILE_VERSION
+      && is_valid_section<FileEntry>(
+        length,
+        header->entries_offset,
+        header->entry_count
+      )
+      && is_valid_section<std::uint32_t>(
+        length,
+        header->uri_index_offset,
+        header->entry_count
+      )
+      && is_valid_section<std::uint32_t>(
+        length,
+        header->entry_tags_offset,
+        header->entry_tag_count
+      )
+      && is_valid_section<FileTag>(
+        length,
+        header->tags_offset,
+        header->tag_count
+      )
+      && is_valid_section<std::uint32_t>(
+        length,
+        header->postings_offset,
+        header->posting_count
+      )
+      && is_valid_section<FileQuickmark>(
+        length,
+        header->quickmarks_offset,
+        header->quickmark_count
+      )
+      && is_valid_section<char>(
+        length,
+        header->strings_offset,
+        header->strings_length
+      );
+  }
+
+  static std::uint32_t
+  checksum(const char* data, std::size_t length)
+  {
+    // 32-bit FNV-1a.
+    std::uint32_t hash = 2166136261u;
+
+    for (std::size_t i = 0; i < length; ++i)
+    {
+      hash ^= static_cast<unsigned char>(data[i]);
+      hash *= 16777619u;
+    }
+
+    return hash;
+  }
+
+  static inline void
+  append_uint32(std::string& output, std::uint32_t value)
+  {
+    output.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  static inline std::uint32_t
+  read_uint32(const char* data)
+  {
+    std::uint32_t value;
+
+    std::memcpy(&value, data, sizeof(value));
+
+    return value;
+  }
+
+  /**
+   * Encodes record of the write-ahead log. Each record consists of it's
+   * length, a checksum and a payload, which consists of the record type and
+   * length prefixed fields.
+   */
+  static std::string
+  encode_record(char type, const std::vector<std::string>& fields)
+  {
+    std::string payload(1, type);
+    std::string record;
+
+    for (const auto& field : fields)
+    {
+      append_uint32(payload, static_cast<std::uint32_t>(field.length()));
+      payload.append(field);
+    }
+    append_uint32(record, static_cast<std::uint32_t>(payload.length()));
+    append_uint32(record, checksum(payload.data(), payload.length()));
+    record.append(payload);
+
+    return record;
+  }
+
+  static bool
+  decode_fields(const std::string& payload, std::vector<std::string>& fields)
+  {
+    std::size_t position = 1;
+
+    fields.clear();
+    while (position < payload.length())
+    {
+      std::uint32_t length;
+
+      if (payload.length() - position < sizeof(length))
+      {
+        return false;
+      }
+      length = read_uint32(payload.data() + position);
+      position += sizeof(length);
+      if (payload.length() - position < length)
+      {
+        return false;
+      }
+      fields.push_back(payload.substr(position, length));
+      position += length;
+    }
+
+    return true;
+  }
+
+  static std::string
+  encode_bookmark(const Bookmark& bookmark)
+  {
+    std::vector<std::string> fields = {
+      bookmark.uri,
+      bookmark.title,
+      std::to_string(bookmark.added),
+    };
+
+    fields.insert(
+      std::end(fields),
+      std::begin(bookmark.tags),
+      std::end(bookmark.tags)
+    );
+
+    return encode_record('A', fields);
+  }
+
+  /**
+   * Replaces whitespace in given tag with dashes, so that it can be given
+   * as a command argument.
+   */
+  static std::string
+  normalize_tag(const std::string& tag)
+  {
+    auto result = utils::string_trim(tag);
+
+    std::replace_if(
+      std::begin(result),
+      std::end(result),
+      [](const char c)
+      {
+        return std::isspace(static_cast<unsigned char>(c));
+      },
+      '-'
+    );
+
+    return result;
+  }
+
+  static void
+  normalize_tags(std::vector<std::string>& tags)
+  {
+    for (auto& tag : tags)
+    {
+      tag = normalize_tag(tag);
+    }
+    tags.erase(
+      std::remove(std::begin(tags), std::end(tags), std::string()),
+      std::end(tags)
+    );
+    std::sort(std::begin(tags), std::end(tags));
+    tags.erase(std::unique(std::begin(tags), std::end(tags)), std::end(tags));
+  }
+
+  template<class T>
+  static inline bool
+  write_section(std::FILE* file, const std::vector<T>& section)
+  {
+    return section.empty() || std::fwrite(
+      section.data(),
+      sizeof(T),
+      section.size(),
+      file
+    ) == section.size();
+  }
+
+  static bool
+  is_same_bookmark(const Bookmark& a, const Bookmark& b)
+  {
+    return a.uri == b.uri
+      && a.title == b.title
+      && a.tags == b.tags
+      && a.added == b.added;
+  }
+
+  /**
+   * Writes given bookmarks and quickmarks into a new bookmark file.
+   */
+  static bool
+  write_file(const std::string& path,
+             const std::vector<Bookmark>& bookmarks,
+             const std::vector<Bookmarks::quickmark_type>& quickmarks)
+  {
+    FileHeader header;
+    std::string strings;
+    std::vector<FileEntry> entries;
+    std::vector<std::uint32_t> uri_index;
+    std::vector<std::uint32_t> entry_tags;
+    std::vector<FileTag> tags;
+    std::vector<std::uint32_t> postings;
+    std::vector<FileQuickmark> file_quickmarks;
+    std::map<std::string, std::vector<std::uint32_t>> tag_postings;
+    std::unordered_map<std::string, std::uint32_t> tag_ids;
+    std::FILE* file;
+    bool success;
+    const auto add_string = [&strings](const std::string& input)
+    {
+      const auto offset = static_cast<std::uint32_t>(strings.length());
+
+      strings.append(input);
+
+      return offset;
+    };
+
+    for (std::uint32_t i = 0; i < bookmarks.size(); ++i)
+    {
+      for (const auto& tag : bookmarks[i].tags)
+      {
+        tag_postings[tag].push_back(i);
+      }
+    }
+    for (const auto& entry : tag_postings)
+    {
+      tag_ids[entry.first] = static_cast<std::uint32_t>(tags.size());
+      tags.push_back({
+        add_string(entry.first),
+        static_cast<std::uint32_t>(entry.first.length()),
+        static_cast<std::uint32_t>(postings.size()),
+        static_cast<std::uint32_t>(entry.second.size())
+      });
+      postings.insert(
+        std::end(postings),
+        std::begin(entry.second),
+        std::end(entry.second)
+      );
+    }
+
+    entries.reserve(bookmarks.size());
+    uri_index.reserve(bookmarks.size());
+    for (std::uint32_t i = 0; i < bookmarks.size(); ++i)
+    {
+      const auto& bookmark = bookmarks[i];
+
+      entries.push_back({
+        add_string(bookmark.uri),
+        static_cast<std::uint32_t>(bookmark.uri.length()),
+        add_string(bookmark.title),
+        static_cast<std::uint32_t>(bookmark.title.length()),
+        static_cast<std::uint32_t>(entry_tags.size()),
+        static_cast<std::uint32_t>(bookmark.tags.size()),
+        bookmark.added
+      });
+      for (const auto& tag : bookmark.tags)
+      {
+        entry_tags.push_back(tag_ids[tag]);
+      }
+      uri_index.push_back(i);
+    }
+    std::sort(
+      std::begin(uri_index),
+      std::end(uri_index),
+      [&bookmarks](std::uint32_t a, std::uint32_t b)
+      {
+        return bookmarks[a].uri < bookmarks[b].uri;
+      }
+    );
+
+    for (const auto& quickmark : quickmarks)
+    {
+      file_quickmarks.push_back({
+        add_string(quickmark.first),
+        static_cast<std::uint32_t>(quickmark.first.length()),
+        add_string(quickmark.second),
+        static_cast<std::uint32_t>(quickmark.second.length())
+      });
+    }
+
+    if (strings.length() > std::numeric_limits<std::uint32_t>::max())
+    {
+      return false;
+    }
+
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.entry_count = static_cast<std::uint32_t>(entries.size());
+    header.tag_count = static_cast<std::uint32_t>(tags.size());
+    header.quickmark_count = static_cast<std::uint32_t>(
+      file_quickmarks.size()
+    );
+    header.entry_tag_count = static_cast<std::uint32_t>(entry_tags.size());
+    header.posting_count = static_cast<std::uint32_t>(postings.size());
+    header.entries_offset = sizeof(FileHeader);
+    header.uri_index_offset = header.entries_offset
+      + entries.size() * sizeof(FileEntry);
+    header.entry_tags_offset = header.uri_index_offset
+      + uri_index.size() * sizeof(std::uint32_t);
+    header.tags_offset = header.entry_tags_offset
+      + entry_tags.size() * sizeof(std::uint32_t);
+    header.postings_offset = header.tags_offset
+      + tags.size() * sizeof(FileTag);
+    header.quickmarks_offset = header.postings_offset
+      + postings.size() * sizeof(std::uint32_t);
+    header.strings_offset = header.quickmarks_offset
+      + file_quickmarks.size() * sizeof(FileQuickmark);
+    header.strings_length = strings.length();
+
+    if (!(file = std::fopen(path.c_str(), "wb")))
+    {
+      return false;
+    }
+    success = std::fwrite(&header, sizeof(header), 1, file) == 1
+      && write_section(file, entries)
+      && write_section(file, uri_index)
+      && write_section(file, entry_tags)
+      && write_section(file, tags)
+      && write_section(file, postings)
+      && write_section(file, file_quickmarks)
+      && std::fwrite(strings.data(), 1, strings.length(), file)
+        == strings.length()
+      && !std::fflush(file)
+      && !::fsync(::fileno(file));
+
+    return !std::fclose(file) && success;
+  }
+
+  /**
+   * Streaming parser for the Netscape bookmark file format, which is used
+   * by all major browsers to export their bookmarks. Names of the folders
+   * containing the bookmarks are used as their tags, in addition to the
+   * tags exported by Firefox.
+   */
+  class HtmlBookmarkParser
+  {
+  public:
+    explicit HtmlBookmarkParser(std::vector<Bookmark>& bookmarks)
+      : m_bookmarks(bookmarks)
+      , m_in_tag(false)
+      , m_quote(0)
+      , m_in_anchor(false)
+      , m_in_heading(false) {}
+
+    void feed(const char* data, std::size_t length)
+    {
+      for (std::size_t i = 0; i < length; ++i)
+      {
+        const auto c = data[i];
+
+        if (!m_in_tag)
+        {
+          if (c == '<')
+          {
+            m_in_tag = true;
+            m_tag.clear();
+          }
+          else if (m_in_anchor || m_in_heading)
+          {
+            m_text.append(1, c);
+          }
+        }
+        else if (m_quote)
+        {
+          if (c == m_quote)
+          {
+            m_quote = 0;
+          }
+          m_tag.append(1, c);
+        }
+        else if (c == '>')
+        {
+          m_in_tag = false;
+          on_tag();
+        } else {
+          if (c == '"' || c == '\'')
+          {
+            m_quote = c;
+          }
+          m_tag.append(1, c);
+        }
+      }
+    }
+
+  private:
+    void on_tag()
+    {
+      std::string name;
+      std::unordered_map<std::string, std::string> attributes;
+
+      parse_tag(name, attributes);
+      if (name == "a")
+      {
+        m_in_anchor = true;
+        m_text.clear();
+        m_bookmark.uri = decode_entities(attributes["href"]);
+        m_bookmark.added = std::strtoll(
+          attributes["add_date"].c_str(),
+          nullptr,
+          10
+        );
+        m_bookmark.tags.clear();
+        split_tags(decode_entities(attributes["tags"]));
+      }
+      else if (name == "/a" && m_in_anchor)
+      {
+        m_in_anchor = false;
+        if (!is_importable(m_bookmark.uri))
+        {
+          return;
+        }
+        m_bookmark.title = decode_entities(utils::string_trim(m_text));
+        for (const auto& folder : m_folders)
+        {
+          m_bookmark.tags.push_back(folder);
+        }
+        normalize_tags(m_bookmark.tags);
+        if (!m_bookmark.added)
+        {
+          m_bookmark.added = static_cast<std::int64_t>(std::time(nullptr));
+        }
+        m_bookmarks.push_back(m_bookmark);
+      }
+      else if (name == "h3")
+      {
+        m_in_heading = true;
+        m_text.clear();
+      }
+      else if (name == "/h3" && m_in_heading)
+      {
+        m_in_heading = false;
+        m_folder = decode_entities(utils::string_trim(m_text));
+      }
+      else if (name == "dl")
+      {
+        m_folders.push_back(m_folder);
+        m_folder.clear();
+      }
+      else if (name == "/dl" && !m_folders.empty())
+      {
+        m_folders.pop_back();
+      }
+    }
+
+    void parse_tag(std::string& name,
+                   std::unordered_map<std::string, std::string>& attributes)
+    {
+      const auto length = m_tag.length();
+      std::size_t i = 0;
+
+      while (i < length && !std::isspace(static_cast<unsigned char>(m_tag[i])))
+      {
+        name.append(1, std::tolower(static_cast<unsigned char>(m_tag[i++])));
+      }
+      while (i < length)
+      {
+        std::string attribute;
+        std::string value;
+
+        while (i < length
+            && std::isspace(static_cast<unsigned char>(m_tag[i])))
+        {
+          ++i;
+        }
+        while (i < length
+            && m_tag[i] != '='
+            && !std::isspace(static_cast<unsigned char>(m_tag[i])))
+        {
+          attribute.append(
+            1,
+            std::tolower(static_cast<unsigned char>(m_tag[i++]))
+          );
+        }
+        if (i < length && m_tag[i] == '=')
+        {
+          ++i;
+          if (i < length && (m_tag[i] == '"' || m_tag[i] == '\''))
+          {
+            const auto quote = m_tag[i++];
+
+            while (i < length && m_tag[i] != quote)
+            {
+              value.append(1, m_tag[i++]);
+            }
+            ++i;
+          } else {
+            while (i < length
+                && !std::isspace(static_cast<unsigned char>(m_tag[i])))
+            {
+              value.append(1, m_tag[i++]);
+            }
+          }
+        }
+        if (!attribute.empty())
+        {
+          attributes[attribute] = value;
+        }
+      }
+    }
+
+    void split_tags(const std::string& input)
+    {
+      std::string::size_type start = 0;
+      std::string::size_type end;
+
+      if (input.empty())
+      {
+        return;
+      }
+      while ((end = input.find(',', start)) != std::string::npos)
+      {
+        m_bookmark.tags.push_back(input.substr(start, end - start));
+        start = end + 1;
+      }
+      m_bookmark.tags.push_back(input.substr(start));
+    }
+
+    static bool is_importable(const std::string& uri)
+    {
+      return !uri.empty()
+        && uri.compare(0, 6, "place:")
+        && uri.compare(0, 11, "javascript:");
+    }
+
+    static std::string decode_entities(const std::string& input)
+    {
+      std::string result;
+      std::string::size_type position = 0;
+      std::string::size_type start;
+
+      while ((start = input.find('&', position)) != std::string::npos)
+      {
+        const auto end = input.find(';', start);
+        std::string entity;
+
+        result.append(input, position, start - position);
+        if (end == std::string::npos || end - start > 10)
+        {
+          result.append(1, '&');
+          position = start + 1;
+          continue;
+        }
+        entity = input.substr(start + 1, end - start - 1);
+        position = end + 1;
+        if (entity == "amp")
+        {
+          result.append(1, '&');
+        }
+        else if (entity == "lt")
+        {
+          result.append(1, '<');
+        }
+        else if (entity == "gt")
+        {
+          result.append(1, '>');
+        }
+        else if (entity == "quot")
+        {
+          result.append(1, '"');
+        }
+        else if (entity == "apos")
+        {
+          result.append(1, '\'');
+        }
+        else if (entity.length() > 1 && entity[0] == '#')
+        {
+          const auto hex = entity[1] == 'x' || entity[1] == 'X';
+          const auto c = std::strtoul(
+            entity.c_str() + (hex ? 2 : 1),
+            nullptr,
+            hex ? 16 : 10
+          );
+          char buffer[6];
+
+          if (c && ::g_unichar_validate(static_cast<::gunichar>(c)))
+          {
+            result.append(buffer, ::g_unichar_to_utf8(
+              static_cast<::gunichar>(c),
+              buffer
+            ));
+          }
+        } else {
+          result.append(input, start, end - start + 1);
+        }
+      }
+      result.append(input, position, std::string::npos);
+
+      return result;
+    }
+
+  private:
+    std::vector<Bookmark>& m_bookmarks;
+    std::string m_tag;
+    std::string m_text;
+    std::string m_folder;
+    std::vector<std::string> m_folders;
+    Bookmark m_bookmark;
+    bool m_in_tag;
+    char m_quote;
+    bool m_in_anchor;
+    bool m_in_heading;
+  };
+
+  static void
+  read_bookmark_html(const std::string& path,
+                     std::vector<Bookmark>& bookmarks,
+                     std::string& error)
+  {
+    std::ifstream input(path, std::ios::binary);
+    std::vector<char> buffer(IMPORT_CHUNK_SIZE);
+    HtmlBookmarkParser parser(bookmarks);
+
+    if (!input.good())
+    {
+      error = "Unable to open " + path;
+      return;
+    }
+    while (input.read(buffer.data(), buffer.size()) || input.gcount() > 0)
+    {
+      parser.feed(buffer.data(), static_cast<std::size_t>(input.gcount()));
+    }
+    if (input.bad())
+    {
+      error = "Unable to read " + path;
+    }
+  }
+
+  Bookmarks::Bookmarks()
+    : m_mapped_file(nullptr)
+    , m_data(nullptr)
+    , m_length(0)
+    , m_size(0)
+    , m_log(nullptr)
+    , m_log_record_count(0)
+    , m_running(false)
+    , m_import_count(0)
+  {
+    m_import_dispatcher.connect(
+      sigc::mem_fun(this, &Bookmarks::on_import_finished)
+    );
+  }
+
+  Bookmarks::~Bookmarks()
+  {
+    // Import has to finish first, as it queues records for the log thread.
+    if (m_import_thread.joinable())
+    {
+      m_import_thread.join();
+    }
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      m_running = false;
+    }
+    m_condition.notify_one();
+    if (m_thread.joinable())
+    {
+      m_thread.join();
+    }
+
+    // All changes are already in the log, so a new version of the file is
+    // only written when the log has grown large enough to slow down the
+    // next start.
+    if (m_log_record_count >= CHECKPOINT_RECORDS)
+    {
+      checkpoint();
+    }
+    if (m_log)
+    {
+      std::fclose(m_log);
+    }
+    unmap_file();
+  }
+
+  void
+  Bookmarks::open(const std::string& path)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    if (!m_path.empty())
+    {
+      return;
+    }
+    m_path = path;
+
+    // Changes made before the store was opened are all in the queue, so the
+    // state is rebuilt from the file and the log, and the queued changes are
+    // applied on top of it, as they are newer than anything on disk.
+    m_pending.clear();
+    m_pending_quickmarks.clear();
+    m_size = 0;
+    map_file();
+    replay_log();
+    for (const auto& record : m_log_queue)
+    {
+      apply_record(record.substr(2 * sizeof(std::uint32_t)));
+    }
+    if (!(m_log = std::fopen((m_path + ".log").c_str(), "ab")))
+    {
+      ::g_warning("Unable to open bookmark log: %s.log", m_path.c_str());
+    }
+    m_running = true;
+    m_thread = std::thread(&Bookmarks::run, this);
+  }
+
+  void
+  Bookmarks::add(const Bookmark& bookmark)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto normalized = bookmark;
+
+    normalize_tags(normalized.tags);
+    if (!normalized.added)
+    {
+      normalized.added = static_cast<std::int64_t>(std::time(nullptr));
+    }
+    if (!exists(normalized.uri))
+    {
+      ++m_size;
+    }
+    m_pending[normalized.uri] = { false, normalized };
+    append_log(encode_bookmark(normalized));
+  }
+
+  bool
+  Bookmarks::remove(const std::string& uri)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    if (!exists(uri))
+    {
+      return false;
+    }
+    --m_size;
+    m_pending[uri] = { true, { uri, std::string(), {}, 0 } };
+    append_log(encode_record('D', { uri }));
+
+    return true;
+  }
+
+  bool
+  Bookmarks::find(const std::string& uri, Bookmark& result) const
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    const auto pending = m_pending.find(uri);
+    std::uint32_t index;
+
+    if (pending != std::end(m_pending))
+    {
+      if (pending->second.removed)
+      {
+        return false;
+      }
+      result = pending->second.bookmark;
+
+      return true;
+    }
+    else if ((index = find_mapped(uri)) != NOT_FOUND)
+    {
+      read_mapped(index, result);
+
+      return true;
+    }
+
+    return false;
+  }
+
+  std::vector<Bookmark>
+  Bookmarks::find_by_tag(const std::string& tag) const
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    std::vector<Bookmark> result;
+    Bookmark bookmark;
+
+    if (m_data)
+    {
+      const auto header = get_header(m_data);
+      const auto tags = get_section<FileTag>(m_data, header->tags_offset);
+      const auto end = tags + header->tag_count;
+      const auto it = std::lower_bound(
+        tags,
+        end,
+        tag,
+        [this](const FileTag& a, const std::string& b)
+        {
+          return get_string(m_data, a.name_offset, a.name_length) < b;
+        }
+      );
+
+      if (it != end
+          && get_string(m_data, it->name_offset, it->name_length) == tag
+          && static_cast<std::uint64_t>(it->postings_offset)
+            + it->posting_count <= header->posting_count)
+      {
+        const auto postings = get_section<std::uint32_t>(
+          m_data,
+          header->postings_offset
+        ) + it->postings_offset;
+
+        for (std::uint32_t i = 0; i < it->posting_count; ++i)
+        {
+          if (postings[i] >= header->entry_count)
+          {
+            continue;
+          }
+          read_mapped(postings[i], bookmark);
+          if (m_pending.find(bookmark.uri) == std::end(m_pending))
+          {
+            result.push_back(bookmark);
+          }
+        }
+      }
+    }
+    for (const auto& entry : m_pending)
+    {
+      const auto& tags = entry.second.bookmark.tags;
+
+      if (!entry.second.removed
+          && std::binary_search(std::begin(tags), std::end(tags), tag))
+      {
+        result.push_back(entry.second.bookmark);
+      }
+    }
+
+    return result;
+  }
+
+  void
+  Bookmarks::for_each(
+    const std::function<bool(const Bookmark&)>& callback
+  ) const
+  {
+    std::vector<Bookmark> chunk;
+    std::string last;
+    bool first = true;
+
+    chunk.reserve(ITERATION_CHUNK_SIZE);
+    for (;;)
+    {
+      // Copy next chunk of bookmarks in URI order, so that the main thread
+      // is not blocked while the callback goes through a large number of
+      // bookmarks.
+      {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        const auto header = m_data ? get_header(m_data) : nullptr;
+        const auto count = header ? header->entry_count : 0;
+        auto pending = first
+          ? std::begin(m_pending)
+          : m_pending.upper_bound(last);
+        auto position = first ? 0 : upper_bound_mapped(last);
+        Bookmark bookmark;
+
+        chunk.clear();
+        while (chunk.size() < ITERATION_CHUNK_SIZE)
+        {
+          const auto index = position < count
+            ? get_section<std::uint32_t>(
+              m_data,
+              header->uri_index_offset
+            )[position]
+            : NOT_FOUND;
+
+          if (position < count && index >= count)
+          {
+            ++position;
+            continue;
+          }
+          else if (index == NOT_FOUND && pending == std::end(m_pending))
+          {
+            break;
+          }
+          if (index != NOT_FOUND)
+          {
+            read_mapped(index, bookmark);
+          }
+          if (index == NOT_FOUND
+              || (pending != std::end(m_pending)
+                && pending->first <= bookmark.uri))
+          {
+            if (index != NOT_FOUND && pending->first == bookmark.uri)
+            {
+              ++position;
+            }
+            if (!pending->second.removed)
+            {
+              chunk.push_back(pending->second.bookmark);
+            }
+            last = pending->first;
+            ++pending;
+          } else {
+            chunk.push_back(bookmark);
+            last = bookmark.uri;
+            ++position;
+          }
+        }
+      }
+      if (chunk.empty())
+      {
+        return;
+      }
+      for (const auto& bookmark : chunk)
+      {
+        if (!callback(bookmark))
+        {
+          return;
+        }
+      }
+      first = false;
+    }
+  }
+
+  std::size_t
+  Bookmarks::size() const
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    return m_size;
+  }
+
+  void
+  Bookmarks::set_quickmark(const std::string& name, const std::string& uri)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    m_pending_quickmarks[name] = uri;
+    append_log(encode_record('Q', { name, uri }));
+  }
+
+  bool
+  Bookmarks::find_quickmark(const std::string& name, std::string& uri) const
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    const auto pending = m_pending_quickmarks.find(name);
+
+    if (pending != std::end(m_pending_quickmarks))
+    {
+      uri = pending->second;
+
+      return !uri.empty();
+    }
+    else if (m_data)
+    {
+      const auto header = get_header(m_data);
+      const auto quickmarks = get_section<FileQuickmark>(
+        m_data,
+        header->quickmarks_offset
+      );
+      const auto end = quickmarks + header->quickmark_count;
+      const auto it = std::lower_bound(
+        quickmarks,
+        end,
+        name,
+        [this](const FileQuickmark& a, const std::string& b)
+        {
+          return get_string(m_data, a.name_offset, a.name_length) < b;
+        }
+      );
+
+      if (it != end
+          && get_string(m_data, it->name_offset, it->name_length) == name)
+      {
+        uri = get_string(m_data, it->uri_offset, it->uri_length);
+
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  std::vector<Bookmarks::quickmark_type>
+  Bookmarks::get_quickmarks() const
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    return get_quickmarks_locked();
+  }
+
+  void
+  Bookmarks::import(const std::string& path,
+                    const import_callback_type& callback)
+  {
+    if (m_import_thread.joinable())
+    {
+      callback(0, "Another import is already in progress");
+      return;
+    }
+    m_import_callback = callback;
+    m_import_thread = std::thread([this, path]()
+    {
+      std::vector<Bookmark> bookmarks;
+
+      // The file is parsed without holding the lock, so that the bookmarks
+      // remain usable while a large export is being read.
+      m_import_count = 0;
+      m_import_error.clear();
+      read_bookmark_html(path, bookmarks, m_import_error);
+      if (m_import_error.empty())
+      {
+        std::lock_guard<std::mutex> guard(m_mutex);
+
+        // Large imports go past CHECKPOINT_RECORDS, so the background
+        // thread writes a new version of the bookmark file right after
+        // logging them.
+        for (auto& bookmark : bookmarks)
+        {
+          if (exists(bookmark.uri))
+          {
+            continue;
+          }
+          append_log(encode_bookmark(bookmark));
+          auto& pending = m_pending[bookmark.uri];
+
+          pending.removed = false;
+          pending.bookmark = std::move(bookmark);
+          ++m_size;
+          ++m_import_count;
+        }
+      }
+      m_import_dispatcher.emit();
+    });
+  }
+
+  void
+  Bookmarks::on_import_finished()
+  {
+    import_callback_type callback;
+
+    m_import_thread.join();
+    callback.swap(m_import_callback);
+    callback(m_import_count, m_import_error);
+  }
+
+  bool
+  Bookmarks::map_file()
+  {
+    ::GError* error = nullptr;
+    const auto file = ::g_mapped_file_new(m_path.c_str(), FALSE, &error);
+    const char* data;
+    std::size_t length;
+
+    if (!file)
+    {
+      if (!::g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+      {
+        ::g_warning("Unable to open bookmark file: %s", error->message);
+      }
+      ::g_error_free(error);
+
+      return false;
+    }
+    data = ::g_mapped_file_get_contents(file);
+    length = ::g_mapped_file_get_length(file);
+    if (!is_valid_file(data, length))
+    {
+      ::g_warning("Ignoring invalid bookmark file: %s", m_path.c_str());
+      ::g_mapped_file_unref(file);
+
+      return false;
+    }
+    unmap_file();
+    m_mapped_file = file;
+    m_data = data;
+    m_length = length;
+    m_size = get_header(data)->entry_count;
+
+    return true;
+  }
+
+  void
+  Bookmarks::unmap_file()
+  {
+    if (m_mapped_file)
+    {
+      ::g_mapped_file_unref(m_mapped_file);
+      m_mapped_file = nullptr;
+      m_data = nullptr;
+      m_length = 0;
+      m_size = 0;
+    }
+  }
+
+  void
+  Bookmarks::replay_log()
+  {
+    const auto path = m_path + ".log";
+    std::ifstream input(path, std::ios::binary);
+    std::string contents;
+    std::size_t position = 0;
+
+    if (!input.good())
+    {
+      return;
+    }
+    contents.assign(
+      std::istreambuf_iterator<char>(input),
+      std::istreambuf_iterator<char>()
+    );
+    while (contents.length() - position >= 2 * sizeof(std::uint32_t))
+    {
+      const auto length = read_uint32(contents.data() + position);
+      const auto payload = position + 2 * sizeof(std::uint32_t);
+
+      if (!length
+          || contents.length() - payload < length
+          || checksum(contents.data() + payload, length)
+            != read_uint32(contents.data() + position + sizeof(length)))
+      {
+        break;
+      }
+      apply_record(contents.substr(payload, length));
+      ++m_log_record_count;
+      position = payload + length;
+    }
+
+    // Drop the partially written record left by a crash, so that new
+    // records are not appended after it.
+    if (position < contents.length())
+    {
+      ::g_warning("Truncating corrupted bookmark log: %s", path.c_str());
+      if (::truncate(path.c_str(), static_cast<::off_t>(position)))
+      {
+        ::g_warning("Unable to truncate bookmark log: %s", path.c_str());
+      }
+    }
+  }
+
+  void
+  Bookmarks::apply_record(const std::string& payload)
+  {
+    std::vector<std::string> fields;
+
+    if (!decode_fields(payload, fields))
+    {
+      return;
+    }
+    if (payload[0] == 'A' && fields.size() >= 3)
+    {
+      if (!exists(fields[0]))
+      {
+        ++m_size;
+      }
+      m_pending[fields[0]] = {
+        false,
+        {
+          fields[0],
+          fields[1],
+          std::vector<std::string>(
+            std::begin(fields) + 3,
+            std::end(fields)
+          ),
+          std::strtoll(fields[2].c_str(), nullptr, 10)
+        }
+      };
+    }
+    else if (payload[0] == 'D' && fields.size() == 1)
+    {
+      if (exists(fields[0]))
+      {
+        --m_size;
+        m_pending[fields[0]] = { true, { fields[0], std::string(), {}, 0 } };
+      }
+    }
+    else if (payload[0] == 'Q' && fields.size() == 2)
+    {
+      m_pending_quickmarks[fields[0]] = fields[1];
+    }
+  }
+
+  void
+  Bookmarks::append_log(const std::string& record)
+  {
+    m_log_queue.push_back(record);
+    m_condition.notify_one();
+  }
+
+  void
+  Bookmarks::write_log(const std::vector<std::string>& records)
+  {
+    if (!m_log)
+    {
+      return;
+    }
+    for (const auto& record : records)
+    {
+      if (std::fwrite(record.data(), 1, record.length(), m_log)
+          != record.length())
+      {
+        break;
+      }
+    }
+    if (std::ferror(m_log) || std::fflush(m_log) || ::fsync(::fileno(m_log)))
+    {
+      ::g_warning("Unable to write bookmark log: %s.log", m_path.c_str());
+      std::clearerr(m_log);
+    }
+  }
+
+  void
+  Bookmarks::run()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;)
+    {
+      std::vector<std::string> records;
+
+      if (m_log_record_count >= CHECKPOINT_RECORDS)
+      {
+        lock.unlock();
+        checkpoint();
+        lock.lock();
+      }
+      m_condition.wait(lock, [this]()
+      {
+        return !m_running || !m_log_queue.empty();
+      });
+      if (m_log_queue.empty())
+      {
+        break;
+      }
+      records.swap(m_log_queue);
+      lock.unlock();
+      write_log(records);
+      lock.lock();
+      m_log_record_count += records.size();
+    }
+  }
+
+  bool
+  Bookmarks::checkpoint()
+  {
+    const auto temporary_path = m_path + ".tmp";
+    const auto log_path = m_path + ".log";
+    std::vector<Bookmark> bookmarks;
+    std::vector<quickmark_type> quickmarks;
+    std::map<std::string, PendingBookmark> written;
+    std::unordered_map<std::string, std::string> written_quickmarks;
+
+    if (m_path.empty())
+    {
+      return false;
+    }
+
+    // The new version of the file is written from a snapshot, so that the
+    // main thread is not blocked while it is being written and synced.
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      bookmarks.reserve(m_size);
+      for_each_locked([&bookmarks](const Bookmark& bookmark)
+      {
+        bookmarks.push_back(bookmark);
+
+        return true;
+      });
+      quickmarks = get_quickmarks_locked();
+      written = m_pending;
+      written_quickmarks = m_pending_quickmarks;
+    }
+    if (!write_file(temporary_path, bookmarks, quickmarks))
+    {
+      ::g_warning("Unable to write bookmark file: %s", m_path.c_str());
+      std::remove(temporary_path.c_str());
+
+      return false;
+    }
+    if (std::rename(temporary_path.c_str(), m_path.c_str()))
+    {
+      ::g_warning("Unable to replace bookmark file: %s", m_path.c_str());
+      std::remove(temporary_path.c_str());
+
+      return false;
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    // If the new file cannot be mapped, the old mapping and the pending
+    // changes still describe the same state, so they are kept as they are.
+    if (!map_file())
+    {
+      return false;
+    }
+
+    // Changes made while the file was being written are not included in
+    // it, so they are kept on top of the new mapping. Records of the
+    // changes which are included end up in the new log as well if they
+    // were still queued, which is harmless as replaying them again does not
+    // change anything.
+    for (const auto& entry : written)
+    {
+      const auto pending = m_pending.find(entry.first);
+
+      if (pending != std::end(m_pending)
+          && pending->second.removed == entry.second.removed
+          && is_same_bookmark(pending->second.bookmark, entry.second.bookmark))
+      {
+        m_pending.erase(pending);
+      }
+    }
+    for (const auto& entry : written_quickmarks)
+    {
+      const auto pending = m_pending_quickmarks.find(entry.first);
+
+      if (pending != std::end(m_pending_quickmarks)
+          && pending->second == entry.second)
+      {
+        m_pending_quickmarks.erase(pending);
+      }
+    }
+    for (const auto& entry : m_pending)
+    {
+      const auto mapped = find_mapped(entry.first) != NOT_FOUND;
+
+      if (entry.second.removed && mapped)
+      {
+        --m_size;
+      }
+      else if (!entry.second.removed && !mapped)
+      {
+        ++m_size;
+      }
+    }
+    m_log_record_count = 0;
+    if (m_log)
+    {
+      std::fclose(m_log);
+    }
+    if (!(m_log = std::fopen(log_path.c_str(), "wb")))
+    {
+      ::g_warning("Unable to open bookmark log: %s", log_path.c_str());
+    }
+
+    return true;
+  }
+
+  std::uint32_t
+  Bookmarks::find_mapped(const std::string& uri) const
+  {
+    const FileHeader* header;
+    const FileEntry* entries;
+    const std::uint32_t* index;
+    std::uint32_t low = 0;
+    std::uint32_t high;
+
+    if (!m_data)
+    {
+      return NOT_FOUND;
+    }
+    header = get_header(m_data);
+    entries = get_section<FileEntry>(m_data, header->entries_offset);
+    index = get_section<std::uint32_t>(m_data, header->uri_index_offset);
+    high = header->entry_count;
+    while (low < high)
+    {
+      const auto middle = low + (high - low) / 2;
+      const auto id = index[middle];
+      int result;
+
+      if (id >= header->entry_count)
+      {
+        return NOT_FOUND;
+      }
+      result = get_string(
+        m_data,
+        entries[id].uri_offset,
+        entries[id].uri_length
+      ).compare(uri);
+      if (result < 0)
+      {
+        low = middle + 1;
+      }
+      else if (result > 0)
+      {
+        high = middle;
+      } else {
+        return id;
+      }
+    }
+
+    return NOT_FOUND;
+  }
+
+  std::uint32_t
+  Bookmarks::upper_bound_mapped(const std::string& uri) const
+  {
+    const FileHeader* header;
+    const FileEntry* entries;
+    const std::uint32_t* index;
+    std::uint32_t low = 0;
+    std::uint32_t high;
+
+    if (!m_data)
+    {
+      return 0;
+    }
+    header = get_header(m_data);
+    entries = get_section<FileEntry>(m_data, header->entries_offset);
+    index = get_section<std::uint32_t>(m_data, header->uri_index_offset);
+    high = header->entry_count;
+    while (low < high)
+    {
+      const auto middle = low + (high - low) / 2;
+      const auto id = index[middle];
+
+      if (id < header->entry_count
+          && get_string(
+            m_data,
+            entries[id].uri_offset,
+            entries[id].uri_length
+          ).compare(uri) <= 0)
+      {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+
+    return low;
+  }
+
+  bool
+  Bookmarks::exists(const std::string& uri) const
+  {
+    const auto pending = m_pending.find(uri);
+
+    if (pending != std::end(m_pending))
+    {
+      return !pending->second.removed;
+    }
+
+    return find_mapped(uri) != NOT_FOUND;
+  }
+
+  void
+  Bookmarks::read_mapped(std::uint32_t index, Bookmark& result) const
+  {
+    const auto header = get_header(m_data);
+    const auto& entry = get_section<FileEntry>(
+      m_data,
+      header->entries_offset
+    )[index];
+    const auto entry_tags = get_section<std::uint32_t>(
+      m_data,
+      header->entry_tags_offset
+    );
+    const auto tags = get_section<FileTag>(m_data, header->tags_offset);
+
+    result.uri = get_string(m_data, entry.uri_offset, entry.uri_length);
+    result.title = get_string(m_data, entry.title_offset, entry.title_length);
+    result.added = entry.added;
+    result.tags.clear();
+    if (static_cast<std::uint64_t>(entry.tags_offset) + entry.tag_count
+        > header->entry_tag_count)
+    {
+      return;
+    }
+    for (std::uint32_t i = 0; i < entry.tag_count; ++i)
+    {
+      const auto id = entry_tags[entry.tags_offset + i];
+
+      if (id < header->tag_count)
+      {
+        result.tags.emplace_back(get_string(
+          m_data,
+          tags[id].name_offset,
+          tags[id].name_length
+        ));
+      }
+    }
+  }
+
+  bool
+  Bookmarks::for_each_locked(
+    const std::function<bool(const Bookmark&)>& callback
+  ) const
+  {
+    if (m_data)
+    {
+      const auto count = get_header(m_data)->entry_count;
+      Bookmark bookmark;
+
+      for (std::uint32_t i = 0; i < count; ++i)
+      {
+        read_mapped(i, bookmark);
+        if (!m_pending.empty()
+            && m_pending.find(bookmark.uri) != std::end(m_pending))
+        {
+          continue;
+        }
+        if (!callback(bookmark))
+        {
+          return false;
+        }
+      }
+    }
+    for (const auto& entry : m_pending)
+    {
+      if (!entry.second.removed && !callback(entry.second.bookmark))
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  std::vector<Bookmarks::quickmark_type>
+  Bookmarks::get_quickmarks_locked() const
+  {
+    std::map<std::string, std::string> quickmarks;
+
+    if (m_data)
+    {
+      const auto header = get_header(m_data);
+      const auto mapped = get_section<FileQuickmark>(
+        m_data,
+        header->quickmarks_offset
+      );
+
+      for (std::uint32_t i = 0; i < header->quickmark_count; ++i)
+      {
+        quickmarks[std::string(get_string(
+          m_data,
+          mapped[i].name_offset,
+          mapped[i].name_length
+        ))] = get_string(m_data, mapped[i].uri_offset, mapped[i].uri_length);
+      }
+    }
+    for (const auto& entry : m_pending_quickmarks)
+    {
+      if (entry.second.empty())
+      {
+        quickmarks.erase(entry.first);
+      } else {
+        quickmarks[entry.first] = entry.second;
+      }
+    }
+
+    return std::vector<quickmark_type>(
+      std::begin(quickmarks),
+      std::end(quickmarks)
+    );
+  }
+}
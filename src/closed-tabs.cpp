@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/closed-tabs.hpp>
+
+#include <gio/gio.h>
+
+namespace selain
+{
+  static constexpr std::size_t CONVERT_BUFFER_SIZE = 16 * 1024;
+
+  /**
+   * Passes whole input through given GIO converter. Returns false if the
+   * conversion fails.
+   */
+  static bool
+  convert(::GConverter* converter,
+          const std::string& input,
+          std::string& output)
+  {
+    char buffer[CONVERT_BUFFER_SIZE];
+    std::size_t offset = 0;
+
+    output.clear();
+    for (;;)
+    {
+      ::gsize bytes_read = 0;
+      ::gsize bytes_written = 0;
+      ::GError* error = nullptr;
+      const auto result = ::g_converter_convert(
+        converter,
+        input.data() + offset,
+        input.length() - offset,
+        buffer,
+        sizeof(buffer),
+        G_CONVERTER_INPUT_AT_END,
+        &bytes_read,
+        &bytes_written,
+        &error
+      );
+
+      if (result == G_CONVERTER_ERROR)
+      {
+        ::g_error_free(error);
+
+        return false;
+      }
+      offset += bytes_read;
+      output.append(buffer, bytes_written);
+      if (result == G_CONVERTER_FINISHED)
+      {
+        return true;
+      }
+    }
+  }
+
+  static bool
+  compress(const std::string& input, std::string& output)
+  {
+    const auto compressor = ::g_zlib_compressor_new(
+      G_ZLIB_COMPRESSOR_FORMAT_RAW,
+      -1
+    );
+    const auto result = convert(G_CONVERTER(compressor), input, output);
+
+    ::g_object_unref(compressor);
+
+    return result;
+  }
+
+  static bool
+  decompress(const std::string& input, std::string& output)
+  {
+    const auto decompressor = ::g_zlib_decompressor_new(
+      G_ZLIB_COMPRESSOR_FORMAT_RAW
+    );
+    const auto result = convert(G_CONVERTER(decompressor), input, output);
+
+    ::g_object_unref(decompressor);
+
+    return result;
+  }
+
+  ClosedTabStack::ClosedTabStack(std::size_t max_count,
+                                 std::size_t max_bytes)
+    : m_max_count(max_count)
+    , m_max_bytes(max_bytes)
+    , m_bytes(0)
+    , m_last_id(0)
+  {
+  }
+
+  ::guint
+  ClosedTabStack::push(ClosedTab&& tab)
+  {
+    std::string compressed;
+
+    // Tab without session state can still be reopened from it's URI.
+    if (!compress(tab.session_state, compressed))
+    {
+      compressed.clear();
+    }
+    tab.id = ++m_last_id;
+    tab.session_state = std::move(compressed);
+    m_bytes += tab.session_state.length();
+    m_entries.push_back(std::move(tab));
+    trim();
+
+    return m_last_id;
+  }
+
+  bool
+  ClosedTabStack::pop(ClosedTab& tab)
+  {
+    if (m_entries.empty())
+    {
+      return false;
+    }
+    tab = std::move(m_entries.back());
+    m_entries.pop_back();
+    m_bytes -= tab.session_state.length();
+
+    std::string session_state;
+
+    if (tab.session_state.empty() ||
+        !decompress(tab.session_state, session_state))
+    {
+      session_state.clear();
+    }
+    tab.session_state = std::move(session_state);
+
+    return true;
+  }
+
+  bool
+  ClosedTabStack::is_scroll_pending() const
+  {
+    return !m_entries.empty() && m_entries.back().scroll_pending;
+  }
+
+  void
+  ClosedTabStack::set_scroll_position(::guint id, int x, int y)
+  {
+    // Scroll position arrives shortly after the tab was closed, so it's
+    // most likely near the top of the stack.
+    for (auto it = m_entries.rbegin(); it != m_entries.rend(); ++it)
+    {
+      if (it->id == id)
+      {
+        it->scroll_x = x;
+        it->scroll_y = y;
+        it->scroll_pending = false;
+        break;
+      }
+    }
+    m_signal_scroll_position_received.emit(id);
+  }
+
+  void
+  ClosedTabStack::trim()
+  {
+    while (m_entries.size() > 1 && (
+      m_entries.size() > m_max_count || m_bytes > m_max_bytes
+    ))
+    {
+      m_bytes -= m_entries.front().session_state.length();
+      m_entries.pop_front();
+    }
+  }
+}
@@ -24,11 +24,21 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 #include <selain/command-entry.hpp>
+#include <selain/metrics.hpp>
 #include <selain/theme.hpp>
 #include <selain/utils.hpp>
 
 namespace selain
 {
+  static metrics::Counter notifications_shown(
+    "selain_notifications",
+    "Notifications shown in the command line."
+  );
+  static metrics::Gauge notifications_queued(
+    "selain_notifications_queued",
+    "Notifications waiting to be shown, including the visible one."
+  );
+
   CommandEntry::CommandEntry()
   {
     const auto& font = utils::get_monospace_font();
@@ -75,6 +85,8 @@ namespace selain
     std::lock_guard<std::mutex> guard(m_notification_queue_mutex);
 
     m_notification_queue.push(notification);
+    notifications_shown.increment();
+    notifications_queued.set(m_notification_queue.size());
     if (m_notification_queue.size() > 1)
     {
       return;
@@ -131,6 +143,7 @@ namespace selain
       return;
     }
     m_notification_queue.pop();
+    notifications_queued.set(m_notification_queue.size());
     if (m_notification_queue.empty())
     {
       set_visible_child(m_entry);
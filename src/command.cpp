@@ -24,35 +24,109 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 #include <selain/main-window.hpp>
+#include <selain/metrics.hpp>
+#include <selain/trace.hpp>
 #include <selain/utils.hpp>
 
+#include <cstdlib>
+#include <ctime>
+
 namespace selain
 {
+  static void cmd_bookmark(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_bookmark_import(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_bookmark_remove(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_buffer(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_cache_model(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_cache_quota(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_cache_stats(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_download(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_download_cancel(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_download_resume(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_downloads(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_har_export(MainWindow&, Tab&, const Glib::ustring&);
   static void cmd_hint_mode(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_history_import(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_history_search(MainWindow&, Tab&, const Glib::ustring&);
   static void cmd_insert_mode(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_lite(MainWindow&, Tab&, const Glib::ustring&);
   static void cmd_open(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_open_lite(MainWindow&, Tab&, const Glib::ustring&);
   static void cmd_open_tab(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_perf(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_quickmark(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_quickmark_add(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_quickmark_remove(MainWindow&, Tab&, const Glib::ustring&);
   static void cmd_quit(MainWindow&, Tab&, const Glib::ustring&);
   static void cmd_quit_all(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_read_later(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_read_later_list(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_read_later_open(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_read_later_remove(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_reader(MainWindow&, Tab&, const Glib::ustring&);
   static void cmd_reload(MainWindow&, Tab&, const Glib::ustring&);
   static void cmd_force_reload(MainWindow&, Tab&, const Glib::ustring&);
   static void cmd_stop(MainWindow&, Tab&, const Glib::ustring&);
   static void cmd_tab_next(MainWindow&, Tab&, const Glib::ustring&);
   static void cmd_tab_prev(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_tab_reopen(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_stats(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_tabs(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_trace(MainWindow&, Tab&, const Glib::ustring&);
+  static void cmd_waterfall(MainWindow&, Tab&, const Glib::ustring&);
+
+  static metrics::Counter commands_executed(
+    "selain_commands_executed",
+    "Commands executed from the command line."
+  );
+  static metrics::Counter commands_unknown(
+    "selain_commands_unknown",
+    "Unknown commands entered into the command line."
+  );
 
   static const std::vector<Command> command_list =
   {
+    { "bookmark", "bm", cmd_bookmark },
+    { "bookmark-import", nullptr, cmd_bookmark_import },
+    { "bookmark-remove", "bmr", cmd_bookmark_remove },
+    { "buffer", "b", cmd_buffer },
+    { "cache-model", nullptr, cmd_cache_model },
+    { "cache-quota", nullptr, cmd_cache_quota },
+    { "cache-stats", nullptr, cmd_cache_stats },
+    { "download", nullptr, cmd_download },
+    { "download-cancel", nullptr, cmd_download_cancel },
+    { "download-resume", nullptr, cmd_download_resume },
+    { "downloads", "dl", cmd_downloads },
+    { "har-export", nullptr, cmd_har_export },
     { "hint", "h", cmd_hint_mode },
+    { "history-import", nullptr, cmd_history_import },
+    { "history-search", "hs", cmd_history_search },
     { "insert", "i", cmd_insert_mode },
+    { "lite", nullptr, cmd_lite },
     { "open", "o", cmd_open },
+    { "open-lite", "ol", cmd_open_lite },
     { "open-tab", "ot", cmd_open_tab },
+    { "perf", nullptr, cmd_perf },
+    { "quickmark", "qm", cmd_quickmark },
+    { "quickmark-add", "qma", cmd_quickmark_add },
+    { "quickmark-remove", "qmr", cmd_quickmark_remove },
     { "quit", "q", cmd_quit },
     { "quit-all", "qa", cmd_quit_all },
+    { "read-later", "rl", cmd_read_later },
+    { "read-later-list", "rll", cmd_read_later_list },
+    { "read-later-open", "rlo", cmd_read_later_open },
+    { "read-later-remove", "rlr", cmd_read_later_remove },
+    { "reader", "rd", cmd_reader },
     { "reload", "r", cmd_reload },
     { "reload!", "r!", cmd_force_reload },
+    { "stats", nullptr, cmd_stats },
     { "stop", "s", cmd_stop },
     { "tab-next", "tn", cmd_tab_next },
     { "tab-prev", "tp", cmd_tab_prev },
+    { "tab-reopen", "tr", cmd_tab_reopen },
+    { "tabs", nullptr, cmd_tabs },
+    { "trace", nullptr, cmd_trace },
+    { "waterfall", "wf", cmd_waterfall },
   };
 
   void
@@ -118,41 +192,568 @@ namespace selain
       entry = mapping.find(command_name.c_str());
       if (entry != std::end(mapping))
       {
+        commands_executed.increment();
         entry->second.callback(*window, *this, command_args);
         return;
       }
     }
 
+    commands_unknown.increment();
     window->get_command_entry().show_notification(
       "Error: Unknown command: " + command,
       NotificationType::ERROR
     );
   }
 
+  static void
+  cmd_bookmark(MainWindow& window, Tab& tab, const Glib::ustring& args)
+  {
+    const auto uri = tab.get_uri();
+    Bookmark bookmark = { uri, tab.get_title(), {}, 0 };
+    Glib::ustring::size_type start = 0;
+    Glib::ustring::size_type end;
+
+    if (uri.empty())
+    {
+      window.get_command_entry().show_notification(
+        "Error: Nothing to bookmark.",
+        NotificationType::ERROR
+      );
+      return;
+    }
+    while ((end = args.find(' ', start)) != Glib::ustring::npos)
+    {
+      bookmark.tags.push_back(args.substr(start, end - start).raw());
+      start = end + 1;
+    }
+    bookmark.tags.push_back(args.substr(start).raw());
+    window.get_bookmarks().add(bookmark);
+    window.get_command_entry().show_notification("Bookmarked " + uri);
+  }
+
+  static void
+  cmd_bookmark_import(MainWindow& window, Tab&, const Glib::ustring& args)
+  {
+    const auto path = utils::expand_path(args);
+
+    if (path.empty())
+    {
+      window.get_command_entry().show_notification(
+        "Usage: :bookmark-import <path to HTML file>",
+        NotificationType::ERROR
+      );
+      return;
+    }
+    window.get_bookmarks().import(
+      path,
+      [&window, path](std::size_t bookmark_count, const std::string& error)
+      {
+        if (error.empty())
+        {
+          window.get_command_entry().show_notification(Glib::ustring::compose(
+            "Imported %1 bookmarks from %2",
+            bookmark_count,
+            Glib::ustring(path)
+          ));
+        } else {
+          window.get_command_entry().show_notification(
+            "Error: Unable to import bookmarks: " + error,
+            NotificationType::ERROR
+          );
+        }
+      }
+    );
+  }
+
+  static void
+  cmd_bookmark_remove(MainWindow& window, Tab& tab, const Glib::ustring& args)
+  {
+    const auto uri = args.empty() ? tab.get_uri() : args;
+
+    if (window.get_bookmarks().remove(uri))
+    {
+      window.get_command_entry().show_notification(
+        "Removed bookmark " + uri
+      );
+    } else {
+      window.get_command_entry().show_notification(
+        "Error: No bookmark for " + uri,
+        NotificationType::ERROR
+      );
+    }
+  }
+
+  static void
+  cmd_buffer(MainWindow& window, Tab&, const Glib::ustring& args)
+  {
+    int index = -1;
+
+    if (args.empty())
+    {
+      window.get_command_entry().show_notification(
+        "Usage: :buffer <number|query>",
+        NotificationType::ERROR
+      );
+      return;
+    }
+    if (std::all_of(std::begin(args), std::end(args), ::g_unichar_isdigit))
+    {
+      index = std::atoi(args.c_str()) - 1;
+    } else {
+      index = window.find_tab(args);
+    }
+    if (index < 0 || !window.get_nth_tab(index))
+    {
+      window.get_command_entry().show_notification(
+        "Error: No matching tab: " + args,
+        NotificationType::ERROR
+      );
+      return;
+    }
+    window.set_current_tab(index);
+  }
+
+  static void
+  cmd_cache_model(MainWindow& window, Tab&, const Glib::ustring& args)
+  {
+    const auto& context = window.get_web_context();
+    ::WebKitCacheModel model;
+
+    if (args.empty())
+    {
+      window.get_command_entry().show_notification(
+        Glib::ustring("Cache model: ")
+        + WebContext::get_cache_model_name(context->get_cache_model())
+      );
+    }
+    else if (WebContext::parse_cache_model(args, model))
+    {
+      context->set_cache_model(model);
+      window.get_command_entry().show_notification(
+        Glib::ustring("Cache model set to ")
+        + WebContext::get_cache_model_name(model)
+      );
+    } else {
+      window.get_command_entry().show_notification(
+        "Usage: :cache-model [document-viewer|web-browser|document-browser]",
+        NotificationType::ERROR
+      );
+    }
+  }
+
+  static void
+  cmd_cache_quota(MainWindow& window, Tab&, const Glib::ustring& args)
+  {
+    auto& cache = window.get_web_context()->get_disk_cache();
+    std::uint64_t quota;
+
+    if (args.empty())
+    {
+      quota = cache.get_quota();
+      window.get_command_entry().show_notification(
+        "Cache quota: " + (quota ? utils::format_size(quota) : "unlimited")
+      );
+    }
+    else if (utils::parse_size(args, quota))
+    {
+      window.get_web_context()->set_disk_cache_quota(quota);
+      window.get_command_entry().show_notification(
+        "Cache quota set to "
+        + (quota ? utils::format_size(quota) : "unlimited")
+      );
+    } else {
+      window.get_command_entry().show_notification(
+        "Usage: :cache-quota <size, e.g. 512M>",
+        NotificationType::ERROR
+      );
+    }
+  }
+
+  static void
+  cmd_cache_stats(MainWindow& window, Tab& tab, const Glib::ustring&)
+  {
+    auto& cache = window.get_web_context()->get_disk_cache();
+    auto& command_entry = window.get_command_entry();
+    const auto quota = cache.get_quota();
+    const auto lite = tab.get_profile() == SettingsProfile::LITE;
+
+    // The slot is tracked by the command entry, so that it's not called if
+    // the window has been destroyed before the statistics are ready.
+    cache.get_stats(sigc::track_obj(
+      [&command_entry, quota, lite](const DiskCacheStats& stats)
+      {
+        const auto requests = stats.hits + stats.misses;
+        Glib::ustring hit_ratio;
+
+        // The hit ratio is computed from the Resource Timing entries of the
+        // loaded pages, which are not collected in lite tabs.
+        if (lite || !requests)
+        {
+          hit_ratio = "unavailable";
+        } else {
+          hit_ratio = Glib::ustring::compose(
+            "%1%%",
+            stats.hits * 100 / requests
+          );
+        }
+        command_entry.show_notification(Glib::ustring::compose(
+          "Cache: %1 of %2, %3 entries from %4 sites, hit ratio %5",
+          Glib::ustring(utils::format_size(stats.size)),
+          Glib::ustring(quota ? utils::format_size(quota) : "unlimited"),
+          stats.entry_count,
+          stats.site_count,
+          hit_ratio
+        ));
+      },
+      command_entry
+    ));
+  }
+
+  static void
+  cmd_download(MainWindow& window, Tab& tab, const Glib::ustring& args)
+  {
+    const auto uri = args.empty() ? tab.get_uri() : args;
+
+    if (uri.empty())
+    {
+      window.get_command_entry().show_notification(
+        "Usage: :download [URI]",
+        NotificationType::ERROR
+      );
+      return;
+    }
+    window.get_command_entry().show_notification(Glib::ustring::compose(
+      "Download %1 started.",
+      window.get_web_context()->get_download_manager().add(uri, tab.get_uri())
+    ));
+  }
+
+  /**
+   * Parses identifier of a download from command arguments. Shows usage of
+   * the command and returns zero if the arguments are not valid.
+   */
+  static unsigned int
+  parse_download_id(MainWindow& window,
+                    const Glib::ustring& args,
+                    const char* usage)
+  {
+    const auto id = std::strtoul(args.c_str(), nullptr, 10);
+
+    if (!id)
+    {
+      window.get_command_entry().show_notification(
+        usage,
+        NotificationType::ERROR
+      );
+    }
+
+    return static_cast<unsigned int>(id);
+  }
+
+  static void
+  cmd_download_cancel(MainWindow& window, Tab&, const Glib::ustring& args)
+  {
+    auto& manager = window.get_web_context()->get_download_manager();
+    const auto id = parse_download_id(
+      window,
+      args,
+      "Usage: :download-cancel <number>"
+    );
+
+    if (!id)
+    {
+      return;
+    }
+    else if (manager.cancel(id))
+    {
+      window.get_command_entry().show_notification(
+        Glib::ustring::compose("Download %1 cancelled.", id)
+      );
+    } else {
+      window.get_command_entry().show_notification(
+        Glib::ustring::compose("Error: Download %1 is not in progress.", id),
+        NotificationType::ERROR
+      );
+    }
+  }
+
+  static void
+  cmd_download_resume(MainWindow& window, Tab&, const Glib::ustring& args)
+  {
+    auto& manager = window.get_web_context()->get_download_manager();
+    const auto id = parse_download_id(
+      window,
+      args,
+      "Usage: :download-resume <number>"
+    );
+
+    if (!id)
+    {
+      return;
+    }
+    else if (manager.resume(id))
+    {
+      window.get_command_entry().show_notification(
+        Glib::ustring::compose("Download %1 resumed.", id)
+      );
+    } else {
+      window.get_command_entry().show_notification(
+        Glib::ustring::compose("Error: Download %1 cannot be resumed.", id),
+        NotificationType::ERROR
+      );
+    }
+  }
+
+  static void
+  cmd_downloads(MainWindow& window, Tab&, const Glib::ustring&)
+  {
+    window.open_tab("selain://downloads");
+  }
+
+  /**
+   * Returns path in the downloads directory where HAR file is exported when
+   * no path is given to the command.
+   */
+  static std::string
+  get_default_har_path()
+  {
+    const auto directory = ::g_get_user_special_dir(G_USER_DIRECTORY_DOWNLOAD);
+    const auto timestamp = std::time(nullptr);
+    char name[64];
+    ::gchar* path;
+    std::string result;
+
+    std::strftime(
+      name,
+      sizeof(name),
+      "selain-%Y%m%d-%H%M%S.har",
+      std::localtime(&timestamp)
+    );
+    path = ::g_build_filename(
+      directory ? directory : ::g_get_home_dir(),
+      name,
+      nullptr
+    );
+    result = path;
+    ::g_free(path);
+
+    return result;
+  }
+
+  static void
+  cmd_har_export(MainWindow& window, Tab& tab, const Glib::ustring& args)
+  {
+    const auto path = args.empty()
+      ? get_default_har_path()
+      : utils::expand_path(args);
+    auto& log = tab.get_resource_log();
+
+    if (!log.size())
+    {
+      window.get_command_entry().show_notification(
+        "Error: No requests recorded for current page.",
+        NotificationType::ERROR
+      );
+      return;
+    }
+    // The tab owns the writer thread and joins it when closed, so the
+    // callback is never called after the tab, or the window, is gone.
+    log.save_har(
+      path,
+      tab.get_uri(),
+      tab.get_title(),
+      [&window, path](const std::string& error)
+      {
+        if (error.empty())
+        {
+          window.get_command_entry().show_notification(
+            "Exported requests to " + path
+          );
+        } else {
+          window.get_command_entry().show_notification(
+            "Error: Unable to export requests: " + error,
+            NotificationType::ERROR
+          );
+        }
+      }
+    );
+  }
+
   static void
   cmd_hint_mode(MainWindow& window, Tab&, const Glib::ustring&)
   {
     window.set_mode(Mode::HINT);
   }
 
+  static void
+  cmd_history_import(MainWindow& window, Tab&, const Glib::ustring& args)
+  {
+    const auto pos = args.find(' ');
+    const auto browser = args.substr(0, pos);
+    Glib::ustring path;
+    auto source = HistoryImportSource::FIREFOX;
+
+    if (pos != Glib::ustring::npos)
+    {
+      path = utils::expand_path(utils::string_trim(args.substr(pos + 1)));
+    }
+    if (browser == "chromium" || browser == "chrome")
+    {
+      source = HistoryImportSource::CHROMIUM;
+    }
+    else if (browser != "firefox")
+    {
+      path.clear();
+    }
+    if (path.empty())
+    {
+      window.get_command_entry().show_notification(
+        "Usage: :history-import firefox|chromium <path to database>",
+        NotificationType::ERROR
+      );
+      return;
+    }
+    window.get_history().import(
+      source,
+      path,
+      [&window, path](std::size_t visit_count, const std::string& error)
+      {
+        if (error.empty())
+        {
+          window.get_command_entry().show_notification(Glib::ustring::compose(
+            "Imported %1 visits from %2",
+            visit_count,
+            path
+          ));
+        } else {
+          window.get_command_entry().show_notification(
+            "Error: Unable to import history: " + error,
+            NotificationType::ERROR
+          );
+        }
+      }
+    );
+  }
+
+  static void
+  cmd_history_search(MainWindow& window, Tab&, const Glib::ustring& args)
+  {
+    if (args.empty())
+    {
+      window.get_command_entry().show_notification(
+        "Usage: :history-search <words>",
+        NotificationType::ERROR
+      );
+      return;
+    }
+    const auto query = ::g_uri_escape_string(args.c_str(), nullptr, false);
+
+    window.open_tab(Glib::ustring("selain://history-search?q=") + query);
+    ::g_free(query);
+  }
+
   static void
   cmd_insert_mode(MainWindow& window, Tab&, const Glib::ustring&)
   {
     window.set_mode(Mode::INSERT);
   }
 
+  static void
+  cmd_lite(MainWindow& window, Tab& tab, const Glib::ustring&)
+  {
+    const auto lite = tab.get_profile() != SettingsProfile::LITE;
+
+    tab.set_profile(lite ? SettingsProfile::LITE : SettingsProfile::NORMAL);
+    window.get_command_entry().show_notification(
+      lite ? "Lite profile enabled." : "Lite profile disabled."
+    );
+  }
+
   static void
   cmd_open(MainWindow&, Tab& tab, const Glib::ustring& args)
   {
     tab.load_uri(args);
   }
 
+  static void
+  cmd_open_lite(MainWindow& window, Tab&, const Glib::ustring& args)
+  {
+    window.open_tab(args, true, SettingsProfile::LITE);
+  }
+
   static void
   cmd_open_tab(MainWindow& window, Tab&, const Glib::ustring& args)
   {
     window.open_tab(args);
   }
 
+  static void
+  cmd_perf(MainWindow& window, Tab&, const Glib::ustring& args)
+  {
+    const auto filter = ::g_uri_escape_string(args.c_str(), nullptr, false);
+
+    window.open_tab(Glib::ustring("selain://perf?site=") + filter);
+    ::g_free(filter);
+  }
+
+  static void
+  cmd_quickmark(MainWindow& window, Tab& tab, const Glib::ustring& args)
+  {
+    std::string uri;
+
+    if (!window.get_bookmarks().find_quickmark(args, uri))
+    {
+      window.get_command_entry().show_notification(
+        "Error: No such quickmark: " + args,
+        NotificationType::ERROR
+      );
+      return;
+    }
+    tab.load_uri(uri);
+  }
+
+  static void
+  cmd_quickmark_add(MainWindow& window, Tab& tab, const Glib::ustring& args)
+  {
+    const auto pos = args.find(' ');
+    const auto name = args.substr(0, pos);
+    const auto uri = pos == Glib::ustring::npos
+      ? tab.get_uri()
+      : utils::string_trim(args.substr(pos + 1));
+
+    if (name.empty() || uri.empty())
+    {
+      window.get_command_entry().show_notification(
+        "Usage: :quickmark-add <name> [uri]",
+        NotificationType::ERROR
+      );
+      return;
+    }
+    window.get_bookmarks().set_quickmark(name, uri);
+    window.get_command_entry().show_notification(
+      "Quickmark " + name + " set to " + uri
+    );
+  }
+
+  static void
+  cmd_quickmark_remove(MainWindow& window, Tab&, const Glib::ustring& args)
+  {
+    std::string uri;
+
+    if (!window.get_bookmarks().find_quickmark(args, uri))
+    {
+      window.get_command_entry().show_notification(
+        "Error: No such quickmark: " + args,
+        NotificationType::ERROR
+      );
+      return;
+    }
+    window.get_bookmarks().set_quickmark(args, std::string());
+    window.get_command_entry().show_notification(
+      "Removed quickmark " + args
+    );
+  }
+
   static void
   cmd_quit(MainWindow& window, Tab& tab, const Glib::ustring&)
   {
@@ -160,10 +761,87 @@ namespace selain
   }
 
   static void
-  cmd_quit_all(MainWindow&, Tab&, const Glib::ustring&)
+  cmd_quit_all(MainWindow& window, Tab&, const Glib::ustring&)
+  {
+    window.get_application()->quit();
+  }
+
+  static void
+  cmd_read_later(MainWindow& window, Tab& tab, const Glib::ustring& args)
   {
-    // TODO: Close the main window instead.
-    std::exit(EXIT_SUCCESS);
+    const auto uri = args.empty() ? tab.get_uri() : args;
+
+    if (uri.empty())
+    {
+      window.get_command_entry().show_notification(
+        "Error: Nothing to read later.",
+        NotificationType::ERROR
+      );
+      return;
+    }
+    window.get_read_later().add(uri);
+    window.get_command_entry().show_notification(
+      "Added " + uri + " to read-later queue"
+    );
+  }
+
+  static void
+  cmd_read_later_list(MainWindow& window, Tab&, const Glib::ustring&)
+  {
+    window.open_tab("selain://read-later");
+  }
+
+  static void
+  cmd_read_later_open(MainWindow& window, Tab& tab, const Glib::ustring& args)
+  {
+    const auto id = static_cast<::guint>(
+      std::strtoul(args.c_str(), nullptr, 10)
+    );
+    const auto uri = window.get_read_later().get_archive_uri(id);
+
+    if (uri.empty())
+    {
+      window.get_command_entry().show_notification(
+        "Error: No saved page: " + args,
+        NotificationType::ERROR
+      );
+      return;
+    }
+    tab.load_uri(uri);
+  }
+
+  static void
+  cmd_read_later_remove(MainWindow& window,
+                        Tab&,
+                        const Glib::ustring& args)
+  {
+    const auto id = static_cast<::guint>(
+      std::strtoul(args.c_str(), nullptr, 10)
+    );
+
+    if (window.get_read_later().remove(id))
+    {
+      window.get_command_entry().show_notification(
+        "Removed " + args + " from read-later queue"
+      );
+    } else {
+      window.get_command_entry().show_notification(
+        "Error: No such page in read-later queue: " + args,
+        NotificationType::ERROR
+      );
+    }
+  }
+
+  static void
+  cmd_reader(MainWindow& window, Tab& tab, const Glib::ustring&)
+  {
+    if (!tab.open_reader())
+    {
+      window.get_command_entry().show_notification(
+        "Error: Reader view is available only for web pages.",
+        NotificationType::ERROR
+      );
+    }
   }
 
   static void
@@ -195,4 +873,74 @@ namespace selain
   {
     window.next_tab();
   }
+
+  static void
+  cmd_tab_reopen(MainWindow& window, Tab&, const Glib::ustring&)
+  {
+    if (!window.reopen_tab())
+    {
+      window.get_command_entry().show_notification(
+        "Error: No closed tabs.",
+        NotificationType::ERROR
+      );
+    }
+  }
+
+  static void
+  cmd_stats(MainWindow& window, Tab&, const Glib::ustring&)
+  {
+    window.open_tab("selain://stats");
+  }
+
+  static void
+  cmd_tabs(MainWindow& window, Tab&, const Glib::ustring&)
+  {
+    window.show_tab_overview();
+  }
+
+  static void
+  cmd_trace(MainWindow& window, Tab&, const Glib::ustring& args)
+  {
+    const auto pos = args.find(' ');
+    const auto action = args.substr(0, pos);
+    std::string path;
+    std::string error;
+
+    if (action == "start")
+    {
+      trace::start();
+      window.get_command_entry().show_notification("Tracing started");
+      return;
+    }
+    else if (action != "stop")
+    {
+      window.get_command_entry().show_notification(
+        "Usage: :trace <start|stop> [path]",
+        NotificationType::ERROR
+      );
+      return;
+    }
+    path = pos == Glib::ustring::npos
+      ? utils::get_data_file_path("trace.json")
+      : utils::expand_path(utils::string_trim(args.substr(pos + 1)));
+    trace::stop();
+    if (trace::write(path, error))
+    {
+      window.get_command_entry().show_notification("Wrote trace to " + path);
+    } else {
+      window.get_command_entry().show_notification(
+        "Error: Unable to write trace: " + error,
+        NotificationType::ERROR
+      );
+    }
+  }
+
+  static void
+  cmd_waterfall(MainWindow& window, Tab& tab, const Glib::ustring&)
+  {
+    window.open_tab(Glib::ustring::compose(
+      "selain://waterfall?tab=%1",
+      tab.get_id()
+    ));
+  }
 }
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/completion-view.hpp>
+#include <selain/theme.hpp>
+#include <selain/utils.hpp>
+
+namespace selain
+{
+  static const int MAX_HEIGHT = 240;
+
+  CompletionView::Columns::Columns()
+  {
+    add(value);
+    add(description);
+  }
+
+  CompletionView::CompletionView()
+    : m_store(Gtk::ListStore::create(m_columns))
+    , m_tree_view(m_store)
+  {
+    const auto& font = utils::get_monospace_font();
+
+    set_policy(Gtk::POLICY_NEVER, Gtk::POLICY_AUTOMATIC);
+    set_max_content_height(MAX_HEIGHT);
+    set_propagate_natural_height(true);
+
+    m_tree_view.set_headers_visible(false);
+    m_tree_view.set_enable_search(false);
+    m_tree_view.set_can_focus(false);
+    m_tree_view.override_font(font);
+    m_tree_view.override_background_color(theme::window_background);
+    m_tree_view.override_color(theme::window_foreground);
+    m_tree_view.append_column("", m_columns.value);
+    m_tree_view.append_column("", m_columns.description);
+    for (const auto column : m_tree_view.get_columns())
+    {
+      for (const auto renderer : column->get_cells())
+      {
+        if (const auto text = dynamic_cast<Gtk::CellRendererText*>(renderer))
+        {
+          text->property_ellipsize() = Pango::ELLIPSIZE_END;
+        }
+      }
+      column->set_expand(true);
+    }
+
+    add(m_tree_view);
+    m_tree_view.show();
+    set_no_show_all(true);
+  }
+
+  void
+  CompletionView::set_items(const std::vector<CompletionItem>& items)
+  {
+    m_store->clear();
+    for (const auto& item : items)
+    {
+      auto row = *m_store->append();
+
+      row[m_columns.value] = item.value;
+      row[m_columns.description] = item.description;
+    }
+    if (items.empty())
+    {
+      hide();
+    } else {
+      get_vadjustment()->set_value(0);
+      show();
+    }
+  }
+
+  void
+  CompletionView::clear()
+  {
+    m_store->clear();
+    hide();
+  }
+
+  Glib::ustring
+  CompletionView::select_next()
+  {
+    return select(1);
+  }
+
+  Glib::ustring
+  CompletionView::select_prev()
+  {
+    return select(-1);
+  }
+
+  Glib::ustring
+  CompletionView::select(int offset)
+  {
+    const auto selection = m_tree_view.get_selection();
+    const auto size = static_cast<int>(m_store->children().size());
+    int index = offset > 0 ? 0 : size - 1;
+    Gtk::TreeModel::Path path;
+
+    if (!size)
+    {
+      return Glib::ustring();
+    }
+    if (const auto selected = selection->get_selected())
+    {
+      index = (m_store->get_path(selected)[0] + offset + size) % size;
+    }
+    path.push_back(index);
+    selection->select(path);
+    m_tree_view.scroll_to_row(path);
+
+    return (*m_store->get_iter(path))[m_columns.value];
+  }
+}
@@ -0,0 +1,567 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/bookmarks.hpp>
+#include <selain/completion.hpp>
+#include <selain/history.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+namespace selain
+{
+  // Maximum number of candidates returned by a single query.
+  static const std::size_t MAX_RESULTS = 50;
+
+  // How often long running sources check whether their query has been
+  // cancelled, and how often they publish partial results.
+  static const std::size_t CANCELLATION_CHECK_INTERVAL = 1024;
+  static const std::size_t PUBLISH_INTERVAL = 65536;
+
+  static inline bool
+  compare_items(const CompletionItem& a, const CompletionItem& b)
+  {
+    return a.score > b.score || (a.score == b.score && a.value < b.value);
+  }
+
+  /**
+   * Scores given candidate against the pattern being completed. Returns
+   * negative value if the candidate does not match the pattern at all.
+   */
+  static inline double
+  score_match(const std::string& candidate, const fuzzy::Pattern& pattern)
+  {
+    int result;
+
+    if (!fuzzy::score(pattern, candidate, result))
+    {
+      return -1.0;
+    }
+
+    return static_cast<double>(result);
+  }
+
+  static inline double
+  score_match(const std::string& value,
+              const std::string& description,
+              const fuzzy::Pattern& pattern)
+  {
+    return std::max(
+      score_match(value, pattern),
+      score_match(description, pattern) - 10.0
+    );
+  }
+
+  CompletionQuery::CompletionQuery(
+    const std::string& command,
+    const std::string& argument,
+    unsigned int generation,
+    const std::atomic<unsigned int>& current_generation,
+    const publish_callback_type& publish_callback
+  )
+    : m_command(command)
+    , m_argument(argument)
+    , m_pattern(argument)
+    , m_generation(generation)
+    , m_current_generation(current_generation)
+    , m_publish_callback(publish_callback)
+  {
+    m_items.reserve(MAX_RESULTS);
+  }
+
+  void
+  CompletionQuery::add(CompletionItem&& item)
+  {
+    // Items are kept in a heap where the item with lowest score is first.
+    if (m_items.size() < MAX_RESULTS)
+    {
+      m_items.push_back(std::move(item));
+      std::push_heap(std::begin(m_items), std::end(m_items), compare_items);
+    }
+    else if (compare_items(item, m_items.front()))
+    {
+      std::pop_heap(std::begin(m_items), std::end(m_items), compare_items);
+      m_items.back() = std::move(item);
+      std::push_heap(std::begin(m_items), std::end(m_items), compare_items);
+    }
+  }
+
+  void
+  CompletionQuery::publish()
+  {
+    if (!is_cancelled())
+    {
+      m_publish_callback(*this);
+    }
+  }
+
+  std::vector<CompletionItem>
+  CompletionQuery::get_results() const
+  {
+    auto results = m_items;
+
+    std::sort(std::begin(results), std::end(results), compare_items);
+
+    return results;
+  }
+
+  CommandCompletionSource::CommandCompletionSource(
+    const std::unordered_map<std::string, Command>& mapping
+  )
+  {
+    for (const auto& entry : mapping)
+    {
+      const auto& command = entry.second;
+
+      // Skip shortcuts, which are also present in the mapping.
+      if (!command.name || entry.first != command.name)
+      {
+        continue;
+      }
+      m_commands.push_back({
+        command.name,
+        command.name_shortcut && *command.name_shortcut
+          ? std::string(":") + command.name_shortcut
+          : std::string(),
+        0.0
+      });
+    }
+  }
+
+  bool
+  CommandCompletionSource::accepts(const std::string& command) const
+  {
+    return command.empty();
+  }
+
+  void
+  CommandCompletionSource::complete(CompletionQuery& query)
+  {
+    for (const auto& command : m_commands)
+    {
+      const auto score = score_match(command.value, query.get_pattern());
+
+      if (score >= 0.0)
+      {
+        query.add({ command.value, command.description, score });
+      }
+    }
+  }
+
+  HistoryCompletionSource::HistoryCompletionSource(const History& history)
+    : m_history(history) {}
+
+  bool
+  HistoryCompletionSource::accepts(const std::string& command) const
+  {
+    return command == "open" || command == "open-tab";
+  }
+
+  void
+  HistoryCompletionSource::complete(CompletionQuery& query)
+  {
+    const auto& pattern = query.get_pattern();
+    const auto now = static_cast<std::int64_t>(std::time(nullptr));
+    std::size_t count = 0;
+    std::size_t match_count = 0;
+
+    m_history.for_each([&](const HistoryEntry& entry)
+    {
+      double score;
+
+      if (!(++count % CANCELLATION_CHECK_INTERVAL))
+      {
+        if (query.is_cancelled())
+        {
+          return false;
+        }
+        else if (!(count % PUBLISH_INTERVAL))
+        {
+          query.publish();
+        }
+      }
+      if ((score = score_match(entry.uri, entry.title, pattern)) < 0.0)
+      {
+        return true;
+      }
+      query.add({
+        entry.uri,
+        entry.title,
+        score + 10.0 * std::log1p(History::get_score(entry, now))
+      });
+
+      // Entries are iterated in order of their frecency, so when there is
+      // nothing to match against, the first ones are all that is needed.
+      return !pattern.empty() || ++match_count < MAX_RESULTS;
+    });
+  }
+
+  BookmarkCompletionSource::BookmarkCompletionSource(
+    const Bookmarks& bookmarks
+  )
+    : m_bookmarks(bookmarks) {}
+
+  bool
+  BookmarkCompletionSource::accepts(const std::string& command) const
+  {
+    return command == "open"
+      || command == "open-tab"
+      || command == "quickmark"
+      || command == "quickmark-add";
+  }
+
+  void
+  BookmarkCompletionSource::complete(CompletionQuery& query)
+  {
+    const auto& argument = query.get_argument();
+    std::string::size_type pos;
+    std::size_t count = 0;
+
+    if (query.get_command() == "quickmark"
+        || query.get_command() == "quickmark-add")
+    {
+      complete_quickmarks(query);
+      return;
+    }
+
+    if (argument.length() > 1
+        && argument[0] == '#'
+        && (pos = argument.find(' ')) != std::string::npos)
+    {
+      const fuzzy::Pattern pattern(argument.substr(pos + 1));
+
+      // Bookmarks with the tag are looked up from the tag index. The tag is
+      // replaced along with rest of the argument when a candidate is chosen.
+      for (const auto& bookmark : m_bookmarks.find_by_tag(
+        argument.substr(1, pos - 1)
+      ))
+      {
+        const auto score = score_match(bookmark.uri, bookmark.title, pattern);
+
+        if (score >= 0.0)
+        {
+          query.add({ bookmark.uri, bookmark.title, score + 10.0 });
+        }
+      }
+      return;
+    }
+
+    m_bookmarks.for_each([&](const Bookmark& bookmark)
+    {
+      double score;
+
+      if (!(++count % CANCELLATION_CHECK_INTERVAL) && query.is_cancelled())
+      {
+        return false;
+      }
+      score = score_match(bookmark.uri, bookmark.title, query.get_pattern());
+      if (score >= 0.0)
+      {
+        query.add({ bookmark.uri, bookmark.title, score + 10.0 });
+      }
+
+      return true;
+    });
+  }
+
+  void
+  BookmarkCompletionSource::complete_quickmarks(CompletionQuery& query)
+  {
+    for (const auto& quickmark : m_bookmarks.get_quickmarks())
+    {
+      const auto score = score_match(quickmark.first, query.get_pattern());
+
+      if (score >= 0.0)
+      {
+        query.add({ quickmark.first, quickmark.second, score });
+      }
+    }
+  }
+
+  bool
+  TabCompletionSource::accepts(const std::string& command) const
+  {
+    return command == "open"
+      || command == "open-tab"
+      || command == "buffer";
+  }
+
+  void
+  TabCompletionSource::complete(CompletionQuery& query)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    if (query.get_command() == "buffer")
+    {
+      complete_buffer(query);
+      return;
+    }
+    for (const auto& tab : m_tabs)
+    {
+      const auto score = score_match(
+        tab.uri,
+        tab.title,
+        query.get_pattern()
+      );
+
+      if (score >= 0.0)
+      {
+        query.add({ tab.uri, tab.title, score + 5.0 });
+      }
+    }
+  }
+
+  void
+  TabCompletionSource::complete_buffer(CompletionQuery& query)
+  {
+    fuzzy::match(query.get_pattern(), m_arena, MAX_RESULTS, m_matches);
+
+    // Matches are already sorted by their score and position of the tab, so
+    // the rank is used as the score to keep that order.
+    for (std::size_t i = 0; i < m_matches.size(); ++i)
+    {
+      const auto& tab = m_tabs[m_matches[i].index];
+
+      query.add({
+        std::to_string(tab.index + 1),
+        tab.title.empty() ? tab.uri : tab.title + " - " + tab.uri,
+        -static_cast<double>(i)
+      });
+    }
+  }
+
+  void
+  TabCompletionSource::set_tabs(std::vector<TabInfo>&& tabs)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    std::size_t bytes = 0;
+
+    m_tabs = std::move(tabs);
+    for (const auto& tab : m_tabs)
+    {
+      bytes += tab.title.length() + tab.uri.length() + 1;
+    }
+    m_arena.clear();
+    m_arena.reserve(m_tabs.size(), bytes);
+    for (const auto& tab : m_tabs)
+    {
+      m_arena.add(tab.title + ' ' + tab.uri);
+    }
+  }
+
+  int
+  TabCompletionSource::find(const std::string& query)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    fuzzy::match(fuzzy::Pattern(query), m_arena, 1, m_matches);
+
+    return m_matches.empty() ? -1 : m_tabs[m_matches[0].index].index;
+  }
+
+  Completion::Completion()
+    : m_generation(0)
+    , m_results_generation(0)
+    , m_running(true)
+    , m_thread(&Completion::run, this)
+  {
+    m_dispatcher.connect(sigc::mem_fun(
+      this,
+      &Completion::on_results_available
+    ));
+  }
+
+  Completion::~Completion()
+  {
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      m_running = false;
+      ++m_generation;
+    }
+    m_condition.notify_one();
+    m_thread.join();
+  }
+
+  void
+  Completion::add_source(const std::shared_ptr<CompletionSource>& source)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    m_sources.push_back(source);
+  }
+
+  void
+  Completion::set_command_mapping(
+    const std::unordered_map<std::string, Command>& mapping
+  )
+  {
+    m_command_names.clear();
+    for (const auto& entry : mapping)
+    {
+      if (entry.second.name)
+      {
+        m_command_names[entry.first] = entry.second.name;
+      }
+    }
+  }
+
+  void
+  Completion::complete(const Glib::ustring& text)
+  {
+    auto request = std::unique_ptr<Request>(new Request());
+    Glib::ustring::size_type pos;
+
+    if (text.empty() || text[0] != ':')
+    {
+      cancel();
+      return;
+    }
+
+    if ((pos = text.find(' ')) == Glib::ustring::npos)
+    {
+      m_prefix = ":";
+      request->argument = text.substr(1).raw();
+    } else {
+      const auto name = text.substr(1, pos - 1).raw();
+      const auto entry = m_command_names.find(name);
+      auto argument_pos = text.find_first_not_of(' ', pos);
+
+      if (argument_pos == Glib::ustring::npos)
+      {
+        argument_pos = text.length();
+      }
+      m_prefix = text.substr(0, argument_pos);
+      request->command = entry != std::end(m_command_names)
+        ? entry->second
+        : name;
+      request->argument = text.substr(argument_pos).raw();
+    }
+
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      request->generation = ++m_generation;
+      m_request = std::move(request);
+    }
+    m_condition.notify_one();
+  }
+
+  void
+  Completion::cancel()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    ++m_generation;
+    m_request.reset();
+  }
+
+  void
+  Completion::run()
+  {
+    const auto publish = [this](const CompletionQuery& query)
+    {
+      {
+        std::lock_guard<std::mutex> guard(m_mutex);
+
+        if (query.get_generation() != m_generation)
+        {
+          return;
+        }
+        m_results = query.get_results();
+        m_results_generation = query.get_generation();
+      }
+      m_dispatcher.emit();
+    };
+
+    for (;;)
+    {
+      std::unique_ptr<Request> request;
+      std::vector<std::shared_ptr<CompletionSource>> sources;
+
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_condition.wait(lock, [this]()
+        {
+          return !m_running || m_request;
+        });
+        if (!m_running)
+        {
+          break;
+        }
+        request = std::move(m_request);
+        sources = m_sources;
+      }
+
+      CompletionQuery query(
+        request->command,
+        request->argument,
+        request->generation,
+        m_generation,
+        publish
+      );
+      bool published = false;
+
+      // Results are published after each source, so that candidates from
+      // fast sources are displayed while slower ones are still processed.
+      for (const auto& source : sources)
+      {
+        if (query.is_cancelled())
+        {
+          break;
+        }
+        if (source->accepts(query.get_command()))
+        {
+          source->complete(query);
+          query.publish();
+          published = true;
+        }
+      }
+      if (!published)
+      {
+        query.publish();
+      }
+    }
+  }
+
+  void
+  Completion::on_results_available()
+  {
+    std::vector<CompletionItem> results;
+
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      if (m_results_generation != m_generation)
+      {
+        return;
+      }
+      results.swap(m_results);
+    }
+    m_signal_results.emit(results);
+  }
+}
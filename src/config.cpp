@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/config.hpp>
+
+namespace selain
+{
+  // Editors tend to write files in several steps, so the file is reloaded
+  // only after it has not changed for this many milliseconds.
+  static const unsigned int RELOAD_DELAY = 100;
+
+  Config::Config()
+    : m_monitor(nullptr) {}
+
+  Config::~Config()
+  {
+    m_reload_connection.disconnect();
+    if (m_monitor)
+    {
+      ::g_file_monitor_cancel(m_monitor);
+      ::g_object_unref(m_monitor);
+    }
+  }
+
+  std::string
+  Config::get_default_path()
+  {
+    const auto path = ::g_build_filename(
+      ::g_get_user_config_dir(),
+      "selain",
+      "config",
+      nullptr
+    );
+    const std::string result(path);
+
+    ::g_free(path);
+
+    return result;
+  }
+
+  void
+  Config::open(const std::string& path)
+  {
+    const auto file = ::g_file_new_for_path(path.c_str());
+    ::GError* error = nullptr;
+
+    m_path = path;
+    load();
+    if (!(m_monitor = ::g_file_monitor_file(
+      file,
+      G_FILE_MONITOR_NONE,
+      nullptr,
+      &error
+    )))
+    {
+      ::g_warning("Unable to watch %s: %s", path.c_str(), error->message);
+      ::g_error_free(error);
+    } else {
+      ::g_signal_connect(
+        G_OBJECT(m_monitor),
+        "changed",
+        G_CALLBACK(on_file_changed),
+        static_cast<::gpointer>(this)
+      );
+    }
+    ::g_object_unref(file);
+  }
+
+  std::string
+  Config::get(const std::string& group, const std::string& key) const
+  {
+    const auto value = m_values.find({ group, key });
+
+    return value != std::end(m_values) ? value->second : std::string();
+  }
+
+  std::vector<std::pair<std::string, std::string>>
+  Config::get_group(const std::string& group) const
+  {
+    std::vector<std::pair<std::string, std::string>> result;
+
+    for (auto it = m_values.lower_bound({ group, std::string() });
+         it != std::end(m_values) && it->first.first == group;
+         ++it)
+    {
+      result.emplace_back(it->first.second, it->second);
+    }
+
+    return result;
+  }
+
+  void
+  Config::load()
+  {
+    const auto key_file = ::g_key_file_new();
+    decltype(m_values) values;
+    ::GError* error = nullptr;
+    ::gchar** groups;
+
+    if (!::g_key_file_load_from_file(
+      key_file,
+      m_path.c_str(),
+      G_KEY_FILE_NONE,
+      &error
+    ))
+    {
+      // Keep the previous configuration while the file is being edited
+      // into a valid state.
+      if (!::g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+      {
+        ::g_warning("Unable to load %s: %s", m_path.c_str(), error->message);
+        ::g_error_free(error);
+        ::g_key_file_free(key_file);
+        return;
+      }
+      ::g_error_free(error);
+    }
+
+    groups = ::g_key_file_get_groups(key_file, nullptr);
+    for (auto group = groups; *group; ++group)
+    {
+      const auto keys = ::g_key_file_get_keys(
+        key_file,
+        *group,
+        nullptr,
+        nullptr
+      );
+
+      for (auto key = keys; key && *key; ++key)
+      {
+        if (const auto value = ::g_key_file_get_string(
+          key_file,
+          *group,
+          *key,
+          nullptr
+        ))
+        {
+          values[{ *group, *key }] = value;
+          ::g_free(value);
+        }
+      }
+      ::g_strfreev(keys);
+    }
+    ::g_strfreev(groups);
+    ::g_key_file_free(key_file);
+
+    std::swap(m_values, values);
+    for (const auto& entry : m_values)
+    {
+      const auto previous = values.find(entry.first);
+
+      if (previous == std::end(values) || previous->second != entry.second)
+      {
+        m_signal_changed.emit(
+          entry.first.first,
+          entry.first.second,
+          entry.second
+        );
+      }
+    }
+    for (const auto& entry : values)
+    {
+      if (m_values.find(entry.first) == std::end(m_values))
+      {
+        m_signal_changed.emit(
+          entry.first.first,
+          entry.first.second,
+          std::string()
+        );
+      }
+    }
+  }
+
+  bool
+  Config::on_reload_timeout()
+  {
+    load();
+
+    return false;
+  }
+
+  void
+  Config::on_file_changed(::GFileMonitor*,
+                          ::GFile*,
+                          ::GFile*,
+                          ::GFileMonitorEvent event,
+                          ::gpointer data)
+  {
+    const auto config = static_cast<Config*>(data);
+
+    if (event != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT &&
+        event != G_FILE_MONITOR_EVENT_CREATED &&
+        event != G_FILE_MONITOR_EVENT_DELETED)
+    {
+      return;
+    }
+    config->m_reload_connection.disconnect();
+    config->m_reload_connection = Glib::signal_timeout().connect(
+      sigc::mem_fun(config, &Config::on_reload_timeout),
+      RELOAD_DELAY
+    );
+  }
+}
@@ -0,0 +1,961 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/content-filter.hpp>
+#include <selain/utils.hpp>
+
+#include <glib/gstdio.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
+namespace selain
+{
+  // Identifier of the compiled filter in the content filter store.
+  static const char* FILTER_IDENTIFIER = "selain";
+
+  // Identifier and rules of the filter which blocks web fonts and media in
+  // tabs using the lite settings profile. Images, scripts and WebGL are
+  // disabled by the WebKit settings of the profile instead.
+  static const char* LITE_FILTER_IDENTIFIER = "selain-lite";
+  static const char* LITE_FILTER_RULES =
+    "[{\"trigger\":{\"url-filter\":\".*\","
+    "\"resource-type\":[\"font\",\"media\"]},"
+    "\"action\":{\"type\":\"block\"}}]";
+
+  // Should be incremented whenever conversion of the filter lists changes,
+  // so that filters compiled by older versions are compiled again.
+  static const int CONVERTER_VERSION = 1;
+
+  // WebKit refuses to compile content blockers with more rules than this.
+  static const std::size_t MAX_RULES = 150000;
+
+  // Generic element hiding selectors are combined into rules of this many
+  // selectors, as thousands of single selector rules are slow to apply.
+  static const std::size_t SELECTORS_PER_RULE = 250;
+
+  static const std::unordered_map<std::string, const char*> resource_types =
+  {
+    { "document", "document" },
+    { "font", "font" },
+    { "image", "image" },
+    { "media", "media" },
+    { "object", "media" },
+    { "other", "raw" },
+    { "ping", "raw" },
+    { "popup", "popup" },
+    { "script", "script" },
+    { "stylesheet", "style-sheet" },
+    { "subdocument", "document" },
+    { "websocket", "raw" },
+    { "xmlhttprequest", "raw" },
+  };
+
+  static const char* all_resource_types[] =
+  {
+    "document",
+    "font",
+    "image",
+    "media",
+    "popup",
+    "raw",
+    "script",
+    "style-sheet",
+    "svg-document",
+  };
+
+  // Extended CSS syntax of the ad blockers, which browsers do not support.
+  static const char* extended_selectors[] =
+  {
+    ":-abp-",
+    ":contains(",
+    ":has-text(",
+    ":matches-css",
+    ":remove(",
+    ":style(",
+    ":upward(",
+    ":xpath(",
+  };
+
+  namespace
+  {
+    struct Rule
+    {
+      std::string url_filter;
+      bool case_sensitive = false;
+      std::vector<std::string> resource_types;
+      std::vector<std::string> load_types;
+      std::vector<std::string> if_domains;
+      std::vector<std::string> unless_domains;
+      const char* action = "block";
+      std::string selector;
+    };
+  }
+
+  static void
+  append_json_string(std::string& output, const std::string& input)
+  {
+    char buffer[7];
+
+    output.append(1, '"');
+    for (const auto c : input)
+    {
+      if (c == '"' || c == '\\')
+      {
+        output.append(1, '\\');
+        output.append(1, c);
+      }
+      else if (static_cast<unsigned char>(c) < 0x20)
+      {
+        std::snprintf(buffer, 7, "\\u%04x", static_cast<unsigned int>(c));
+        output.append(buffer);
+      } else {
+        output.append(1, c);
+      }
+    }
+    output.append(1, '"');
+  }
+
+  static void
+  append_json_array(std::string& output,
+                    const char* name,
+                    const std::vector<std::string>& items)
+  {
+    if (items.empty())
+    {
+      return;
+    }
+    output.append(",\"").append(name).append("\":[");
+    for (std::size_t i = 0; i < items.size(); ++i)
+    {
+      if (i > 0)
+      {
+        output.append(1, ',');
+      }
+      append_json_string(output, items[i]);
+    }
+    output.append(1, ']');
+  }
+
+  static void
+  append_rule(std::string& output, const Rule& rule)
+  {
+    if (!output.empty())
+    {
+      output.append(1, ',');
+    }
+    output.append("{\"trigger\":{\"url-filter\":");
+    append_json_string(output, rule.url_filter);
+    if (rule.case_sensitive)
+    {
+      output.append(",\"url-filter-is-case-sensitive\":true");
+    }
+    append_json_array(output, "resource-type", rule.resource_types);
+    append_json_array(output, "load-type", rule.load_types);
+    append_json_array(output, "if-domain", rule.if_domains);
+    append_json_array(output, "unless-domain", rule.unless_domains);
+    output.append("},\"action\":{\"type\":\"").append(rule.action);
+    output.append(1, '"');
+    if (!rule.selector.empty())
+    {
+      output.append(",\"selector\":");
+      append_json_string(output, rule.selector);
+    }
+    output.append("}}");
+  }
+
+  static bool
+  is_ascii(const std::string& input)
+  {
+    return std::all_of(
+      std::begin(input),
+      std::end(input),
+      [](const char c)
+      {
+        return !(static_cast<unsigned char>(c) & 0x80);
+      }
+    );
+  }
+
+  /**
+   * Parses list of domains given to a filter, which are either included or,
+   * when prefixed with "~", excluded. Content blocker rules can either
+   * include or exclude domains but not both, so false is returned for lists
+   * containing both.
+   */
+  static bool
+  parse_domains(const std::string& input, char separator, Rule& rule)
+  {
+    std::string::size_type start = 0;
+
+    while (start <= input.length())
+    {
+      auto end = input.find(separator, start);
+      std::string domain;
+      bool negated;
+
+      if (end == std::string::npos)
+      {
+        end = input.length();
+      }
+      domain = input.substr(start, end - start);
+      start = end + 1;
+      if (domain.empty())
+      {
+        continue;
+      }
+      if ((negated = domain[0] == '~'))
+      {
+        domain.erase(0, 1);
+      }
+      if (domain.empty() ||
+          !is_ascii(domain) ||
+          domain.find('*') != std::string::npos)
+      {
+        return false;
+      }
+      std::transform(
+        std::begin(domain),
+        std::end(domain),
+        std::begin(domain),
+        ::tolower
+      );
+      (negated ? rule.unless_domains : rule.if_domains).push_back(
+        "*" + domain
+      );
+    }
+
+    return rule.if_domains.empty() || rule.unless_domains.empty();
+  }
+
+  /**
+   * Converts URL pattern of a network filter into regular expression
+   * supported by the content blocker.
+   */
+  static bool
+  convert_pattern(const std::string& pattern, std::string& result)
+  {
+    std::string::size_type start = 0;
+    auto end = pattern.length();
+    bool end_anchor = false;
+
+    if (!pattern.compare(0, 2, "||"))
+    {
+      result = "^[^:]+://+([^/:]+\\.)?";
+      start = 2;
+    }
+    else if (!pattern.empty() && pattern[0] == '|')
+    {
+      result = "^";
+      start = 1;
+    }
+    if (end > start && pattern[end - 1] == '|')
+    {
+      end_anchor = true;
+      --end;
+    }
+    for (auto i = start; i < end; ++i)
+    {
+      const auto c = pattern[i];
+
+      switch (c)
+      {
+        case '*':
+          result.append(".*");
+          break;
+
+        // Separator matches anything but a letter, a digit or one of "_-.%".
+        case '^':
+          result.append("[/:?&=]");
+          break;
+
+        case '.':
+        case '+':
+        case '?':
+        case '{':
+        case '}':
+        case '(':
+        case ')':
+        case '[':
+        case ']':
+        case '\\':
+        case '|':
+        case '$':
+          result.append(1, '\\');
+          result.append(1, c);
+          break;
+
+        default:
+          if (static_cast<unsigned char>(c) & 0x80)
+          {
+            return false;
+          }
+          result.append(1, c);
+      }
+    }
+    if (end_anchor)
+    {
+      result.append(1, '$');
+    }
+    if (result.empty())
+    {
+      result = ".*";
+    }
+
+    return true;
+  }
+
+  /**
+   * Parses network filter such as "||ads.example.com^$third-party", which
+   * blocks requests, or exception filter prefixed with "@@".
+   */
+  static bool
+  parse_network_filter(const std::string& line, Rule& rule, bool& exception)
+  {
+    std::string pattern = line;
+    std::string options;
+    std::set<std::string> types;
+    std::set<std::string> excluded_types;
+    bool document = false;
+    std::string::size_type pos;
+
+    if ((exception = !pattern.compare(0, 2, "@@")))
+    {
+      pattern.erase(0, 2);
+    }
+    if ((pos = pattern.rfind('$')) != std::string::npos &&
+        pattern.find('/', pos) == std::string::npos)
+    {
+      options = pattern.substr(pos + 1);
+      pattern.erase(pos);
+    }
+
+    // Regular expression filters use syntax which the content blocker does
+    // not support.
+    if (pattern.length() > 1 && pattern[0] == '/' && pattern.back() == '/')
+    {
+      return false;
+    }
+
+    pos = 0;
+    while (!options.empty() && pos <= options.length())
+    {
+      auto end = options.find(',', pos);
+      std::string option;
+      std::string value;
+      bool negated;
+      std::string::size_type separator;
+
+      if (end == std::string::npos)
+      {
+        end = options.length();
+      }
+      option = options.substr(pos, end - pos);
+      pos = end + 1;
+      if ((negated = !option.empty() && option[0] == '~'))
+      {
+        option.erase(0, 1);
+      }
+      if ((separator = option.find('=')) != std::string::npos)
+      {
+        value = option.substr(separator + 1);
+        option.erase(separator);
+      }
+      if (option == "third-party" || option == "3p")
+      {
+        rule.load_types = { negated ? "first-party" : "third-party" };
+      }
+      else if (option == "first-party" || option == "1p")
+      {
+        rule.load_types = { negated ? "third-party" : "first-party" };
+      }
+      else if (option == "domain")
+      {
+        if (!parse_domains(value, '|', rule))
+        {
+          return false;
+        }
+      }
+      else if (option == "match-case")
+      {
+        rule.case_sensitive = true;
+      }
+      else if (exception && (
+        option == "document" ||
+        option == "elemhide" ||
+        option == "generichide"
+      ))
+      {
+        document = true;
+      } else {
+        const auto type = resource_types.find(option);
+
+        if (type == std::end(resource_types))
+        {
+          return false;
+        }
+        (negated ? excluded_types : types).insert(type->second);
+      }
+    }
+
+    if (!excluded_types.empty() && types.empty())
+    {
+      for (const auto type : all_resource_types)
+      {
+        if (!excluded_types.count(type))
+        {
+          types.insert(type);
+        }
+      }
+    }
+    rule.resource_types.assign(std::begin(types), std::end(types));
+
+    // Exceptions for whole pages can only be expressed for domains, as the
+    // content blocker has no trigger for URL of the page itself.
+    if (document)
+    {
+      if (pattern.compare(0, 2, "||") ||
+          !rule.if_domains.empty() ||
+          !rule.unless_domains.empty())
+      {
+        return false;
+      }
+      pattern.erase(0, 2);
+      if (!pattern.empty() && pattern.back() == '^')
+      {
+        pattern.pop_back();
+      }
+      if (pattern.empty() ||
+          pattern.find_first_of("/*^|") != std::string::npos ||
+          !parse_domains(pattern, ',', rule))
+      {
+        return false;
+      }
+      rule.url_filter = ".*";
+      rule.resource_types.clear();
+      rule.action = "ignore-previous-rules";
+
+      return true;
+    }
+    if (!convert_pattern(pattern, rule.url_filter))
+    {
+      return false;
+    }
+    if (exception)
+    {
+      rule.action = "ignore-previous-rules";
+    }
+
+    return true;
+  }
+
+  static void
+  flush_selectors(std::vector<std::string>& selectors, std::string& output)
+  {
+    Rule rule;
+
+    if (selectors.empty())
+    {
+      return;
+    }
+    rule.url_filter = ".*";
+    rule.action = "css-display-none";
+    for (const auto& selector : selectors)
+    {
+      if (!rule.selector.empty())
+      {
+        rule.selector.append(", ");
+      }
+      rule.selector.append(selector);
+    }
+    append_rule(output, rule);
+    selectors.clear();
+  }
+
+  std::size_t
+  ContentFilter::convert(std::istream& input,
+                         std::string& rules,
+                         std::string& exceptions,
+                         std::size_t limit)
+  {
+    std::vector<std::string> selectors;
+    std::size_t count = 0;
+    std::string line;
+
+    while (count < limit && std::getline(input, line))
+    {
+      std::string::size_type pos;
+
+      if (!line.empty() && line.back() == '\r')
+      {
+        line.pop_back();
+      }
+
+      // Skip empty lines, comments and the "[Adblock Plus 2.0]" header.
+      if (line.empty() || line[0] == '!' || line[0] == '[')
+      {
+        continue;
+      }
+
+      // Element hiding exceptions and snippet or extended CSS filters are
+      // not supported.
+      if (line.find("#@#") != std::string::npos ||
+          line.find("#?#") != std::string::npos ||
+          line.find("#$#") != std::string::npos)
+      {
+        continue;
+      }
+
+      if ((pos = line.find("##")) != std::string::npos)
+      {
+        const auto selector = line.substr(pos + 2);
+        Rule rule;
+
+        if (selector.empty() ||
+            !is_ascii(selector) ||
+            std::any_of(
+              std::begin(extended_selectors),
+              std::end(extended_selectors),
+              [&selector](const char* extension)
+              {
+                return selector.find(extension) != std::string::npos;
+              }
+            ))
+        {
+          continue;
+        }
+        if (!pos)
+        {
+          if (selectors.empty())
+          {
+            ++count;
+          }
+          selectors.push_back(selector);
+          if (selectors.size() >= SELECTORS_PER_RULE)
+          {
+            flush_selectors(selectors, rules);
+          }
+          continue;
+        }
+        if (!parse_domains(line.substr(0, pos), ',', rule))
+        {
+          continue;
+        }
+        rule.url_filter = ".*";
+        rule.action = "css-display-none";
+        rule.selector = selector;
+        append_rule(rules, rule);
+        ++count;
+      } else {
+        Rule rule;
+        bool exception;
+
+        if (parse_network_filter(line, rule, exception))
+        {
+          append_rule(exception ? exceptions : rules, rule);
+          ++count;
+        }
+      }
+    }
+    flush_selectors(selectors, rules);
+
+    return count;
+  }
+
+  /**
+   * Returns paths of the filter lists in given directory, in alphabetical
+   * order.
+   */
+  static std::vector<std::string>
+  get_filter_lists(const std::string& directory)
+  {
+    std::vector<std::string> result;
+
+    if (const auto dir = ::g_dir_open(directory.c_str(), 0, nullptr))
+    {
+      const char* name;
+
+      while ((name = ::g_dir_read_name(dir)))
+      {
+        const auto path = ::g_build_filename(
+          directory.c_str(),
+          name,
+          nullptr
+        );
+
+        if (::g_file_test(path, G_FILE_TEST_IS_REGULAR))
+        {
+          result.push_back(path);
+        }
+        ::g_free(path);
+      }
+      ::g_dir_close(dir);
+    }
+    std::sort(std::begin(result), std::end(result));
+
+    return result;
+  }
+
+  /**
+   * Returns string which identifies current versions of the filter lists,
+   * or empty string if there are no filter lists. It's stored alongside the
+   * compiled filter, so that changes to the filter lists can be detected
+   * without reading them.
+   */
+  static std::string
+  get_source_version(const std::string& directory)
+  {
+    const auto lists = get_filter_lists(directory);
+    std::stringstream result;
+
+    if (lists.empty())
+    {
+      return std::string();
+    }
+    result << CONVERTER_VERSION << '\n';
+    for (const auto& path : lists)
+    {
+      ::GStatBuf buffer;
+
+      if (!::g_stat(path.c_str(), &buffer))
+      {
+        result << path << '\t'
+               << buffer.st_size << '\t'
+               << buffer.st_mtime << '\n';
+      }
+    }
+
+    return result.str();
+  }
+
+  ContentFilter::ContentFilter()
+    : m_store(nullptr)
+    , m_filter(nullptr)
+    , m_lite_filter(nullptr)
+    , m_source_directory(utils::get_data_file_path("filters"))
+  {
+    const auto store_directory = ::g_build_filename(
+      ::g_get_user_cache_dir(),
+      "selain",
+      "content-filters",
+      nullptr
+    );
+    const auto version_path = ::g_build_filename(
+      store_directory,
+      "version",
+      nullptr
+    );
+
+    m_store = ::webkit_user_content_filter_store_new(store_directory);
+    m_version_path = version_path;
+    ::g_free(store_directory);
+    ::g_free(version_path);
+
+    m_dispatcher.connect(sigc::mem_fun(this, &ContentFilter::on_compiled));
+  }
+
+  ContentFilter::~ContentFilter()
+  {
+    if (m_thread.joinable())
+    {
+      m_thread.join();
+    }
+    for (const auto manager : m_managers)
+    {
+      ::g_object_weak_unref(
+        G_OBJECT(manager),
+        on_manager_finalized,
+        static_cast<::gpointer>(this)
+      );
+    }
+    if (m_filter)
+    {
+      ::webkit_user_content_filter_unref(m_filter);
+    }
+    if (m_lite_filter)
+    {
+      ::webkit_user_content_filter_unref(m_lite_filter);
+    }
+    ::g_object_unref(m_store);
+  }
+
+  void
+  ContentFilter::load()
+  {
+    std::ifstream input(m_version_path);
+    std::stringstream stored_version;
+    const auto lite_rules = ::g_bytes_new_static(
+      LITE_FILTER_RULES,
+      std::strlen(LITE_FILTER_RULES)
+    );
+
+    ::webkit_user_content_filter_store_save(
+      m_store,
+      LITE_FILTER_IDENTIFIER,
+      lite_rules,
+      nullptr,
+      on_lite_save_finished,
+      static_cast<::gpointer>(this)
+    );
+    ::g_bytes_unref(lite_rules);
+
+    if ((m_version = get_source_version(m_source_directory)).empty())
+    {
+      return;
+    }
+    stored_version << input.rdbuf();
+    if (stored_version.str() != m_version)
+    {
+      compile();
+      return;
+    }
+    ::webkit_user_content_filter_store_load(
+      m_store,
+      FILTER_IDENTIFIER,
+      nullptr,
+      on_load_finished,
+      static_cast<::gpointer>(this)
+    );
+  }
+
+  void
+  ContentFilter::install(::WebKitUserContentManager* manager)
+  {
+    m_managers.push_back(manager);
+    ::g_object_weak_ref(
+      G_OBJECT(manager),
+      on_manager_finalized,
+      static_cast<::gpointer>(this)
+    );
+    if (m_filter)
+    {
+      ::webkit_user_content_manager_add_filter(manager, m_filter);
+    }
+  }
+
+  void
+  ContentFilter::set_lite(::WebKitUserContentManager* manager, bool lite)
+  {
+    const auto position = std::find(
+      std::begin(m_lite_managers),
+      std::end(m_lite_managers),
+      manager
+    );
+
+    if (lite && position == std::end(m_lite_managers))
+    {
+      m_lite_managers.push_back(manager);
+      if (m_lite_filter)
+      {
+        ::webkit_user_content_manager_add_filter(manager, m_lite_filter);
+      }
+    }
+    else if (!lite && position != std::end(m_lite_managers))
+    {
+      m_lite_managers.erase(position);
+      if (m_lite_filter)
+      {
+        ::webkit_user_content_manager_remove_filter(manager, m_lite_filter);
+      }
+    }
+  }
+
+  void
+  ContentFilter::compile()
+  {
+    if (m_thread.joinable())
+    {
+      return;
+    }
+    m_thread = std::thread([this]()
+    {
+      std::string rules;
+      std::string exceptions;
+      std::size_t count = 0;
+
+      for (const auto& path : get_filter_lists(m_source_directory))
+      {
+        std::ifstream input(path);
+
+        count += convert(input, rules, exceptions, MAX_RULES - count);
+      }
+      if (count > 0)
+      {
+        m_rules = "[" + rules;
+        if (!rules.empty() && !exceptions.empty())
+        {
+          m_rules.append(1, ',');
+        }
+        m_rules.append(exceptions).append(1, ']');
+      }
+      m_dispatcher.emit();
+    });
+  }
+
+  void
+  ContentFilter::on_compiled()
+  {
+    ::GBytes* bytes;
+
+    m_thread.join();
+    if (m_rules.empty())
+    {
+      return;
+    }
+    bytes = ::g_bytes_new(m_rules.data(), m_rules.length());
+    std::string().swap(m_rules);
+    ::webkit_user_content_filter_store_save(
+      m_store,
+      FILTER_IDENTIFIER,
+      bytes,
+      nullptr,
+      on_save_finished,
+      static_cast<::gpointer>(this)
+    );
+    ::g_bytes_unref(bytes);
+  }
+
+  void
+  ContentFilter::apply(::WebKitUserContentFilter* filter)
+  {
+    if (m_filter)
+    {
+      ::webkit_user_content_filter_unref(m_filter);
+    }
+    m_filter = ::webkit_user_content_filter_ref(filter);
+    for (const auto manager : m_managers)
+    {
+      ::webkit_user_content_manager_remove_all_filters(manager);
+      ::webkit_user_content_manager_add_filter(manager, m_filter);
+    }
+    if (m_lite_filter)
+    {
+      for (const auto manager : m_lite_managers)
+      {
+        ::webkit_user_content_manager_add_filter(manager, m_lite_filter);
+      }
+    }
+  }
+
+  void
+  ContentFilter::on_load_finished(::GObject* source,
+                                  ::GAsyncResult* result,
+                                  ::gpointer data)
+  {
+    const auto content_filter = static_cast<ContentFilter*>(data);
+    ::GError* error = nullptr;
+    const auto filter = ::webkit_user_content_filter_store_load_finish(
+      WEBKIT_USER_CONTENT_FILTER_STORE(source),
+      result,
+      &error
+    );
+
+    // Compiled filter may have been removed from the cache directory, or it
+    // has been compiled by an incompatible version of WebKit.
+    if (!filter)
+    {
+      ::g_error_free(error);
+      content_filter->compile();
+      return;
+    }
+    content_filter->apply(filter);
+    ::webkit_user_content_filter_unref(filter);
+  }
+
+  void
+  ContentFilter::on_save_finished(::GObject* source,
+                                  ::GAsyncResult* result,
+                                  ::gpointer data)
+  {
+    const auto content_filter = static_cast<ContentFilter*>(data);
+    ::GError* error = nullptr;
+    const auto filter = ::webkit_user_content_filter_store_save_finish(
+      WEBKIT_USER_CONTENT_FILTER_STORE(source),
+      result,
+      &error
+    );
+
+    if (!filter)
+    {
+      ::g_warning("Unable to compile content filter: %s", error->message);
+      ::g_error_free(error);
+      return;
+    }
+    std::ofstream(content_filter->m_version_path) << content_filter->m_version;
+    content_filter->apply(filter);
+    ::webkit_user_content_filter_unref(filter);
+  }
+
+  void
+  ContentFilter::on_lite_save_finished(::GObject* source,
+                                       ::GAsyncResult* result,
+                                       ::gpointer data)
+  {
+    const auto content_filter = static_cast<ContentFilter*>(data);
+    ::GError* error = nullptr;
+    const auto filter = ::webkit_user_content_filter_store_save_finish(
+      WEBKIT_USER_CONTENT_FILTER_STORE(source),
+      result,
+      &error
+    );
+
+    if (!filter)
+    {
+      ::g_warning("Unable to compile lite filter: %s", error->message);
+      ::g_error_free(error);
+      return;
+    }
+    content_filter->m_lite_filter = filter;
+    for (const auto manager : content_filter->m_lite_managers)
+    {
+      ::webkit_user_content_manager_add_filter(manager, filter);
+    }
+  }
+
+  void
+  ContentFilter::on_manager_finalized(::gpointer data, ::GObject* manager)
+  {
+    const auto content_filter = static_cast<ContentFilter*>(data);
+    const auto finalized = reinterpret_cast<::WebKitUserContentManager*>(
+      manager
+    );
+
+    for (auto managers : {
+      &content_filter->m_managers,
+      &content_filter->m_lite_managers
+    })
+    {
+      managers->erase(
+        std::remove(std::begin(*managers), std::end(*managers), finalized),
+        std::end(*managers)
+      );
+    }
+  }
+}
@@ -0,0 +1,509 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/disk-cache.hpp>
+#include <selain/utils.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace selain
+{
+  // How often the cache is checked against it's quota, in seconds. The
+  // first check is made shortly after startup.
+  static const unsigned int SWEEP_INITIAL_DELAY = 30;
+  static const unsigned int SWEEP_INTERVAL = 10 * 60;
+
+  // Once the cache is over it's quota, data is removed until the cache is
+  // below this percentage of the quota, so that sweeping is not needed
+  // again right away.
+  static const std::uint64_t SWEEP_TARGET_PERCENTAGE = 90;
+
+  // Access times older than this are forgotten, in seconds.
+  static const std::int64_t ACCESS_TIME_RETENTION = 90 * 24 * 60 * 60;
+
+  /**
+   * Extracts host name from given HTTP(S) URI.
+   */
+  static std::string
+  get_host(const std::string& uri)
+  {
+    std::string::size_type start;
+    std::string::size_type end;
+
+    if (!uri.compare(0, 7, "http://"))
+    {
+      start = 7;
+    }
+    else if (!uri.compare(0, 8, "https://"))
+    {
+      start = 8;
+    } else {
+      return std::string();
+    }
+    if ((end = uri.find_first_of("/:?#", start)) == std::string::npos)
+    {
+      end = uri.length();
+    }
+
+    return uri.substr(start, end - start);
+  }
+
+  /**
+   * Counts cache records stored under given directory. WebKit stores each
+   * cached resource as a separate file under a directory named "Records".
+   */
+  static std::size_t
+  count_records(const std::string& path, bool in_records)
+  {
+    const auto dir = ::g_dir_open(path.c_str(), 0, nullptr);
+    std::size_t count = 0;
+    const char* name;
+
+    if (!dir)
+    {
+      return 0;
+    }
+    while ((name = ::g_dir_read_name(dir)))
+    {
+      const auto child = ::g_build_filename(path.c_str(), name, nullptr);
+
+      if (::g_file_test(child, G_FILE_TEST_IS_DIR))
+      {
+        count += count_records(
+          child,
+          in_records || !std::strcmp(name, "Records")
+        );
+      }
+      else if (in_records)
+      {
+        ++count;
+      }
+      ::g_free(child);
+    }
+    ::g_dir_close(dir);
+
+    return count;
+  }
+
+  DiskCache::DiskCache(::WebKitWebsiteDataManager* manager)
+    : m_manager(manager)
+    , m_quota(0)
+    , m_sweeping(false)
+    , m_sweep_pending(false)
+    , m_hits(0)
+    , m_misses(0)
+    , m_stats{ 0, 0, 0, 0, 0 }
+  {
+    if (const auto directory =
+          ::webkit_website_data_manager_get_disk_cache_directory(manager))
+    {
+      m_directory = directory;
+    }
+    m_load_dispatcher.connect(
+      sigc::mem_fun(this, &DiskCache::on_load_finished)
+    );
+    m_stats_dispatcher.connect(
+      sigc::mem_fun(this, &DiskCache::on_stats_finished)
+    );
+
+    // Reading the access times from disk is kept out of the startup path.
+    // Sweeping is postponed until they have been loaded, so that the sites
+    // are not evicted based on incomplete access times.
+    m_load_thread = std::thread([this]()
+    {
+      load_access_times();
+      m_load_dispatcher.emit();
+    });
+    m_sweep_connection = Glib::signal_timeout().connect_seconds(
+      sigc::mem_fun(this, &DiskCache::on_sweep_timeout),
+      SWEEP_INITIAL_DELAY
+    );
+  }
+
+  DiskCache::~DiskCache()
+  {
+    m_sweep_connection.disconnect();
+    if (m_stats_thread.joinable())
+    {
+      m_stats_thread.join();
+    }
+    if (m_load_thread.joinable())
+    {
+      m_load_thread.join();
+      merge_access_times();
+    }
+    save_access_times();
+  }
+
+  void
+  DiskCache::set_quota(std::uint64_t quota)
+  {
+    m_quota = quota;
+    sweep();
+  }
+
+  void
+  DiskCache::record_access(const std::string& uri)
+  {
+    auto host = get_host(uri);
+
+    if (!host.empty())
+    {
+      m_access_times[std::move(host)] = static_cast<std::int64_t>(
+        std::time(nullptr)
+      );
+    }
+  }
+
+  void
+  DiskCache::record_requests(std::uint64_t hits, std::uint64_t misses)
+  {
+    m_hits += hits;
+    m_misses += misses;
+  }
+
+  void
+  DiskCache::sweep()
+  {
+    if (!m_quota || m_sweeping)
+    {
+      return;
+    }
+    if (m_load_thread.joinable())
+    {
+      m_sweep_pending = true;
+      return;
+    }
+    m_sweeping = true;
+    ::webkit_website_data_manager_fetch(
+      m_manager,
+      WEBKIT_WEBSITE_DATA_DISK_CACHE,
+      nullptr,
+      on_sweep_fetch_finished,
+      static_cast<::gpointer>(this)
+    );
+  }
+
+  void
+  DiskCache::get_stats(const stats_callback_type& callback)
+  {
+    // Callers which ask for the statistics while they are being collected
+    // receive the same results.
+    m_stats_callbacks.push_back(callback);
+    if (m_stats_callbacks.size() > 1)
+    {
+      return;
+    }
+    m_stats = { 0, 0, 0, 0, 0 };
+    ::webkit_website_data_manager_fetch(
+      m_manager,
+      WEBKIT_WEBSITE_DATA_DISK_CACHE,
+      nullptr,
+      on_stats_fetch_finished,
+      static_cast<::gpointer>(this)
+    );
+  }
+
+  bool
+  DiskCache::on_sweep_timeout()
+  {
+    sweep();
+    m_sweep_connection = Glib::signal_timeout().connect_seconds(
+      sigc::mem_fun(this, &DiskCache::on_sweep_timeout),
+      SWEEP_INTERVAL
+    );
+
+    return false;
+  }
+
+  void
+  DiskCache::evict(::GList* website_data)
+  {
+    struct Candidate
+    {
+      ::WebKitWebsiteData* data;
+      std::uint64_t size;
+      std::int64_t last_access;
+    };
+    std::vector<Candidate> candidates;
+    std::uint64_t total_size = 0;
+    const auto target_size = m_quota / 100 * SWEEP_TARGET_PERCENTAGE;
+    ::GList* victims = nullptr;
+
+    for (auto link = website_data; link; link = link->next)
+    {
+      const auto data = static_cast<::WebKitWebsiteData*>(link->data);
+      const auto size = ::webkit_website_data_get_size(
+        data,
+        WEBKIT_WEBSITE_DATA_DISK_CACHE
+      );
+
+      total_size += size;
+      candidates.push_back({
+        data,
+        size,
+        get_last_access(::webkit_website_data_get_name(data))
+      });
+    }
+    if (total_size <= m_quota)
+    {
+      m_sweeping = false;
+      return;
+    }
+
+    std::sort(
+      std::begin(candidates),
+      std::end(candidates),
+      [](const Candidate& a, const Candidate& b)
+      {
+        return a.last_access < b.last_access;
+      }
+    );
+    for (const auto& candidate : candidates)
+    {
+      if (total_size <= target_size)
+      {
+        break;
+      }
+      victims = ::g_list_prepend(victims, candidate.data);
+      total_size -= candidate.size;
+    }
+    ::webkit_website_data_manager_remove(
+      m_manager,
+      WEBKIT_WEBSITE_DATA_DISK_CACHE,
+      victims,
+      nullptr,
+      on_remove_finished,
+      static_cast<::gpointer>(this)
+    );
+    ::g_list_free(victims);
+  }
+
+  /**
+   * Returns time of the latest request to given site. Website data is
+   * grouped by registrable domain, so requests to it's subdomains are
+   * taken into account as well.
+   */
+  std::int64_t
+  DiskCache::get_last_access(const std::string& site) const
+  {
+    std::int64_t result = 0;
+
+    for (const auto& entry : m_access_times)
+    {
+      const auto& host = entry.first;
+
+      if (host == site || (
+        host.length() > site.length()
+        && host[host.length() - site.length() - 1] == '.'
+        && !host.compare(host.length() - site.length(), site.length(), site)
+      ))
+      {
+        result = std::max(result, entry.second);
+      }
+    }
+
+    return result;
+  }
+
+  /**
+   * Reads access times persisted by previous sessions. Called from the
+   * loader thread, so only m_loaded_access_times is touched.
+   */
+  void
+  DiskCache::load_access_times()
+  {
+    std::ifstream input(utils::get_data_file_path("cache-access"));
+    const auto cutoff = static_cast<std::int64_t>(std::time(nullptr))
+      - ACCESS_TIME_RETENTION;
+    std::string line;
+
+    while (std::getline(input, line))
+    {
+      const auto pos = line.find('\t');
+      std::int64_t timestamp;
+
+      if (pos == std::string::npos)
+      {
+        continue;
+      }
+      timestamp = std::strtoll(line.c_str(), nullptr, 10);
+      if (timestamp >= cutoff)
+      {
+        m_loaded_access_times[line.substr(pos + 1)] = timestamp;
+      }
+    }
+  }
+
+  /**
+   * Merges access times read by the loader thread into the ones recorded
+   * during this session. Times recorded during this session are newer, so
+   * they are kept.
+   */
+  void
+  DiskCache::merge_access_times()
+  {
+    for (auto& entry : m_loaded_access_times)
+    {
+      m_access_times.emplace(entry.first, entry.second);
+    }
+    m_loaded_access_times.clear();
+  }
+
+  void
+  DiskCache::save_access_times() const
+  {
+    std::ofstream output(utils::get_data_file_path("cache-access"));
+
+    for (const auto& entry : m_access_times)
+    {
+      output << entry.second << '\t' << entry.first << '\n';
+    }
+  }
+
+  void
+  DiskCache::on_load_finished()
+  {
+    if (!m_load_thread.joinable())
+    {
+      return;
+    }
+    m_load_thread.join();
+    merge_access_times();
+    if (m_sweep_pending)
+    {
+      m_sweep_pending = false;
+      sweep();
+    }
+  }
+
+  void
+  DiskCache::on_stats_finished()
+  {
+    std::vector<stats_callback_type> callbacks;
+
+    m_stats_thread.join();
+    m_stats.hits = m_hits;
+    m_stats.misses = m_misses;
+    callbacks.swap(m_stats_callbacks);
+    for (auto& callback : callbacks)
+    {
+      callback(m_stats);
+    }
+  }
+
+  void
+  DiskCache::on_sweep_fetch_finished(::GObject* source,
+                                     ::GAsyncResult* result,
+                                     ::gpointer data)
+  {
+    const auto cache = static_cast<DiskCache*>(data);
+    ::GError* error = nullptr;
+    const auto website_data = ::webkit_website_data_manager_fetch_finish(
+      WEBKIT_WEBSITE_DATA_MANAGER(source),
+      result,
+      &error
+    );
+
+    if (error)
+    {
+      ::g_warning("Unable to fetch disk cache data: %s", error->message);
+      ::g_error_free(error);
+      cache->m_sweeping = false;
+      return;
+    }
+    cache->evict(website_data);
+    ::g_list_free_full(
+      website_data,
+      reinterpret_cast<::GDestroyNotify>(::webkit_website_data_unref)
+    );
+  }
+
+  void
+  DiskCache::on_stats_fetch_finished(::GObject* source,
+                                     ::GAsyncResult* result,
+                                     ::gpointer data)
+  {
+    const auto cache = static_cast<DiskCache*>(data);
+    ::GError* error = nullptr;
+    const auto website_data = ::webkit_website_data_manager_fetch_finish(
+      WEBKIT_WEBSITE_DATA_MANAGER(source),
+      result,
+      &error
+    );
+
+    if (error)
+    {
+      ::g_warning("Unable to fetch disk cache data: %s", error->message);
+      ::g_error_free(error);
+    }
+    for (auto link = website_data; link; link = link->next)
+    {
+      cache->m_stats.size += ::webkit_website_data_get_size(
+        static_cast<::WebKitWebsiteData*>(link->data),
+        WEBKIT_WEBSITE_DATA_DISK_CACHE
+      );
+      ++cache->m_stats.site_count;
+    }
+    ::g_list_free_full(
+      website_data,
+      reinterpret_cast<::GDestroyNotify>(::webkit_website_data_unref)
+    );
+
+    // Counting the records requires walking through the whole cache
+    // directory, so it's done in a background thread.
+    cache->m_stats_thread = std::thread([cache]()
+    {
+      cache->m_stats.entry_count = count_records(cache->m_directory, false);
+      cache->m_stats_dispatcher.emit();
+    });
+  }
+
+  void
+  DiskCache::on_remove_finished(::GObject* source,
+                                ::GAsyncResult* result,
+                                ::gpointer data)
+  {
+    const auto cache = static_cast<DiskCache*>(data);
+    ::GError* error = nullptr;
+
+    if (!::webkit_website_data_manager_remove_finish(
+      WEBKIT_WEBSITE_DATA_MANAGER(source),
+      result,
+      &error
+    ))
+    {
+      ::g_warning("Unable to remove disk cache data: %s", error->message);
+      ::g_error_free(error);
+    }
+    cache->m_sweeping = false;
+  }
+}
@@ -0,0 +1,1049 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/download-manager.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+
+namespace selain
+{
+  // Maximum number of downloads which are transferred at the same time.
+  static const std::size_t MAX_RUNNING_DOWNLOADS = 4;
+
+  // Size of the chunks in which response body is read and written to disk.
+  static const ::gsize CHUNK_SIZE = 256 * 1024;
+
+  // How many times the transfer is attempted before the download fails.
+  // Later attempts continue from where the previous one was interrupted.
+  static const unsigned int MAX_ATTEMPTS = 5;
+
+  // Interval in which progress of the downloads is sampled, in
+  // milliseconds.
+  static const unsigned int PROGRESS_INTERVAL = 500;
+
+  // Weight of the latest sample in the throughput estimate.
+  static const double SPEED_SMOOTHING = 0.3;
+
+  // Serializes choosing of file names, so that parallel downloads of files
+  // with the same name do not end up writing into the same file.
+  static std::mutex path_mutex;
+
+  struct DownloadManager::Download
+  {
+    unsigned int id;
+    std::string uri;
+    std::string referrer;
+    std::string user_agent;
+    std::string cookies;
+    /** Guarded by the mutex of the manager. */
+    std::string path;
+    /** Guarded by the mutex of the manager. */
+    std::string error;
+    /** Entity tag or modification time used for resuming. */
+    std::string validator;
+    std::atomic<DownloadState> state;
+    std::atomic<std::uint64_t> received;
+    std::atomic<std::uint64_t> total;
+    std::uint64_t sampled;
+    double speed;
+    ::GCancellable* cancellable;
+    std::thread thread;
+    /** Download which is transferred by WebKit instead of a thread. */
+    ::WebKitDownload* webkit_download;
+    DownloadManager* manager;
+
+    explicit Download(unsigned int id, const std::string& uri)
+      : id(id)
+      , uri(uri)
+      , state(DownloadState::QUEUED)
+      , received(0)
+      , total(0)
+      , sampled(0)
+      , speed(0)
+      , cancellable(::g_cancellable_new())
+      , webkit_download(nullptr)
+      , manager(nullptr) {}
+
+    ~Download()
+    {
+      if (webkit_download)
+      {
+        ::g_signal_handlers_disconnect_by_data(
+          G_OBJECT(webkit_download),
+          static_cast<::gpointer>(this)
+        );
+        ::g_object_unref(webkit_download);
+      }
+      ::g_object_unref(cancellable);
+    }
+  };
+
+  struct DownloadManager::CookieRequest
+  {
+    DownloadManager* manager;
+    std::shared_ptr<Download> download;
+  };
+
+  DownloadManager::DownloadManager(::WebKitWebContext* context)
+    : m_context(context)
+    , m_last_id(0)
+    , m_running_count(0)
+    , m_speed(0)
+    , m_last_sample_time(0)
+  {
+    m_dispatcher.connect(
+      sigc::mem_fun(this, &DownloadManager::on_download_stopped)
+    );
+    ::g_signal_connect(
+      G_OBJECT(m_context),
+      "download-started",
+      G_CALLBACK(on_download_started),
+      static_cast<::gpointer>(this)
+    );
+  }
+
+  DownloadManager::~DownloadManager()
+  {
+    ::g_signal_handlers_disconnect_by_data(
+      G_OBJECT(m_context),
+      static_cast<::gpointer>(this)
+    );
+    m_progress_connection.disconnect();
+    for (const auto& download : m_downloads)
+    {
+      ::g_cancellable_cancel(download->cancellable);
+      if (download->webkit_download)
+      {
+        ::g_signal_handlers_disconnect_by_data(
+          G_OBJECT(download->webkit_download),
+          static_cast<::gpointer>(download.get())
+        );
+        if (download->state == DownloadState::RUNNING)
+        {
+          ::webkit_download_cancel(download->webkit_download);
+        }
+      }
+    }
+    for (const auto& download : m_downloads)
+    {
+      if (download->thread.joinable())
+      {
+        download->thread.join();
+      }
+    }
+  }
+
+  unsigned int
+  DownloadManager::add(const std::string& uri,
+                       const std::string& referrer,
+                       const std::string& user_agent)
+  {
+    const auto download = std::make_shared<Download>(++m_last_id, uri);
+
+    download->referrer = referrer;
+    download->user_agent = user_agent;
+    m_downloads.push_back(download);
+
+    // Cookies are fetched from the web context before the download is
+    // started, so that files behind a login can be downloaded.
+    ::webkit_cookie_manager_get_cookies(
+      ::webkit_web_context_get_cookie_manager(m_context),
+      uri.c_str(),
+      nullptr,
+      on_cookies_received,
+      static_cast<::gpointer>(new CookieRequest{ this, download })
+    );
+
+    return download->id;
+  }
+
+  bool
+  DownloadManager::cancel(unsigned int id)
+  {
+    for (const auto& download : m_downloads)
+    {
+      if (download->id != id)
+      {
+        continue;
+      }
+      switch (download->state)
+      {
+        case DownloadState::QUEUED:
+          for (auto it = std::begin(m_queue); it != std::end(m_queue); ++it)
+          {
+            if (*it == download)
+            {
+              m_queue.erase(it);
+              break;
+            }
+          }
+          download->state = DownloadState::CANCELLED;
+          return true;
+
+        case DownloadState::RUNNING:
+          if (download->webkit_download)
+          {
+            ::webkit_download_cancel(download->webkit_download);
+          } else {
+            ::g_cancellable_cancel(download->cancellable);
+          }
+          return true;
+
+        default:
+          return false;
+      }
+    }
+
+    return false;
+  }
+
+  bool
+  DownloadManager::resume(unsigned int id)
+  {
+    for (const auto& download : m_downloads)
+    {
+      if (download->id != id)
+      {
+        continue;
+      }
+      // Downloads transferred by WebKit cannot be repeated.
+      if ((download->state != DownloadState::FAILED &&
+           download->state != DownloadState::CANCELLED) ||
+          download->thread.joinable() ||
+          download->webkit_download)
+      {
+        return false;
+      }
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        download->error.clear();
+      }
+      download->state = DownloadState::QUEUED;
+      start(download);
+
+      return true;
+    }
+
+    return false;
+  }
+
+  std::vector<DownloadInfo>
+  DownloadManager::get_downloads() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<DownloadInfo> result;
+
+    result.reserve(m_downloads.size());
+    for (const auto& download : m_downloads)
+    {
+      result.push_back({
+        download->id,
+        download->uri,
+        download->path,
+        download->state,
+        download->error,
+        download->received,
+        download->total,
+        download->speed
+      });
+    }
+
+    return result;
+  }
+
+  double
+  DownloadManager::get_speed() const
+  {
+    return m_speed;
+  }
+
+  void
+  DownloadManager::start(const std::shared_ptr<Download>& download)
+  {
+    if (download->state != DownloadState::QUEUED)
+    {
+      return;
+    }
+    else if (m_running_count >= MAX_RUNNING_DOWNLOADS)
+    {
+      m_queue.push_back(download);
+      return;
+    }
+    ++m_running_count;
+    ::g_cancellable_reset(download->cancellable);
+    download->state = DownloadState::RUNNING;
+    download->sampled = download->received;
+    download->speed = 0;
+    start_progress_timer();
+    download->thread = std::thread(
+      &DownloadManager::run,
+      this,
+      std::ref(*download)
+    );
+  }
+
+  void
+  DownloadManager::start_queued()
+  {
+    while (!m_queue.empty() && m_running_count < MAX_RUNNING_DOWNLOADS)
+    {
+      const auto download = m_queue.front();
+
+      m_queue.pop_front();
+      start(download);
+    }
+  }
+
+  void
+  DownloadManager::start_progress_timer()
+  {
+    if (!m_progress_connection.connected())
+    {
+      m_last_sample_time = ::g_get_monotonic_time();
+      m_progress_connection = Glib::signal_timeout().connect(
+        sigc::mem_fun(this, &DownloadManager::on_progress_timeout),
+        PROGRESS_INTERVAL
+      );
+    }
+  }
+
+  /**
+   * Starts tracking download which is transferred by WebKit itself. It's
+   * counted as running, but it's not subject to the queue, as WebKit has
+   * already started it.
+   */
+  void
+  DownloadManager::track(::WebKitDownload* webkit_download)
+  {
+    const auto request = ::webkit_download_get_request(webkit_download);
+    const auto download = std::make_shared<Download>(
+      ++m_last_id,
+      ::webkit_uri_request_get_uri(request)
+    );
+    const auto data = static_cast<::gpointer>(download.get());
+
+    download->webkit_download = static_cast<::WebKitDownload*>(
+      ::g_object_ref(webkit_download)
+    );
+    download->manager = this;
+    download->state = DownloadState::RUNNING;
+    m_downloads.push_back(download);
+    ++m_running_count;
+    start_progress_timer();
+
+    // Partial file is written over, as it has been created by
+    // reserve_path() to claim the name.
+    ::webkit_download_set_allow_overwrite(webkit_download, TRUE);
+    ::g_signal_connect(
+      G_OBJECT(webkit_download),
+      "decide-destination",
+      G_CALLBACK(on_decide_destination),
+      data
+    );
+    ::g_signal_connect(
+      G_OBJECT(webkit_download),
+      "received-data",
+      G_CALLBACK(on_received_data),
+      data
+    );
+    ::g_signal_connect(
+      G_OBJECT(webkit_download),
+      "failed",
+      G_CALLBACK(on_failed),
+      data
+    );
+    ::g_signal_connect(
+      G_OBJECT(webkit_download),
+      "finished",
+      G_CALLBACK(on_finished),
+      data
+    );
+  }
+
+  void
+  DownloadManager::on_webkit_download_finished(Download& download)
+  {
+    std::string path;
+    DownloadInfo info;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      path = download.path;
+    }
+    if (download.state == DownloadState::RUNNING)
+    {
+      const auto part_path = path + ".part";
+
+      if (::g_rename(part_path.c_str(), path.c_str()) < 0)
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        download.error = std::strerror(errno);
+        download.state = DownloadState::FAILED;
+      } else {
+        download.state = DownloadState::FINISHED;
+      }
+    }
+    download.speed = 0;
+    --m_running_count;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      info = {
+        download.id,
+        download.uri,
+        download.path,
+        download.state,
+        download.error,
+        download.received,
+        download.total,
+        0
+      };
+    }
+    start_queued();
+    if (!m_running_count)
+    {
+      m_progress_connection.disconnect();
+      m_speed = 0;
+    }
+    m_signal_finished.emit(info);
+  }
+
+  void
+  DownloadManager::run(Download& download)
+  {
+    const auto session = ::soup_session_new_with_options(
+      SOUP_SESSION_USER_AGENT,
+      download.user_agent.empty() ? nullptr : download.user_agent.c_str(),
+      SOUP_SESSION_TIMEOUT,
+      60,
+      nullptr
+    );
+    auto result = DownloadState::FAILED;
+
+    // Response bodies are written to disk as they are, so that sizes and
+    // ranges of the partial files match those given by the server.
+    ::soup_session_remove_feature_by_type(session, SOUP_TYPE_CONTENT_DECODER);
+
+    for (unsigned int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt)
+    {
+      bool retryable = false;
+
+      // Back off exponentially between the attempts, starting from one
+      // second.
+      for (unsigned int i = 0; attempt > 0 && i < 10u << (attempt - 1); ++i)
+      {
+        if (::g_cancellable_is_cancelled(download.cancellable))
+        {
+          break;
+        }
+        ::g_usleep(100000);
+      }
+      if (transfer(download, session, retryable))
+      {
+        result = DownloadState::FINISHED;
+        break;
+      }
+      else if (::g_cancellable_is_cancelled(download.cancellable))
+      {
+        result = DownloadState::CANCELLED;
+        break;
+      }
+      else if (!retryable)
+      {
+        break;
+      }
+    }
+    ::g_object_unref(session);
+    download.state = result;
+    m_dispatcher.emit();
+  }
+
+  /**
+   * Returns last component of given path, which is safe to use as name of
+   * a file in the downloads directory.
+   */
+  static std::string
+  get_safe_name(const char* path)
+  {
+    const auto basename = ::g_path_get_basename(path);
+    const std::string name(basename);
+
+    ::g_free(basename);
+    if (name.empty() || name == "." || name == ".." || name == "/")
+    {
+      return "download";
+    }
+
+    return name;
+  }
+
+  /**
+   * Determines name of the downloaded file from the Content-Disposition
+   * header of the response, or from the last segment of the URI path.
+   */
+  static std::string
+  get_file_name(::SoupMessage* message)
+  {
+    char* disposition = nullptr;
+    ::GHashTable* params = nullptr;
+    std::string name;
+
+    if (::soup_message_headers_get_content_disposition(
+      message->response_headers,
+      &disposition,
+      &params
+    ))
+    {
+      const auto filename = static_cast<const char*>(
+        ::g_hash_table_lookup(params, "filename")
+      );
+
+      if (filename)
+      {
+        name = get_safe_name(filename);
+      }
+      ::g_free(disposition);
+      ::g_hash_table_destroy(params);
+    }
+    if (name.empty())
+    {
+      const auto path = ::soup_uri_decode(
+        ::soup_uri_get_path(::soup_message_get_uri(message))
+      );
+
+      name = get_safe_name(path);
+      ::g_free(path);
+    }
+
+    return name;
+  }
+
+  /**
+   * Picks path in the downloads directory for file with given name, adding
+   * a number to the name if a file with the same name already exists, and
+   * creates the partial file for it.
+   */
+  static std::string
+  reserve_path(const std::string& name)
+  {
+    std::lock_guard<std::mutex> lock(path_mutex);
+    const auto directory = ::g_get_user_special_dir(G_USER_DIRECTORY_DOWNLOAD);
+    const auto dot = name.rfind('.');
+    const auto stem = dot != std::string::npos && dot > 0
+      ? name.substr(0, dot)
+      : name;
+    const auto extension = dot != std::string::npos && dot > 0
+      ? name.substr(dot)
+      : std::string();
+
+    for (unsigned int n = 0;; ++n)
+    {
+      const auto candidate = n > 0
+        ? stem + " (" + std::to_string(n) + ")" + extension
+        : name;
+      const auto path = ::g_build_filename(
+        directory ? directory : ::g_get_home_dir(),
+        candidate.c_str(),
+        nullptr
+      );
+      const std::string result(path);
+      const auto part_path = result + ".part";
+
+      ::g_free(path);
+      if (::g_file_test(result.c_str(), G_FILE_TEST_EXISTS) ||
+          ::g_file_test(part_path.c_str(), G_FILE_TEST_EXISTS))
+      {
+        continue;
+      }
+      ::close(::g_open(part_path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644));
+
+      return result;
+    }
+  }
+
+  bool
+  DownloadManager::transfer(Download& download,
+                            ::SoupSession* session,
+                            bool& retryable)
+  {
+    const auto message = ::soup_message_new("GET", download.uri.c_str());
+    const auto set_error = [this, &download](const std::string& error)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      download.error = error;
+    };
+    std::uint64_t offset = download.received;
+    ::GInputStream* stream;
+    ::GError* error = nullptr;
+    std::string path;
+    std::string part_path;
+    ::goffset length = 0;
+    const char* validator;
+    std::vector<char> buffer;
+    bool success = true;
+    int fd;
+
+    if (!message)
+    {
+      set_error("Invalid URI.");
+      return false;
+    }
+    ::soup_message_headers_replace(
+      message->request_headers,
+      "Accept-Encoding",
+      "identity"
+    );
+    if (!download.referrer.empty())
+    {
+      ::soup_message_headers_replace(
+        message->request_headers,
+        "Referer",
+        download.referrer.c_str()
+      );
+    }
+    if (!download.cookies.empty())
+    {
+      ::soup_message_headers_replace(
+        message->request_headers,
+        "Cookie",
+        download.cookies.c_str()
+      );
+    }
+    if (offset > 0)
+    {
+      ::soup_message_headers_set_range(
+        message->request_headers,
+        offset,
+        -1
+      );
+      if (!download.validator.empty())
+      {
+        ::soup_message_headers_replace(
+          message->request_headers,
+          "If-Range",
+          download.validator.c_str()
+        );
+      }
+    }
+
+    if (!(stream = ::soup_session_send(
+      session,
+      message,
+      download.cancellable,
+      &error
+    )))
+    {
+      set_error(error->message);
+      retryable = true;
+      ::g_error_free(error);
+      ::g_object_unref(message);
+      return false;
+    }
+
+    if (message->status_code == SOUP_STATUS_PARTIAL_CONTENT && offset > 0)
+    {
+      // Server continues from where the previous attempt was interrupted.
+    }
+    else if (SOUP_STATUS_IS_SUCCESSFUL(message->status_code))
+    {
+      // Server ignored the range or the file has changed since, so the
+      // download starts over.
+      offset = 0;
+      download.received = 0;
+    } else {
+      set_error(
+        "HTTP error " + std::to_string(message->status_code) + ": " +
+        (message->reason_phrase ? message->reason_phrase : "")
+      );
+      if (message->status_code == SOUP_STATUS_REQUESTED_RANGE_NOT_SATISFIABLE)
+      {
+        download.received = 0;
+        download.validator.clear();
+        retryable = true;
+      } else {
+        retryable = message->status_code >= 500;
+      }
+      ::g_object_unref(stream);
+      ::g_object_unref(message);
+      return false;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      path = download.path;
+    }
+    if (path.empty())
+    {
+      path = reserve_path(get_file_name(message));
+      std::lock_guard<std::mutex> lock(m_mutex);
+      download.path = path;
+    }
+    part_path = path + ".part";
+
+    if (::soup_message_headers_get_encoding(message->response_headers) ==
+        SOUP_ENCODING_CONTENT_LENGTH)
+    {
+      length = ::soup_message_headers_get_content_length(
+        message->response_headers
+      );
+    }
+    download.total = length > 0 ? offset + length : 0;
+
+    // Weak entity tags cannot be used for range requests, so modification
+    // time is used instead when the server does not give a strong one.
+    if ((validator = ::soup_message_headers_get_one(
+      message->response_headers,
+      "ETag"
+    )) && !std::strncmp(validator, "W/", 2))
+    {
+      validator = nullptr;
+    }
+    if (!validator)
+    {
+      validator = ::soup_message_headers_get_one(
+        message->response_headers,
+        "Last-Modified"
+      );
+    }
+    download.validator = validator ? validator : "";
+
+    if ((fd = ::g_open(part_path.c_str(), O_WRONLY | O_CREAT, 0644)) < 0)
+    {
+      set_error(std::strerror(errno));
+      ::g_object_unref(stream);
+      ::g_object_unref(message);
+      return false;
+    }
+
+    // Allocate the whole file up front, so that the file system can lay it
+    // out contiguously. Failure here is not fatal; the file just grows as
+    // it is written.
+    if (download.total > 0)
+    {
+      ::posix_fallocate(fd, 0, download.total);
+    }
+
+    buffer.resize(CHUNK_SIZE);
+    for (;;)
+    {
+      const auto count = ::g_input_stream_read(
+        stream,
+        buffer.data(),
+        CHUNK_SIZE,
+        download.cancellable,
+        &error
+      );
+      ::gssize written = 0;
+
+      if (count < 0)
+      {
+        set_error(error->message);
+        ::g_error_free(error);
+        retryable = true;
+        success = false;
+        break;
+      }
+      else if (count == 0)
+      {
+        break;
+      }
+      while (written < count)
+      {
+        const auto result = ::pwrite(
+          fd,
+          buffer.data() + written,
+          count - written,
+          offset + written
+        );
+
+        if (result < 0)
+        {
+          if (errno == EINTR)
+          {
+            continue;
+          }
+          set_error(std::strerror(errno));
+          success = false;
+          break;
+        }
+        written += result;
+      }
+      if (!success)
+      {
+        break;
+      }
+      offset += count;
+      download.received = offset;
+    }
+
+    if (success && download.total > 0 && offset < download.total)
+    {
+      set_error("Connection closed before the download was complete.");
+      retryable = true;
+      success = false;
+    }
+    // Preallocated space past the received data is released, in case the
+    // server sent less than it announced.
+    if (success && ::ftruncate(fd, offset) < 0)
+    {
+      set_error(std::strerror(errno));
+      success = false;
+    }
+    ::close(fd);
+    ::g_input_stream_close(stream, nullptr, nullptr);
+    ::g_object_unref(stream);
+    ::g_object_unref(message);
+
+    if (success && ::g_rename(part_path.c_str(), path.c_str()) < 0)
+    {
+      set_error(std::strerror(errno));
+      success = false;
+    }
+
+    return success;
+  }
+
+  bool
+  DownloadManager::on_progress_timeout()
+  {
+    const auto now = ::g_get_monotonic_time();
+    const auto elapsed = static_cast<double>(now - m_last_sample_time) /
+      G_USEC_PER_SEC;
+
+    m_last_sample_time = now;
+    m_speed = 0;
+    for (const auto& download : m_downloads)
+    {
+      const std::uint64_t received = download->received;
+
+      if (download->state == DownloadState::RUNNING && elapsed > 0)
+      {
+        const auto sample = received > download->sampled
+          ? (received - download->sampled) / elapsed
+          : 0.0;
+
+        download->speed = SPEED_SMOOTHING * sample +
+          (1.0 - SPEED_SMOOTHING) * download->speed;
+        m_speed += download->speed;
+      } else {
+        download->speed = 0;
+      }
+      download->sampled = received;
+    }
+
+    return true;
+  }
+
+  void
+  DownloadManager::on_download_stopped()
+  {
+    std::vector<DownloadInfo> stopped;
+
+    for (const auto& download : m_downloads)
+    {
+      if (!download->thread.joinable() ||
+          download->state == DownloadState::RUNNING)
+      {
+        continue;
+      }
+      download->thread.join();
+      download->speed = 0;
+      --m_running_count;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        stopped.push_back({
+          download->id,
+          download->uri,
+          download->path,
+          download->state,
+          download->error,
+          download->received,
+          download->total,
+          0
+        });
+      }
+    }
+    start_queued();
+    if (!m_running_count)
+    {
+      m_progress_connection.disconnect();
+      m_speed = 0;
+    }
+    for (const auto& info : stopped)
+    {
+      m_signal_finished.emit(info);
+    }
+  }
+
+  void
+  DownloadManager::on_download_started(::WebKitWebContext*,
+                                       ::WebKitDownload* download,
+                                       DownloadManager* manager)
+  {
+    const auto request = ::webkit_download_get_request(download);
+    const auto web_view = ::webkit_download_get_web_view(download);
+    const auto uri = ::webkit_uri_request_get_uri(request);
+    const auto method = ::webkit_uri_request_get_http_method(request);
+    std::string referrer;
+    std::string user_agent;
+
+    // Only plain GET requests over HTTP(S) can be repeated by libsoup
+    // without losing the request body or the credentials of the page.
+    // Others are left for WebKit to transfer.
+    if ((std::strncmp(uri, "http://", 7) && std::strncmp(uri, "https://", 8))
+        || (method && std::strcmp(method, "GET")))
+    {
+      manager->track(download);
+      return;
+    }
+    if (web_view)
+    {
+      const auto uri = ::webkit_web_view_get_uri(web_view);
+
+      if (uri)
+      {
+        referrer = uri;
+      }
+      user_agent = ::webkit_settings_get_user_agent(
+        ::webkit_web_view_get_settings(web_view)
+      );
+    }
+    manager->add(uri, referrer, user_agent);
+    ::webkit_download_cancel(download);
+  }
+
+  ::gboolean
+  DownloadManager::on_decide_destination(::WebKitDownload* webkit_download,
+                                         const ::gchar* suggested_filename,
+                                         Download* download)
+  {
+    const auto path = reserve_path(get_safe_name(
+      suggested_filename && *suggested_filename ? suggested_filename : "/"
+    ));
+    const auto uri = ::g_filename_to_uri(
+      (path + ".part").c_str(),
+      nullptr,
+      nullptr
+    );
+
+    {
+      std::lock_guard<std::mutex> lock(download->manager->m_mutex);
+
+      download->path = path;
+    }
+    ::webkit_download_set_destination(webkit_download, uri);
+    ::g_free(uri);
+
+    return TRUE;
+  }
+
+  void
+  DownloadManager::on_received_data(::WebKitDownload* webkit_download,
+                                    ::guint64 data_length,
+                                    Download* download)
+  {
+    download->received += data_length;
+    if (!download->total)
+    {
+      if (const auto response = ::webkit_download_get_response(
+        webkit_download
+      ))
+      {
+        download->total = ::webkit_uri_response_get_content_length(response);
+      }
+    }
+  }
+
+  void
+  DownloadManager::on_failed(::WebKitDownload*,
+                             ::GError* error,
+                             Download* download)
+  {
+    std::lock_guard<std::mutex> lock(download->manager->m_mutex);
+
+    if (error->domain == WEBKIT_DOWNLOAD_ERROR
+        && error->code == WEBKIT_DOWNLOAD_ERROR_CANCELLED_BY_USER)
+    {
+      download->state = DownloadState::CANCELLED;
+    } else {
+      download->error = error->message;
+      download->state = DownloadState::FAILED;
+    }
+  }
+
+  /**
+   * Emitted by WebKit after the download has completed, failed or been
+   * cancelled.
+   */
+  void
+  DownloadManager::on_finished(::WebKitDownload*, Download* download)
+  {
+    download->manager->on_webkit_download_finished(*download);
+  }
+
+  void
+  DownloadManager::on_cookies_received(::GObject* source,
+                                       ::GAsyncResult* result,
+                                       ::gpointer data)
+  {
+    const auto request = static_cast<CookieRequest*>(data);
+    const auto cookies = ::webkit_cookie_manager_get_cookies_finish(
+      WEBKIT_COOKIE_MANAGER(source),
+      result,
+      nullptr
+    );
+
+    if (cookies)
+    {
+      const auto header = ::soup_cookies_to_cookie_header(cookies);
+
+      if (header)
+      {
+        request->download->cookies = header;
+        ::g_free(header);
+      }
+      ::g_list_free_full(
+        cookies,
+        reinterpret_cast<::GDestroyNotify>(::soup_cookie_free)
+      );
+    }
+    // The download might have been cancelled while waiting for the
+    // cookies, which start() takes care of.
+    request->manager->start(request->download);
+    delete request;
+  }
+}
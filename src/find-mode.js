@@ -0,0 +1,190 @@
+SELAIN_JS_STRINGIFY((() => {
+  if (window.SelainFindMode) {
+    return;
+  }
+
+  const batchDuration = 8;
+  const ignoredTagNames = ['SCRIPT', 'STYLE', 'NOSCRIPT', 'TEXTAREA', 'TITLE'];
+  const markClassName = 'selain-find-match';
+  const matchColor = '#ffd76e';
+  const currentMatchColor = '#ff9632';
+  let generation = 0;
+  let marks = [];
+  let current = -1;
+  let complete = true;
+
+  const report = () => {
+    const handlers = window.webkit && window.webkit.messageHandlers;
+
+    if (handlers && handlers.selainFind) {
+      handlers.selainFind.postMessage(
+        `${current + 1} ${marks.length} ${complete ? 1 : 0}`
+      );
+    }
+  };
+
+  const setCurrent = (index) => {
+    if (current >= 0 && current < marks.length) {
+      marks[current].style.backgroundColor = matchColor;
+    }
+    current = index;
+    if (current >= 0 && current < marks.length) {
+      const mark = marks[current];
+
+      mark.style.backgroundColor = currentMatchColor;
+      mark.scrollIntoView({ block: 'center', inline: 'nearest' });
+    }
+  };
+
+  const clear = () => {
+    const parents = new Set();
+
+    ++generation;
+    marks.forEach((mark) => {
+      const parent = mark.parentNode;
+
+      if (parent) {
+        while (mark.firstChild) {
+          parent.insertBefore(mark.firstChild, mark);
+        }
+        parent.removeChild(mark);
+        parents.add(parent);
+      }
+    });
+    parents.forEach((parent) => parent.normalize());
+    marks = [];
+    current = -1;
+    complete = true;
+  };
+
+  const createMark = (doc) => {
+    const mark = doc.createElement('mark');
+
+    mark.className = markClassName;
+    mark.style.backgroundColor = matchColor;
+    mark.style.color = '#000000';
+
+    return mark;
+  };
+
+  const highlightTextNode = (node, regex, found) => {
+    const text = node.data;
+    const ranges = [];
+    let match;
+
+    regex.lastIndex = 0;
+    while ((match = regex.exec(text)) !== null) {
+      if (match[0].length === 0) {
+        ++regex.lastIndex;
+        continue;
+      }
+      ranges.push([match.index, match[0].length]);
+    }
+
+    // Wrap matches starting from the end of the text node, so that offsets of
+    // the preceding matches stay valid.
+    const nodeMarks = [];
+
+    for (let i = ranges.length - 1; i >= 0; --i) {
+      const [start, length] = ranges[i];
+      const matchNode = node.splitText(start);
+      const mark = createMark(node.ownerDocument);
+
+      matchNode.splitText(length);
+      matchNode.parentNode.replaceChild(mark, matchNode);
+      mark.appendChild(matchNode);
+      nodeMarks.push(mark);
+    }
+    for (let i = nodeMarks.length - 1; i >= 0; --i) {
+      found.push(nodeMarks[i]);
+    }
+  };
+
+  const search = (pattern, flags, backwards) => {
+    let regex;
+
+    clear();
+    try {
+      regex = new RegExp(pattern, `${flags}g`);
+    } catch (e) {
+      report();
+
+      return 'error';
+    }
+
+    const doc = document;
+    const id = generation;
+    const walker = doc.createTreeWalker(
+      doc.body || doc.documentElement,
+      NodeFilter.SHOW_TEXT,
+      {
+        acceptNode: (textNode) => {
+          const parent = textNode.parentNode;
+
+          if (!textNode.data.length ||
+              !parent ||
+              parent.className === markClassName ||
+              ignoredTagNames.indexOf(parent.nodeName) >= 0) {
+            return NodeFilter.FILTER_REJECT;
+          }
+
+          return NodeFilter.FILTER_ACCEPT;
+        }
+      }
+    );
+    let node = walker.nextNode();
+
+    // Text nodes are processed in small time slices so that the page stays
+    // responsive even when it contains megabytes of text.
+    const step = () => {
+      if (id !== generation) {
+        return;
+      }
+
+      const deadline = performance.now() + batchDuration;
+
+      while (node && performance.now() < deadline) {
+        // Advance the walker before the current node is split, so that the
+        // newly created text nodes are not visited again.
+        const next = walker.nextNode();
+
+        highlightTextNode(node, regex, marks);
+        node = next;
+      }
+      complete = !node;
+      if (current < 0 && marks.length > 0 && (!backwards || complete)) {
+        setCurrent(backwards ? marks.length - 1 : 0);
+      }
+      report();
+      if (!complete) {
+        setTimeout(step, 0);
+      }
+    };
+
+    complete = false;
+    step();
+
+    return 'ok';
+  };
+
+  const next = () => {
+    if (marks.length > 0) {
+      setCurrent((current + 1) % marks.length);
+    }
+    report();
+  };
+
+  const prev = () => {
+    if (marks.length > 0) {
+      setCurrent(current > 0 ? current - 1 : marks.length - 1);
+    }
+    report();
+  };
+
+  window.SelainFindMode = {
+    clear,
+    next,
+    prev,
+    search
+  };
+})();)
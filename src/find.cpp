@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/main-window.hpp>
+#include <selain/utils.hpp>
+
+#include <algorithm>
+#include <cstdio>
+
+#define SELAIN_JS_STRINGIFY(source) #source
+
+namespace selain
+{
+  static const char* find_mode_source_code =
+  #include "./find-mode.js"
+  ;
+
+  static const char regex_prefix[] = "\\v";
+
+  static void on_found_text(::WebKitFindController*, ::guint, Tab*);
+  static void on_failed_to_find_text(::WebKitFindController*, Tab*);
+  static void on_counted_matches(::WebKitFindController*, ::guint, Tab*);
+  static void on_find_message(
+    ::WebKitUserContentManager*,
+    ::WebKitJavascriptResult*,
+    Tab*
+  );
+
+  /**
+   * Returns iterator to the character following first occurrence of given
+   * character, or end of the text if there isn't one.
+   */
+  static Glib::ustring::const_iterator
+  skip_past(Glib::ustring::const_iterator it,
+            const Glib::ustring::const_iterator& end,
+            ::gunichar c)
+  {
+    while (it != end)
+    {
+      if (*it++ == c)
+      {
+        break;
+      }
+    }
+
+    return it;
+  }
+
+  /**
+   * Smart case: Search is case sensitive only when the text contains at least
+   * one upper case character. Escape sequences of regular expressions, such
+   * as \W, \S, \p{Lu} or \x4A, are not taken into account.
+   */
+  static bool
+  is_case_sensitive(const Glib::ustring& text, bool regex)
+  {
+    const auto end = std::end(text);
+    auto it = std::begin(text);
+
+    while (it != end)
+    {
+      const auto c = *it++;
+
+      if (regex && c == '\\' && it != end)
+      {
+        const auto escape = *it++;
+
+        if ((escape == 'p' || escape == 'P' || escape == 'u')
+            && it != end && *it == '{')
+        {
+          it = skip_past(it, end, '}');
+        }
+        else if (escape == 'k' && it != end && *it == '<')
+        {
+          it = skip_past(it, end, '>');
+        }
+        else if (escape == 'u' || escape == 'x' || escape == 'c')
+        {
+          // Hexadecimal digits or the control character letter.
+          auto length = escape == 'u' ? 4 : escape == 'x' ? 2 : 1;
+
+          for (; length > 0 && it != end; --length)
+          {
+            ++it;
+          }
+        }
+      }
+      else if (Glib::Unicode::isupper(c))
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /**
+   * Connects signals of the find controller and installs the script which
+   * implements regular expression search into the pages, so that only the
+   * search itself has to be sent into the page on each keystroke.
+   */
+  void
+  Tab::initialize_find()
+  {
+    const auto controller = ::webkit_web_view_get_find_controller(m_web_view);
+    const auto manager = ::webkit_web_view_get_user_content_manager(
+      m_web_view
+    );
+    const auto script = ::webkit_user_script_new(
+      find_mode_source_code,
+      WEBKIT_USER_CONTENT_INJECT_TOP_FRAME,
+      WEBKIT_USER_SCRIPT_INJECT_AT_DOCUMENT_START,
+      nullptr,
+      nullptr
+    );
+
+    ::g_signal_connect(
+      G_OBJECT(controller),
+      "found-text",
+      G_CALLBACK(on_found_text),
+      static_cast<::gpointer>(this)
+    );
+    ::g_signal_connect(
+      G_OBJECT(controller),
+      "failed-to-find-text",
+      G_CALLBACK(on_failed_to_find_text),
+      static_cast<::gpointer>(this)
+    );
+    ::g_signal_connect(
+      G_OBJECT(controller),
+      "counted-matches",
+      G_CALLBACK(on_counted_matches),
+      static_cast<::gpointer>(this)
+    );
+    ::webkit_user_content_manager_add_script(manager, script);
+    ::webkit_user_script_unref(script);
+    ::g_signal_connect(
+      G_OBJECT(manager),
+      "script-message-received::selainFind",
+      G_CALLBACK(on_find_message),
+      static_cast<::gpointer>(this)
+    );
+    ::webkit_user_content_manager_register_script_message_handler(
+      manager,
+      "selainFind"
+    );
+  }
+
+  void
+  Tab::search(const Glib::ustring& text, bool forwards)
+  {
+    const bool regex = !text.compare(0, 2, regex_prefix);
+    const auto pattern = regex ? text.substr(2) : text;
+
+    if (pattern.empty())
+    {
+      search_finish();
+      return;
+    }
+
+    // Incremental search has usually already found the text by the time the
+    // command is submitted, so there is no need to search large pages twice.
+    if (text == m_find_text && forwards == m_find_forwards)
+    {
+      return;
+    }
+
+    if (regex != m_find_regex)
+    {
+      search_finish();
+    }
+    m_find_text = text;
+    m_find_forwards = forwards;
+    m_find_regex = regex;
+    set_find_matches(0, 0, false);
+
+    if (regex)
+    {
+      execute_script(Glib::ustring::compose(
+        "window.SelainFindMode.search(%1, %2, %3);",
+        utils::js_quote(pattern),
+        is_case_sensitive(pattern, true) ? "''" : "'i'",
+        forwards ? "false" : "true"
+      ));
+    } else {
+      const auto controller = ::webkit_web_view_get_find_controller(
+        m_web_view
+      );
+      ::guint32 options = WEBKIT_FIND_OPTIONS_WRAP_AROUND;
+
+      if (!is_case_sensitive(pattern, false))
+      {
+        options |= WEBKIT_FIND_OPTIONS_CASE_INSENSITIVE;
+      }
+      if (!forwards)
+      {
+        options |= WEBKIT_FIND_OPTIONS_BACKWARDS;
+      }
+      ::webkit_find_controller_count_matches(
+        controller,
+        pattern.c_str(),
+        options,
+        G_MAXUINT
+      );
+      ::webkit_find_controller_search(
+        controller,
+        pattern.c_str(),
+        options,
+        G_MAXUINT
+      );
+    }
+  }
+
+  void
+  Tab::search_next()
+  {
+    if (m_find_text.empty())
+    {
+      return;
+    }
+    if (m_find_regex)
+    {
+      execute_script("window.SelainFindMode.next();");
+      return;
+    }
+    if (m_find_match_count > 0)
+    {
+      set_find_matches(
+        m_find_match_index % m_find_match_count + 1,
+        m_find_match_count,
+        m_find_complete
+      );
+    }
+    ::webkit_find_controller_search_next(
+      ::webkit_web_view_get_find_controller(m_web_view)
+    );
+  }
+
+  void
+  Tab::search_prev()
+  {
+    if (m_find_text.empty())
+    {
+      return;
+    }
+    if (m_find_regex)
+    {
+      execute_script("window.SelainFindMode.prev();");
+      return;
+    }
+    if (m_find_match_count > 0)
+    {
+      set_find_matches(
+        m_find_match_index > 1 ? m_find_match_index - 1 : m_find_match_count,
+        m_find_match_count,
+        m_find_complete
+      );
+    }
+    ::webkit_find_controller_search_previous(
+      ::webkit_web_view_get_find_controller(m_web_view)
+    );
+  }
+
+  void
+  Tab::search_finish()
+  {
+    if (m_find_text.empty())
+    {
+      return;
+    }
+    if (m_find_regex)
+    {
+      execute_script(
+        "window.SelainFindMode && window.SelainFindMode.clear();"
+      );
+    } else {
+      ::webkit_find_controller_search_finish(
+        ::webkit_web_view_get_find_controller(m_web_view)
+      );
+    }
+    m_find_text.clear();
+    m_find_forwards = true;
+    m_find_regex = false;
+    set_find_matches(0, 0);
+  }
+
+  Glib::ustring
+  Tab::get_find_status() const
+  {
+    if (m_find_text.empty())
+    {
+      return Glib::ustring();
+    }
+
+    return Glib::ustring::compose(
+      "%1/%2%3",
+      m_find_match_index,
+      m_find_match_count,
+      m_find_complete ? "" : "\xe2\x80\xa6"
+    );
+  }
+
+  void
+  Tab::set_find_matches(::guint index, ::guint count, bool complete)
+  {
+    m_find_match_index = std::min(index, count);
+    m_find_match_count = count;
+    m_find_complete = complete;
+    m_signal_find_status_changed.emit(this, get_find_status());
+  }
+
+  static void
+  on_found_text(::WebKitFindController*, ::guint, Tab* tab)
+  {
+    // Match counting and the actual search are separate operations inside
+    // WebKit, so the total might not be known yet.
+    if (!tab->get_find_match_index())
+    {
+      tab->set_find_matches(
+        1,
+        std::max(tab->get_find_match_count(), 1u),
+        tab->get_find_match_count() > 0
+      );
+    }
+  }
+
+  static void
+  on_failed_to_find_text(::WebKitFindController*, Tab* tab)
+  {
+    tab->set_find_matches(0, 0);
+  }
+
+  static void
+  on_counted_matches(::WebKitFindController*, ::guint count, Tab* tab)
+  {
+    const auto index = tab->get_find_match_index();
+
+    tab->set_find_matches(index ? index : std::min(count, 1u), count);
+  }
+
+  static void
+  on_find_message(::WebKitUserContentManager*,
+                  ::WebKitJavascriptResult* js_result,
+                  Tab* tab)
+  {
+    const auto value = ::webkit_javascript_result_get_js_value(js_result);
+    ::gchar* str_value;
+    unsigned int index;
+    unsigned int count;
+    unsigned int complete;
+
+    if (!::jsc_value_is_string(value))
+    {
+      return;
+    }
+    str_value = ::jsc_value_to_string(value);
+    if (std::sscanf(str_value, "%u %u %u", &index, &count, &complete) == 3)
+    {
+      tab->set_find_matches(index, count, complete != 0);
+    }
+    ::g_free(str_value);
+  }
+}
@@ -0,0 +1,811 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/fuzzy.hpp>
+
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define SELAIN_FUZZY_HAVE_AVX2 1
+# include <immintrin.h>
+#endif
+#if defined(__SSE2__)
+# define SELAIN_FUZZY_HAVE_SSE2 1
+# include <emmintrin.h>
+#endif
+
+namespace selain
+{
+  namespace fuzzy
+  {
+    using find_function_type = const char* (*)(
+      const char*,
+      const char*,
+      char,
+      char
+    );
+    using scan_function_type = void (*)(
+      const char*,
+      std::size_t,
+      char,
+      std::uint64_t*
+    );
+
+    // Longest candidate, in 64 byte windows, which match() scans into
+    // bitmaps. Longer ones are scored with score().
+    static const std::size_t MAX_WINDOWS = 4;
+    // Maximum length of a pattern match() builds bitmaps for.
+    static const std::size_t MAX_CHARACTERS = 16;
+    // Number of candidates match() prefetches at once.
+    static const std::size_t BATCH_SIZE = 64;
+
+    static const int SCORE_MATCH = 16;
+    static const int SCORE_GAP_START = 3;
+    static const int SCORE_GAP_EXTENSION = 1;
+    static const int BONUS_BOUNDARY = 8;
+    static const int BONUS_CAMEL_CASE = 7;
+    static const int BONUS_CONSECUTIVE = 4;
+    static const int MAX_LEADING_PENALTY = 15;
+
+    static inline char
+    fold(char c)
+    {
+      return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+    }
+
+    static inline char
+    unfold(char c)
+    {
+      return c >= 'a' && c <= 'z' ? c - ('a' - 'A') : c;
+    }
+
+    static inline bool
+    is_boundary(char c)
+    {
+      switch (c)
+      {
+        case '/':
+        case ':':
+        case '.':
+        case '-':
+        case '_':
+        case ' ':
+        case '?':
+        case '&':
+        case '=':
+        case '#':
+          return true;
+
+        default:
+          return false;
+      }
+    }
+
+    static inline std::uint64_t
+    get_char_mask(char c)
+    {
+      const auto u = static_cast<unsigned char>(fold(c));
+
+      if (u >= 'a' && u <= 'z')
+      {
+        return std::uint64_t(1) << (u - 'a');
+      }
+      else if (u >= '0' && u <= '9')
+      {
+        return std::uint64_t(1) << (26 + u - '0');
+      }
+
+      return std::uint64_t(1) << (36 + u % 28);
+    }
+
+    static const char*
+    find_byte_scalar(const char* p, const char* end, char lower, char upper)
+    {
+      for (; p < end; ++p)
+      {
+        if (*p == lower || *p == upper)
+        {
+          return p;
+        }
+      }
+
+      return nullptr;
+    }
+
+#if defined(SELAIN_FUZZY_HAVE_SSE2)
+    static const char*
+    find_byte_sse2(const char* p, const char* end, char lower, char upper)
+    {
+      const auto lower_vector = _mm_set1_epi8(lower);
+      const auto upper_vector = _mm_set1_epi8(upper);
+
+      while (end - p >= 16)
+      {
+        const auto block = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(p)
+        );
+        const auto mask = _mm_movemask_epi8(_mm_or_si128(
+          _mm_cmpeq_epi8(block, lower_vector),
+          _mm_cmpeq_epi8(block, upper_vector)
+        ));
+
+        if (mask)
+        {
+          return p + __builtin_ctz(static_cast<unsigned int>(mask));
+        }
+        p += 16;
+      }
+
+      return find_byte_scalar(p, end, lower, upper);
+    }
+
+    /**
+     * Builds bitmap of positions where given character appears in given
+     * number of 64 byte windows.
+     */
+    static void
+    scan_windows_sse2(const char* p,
+                      std::size_t window_count,
+                      char character,
+                      std::uint64_t* bitmap)
+    {
+      const auto lower_vector = _mm_set1_epi8(character);
+      const auto upper_vector = _mm_set1_epi8(unfold(character));
+
+      for (std::size_t window = 0; window < window_count; ++window)
+      {
+        std::uint64_t bits = 0;
+
+        for (int i = 0; i < 4; ++i)
+        {
+          const auto block = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(p + window * 64 + i * 16)
+          );
+          const auto mask = _mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(block, lower_vector),
+            _mm_cmpeq_epi8(block, upper_vector)
+          ));
+
+          bits |= static_cast<std::uint64_t>(mask) << (i * 16);
+        }
+        bitmap[window] = bits;
+      }
+    }
+#endif
+
+#if defined(SELAIN_FUZZY_HAVE_AVX2)
+    __attribute__((target("avx2")))
+    static const char*
+    find_byte_avx2(const char* p, const char* end, char lower, char upper)
+    {
+      const auto lower_vector = _mm256_set1_epi8(lower);
+      const auto upper_vector = _mm256_set1_epi8(upper);
+
+      while (end - p >= 32)
+      {
+        const auto block = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(p)
+        );
+        const auto mask = _mm256_movemask_epi8(_mm256_or_si256(
+          _mm256_cmpeq_epi8(block, lower_vector),
+          _mm256_cmpeq_epi8(block, upper_vector)
+        ));
+
+        if (mask)
+        {
+          return p + __builtin_ctz(static_cast<unsigned int>(mask));
+        }
+        p += 32;
+      }
+
+      return find_byte_scalar(p, end, lower, upper);
+    }
+
+    __attribute__((target("avx2")))
+    static void
+    scan_windows_avx2(const char* p,
+                      std::size_t window_count,
+                      char character,
+                      std::uint64_t* bitmap)
+    {
+      const auto lower_vector = _mm256_set1_epi8(character);
+      const auto upper_vector = _mm256_set1_epi8(unfold(character));
+
+      for (std::size_t window = 0; window < window_count; ++window)
+      {
+        const auto low = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(p + window * 64)
+        );
+        const auto high = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(p + window * 64 + 32)
+        );
+        const auto low_mask = static_cast<std::uint32_t>(
+          _mm256_movemask_epi8(_mm256_or_si256(
+            _mm256_cmpeq_epi8(low, lower_vector),
+            _mm256_cmpeq_epi8(low, upper_vector)
+          ))
+        );
+        const auto high_mask = static_cast<std::uint32_t>(
+          _mm256_movemask_epi8(_mm256_or_si256(
+            _mm256_cmpeq_epi8(high, lower_vector),
+            _mm256_cmpeq_epi8(high, upper_vector)
+          ))
+        );
+
+        bitmap[window] = static_cast<std::uint64_t>(high_mask) << 32
+          | low_mask;
+      }
+    }
+#endif
+
+    static bool
+    is_supported(Implementation implementation)
+    {
+      switch (implementation)
+      {
+        case Implementation::SCALAR:
+          return true;
+
+        case Implementation::SSE2:
+#if defined(SELAIN_FUZZY_HAVE_SSE2)
+          return true;
+#else
+          return false;
+#endif
+
+        case Implementation::AVX2:
+#if defined(SELAIN_FUZZY_HAVE_AVX2)
+          __builtin_cpu_init();
+
+          return __builtin_cpu_supports("avx2");
+#else
+          return false;
+#endif
+      }
+
+      return false;
+    }
+
+    static find_function_type
+    get_find_function(Implementation implementation)
+    {
+      switch (implementation)
+      {
+#if defined(SELAIN_FUZZY_HAVE_AVX2)
+        case Implementation::AVX2:
+          return find_byte_avx2;
+#endif
+
+#if defined(SELAIN_FUZZY_HAVE_SSE2)
+        case Implementation::SSE2:
+          return find_byte_sse2;
+#endif
+
+        default:
+          return find_byte_scalar;
+      }
+    }
+
+    static scan_function_type
+    get_scan_function(Implementation implementation)
+    {
+      switch (implementation)
+      {
+#if defined(SELAIN_FUZZY_HAVE_AVX2)
+        case Implementation::AVX2:
+          return scan_windows_avx2;
+#endif
+
+#if defined(SELAIN_FUZZY_HAVE_SSE2)
+        case Implementation::SSE2:
+          return scan_windows_sse2;
+#endif
+
+        default:
+          // Building the bitmaps without SIMD is slower than scoring the
+          // candidates one by one.
+          return nullptr;
+      }
+    }
+
+    static Implementation
+    detect_implementation()
+    {
+      if (is_supported(Implementation::AVX2))
+      {
+        return Implementation::AVX2;
+      }
+      else if (is_supported(Implementation::SSE2))
+      {
+        return Implementation::SSE2;
+      }
+
+      return Implementation::SCALAR;
+    }
+
+    static Implementation current_implementation = detect_implementation();
+    static find_function_type find_byte = get_find_function(
+      current_implementation
+    );
+    static scan_function_type scan_windows = get_scan_function(
+      current_implementation
+    );
+
+    Implementation
+    get_implementation()
+    {
+      return current_implementation;
+    }
+
+    bool
+    set_implementation(Implementation implementation)
+    {
+      if (!is_supported(implementation))
+      {
+        return false;
+      }
+      current_implementation = implementation;
+      find_byte = get_find_function(implementation);
+      scan_windows = get_scan_function(implementation);
+
+      return true;
+    }
+
+    std::uint64_t
+    get_mask(const char* data, std::size_t length)
+    {
+      std::uint64_t mask = 0;
+
+      for (std::size_t i = 0; i < length; ++i)
+      {
+        mask |= get_char_mask(data[i]);
+      }
+
+      return mask;
+    }
+
+    Pattern::Pattern(const std::string& text)
+      : m_text(text)
+    {
+      std::transform(
+        std::begin(m_text),
+        std::end(m_text),
+        std::begin(m_text),
+        fold
+      );
+      m_mask = fuzzy::get_mask(m_text.data(), m_text.length());
+    }
+
+    Arena::Arena()
+      : m_data(PADDING, 0)
+      , m_offsets(1, 0)
+      , m_mask(0) {}
+
+    void
+    Arena::reserve(std::size_t count, std::size_t bytes)
+    {
+      m_data.reserve(bytes + PADDING);
+      m_offsets.reserve(count + 1);
+      m_masks.reserve(count);
+    }
+
+    std::uint32_t
+    Arena::add(const char* data, std::size_t length)
+    {
+      const auto index = static_cast<std::uint32_t>(m_masks.size());
+
+      m_data.resize(m_offsets.back());
+      m_data.insert(std::end(m_data), data, data + length);
+      m_offsets.push_back(static_cast<std::uint32_t>(m_data.size()));
+      m_data.resize(m_data.size() + PADDING, 0);
+      m_masks.push_back(fuzzy::get_mask(data, length));
+      m_mask |= m_masks.back();
+
+      return index;
+    }
+
+    void
+    Arena::clear()
+    {
+      m_data.assign(PADDING, 0);
+      m_offsets.resize(1);
+      m_masks.clear();
+      m_mask = 0;
+    }
+
+    /**
+     * Scores occurrence of the pattern in the candidate, which begins and
+     * ends at given positions.
+     */
+    static int
+    score_occurrence(const Pattern& pattern,
+                     const char* data,
+                     const char* first,
+                     const char* last)
+    {
+      const auto pattern_length = pattern.length();
+      const auto pattern_text = pattern.get_text().data();
+      char previous = first > data ? first[-1] : '/';
+      std::size_t i = 0;
+      int value = 0;
+      int consecutive = 0;
+      bool in_gap = false;
+
+      for (auto p = first; p <= last; ++p)
+      {
+        const auto c = *p;
+
+        if (i < pattern_length && fold(c) == pattern_text[i])
+        {
+          int bonus = 0;
+
+          if (is_boundary(previous))
+          {
+            bonus = BONUS_BOUNDARY;
+          }
+          else if (previous >= 'a' && previous <= 'z' && c >= 'A' && c <= 'Z')
+          {
+            bonus = BONUS_CAMEL_CASE;
+          }
+          value += SCORE_MATCH + bonus;
+          if (!i)
+          {
+            // Bonus of the first character counts double.
+            value += bonus;
+          }
+          if (consecutive)
+          {
+            value += BONUS_CONSECUTIVE;
+          }
+          ++consecutive;
+          in_gap = false;
+          ++i;
+        } else {
+          value -= in_gap ? SCORE_GAP_EXTENSION : SCORE_GAP_START;
+          consecutive = 0;
+          in_gap = true;
+        }
+        previous = c;
+      }
+
+      // Prefer matches near the beginning of the candidate.
+      return value - std::min(
+        static_cast<int>(first - data),
+        MAX_LEADING_PENALTY
+      );
+    }
+
+    bool
+    score(const Pattern& pattern,
+          const char* data,
+          std::size_t length,
+          int& result)
+    {
+      const auto pattern_length = pattern.length();
+      const auto pattern_text = pattern.get_text().data();
+      const auto end = data + length;
+      const char* position = data;
+      const char* first;
+      const char* last;
+      std::size_t i;
+
+      if (!pattern_length)
+      {
+        result = 0;
+
+        return true;
+      }
+      else if (pattern_length > length)
+      {
+        return false;
+      }
+
+      // Forward pass: Find the end of the leftmost occurrence of the pattern
+      // as a subsequence.
+      for (i = 0; i < pattern_length; ++i)
+      {
+        const auto c = pattern_text[i];
+
+        if (!(position = find_byte(position, end, c, unfold(c))))
+        {
+          return false;
+        }
+        ++position;
+      }
+      last = position - 1;
+
+      // Backward pass: Find the shortest occurrence which ends there.
+      first = last;
+      i = pattern_length;
+      for (auto p = last; ; --p)
+      {
+        if (fold(*p) == pattern_text[i - 1] && !--i)
+        {
+          first = p;
+          break;
+        }
+      }
+
+      result = score_occurrence(pattern, data, first, last);
+
+      return true;
+    }
+
+    /**
+     * Returns position of the first set bit of the bitmap at or after given
+     * position, or the end position if there is none before it.
+     */
+    static inline std::size_t
+    find_next_bit(const std::uint64_t* bitmap,
+                  std::size_t position,
+                  std::size_t end)
+    {
+      auto word = position / 64;
+      auto bits = bitmap[word] & (~std::uint64_t(0) << (position % 64));
+
+      while (!bits)
+      {
+        if (++word * 64 >= end)
+        {
+          return end;
+        }
+        bits = bitmap[word];
+      }
+      position = word * 64 + __builtin_ctzll(bits);
+
+      return position < end ? position : end;
+    }
+
+    /**
+     * Returns position of the last set bit of the bitmap at or before given
+     * position. The bit must exist.
+     */
+    static inline std::size_t
+    find_previous_bit(const std::uint64_t* bitmap, std::size_t position)
+    {
+      auto word = position / 64;
+      auto bits = bitmap[word] & (
+        ~std::uint64_t(0) >> (63 - position % 64)
+      );
+
+      while (!bits)
+      {
+        bits = bitmap[--word];
+      }
+
+      return word * 64 + 63 - __builtin_clzll(bits);
+    }
+
+    /**
+     * Returns the highest score an occurrence of a pattern of given length
+     * can get, when it begins at given offset of the candidate and spans
+     * given number of bytes.
+     */
+    static inline int
+    get_max_score(std::size_t pattern_length,
+                  std::size_t offset,
+                  std::size_t span)
+    {
+      const auto length = static_cast<int>(pattern_length);
+      int value = length * (SCORE_MATCH + BONUS_BOUNDARY) + BONUS_BOUNDARY;
+
+      if (span > pattern_length)
+      {
+        // There is at least one gap, which also breaks the consecutive
+        // matches.
+        value += (length - 2) * BONUS_CONSECUTIVE - SCORE_GAP_START
+          - static_cast<int>(span - pattern_length - 1) * SCORE_GAP_EXTENSION;
+      } else {
+        value += (length - 1) * BONUS_CONSECUTIVE;
+      }
+
+      return value - static_cast<int>(
+        std::min(offset, static_cast<std::size_t>(MAX_LEADING_PENALTY))
+      );
+    }
+
+    static inline bool
+    compare_matches(const Match& a, const Match& b)
+    {
+      return a.score > b.score || (a.score == b.score && a.index < b.index);
+    }
+
+    static inline void
+    add_match(const Match& candidate,
+              std::size_t limit,
+              std::vector<Match>& results)
+    {
+      if (results.size() < limit)
+      {
+        results.push_back(candidate);
+        std::push_heap(
+          std::begin(results),
+          std::end(results),
+          compare_matches
+        );
+      }
+      else if (compare_matches(candidate, results.front()))
+      {
+        std::pop_heap(
+          std::begin(results),
+          std::end(results),
+          compare_matches
+        );
+        results.back() = candidate;
+        std::push_heap(
+          std::begin(results),
+          std::end(results),
+          compare_matches
+        );
+      }
+    }
+
+    void
+    match(const Pattern& pattern,
+          const Arena& arena,
+          std::size_t limit,
+          std::vector<Match>& results)
+    {
+      const auto mask = pattern.get_mask();
+      const auto count = arena.size();
+      const auto pattern_length = pattern.length();
+      const auto pattern_text = pattern.get_text().data();
+      unsigned char character_index[MAX_CHARACTERS];
+      std::uint64_t bitmaps[MAX_CHARACTERS][MAX_WINDOWS];
+      std::size_t character_count = 0;
+
+      results.clear();
+      if (!limit || (arena.get_mask() & mask) != mask)
+      {
+        return;
+      }
+      results.reserve(limit);
+
+      // Each distinct character of the pattern gets it's own bitmap, so
+      // that repeated characters are scanned only once. Very long patterns
+      // fall back to score().
+      if (scan_windows && pattern_length <= MAX_CHARACTERS)
+      {
+        for (std::size_t i = 0; i < pattern_length; ++i)
+        {
+          std::size_t j = 0;
+
+          while (j < i && pattern_text[j] != pattern_text[i])
+          {
+            ++j;
+          }
+          character_index[i] = static_cast<unsigned char>(
+            j < i ? character_index[j] : character_count++
+          );
+        }
+      }
+
+      // Results are kept in a heap where the worst match is first.
+      for (std::size_t index = 0; index < count;)
+      {
+        std::uint32_t batch[BATCH_SIZE];
+        std::size_t batch_size = 0;
+
+        // Candidates passing the mask check are collected in batches and
+        // their text is prefetched, as they can be far apart in the arena.
+        for (; index < count && batch_size < BATCH_SIZE; ++index)
+        {
+          if ((arena.get_mask(index) & mask) == mask
+              && arena.get_length(index) >= pattern_length)
+          {
+            __builtin_prefetch(arena.get_data(index));
+            batch[batch_size++] = static_cast<std::uint32_t>(index);
+          }
+        }
+
+        for (std::size_t n = 0; n < batch_size; ++n)
+        {
+          const auto data = arena.get_data(batch[n]);
+          const auto length = arena.get_length(batch[n]);
+          std::size_t position;
+          std::size_t first;
+          Match candidate;
+
+          if (!character_count || length > MAX_WINDOWS * 64)
+          {
+            if (!score(pattern, data, length, candidate.score))
+            {
+              continue;
+            }
+          } else {
+            const auto window_count = (length + 63) / 64;
+            std::uint32_t scanned = 0;
+
+            // Forward pass. Bitmaps are built as the characters are needed,
+            // so that candidates are rejected as early as possible. Once the
+            // heap is full, offset of the leftmost occurrence of the first
+            // character and later the span of the occurrence give upper
+            // bounds for the score, which reject most of the candidates
+            // before they are scored. The arena is padded so that whole
+            // windows can be read even past the end of the last candidate.
+            // Bits past the end of the candidate are never looked at.
+            position = 0;
+            for (std::size_t i = 0; i < pattern_length; ++i)
+            {
+              const auto j = character_index[i];
+
+              if (!(scanned & (1 << j)))
+              {
+                scan_windows(data, window_count, pattern_text[i], bitmaps[j]);
+                scanned |= 1 << j;
+              }
+              position = find_next_bit(
+                bitmaps[j],
+                i ? position + 1 : 0,
+                length
+              );
+              if (!i
+                  && position < length
+                  && results.size() >= limit
+                  && get_max_score(pattern_length, position, pattern_length)
+                    <= results.front().score)
+              {
+                position = length;
+              }
+              if (position == length)
+              {
+                break;
+              }
+            }
+            if (position == length)
+            {
+              continue;
+            }
+
+            // Backward pass.
+            first = position;
+            for (auto i = pattern_length - 1; i > 0; --i)
+            {
+              first = find_previous_bit(
+                bitmaps[character_index[i - 1]],
+                first - 1
+              );
+            }
+            if (results.size() >= limit
+                && get_max_score(pattern_length, first, position - first + 1)
+                  <= results.front().score)
+            {
+              continue;
+            }
+            candidate.score = score_occurrence(
+              pattern,
+              data,
+              data + first,
+              data + position
+            );
+          }
+          candidate.index = batch[n];
+          add_match(candidate, limit, results);
+        }
+      }
+      std::sort_heap(std::begin(results), std::end(results), compare_matches);
+    }
+  }
+}
@@ -24,32 +24,53 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 #include <selain/main-window.hpp>
+#include <selain/metrics.hpp>
+
+#include <cstring>
 
 #define SELAIN_JS_STRINGIFY(source) #source
 
 namespace selain
 {
+  static metrics::Counter hint_sessions(
+    "selain_hint_sessions",
+    "Times hint mode has been entered."
+  );
+  static metrics::Counter hint_keys(
+    "selain_hint_keys",
+    "Characters typed in hint mode."
+  );
+
   static Glib::ustring hint_mode_source_code =
   #include "./hint-mode.js"
   ;
 
   Glib::RefPtr<HintContext>
-  HintContext::create(bool open_in_new_tab)
+  HintContext::create(HintTarget target)
   {
-    return Glib::RefPtr<HintContext>(new HintContext(open_in_new_tab));
+    return Glib::RefPtr<HintContext>(new HintContext(target));
   }
 
-  HintContext::HintContext(bool open_in_new_tab)
-    : m_open_in_new_tab(open_in_new_tab) {}
+  HintContext::HintContext(HintTarget target)
+    : m_target(target) {}
 
   void
   HintContext::install(Tab& tab)
   {
+    hint_sessions.increment();
     tab.execute_script(hint_mode_source_code);
-    if (m_open_in_new_tab)
+    if (m_target == HintTarget::NEW_TAB)
     {
       tab.execute_script("window.SelainHintMode.setOpenToNewTab();");
     }
+    else if (m_target == HintTarget::LITE_TAB)
+    {
+      tab.execute_script("window.SelainHintMode.setOpenToLiteTab();");
+    }
+    else if (m_target == HintTarget::READ_LATER)
+    {
+      tab.execute_script("window.SelainHintMode.setOpenToReadLater();");
+    }
   }
 
   void
@@ -108,6 +129,31 @@ namespace selain
           window->set_mode(Mode::INSERT);
         }
       }
+      else if (::g_str_has_prefix(str_value, "open-lite::"))
+      {
+        if (const auto window = tab->get_main_window())
+        {
+          window->set_mode(Mode::NORMAL);
+          window->open_tab(
+            str_value + std::strlen("open-lite::"),
+            true,
+            SettingsProfile::LITE
+          );
+        }
+      }
+      else if (::g_str_has_prefix(str_value, "read-later::"))
+      {
+        if (const auto window = tab->get_main_window())
+        {
+          const std::string uri(str_value + std::strlen("read-later::"));
+
+          window->set_mode(Mode::NORMAL);
+          window->get_read_later().add(uri);
+          window->get_command_entry().show_notification(
+            "Added " + uri + " to read-later queue"
+          );
+        }
+      }
       ::g_free(str_value);
     } else {
       ::g_warning("Unexpected return value from hint mode.");
@@ -124,6 +170,7 @@ namespace selain
     {
       return;
     }
+    hint_keys.increment();
     std::snprintf(buffer, 7, "\\u%04x", static_cast<int>(ch));
     tab.execute_script(
       Glib::ustring::compose("window.SelainHintMode.addChar('%1');", buffer),
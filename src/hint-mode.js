@@ -9,6 +9,8 @@ SELAIN_JS_STRINGIFY((() => {
   let hintContainer = null;
   let currentSequence = '';
   let openToNewTab = false;
+  let openToLiteTab = false;
+  let openToReadLater = false;
 
   const numberToSequence = (number) => Array
     .from(`${number}`)
@@ -163,6 +165,12 @@ SELAIN_JS_STRINGIFY((() => {
       return 'mode::insert';
     } else if (['frame', 'iframe'].indexOf(tagName) >= 0) {
       element.focus();
+    } else if (openToReadLater && typeof element.href === 'string' &&
+               element.href.length > 0) {
+      return `read-later::${element.href}`;
+    } else if (openToLiteTab && typeof element.href === 'string' &&
+               element.href.length > 0) {
+      return `open-lite::${element.href}`;
     } else if (openToNewTab) {
       const oldTarget = element.getAttribute('target');
 
@@ -275,13 +283,23 @@ SELAIN_JS_STRINGIFY((() => {
     openToNewTab = true;
   };
 
+  const setOpenToLiteTab = () => {
+    openToLiteTab = true;
+  };
+
+  const setOpenToReadLater = () => {
+    openToReadLater = true;
+  };
+
   install();
 
   window.SelainHintMode = {
     activateCurrentMatch,
     addChar,
     removeChar,
+    setOpenToLiteTab,
     setOpenToNewTab,
+    setOpenToReadLater,
     uninstall
   };
 })();)
@@ -0,0 +1,692 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/history.hpp>
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <limits>
+
+namespace selain
+{
+  // Weight of a visit halves in every thirty days.
+  static const double FRECENCY_HALF_LIFE = 30.0 * 24.0 * 60.0 * 60.0;
+  static const double FRECENCY_DECAY = std::log(2.0) / FRECENCY_HALF_LIFE;
+
+  // The log file is compacted when it contains this many times more records
+  // than there are unique entries in the history.
+  static const std::size_t COMPACTION_RATIO = 4;
+  static const std::size_t COMPACTION_MIN_RECORDS = 10000;
+
+  // Number of entries copied at once while iterating the history.
+  static const std::size_t ITERATION_CHUNK_SIZE = 256;
+
+  // Difference between Windows epoch used by Chromium and the Unix epoch, in
+  // seconds.
+  static const std::int64_t CHROMIUM_EPOCH_OFFSET = 11644473600;
+
+  static inline double
+  log_add(double a, double b)
+  {
+    const auto max = std::max(a, b);
+
+    if (max == -std::numeric_limits<double>::infinity())
+    {
+      return max;
+    }
+
+    return max + std::log1p(std::exp(std::min(a, b) - max));
+  }
+
+  static inline double
+  visit_weight(std::int64_t timestamp)
+  {
+    return FRECENCY_DECAY * static_cast<double>(timestamp);
+  }
+
+  static bool
+  is_recordable(const std::string& uri)
+  {
+    static const char* schemes[] =
+    {
+      "http://",
+      "https://",
+      "ftp://",
+      "file://",
+    };
+
+    return std::any_of(
+      std::begin(schemes),
+      std::end(schemes),
+      [&uri](const char* scheme)
+      {
+        return !uri.compare(0, std::strlen(scheme), scheme);
+      }
+    );
+  }
+
+  /**
+   * Replaces characters used as field and record separators in the log file
+   * with spaces.
+   */
+  static std::string
+  sanitize(const std::string& input)
+  {
+    auto result = input;
+
+    std::replace_if(
+      std::begin(result),
+      std::end(result),
+      [](const char c)
+      {
+        return c == '\t' || c == '\n' || c == '\r';
+      },
+      ' '
+    );
+
+    return result;
+  }
+
+  static std::string
+  format_entry_record(const HistoryEntry& entry)
+  {
+    char buffer[96];
+
+    std::snprintf(
+      buffer,
+      sizeof(buffer),
+      "E\t%.17g\t%u\t%lld\t",
+      entry.frecency,
+      static_cast<unsigned int>(entry.visit_count),
+      static_cast<long long>(entry.last_visit)
+    );
+
+    return buffer + entry.uri + '\t' + sanitize(entry.title);
+  }
+
+  static void
+  split_fields(const std::string& line, std::vector<std::string>& fields)
+  {
+    std::string::size_type start = 0;
+    std::string::size_type end;
+
+    fields.clear();
+    while ((end = line.find('\t', start)) != std::string::npos)
+    {
+      fields.push_back(line.substr(start, end - start));
+      start = end + 1;
+    }
+    fields.push_back(line.substr(start));
+  }
+
+  History::History()
+    : m_running(false)
+    , m_discarding(false)
+    , m_import_cancelled(false)
+    , m_import_count(0)
+  {
+    m_import_dispatcher.connect(
+      sigc::mem_fun(this, &History::on_import_finished)
+    );
+  }
+
+  History::~History()
+  {
+    // Import has to finish first, as it queues records for the log thread.
+    m_import_cancelled = true;
+    if (m_import_thread.joinable())
+    {
+      m_import_thread.join();
+    }
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      m_running = false;
+    }
+    m_condition.notify_one();
+    if (m_thread.joinable())
+    {
+      m_thread.join();
+    }
+  }
+
+  void
+  History::open(const std::string& path)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    if (m_running)
+    {
+      return;
+    }
+    m_path = path;
+    m_running = true;
+    m_thread = std::thread(&History::run, this);
+  }
+
+  void
+  History::add_visit(const std::string& uri, std::int64_t timestamp)
+  {
+    char buffer[32];
+
+    if (!is_recordable(uri))
+    {
+      return;
+    }
+    if (!timestamp)
+    {
+      timestamp = static_cast<std::int64_t>(std::time(nullptr));
+    }
+    std::snprintf(
+      buffer,
+      sizeof(buffer),
+      "V\t%lld\t",
+      static_cast<long long>(timestamp)
+    );
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      m_index.merge({
+        uri,
+        std::string(),
+        visit_weight(timestamp),
+        1,
+        timestamp
+      });
+      if (!m_discarding)
+      {
+        m_queue.push_back(buffer + sanitize(uri));
+      }
+    }
+    m_condition.notify_one();
+  }
+
+  void
+  History::set_title(const std::string& uri, const std::string& title)
+  {
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+      const auto entry = m_index.find(uri);
+
+      if (!entry || entry->title == title)
+      {
+        return;
+      }
+      entry->title = title;
+      if (!m_discarding)
+      {
+        m_queue.push_back("T\t" + sanitize(uri) + '\t' + sanitize(title));
+      }
+    }
+    m_condition.notify_one();
+  }
+
+  std::vector<HistoryEntry>
+  History::get_top(std::size_t count) const
+  {
+    std::vector<HistoryEntry> result;
+
+    result.reserve(count);
+    for_each([&result, count](const HistoryEntry& entry)
+    {
+      result.push_back(entry);
+
+      return result.size() < count;
+    });
+
+    return result;
+  }
+
+  void
+  History::for_each(
+    const std::function<bool(const HistoryEntry&)>& callback
+  ) const
+  {
+    std::vector<HistoryEntry> chunk;
+    Index::ranking_type::key_type last;
+    bool first = true;
+
+    chunk.reserve(ITERATION_CHUNK_SIZE);
+    for (;;)
+    {
+      // Copy next chunk of entries, so that the main thread is not blocked
+      // while the callback goes through a large history.
+      {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        auto it = first
+          ? std::begin(m_index.ranking)
+          : m_index.ranking.upper_bound(last);
+
+        chunk.clear();
+        for (; it != std::end(m_index.ranking)
+               && chunk.size() < ITERATION_CHUNK_SIZE;
+             ++it)
+        {
+          chunk.push_back(m_index.entries[it->second]);
+          last = *it;
+        }
+      }
+      if (chunk.empty())
+      {
+        return;
+      }
+      for (const auto& entry : chunk)
+      {
+        if (!callback(entry))
+        {
+          return;
+        }
+      }
+      first = false;
+    }
+  }
+
+  double
+  History::get_score(const HistoryEntry& entry, std::int64_t now)
+  {
+    return std::exp(entry.frecency - visit_weight(now));
+  }
+
+  void
+  History::Index::merge(const HistoryEntry& entry)
+  {
+    const auto it = uri_index.find(entry.uri);
+    std::size_t id;
+
+    if (it == std::end(uri_index))
+    {
+      id = entries.size();
+      entries.push_back(entry);
+      uri_index[entry.uri] = id;
+      ranking.emplace(entry.frecency, id);
+      return;
+    }
+
+    auto& existing = entries[id = it->second];
+
+    ranking.erase(std::make_pair(existing.frecency, id));
+    existing.frecency = log_add(existing.frecency, entry.frecency);
+    existing.visit_count += entry.visit_count;
+    if (entry.last_visit >= existing.last_visit)
+    {
+      existing.last_visit = entry.last_visit;
+      if (!entry.title.empty())
+      {
+        existing.title = entry.title;
+      }
+    }
+    else if (existing.title.empty())
+    {
+      existing.title = entry.title;
+    }
+    ranking.emplace(existing.frecency, id);
+  }
+
+  HistoryEntry*
+  History::Index::find(const std::string& uri)
+  {
+    const auto it = uri_index.find(uri);
+
+    return it != std::end(uri_index) ? &entries[it->second] : nullptr;
+  }
+
+  void
+  History::run()
+  {
+    const auto record_count = load();
+    std::FILE* file;
+
+    if (record_count >= COMPACTION_MIN_RECORDS)
+    {
+      compact(record_count);
+    }
+
+    if (!(file = std::fopen(m_path.c_str(), "a")))
+    {
+      ::g_warning("Unable to open history file: %s", m_path.c_str());
+
+      // Nothing would ever consume the queue, so stop filling it.
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      m_discarding = true;
+      std::vector<std::string>().swap(m_queue);
+      return;
+    }
+
+    for (;;)
+    {
+      std::vector<std::string> records;
+
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_condition.wait(lock, [this]()
+        {
+          return !m_running || !m_queue.empty();
+        });
+        if (m_queue.empty())
+        {
+          break;
+        }
+        records.swap(m_queue);
+      }
+      for (const auto& record : records)
+      {
+        std::fputs(record.c_str(), file);
+        std::fputc('\n', file);
+      }
+      std::fflush(file);
+    }
+
+    std::fclose(file);
+  }
+
+  std::size_t
+  History::load()
+  {
+    std::ifstream input(m_path);
+    std::string line;
+    std::vector<std::string> fields;
+    std::size_t record_count = 0;
+    Index loaded;
+
+    if (!input.good())
+    {
+      return 0;
+    }
+
+    // The log is parsed into a separate index, so that the main thread can
+    // keep recording visits while a large history file is being loaded.
+    while (std::getline(input, line))
+    {
+      split_fields(line, fields);
+      ++record_count;
+      if (fields[0] == "V" && fields.size() == 3)
+      {
+        const auto timestamp = std::strtoll(fields[1].c_str(), nullptr, 10);
+
+        loaded.merge({
+          fields[2],
+          std::string(),
+          visit_weight(timestamp),
+          1,
+          timestamp
+        });
+      }
+      else if (fields[0] == "T" && fields.size() == 3)
+      {
+        if (const auto entry = loaded.find(fields[1]))
+        {
+          entry->title = fields[2];
+        }
+      }
+      else if (fields[0] == "E" && fields.size() == 6)
+      {
+        loaded.merge({
+          fields[4],
+          fields[5],
+          std::strtod(fields[1].c_str(), nullptr),
+          static_cast<std::uint32_t>(
+            std::strtoul(fields[2].c_str(), nullptr, 10)
+          ),
+          std::strtoll(fields[3].c_str(), nullptr, 10)
+        });
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      // Visits recorded during the load are newer than anything in the file.
+      for (const auto& entry : m_index.entries)
+      {
+        loaded.merge(entry);
+      }
+      m_index = std::move(loaded);
+    }
+
+    return record_count;
+  }
+
+  void
+  History::compact(std::size_t record_count)
+  {
+    const auto temporary_path = m_path + ".tmp";
+    std::vector<std::string> records;
+    std::vector<std::string> pending_records;
+    std::FILE* file;
+
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      if (record_count <= m_index.entries.size() * COMPACTION_RATIO)
+      {
+        return;
+      }
+      records.reserve(m_index.entries.size());
+      for (const auto& entry : m_index.entries)
+      {
+        records.push_back(format_entry_record(entry));
+      }
+      // Queued records are already included in the snapshot.
+      pending_records.swap(m_queue);
+    }
+
+    if ((file = std::fopen(temporary_path.c_str(), "w")))
+    {
+      for (const auto& record : records)
+      {
+        std::fputs(record.c_str(), file);
+        std::fputc('\n', file);
+      }
+      if (!std::fclose(file) &&
+          !std::rename(temporary_path.c_str(), m_path.c_str()))
+      {
+        return;
+      }
+      std::remove(temporary_path.c_str());
+    }
+    ::g_warning("Unable to compact history file: %s", m_path.c_str());
+
+    // Put the records back into the queue so that they are not lost.
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      m_queue.insert(
+        std::begin(m_queue),
+        std::begin(pending_records),
+        std::end(pending_records)
+      );
+    }
+  }
+
+  static std::size_t
+  read_history_database(HistoryImportSource source,
+                        const std::string& path,
+                        const std::atomic<bool>& cancelled,
+                        std::vector<HistoryEntry>& entries,
+                        std::string& error)
+  {
+    static const char* firefox_query =
+      "SELECT p.url, p.title, v.visit_date "
+      "FROM moz_historyvisits AS v "
+      "JOIN moz_places AS p ON p.id = v.place_id";
+    static const char* chromium_query =
+      "SELECT u.url, u.title, v.visit_time "
+      "FROM visits AS v "
+      "JOIN urls AS u ON u.id = v.url";
+    std::unordered_map<std::string, std::size_t> uri_index;
+    std::size_t visit_count = 0;
+    ::gchar* uri;
+    ::sqlite3* db = nullptr;
+    ::sqlite3_stmt* statement = nullptr;
+    int rc;
+
+    // The database is opened as immutable, because running browsers keep
+    // their history databases locked.
+    if (!(uri = ::g_filename_to_uri(path.c_str(), nullptr, nullptr)))
+    {
+      error = "Invalid path: " + path;
+      return 0;
+    }
+    rc = ::sqlite3_open_v2(
+      (std::string(uri) + "?immutable=1").c_str(),
+      &db,
+      SQLITE_OPEN_READONLY | SQLITE_OPEN_URI,
+      nullptr
+    );
+    ::g_free(uri);
+    if (rc != SQLITE_OK || ::sqlite3_prepare_v2(
+      db,
+      source == HistoryImportSource::FIREFOX ? firefox_query : chromium_query,
+      -1,
+      &statement,
+      nullptr
+    ) != SQLITE_OK)
+    {
+      error = db ? ::sqlite3_errmsg(db) : "Unable to open database";
+      ::sqlite3_close(db);
+      return 0;
+    }
+
+    while (!cancelled && (rc = ::sqlite3_step(statement)) == SQLITE_ROW)
+    {
+      const auto url = ::sqlite3_column_text(statement, 0);
+      const auto title = ::sqlite3_column_text(statement, 1);
+      auto timestamp = static_cast<std::int64_t>(
+        ::sqlite3_column_int64(statement, 2) / 1000000
+      );
+      std::string entry_uri;
+
+      if (!url)
+      {
+        continue;
+      }
+      entry_uri = reinterpret_cast<const char*>(url);
+      if (!is_recordable(entry_uri))
+      {
+        continue;
+      }
+      if (source == HistoryImportSource::CHROMIUM)
+      {
+        timestamp -= CHROMIUM_EPOCH_OFFSET;
+      }
+
+      const auto it = uri_index.find(entry_uri);
+
+      if (it == std::end(uri_index))
+      {
+        uri_index[entry_uri] = entries.size();
+        entries.push_back({
+          entry_uri,
+          title ? reinterpret_cast<const char*>(title) : "",
+          visit_weight(timestamp),
+          1,
+          timestamp
+        });
+      } else {
+        auto& entry = entries[it->second];
+
+        entry.frecency = log_add(entry.frecency, visit_weight(timestamp));
+        entry.last_visit = std::max(entry.last_visit, timestamp);
+        ++entry.visit_count;
+      }
+      ++visit_count;
+    }
+    if (cancelled)
+    {
+      error = "Cancelled";
+    }
+    else if (rc != SQLITE_DONE)
+    {
+      error = ::sqlite3_errmsg(db);
+    }
+
+    ::sqlite3_finalize(statement);
+    ::sqlite3_close(db);
+
+    return visit_count;
+  }
+
+  void
+  History::import(HistoryImportSource source,
+                  const std::string& path,
+                  const import_callback_type& callback)
+  {
+    if (m_import_thread.joinable())
+    {
+      callback(0, "Another import is already in progress");
+      return;
+    }
+    m_import_callback = callback;
+    m_import_thread = std::thread([this, source, path]()
+    {
+      std::vector<HistoryEntry> entries;
+
+      m_import_error.clear();
+      m_import_count = read_history_database(
+        source,
+        path,
+        m_import_cancelled,
+        entries,
+        m_import_error
+      );
+      if (m_import_error.empty())
+      {
+        {
+          std::lock_guard<std::mutex> guard(m_mutex);
+
+          for (const auto& entry : entries)
+          {
+            m_index.merge(entry);
+            if (!m_discarding)
+            {
+              m_queue.push_back(format_entry_record(entry));
+            }
+          }
+        }
+        m_condition.notify_one();
+      }
+      m_import_dispatcher.emit();
+    });
+  }
+
+  void
+  History::on_import_finished()
+  {
+    import_callback_type callback;
+
+    m_import_thread.join();
+    callback.swap(m_import_callback);
+    callback(m_import_error.empty() ? m_import_count : 0, m_import_error);
+  }
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/internal-page.hpp>
+
+#include <algorithm>
+
+namespace selain
+{
+  static void
+  free_string(::gpointer data)
+  {
+    delete static_cast<std::string*>(data);
+  }
+
+  InternalResponse::InternalResponse()
+    : m_stream(::g_memory_input_stream_new())
+  {
+  }
+
+  InternalResponse::~InternalResponse()
+  {
+    ::g_object_unref(m_stream);
+  }
+
+  void
+  InternalResponse::append(std::string&& chunk)
+  {
+    const auto data = new std::string(std::move(chunk));
+    const auto bytes = ::g_bytes_new_with_free_func(
+      data->data(),
+      data->length(),
+      free_string,
+      static_cast<::gpointer>(data)
+    );
+
+    ::g_memory_input_stream_add_bytes(G_MEMORY_INPUT_STREAM(m_stream), bytes);
+    ::g_bytes_unref(bytes);
+  }
+
+  void
+  InternalResponse::append_static(const char* chunk)
+  {
+    ::g_memory_input_stream_add_data(
+      G_MEMORY_INPUT_STREAM(m_stream),
+      chunk,
+      -1,
+      nullptr
+    );
+  }
+
+  void
+  InternalResponse::append_escaped(const Glib::ustring& text)
+  {
+    append(Glib::Markup::escape_text(text).raw());
+  }
+
+  bool
+  InternalResponse::append_file(const std::string& path)
+  {
+    const auto file = ::g_mapped_file_new(path.c_str(), false, nullptr);
+    ::GBytes* bytes;
+
+    if (!file)
+    {
+      return false;
+    }
+    bytes = ::g_mapped_file_get_bytes(file);
+    ::g_memory_input_stream_add_bytes(G_MEMORY_INPUT_STREAM(m_stream), bytes);
+    ::g_bytes_unref(bytes);
+    ::g_mapped_file_unref(file);
+
+    return true;
+  }
+
+  InternalRequest::InternalRequest(::WebKitURISchemeRequest* request)
+    : m_request(WEBKIT_URI_SCHEME_REQUEST(::g_object_ref(request)))
+  {
+  }
+
+  InternalRequest::InternalRequest(const InternalRequest& that)
+    : m_request(WEBKIT_URI_SCHEME_REQUEST(::g_object_ref(that.m_request)))
+  {
+  }
+
+  InternalRequest::~InternalRequest()
+  {
+    ::g_object_unref(m_request);
+  }
+
+  std::string
+  InternalRequest::get_page() const
+  {
+    std::string path = ::webkit_uri_scheme_request_get_path(m_request);
+    std::string::size_type pos;
+
+    // Path of "selain://start" is "//start".
+    path.erase(0, path.find_first_not_of('/'));
+    if ((pos = path.find_first_of("?#/")) != std::string::npos)
+    {
+      path.erase(pos);
+    }
+
+    return path;
+  }
+
+  std::string
+  InternalRequest::get_parameter(const std::string& name) const
+  {
+    const std::string uri = ::webkit_uri_scheme_request_get_uri(m_request);
+    auto start = uri.find('?');
+
+    while (start != std::string::npos)
+    {
+      auto end = uri.find_first_of("&#", ++start);
+      const auto separator = uri.find('=', start);
+
+      if (end == std::string::npos)
+      {
+        end = uri.length();
+      }
+      if (separator < end && !uri.compare(start, separator - start, name))
+      {
+        auto value = uri.substr(separator + 1, end - separator - 1);
+        std::string result;
+
+        std::replace(std::begin(value), std::end(value), '+', ' ');
+        if (const auto unescaped = ::g_uri_unescape_string(
+          value.c_str(),
+          nullptr
+        ))
+        {
+          result = unescaped;
+          ::g_free(unescaped);
+        }
+
+        return result;
+      }
+      if (end >= uri.length() || uri[end] == '#')
+      {
+        break;
+      }
+      start = end;
+    }
+
+    return std::string();
+  }
+
+  void
+  InternalRequest::finish(const InternalResponse& response,
+                          const char* content_type) const
+  {
+    ::webkit_uri_scheme_request_finish(
+      m_request,
+      response.get_stream(),
+      -1,
+      content_type
+    );
+  }
+
+  void
+  InternalRequest::finish_error(const std::string& message) const
+  {
+    const auto error = ::g_error_new_literal(
+      G_IO_ERROR,
+      G_IO_ERROR_NOT_FOUND,
+      message.c_str()
+    );
+
+    ::webkit_uri_scheme_request_finish_error(m_request, error);
+    ::g_error_free(error);
+  }
+}
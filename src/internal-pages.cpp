@@ -0,0 +1,984 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/main-window.hpp>
+#include <selain/metrics.hpp>
+#include <selain/utils.hpp>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace selain
+{
+  static void page_downloads(MainWindow&, const InternalRequest&);
+  static void page_history_search(MainWindow&, const InternalRequest&);
+  static void page_perf(MainWindow&, const InternalRequest&);
+  static void page_read_later(MainWindow&, const InternalRequest&);
+  static void page_reader(MainWindow&, const InternalRequest&);
+  static void page_start(MainWindow&, const InternalRequest&);
+  static void page_stats(MainWindow&, const InternalRequest&);
+  static void page_waterfall(MainWindow&, const InternalRequest&);
+
+  // Number of most frequently visited pages listed on the start page.
+  static const std::size_t START_PAGE_TOP_SITES = 12;
+
+  // Maximum number of pages listed by full-text history search.
+  static const std::size_t HISTORY_SEARCH_RESULTS = 100;
+
+  static const struct
+  {
+    const char* name;
+    void (*callback)(MainWindow&, const InternalRequest&);
+  } page_list[] =
+  {
+    { "downloads", page_downloads },
+    { "history-search", page_history_search },
+    { "perf", page_perf },
+    { "read-later", page_read_later },
+    { "reader", page_reader },
+    { "start", page_start },
+    { "stats", page_stats },
+    { "waterfall", page_waterfall },
+  };
+
+  // Style sheet shared by all internal pages. It's embedded into the pages,
+  // so that they are rendered without further requests.
+  static const char* page_style =
+    "body {"
+    "  font-family: sans-serif;"
+    "  margin: 2em auto;"
+    "  max-width: 60em;"
+    "  padding: 0 1em;"
+    "}"
+    "a {"
+    "  color: inherit;"
+    "  text-decoration: none;"
+    "}"
+    "a:hover .title {"
+    "  text-decoration: underline;"
+    "}"
+    "input {"
+    "  box-sizing: border-box;"
+    "  font-size: 1.2em;"
+    "  padding: 0.4em;"
+    "  width: 100%;"
+    "}"
+    "ol, ul {"
+    "  padding: 0;"
+    "}"
+    "li {"
+    "  list-style: none;"
+    "  margin: 0 0 1em;"
+    "}"
+    ".uri {"
+    "  color: #666;"
+    "  display: block;"
+    "  font-size: 0.8em;"
+    "  overflow: hidden;"
+    "  text-overflow: ellipsis;"
+    "  white-space: nowrap;"
+    "}"
+    ".top-sites {"
+    "  display: grid;"
+    "  grid-gap: 1em;"
+    "  grid-template-columns: repeat(auto-fill, minmax(14em, 1fr));"
+    "}"
+    ".top-sites li {"
+    "  border: 1px solid #ccc;"
+    "  border-radius: 4px;"
+    "  margin: 0;"
+    "  padding: 0.8em;"
+    "}"
+    ".top-sites .title {"
+    "  display: block;"
+    "  overflow: hidden;"
+    "  text-overflow: ellipsis;"
+    "  white-space: nowrap;"
+    "}"
+    "table {"
+    "  border-collapse: collapse;"
+    "  font-size: 0.8em;"
+    "  table-layout: fixed;"
+    "  width: 100%;"
+    "}"
+    "th, td {"
+    "  overflow: hidden;"
+    "  padding: 0.2em 0.4em;"
+    "  text-align: left;"
+    "  text-overflow: ellipsis;"
+    "  white-space: nowrap;"
+    "}"
+    "tr:nth-child(even) {"
+    "  background: #f4f4f4;"
+    "}"
+    ".narrow {"
+    "  width: 4em;"
+    "}"
+    ".wide {"
+    "  width: 40%;"
+    "}"
+    ".failed {"
+    "  color: #c33;"
+    "}"
+    ".bar span {"
+    "  display: inline-block;"
+    "  height: 0.8em;"
+    "}"
+    ".redirect {"
+    "  background: #c9a;"
+    "}"
+    ".wait {"
+    "  background: #9bd;"
+    "}"
+    ".receive {"
+    "  background: #37a;"
+    "}"
+    "progress {"
+    "  width: 100%;"
+    "}";
+
+  // Style sheet of the reader view, which replaces the shared one as the
+  // articles need different styling than the lists of the other pages.
+  static const char* reader_style =
+    "body {"
+    "  background: #fbfaf7;"
+    "  color: #222;"
+    "  font-family: serif;"
+    "  font-size: 1.15em;"
+    "  line-height: 1.6;"
+    "  margin: 2em auto;"
+    "  max-width: 38em;"
+    "  padding: 0 1em;"
+    "}"
+    "h1, h2, h3, h4, h5, h6 {"
+    "  font-family: sans-serif;"
+    "  line-height: 1.25;"
+    "}"
+    "a {"
+    "  color: #2a5db0;"
+    "}"
+    "img {"
+    "  height: auto;"
+    "  max-width: 100%;"
+    "}"
+    "pre {"
+    "  overflow-x: auto;"
+    "}"
+    "table {"
+    "  border-collapse: collapse;"
+    "}"
+    "td, th {"
+    "  border: 1px solid #ddd;"
+    "  padding: 0.2em 0.4em;"
+    "}"
+    ".source, .byline {"
+    "  color: #666;"
+    "  font-family: sans-serif;"
+    "  font-size: 0.8em;"
+    "}"
+    ".source {"
+    "  overflow: hidden;"
+    "  text-overflow: ellipsis;"
+    "  white-space: nowrap;"
+    "}";
+
+  void
+  MainWindow::initialize_internal_pages()
+  {
+    for (const auto& page : page_list)
+    {
+      const auto callback = page.callback;
+
+      m_web_context->register_internal_page(
+        page.name,
+        [this, callback](const InternalRequest& request)
+        {
+          callback(*this, request);
+        }
+      );
+    }
+  }
+
+  /**
+   * Appends beginning of an HTML document with given title to the response.
+   * Style sheet from file "internal.css" inside the data directory, if it
+   * exists, is included after the default style sheet.
+   */
+  static void
+  begin_page(InternalResponse& response, const Glib::ustring& title)
+  {
+    response.append_static(
+      "<!DOCTYPE html><html><head><meta charset=\"utf-8\"><title>"
+    );
+    response.append_escaped(title);
+    response.append_static("</title><style>");
+    response.append_static(page_style);
+    response.append_file(utils::get_data_file_path("internal.css"));
+    response.append_static("</style></head><body>");
+  }
+
+  static void
+  end_page(InternalResponse& response)
+  {
+    response.append_static("</body></html>");
+  }
+
+  static void
+  append_link(InternalResponse& response,
+              const std::string& uri,
+              const std::string& title)
+  {
+    const auto escaped_uri = Glib::Markup::escape_text(uri).raw();
+
+    response.append("<li><a href=\"" + escaped_uri + "\">");
+    response.append_static("<span class=\"title\">");
+    response.append_escaped(title.empty() ? uri : title);
+    response.append("</span><span class=\"uri\">" + escaped_uri + "</span>");
+    response.append_static("</a></li>");
+  }
+
+  static void
+  append_search_form(InternalResponse& response, const Glib::ustring& query)
+  {
+    response.append_static(
+      "<form action=\"selain://history-search\">"
+      "<input name=\"q\" placeholder=\"Search visited pages\" value=\""
+    );
+    response.append_escaped(query);
+    response.append_static("\"></form>");
+  }
+
+  /**
+   * Reader view of an article extracted from a page. Article content has
+   * already been reduced to plain markup when it was extracted, and scripts
+   * are disallowed in case site rules have enabled JavaScript for the view.
+   * Style sheet from file "reader.css" inside the data directory, if it
+   * exists, is included after the default style sheet.
+   */
+  static void
+  page_reader(MainWindow& window, const InternalRequest& request)
+  {
+    const auto id = std::strtoul(
+      request.get_parameter("id").c_str(),
+      nullptr,
+      10
+    );
+    const auto article = window.get_reader_articles().find(
+      static_cast<::guint>(id)
+    );
+    const auto title = article && !article->title.empty()
+      ? article->title
+      : std::string("Untitled");
+    InternalResponse response;
+
+    if (!article)
+    {
+      request.finish_error("The article is no longer available.");
+      return;
+    }
+    response.append_static(
+      "<!DOCTYPE html><html><head><meta charset=\"utf-8\">"
+      "<meta http-equiv=\"Content-Security-Policy\""
+      " content=\"script-src 'none'\"><title>"
+    );
+    response.append_escaped(title);
+    response.append_static("</title><style>");
+    response.append_static(reader_style);
+    response.append_file(utils::get_data_file_path("reader.css"));
+    response.append_static("</style></head><body><article>");
+    response.append_static("<p class=\"source\"><a href=\"");
+    response.append_escaped(article->uri);
+    response.append_static("\">");
+    response.append_escaped(article->uri);
+    response.append_static("</a></p><h1>");
+    response.append_escaped(title);
+    response.append_static("</h1>");
+    if (!article->byline.empty())
+    {
+      response.append_static("<p class=\"byline\">");
+      response.append_escaped(article->byline);
+      response.append_static("</p>");
+    }
+    response.append(std::string(article->content));
+    response.append_static("</article>");
+    end_page(response);
+    request.finish(response);
+  }
+
+  static void
+  page_start(MainWindow& window, const InternalRequest& request)
+  {
+    InternalResponse response;
+    const auto top_sites = window.get_history().get_top(
+      START_PAGE_TOP_SITES
+    );
+    const auto quickmarks = window.get_bookmarks().get_quickmarks();
+
+    begin_page(response, "New tab");
+    append_search_form(response, Glib::ustring());
+    if (!top_sites.empty())
+    {
+      response.append_static("<h2>Top sites</h2><ul class=\"top-sites\">");
+      for (const auto& entry : top_sites)
+      {
+        append_link(response, entry.uri, entry.title);
+      }
+      response.append_static("</ul>");
+    }
+    if (!quickmarks.empty())
+    {
+      response.append_static("<h2>Quickmarks</h2><ul class=\"top-sites\">");
+      for (const auto& quickmark : quickmarks)
+      {
+        append_link(response, quickmark.second, quickmark.first);
+      }
+      response.append_static("</ul>");
+    }
+    end_page(response);
+    request.finish(response);
+  }
+
+  static void
+  page_history_search(MainWindow& window, const InternalRequest& request)
+  {
+    const auto query = request.get_parameter("q");
+
+    if (query.empty())
+    {
+      InternalResponse response;
+
+      begin_page(response, "History search");
+      append_search_form(response, Glib::ustring());
+      end_page(response);
+      request.finish(response);
+      return;
+    }
+    window.get_text_index().search(
+      query,
+      HISTORY_SEARCH_RESULTS,
+      [request, query](const std::vector<TextSearchResult>& results,
+                       const std::string& error)
+      {
+        InternalResponse response;
+
+        if (!error.empty())
+        {
+          request.finish_error(error);
+          return;
+        }
+        begin_page(response, "History search: " + query);
+        append_search_form(response, query);
+        if (results.empty())
+        {
+          response.append_static(
+            "<p>No visited pages contain all of the words.</p>"
+          );
+        } else {
+          response.append_static("<ol>");
+          for (const auto& result : results)
+          {
+            append_link(response, result.uri, result.title);
+          }
+          response.append_static("</ol>");
+        }
+        end_page(response);
+        request.finish(response);
+      }
+    );
+  }
+
+  /**
+   * Returns given duration in microseconds as percentage of given total
+   * duration, formatted as CSS length.
+   */
+  static std::string
+  format_percentage(std::int64_t duration, std::int64_t total)
+  {
+    char buffer[16];
+
+    std::snprintf(
+      buffer,
+      sizeof(buffer),
+      "%.2f%%",
+      total > 0 ? std::max<std::int64_t>(duration, 0) * 100.0 / total : 0.0
+    );
+
+    return buffer;
+  }
+
+  static std::string
+  format_milliseconds(std::int64_t duration)
+  {
+    char buffer[32];
+
+    std::snprintf(buffer, sizeof(buffer), "%.0f ms", duration / 1000.0);
+
+    return buffer;
+  }
+
+  static void
+  page_waterfall(MainWindow& window, const InternalRequest& request)
+  {
+    const auto id = std::strtoul(
+      request.get_parameter("tab").c_str(),
+      nullptr,
+      10
+    );
+    const auto tab = window.get_tab_by_id(static_cast<::guint>(id));
+    const auto now = ::g_get_monotonic_time();
+    InternalResponse response;
+    std::int64_t page_started;
+    std::int64_t page_finished;
+    std::uint64_t total_size = 0;
+
+    if (!tab)
+    {
+      request.finish_error("The tab has been closed.");
+      return;
+    }
+
+    const auto& log = tab->get_resource_log();
+
+    page_started = log.get_page_started();
+    page_finished = log.get_page_finished() ? log.get_page_finished() : now;
+    log.for_each([&page_finished, &total_size, now](const ResourceTiming& t)
+    {
+      page_finished = std::max(page_finished, t.finished ? t.finished : now);
+      total_size += t.size;
+    });
+
+    begin_page(response, "Waterfall: " + tab->get_title());
+    response.append_static("<h1>");
+    response.append_escaped(
+      tab->get_title().empty() ? tab->get_uri() : tab->get_title()
+    );
+    response.append_static("</h1><p>");
+    response.append(Glib::ustring::compose(
+      "%1 requests, %2 received, %3",
+      log.size(),
+      Glib::ustring(utils::format_size(total_size)),
+      Glib::ustring(
+        log.get_page_finished()
+          ? "loaded in " + format_milliseconds(
+            log.get_page_finished() - page_started
+          )
+          : std::string("still loading")
+      )
+    ).raw());
+    if (const auto dropped = log.get_dropped_count())
+    {
+      response.append(Glib::ustring::compose(
+        ", %1 oldest requests not shown",
+        dropped
+      ).raw());
+    }
+    response.append_static(
+      ".</p><table><tr><th class=\"narrow\">Status</th>"
+      "<th class=\"narrow\">Method</th><th>Resource</th>"
+      "<th>Type</th><th class=\"narrow\">Size</th>"
+      "<th class=\"narrow\">Time</th><th class=\"wide\"></th></tr>"
+    );
+    log.for_each([&](const ResourceTiming& timing)
+    {
+      const auto total = page_finished - page_started;
+      const auto redirected = timing.redirected ? timing.redirected
+                                                : timing.started;
+      const auto response_received = timing.response_received
+        ? timing.response_received
+        : (timing.finished ? timing.finished : now);
+      const auto finished = timing.finished ? timing.finished : now;
+      std::string row;
+
+      row.append(timing.failed ? "<tr class=\"failed\"><td>" : "<tr><td>");
+      row.append(timing.status ? std::to_string(timing.status) : "\u2013");
+      row.append("</td><td>");
+      row.append(Glib::Markup::escape_text(timing.method).raw());
+      row.append("</td><td title=\"");
+      row.append(Glib::Markup::escape_text(timing.uri).raw());
+      row.append("\">");
+      row.append(Glib::Markup::escape_text(timing.uri).raw());
+      row.append("</td><td>");
+      row.append(Glib::Markup::escape_text(timing.mime_type).raw());
+      row.append("</td><td>");
+      row.append(utils::format_size(timing.size));
+      row.append("</td><td>");
+      row.append(
+        timing.finished
+          ? format_milliseconds(timing.finished - timing.started)
+          : std::string("\u2026")
+      );
+      row.append("</td><td class=\"bar\"><span style=\"width:");
+      row.append(format_percentage(timing.started - page_started, total));
+      row.append("\"></span><span class=\"redirect\" style=\"width:");
+      row.append(format_percentage(redirected - timing.started, total));
+      row.append("\"></span><span class=\"wait\" style=\"width:");
+      row.append(format_percentage(response_received - redirected, total));
+      row.append("\"></span><span class=\"receive\" style=\"width:");
+      row.append(format_percentage(finished - response_received, total));
+      row.append("\"></span></td></tr>");
+      response.append(std::move(row));
+    });
+    response.append_static("</table>");
+    end_page(response);
+    request.finish(response);
+  }
+
+  static const char*
+  get_download_state_name(DownloadState state)
+  {
+    switch (state)
+    {
+      case DownloadState::QUEUED:
+        return "Queued";
+
+      case DownloadState::RUNNING:
+        return "Running";
+
+      case DownloadState::FINISHED:
+        return "Finished";
+
+      case DownloadState::FAILED:
+        return "Failed";
+
+      case DownloadState::CANCELLED:
+        return "Cancelled";
+    }
+
+    return "";
+  }
+
+  /**
+   * Lists downloads of the current session. The page reloads itself every
+   * second while there are downloads in progress.
+   */
+  static void
+  page_downloads(MainWindow& window, const InternalRequest& request)
+  {
+    const auto& manager = window.get_web_context()->get_download_manager();
+    const auto downloads = manager.get_downloads();
+    InternalResponse response;
+    std::size_t running = 0;
+
+    begin_page(response, "Downloads");
+    for (const auto& download : downloads)
+    {
+      if (download.state == DownloadState::QUEUED ||
+          download.state == DownloadState::RUNNING)
+      {
+        ++running;
+      }
+    }
+    if (running > 0)
+    {
+      response.append_static("<meta http-equiv=\"refresh\" content=\"1\">");
+    }
+    response.append_static("<h1>Downloads</h1><p>");
+    if (downloads.empty())
+    {
+      response.append_static("Nothing has been downloaded yet.</p>");
+      end_page(response);
+      request.finish(response);
+      return;
+    }
+    response.append(Glib::ustring::compose(
+      "%1 downloads, %2 in progress, %3/s.",
+      downloads.size(),
+      running,
+      Glib::ustring(
+        utils::format_size(static_cast<std::uint64_t>(manager.get_speed()))
+      )
+    ).raw());
+    response.append_static(
+      "</p><table><tr><th class=\"narrow\">#</th><th>File</th>"
+      "<th class=\"wide\">Progress</th><th>Size</th><th>Speed</th>"
+      "<th>State</th></tr>"
+    );
+    for (const auto& download : downloads)
+    {
+      const auto name = download.path.empty()
+        ? download.uri
+        : Glib::path_get_basename(download.path);
+      std::string row;
+
+      row.append(
+        download.state == DownloadState::FAILED
+          ? "<tr class=\"failed\"><td>"
+          : "<tr><td>"
+      );
+      row.append(std::to_string(download.id));
+      row.append("</td><td title=\"");
+      row.append(Glib::Markup::escape_text(download.uri).raw());
+      row.append("\">");
+      row.append(Glib::Markup::escape_text(name).raw());
+      row.append("</td><td><progress");
+      if (download.total > 0)
+      {
+        row.append(" max=\"" + std::to_string(download.total) + "\"");
+        row.append(" value=\"" + std::to_string(download.received) + "\"");
+      }
+      else if (download.state == DownloadState::FINISHED)
+      {
+        row.append(" max=\"1\" value=\"1\"");
+      }
+      row.append("></progress></td><td>");
+      row.append(utils::format_size(download.received));
+      if (download.total > 0)
+      {
+        row.append(" / " + utils::format_size(download.total));
+      }
+      row.append("</td><td>");
+      if (download.state == DownloadState::RUNNING)
+      {
+        row.append(
+          utils::format_size(static_cast<std::uint64_t>(download.speed))
+        );
+        row.append("/s");
+      }
+      row.append("</td><td title=\"");
+      row.append(Glib::Markup::escape_text(download.error).raw());
+      row.append("\">");
+      row.append(get_download_state_name(download.state));
+      row.append("</td></tr>");
+      response.append(std::move(row));
+    }
+    response.append_static("</table>");
+    end_page(response);
+    request.finish(response);
+  }
+
+  static const struct
+  {
+    PageMetric metric;
+    const char* title;
+  } perf_column_list[] =
+  {
+    { PageMetric::TIME_TO_FIRST_BYTE, "First byte" },
+    { PageMetric::FIRST_CONTENTFUL_PAINT, "First paint" },
+    { PageMetric::LARGEST_CONTENTFUL_PAINT, "Largest paint" },
+    { PageMetric::DOM_CONTENT_LOADED, "DOM ready" },
+    { PageMetric::LOAD, "Load" },
+    { PageMetric::CUMULATIVE_LAYOUT_SHIFT, "Layout shift" },
+    { PageMetric::LONG_TASK_TIME, "Long tasks" },
+  };
+
+  static std::string
+  format_metric(PageMetric metric, double p50, double p95)
+  {
+    char buffer[64];
+
+    if (std::isnan(p50))
+    {
+      return "\u2013";
+    }
+    if (metric == PageMetric::CUMULATIVE_LAYOUT_SHIFT)
+    {
+      std::snprintf(buffer, sizeof(buffer), "%.2f / %.2f", p50, p95);
+    } else {
+      std::snprintf(buffer, sizeof(buffer), "%.0f / %.0f ms", p50, p95);
+    }
+
+    return buffer;
+  }
+
+  static void
+  page_perf(MainWindow& window, const InternalRequest& request)
+  {
+    const auto filter = request.get_parameter("site");
+    const auto summaries = window.get_performance_store().summarize(filter);
+    InternalResponse response;
+
+    begin_page(response, "Page performance");
+    response.append_static(
+      "<h1>Page performance</h1>"
+      "<p>Median and 95th percentile of the recent page loads of each "
+      "site.</p>"
+    );
+    if (summaries.empty())
+    {
+      response.append_static("<p>No page loads have been recorded.</p>");
+      end_page(response);
+      request.finish(response);
+      return;
+    }
+    response.append_static("<table><tr><th>Site</th>");
+    response.append_static("<th class=\"narrow\">Pages</th>");
+    for (const auto& column : perf_column_list)
+    {
+      response.append_static("<th>");
+      response.append_static(column.title);
+      response.append_static("</th>");
+    }
+    response.append_static("</tr>");
+    for (const auto& summary : summaries)
+    {
+      std::string row;
+
+      row.append("<tr><td title=\"");
+      row.append(Glib::Markup::escape_text(summary.origin).raw());
+      row.append("\">");
+      row.append(Glib::Markup::escape_text(summary.origin).raw());
+      row.append("</td><td>");
+      row.append(std::to_string(summary.sample_count));
+      row.append("</td>");
+      for (const auto& column : perf_column_list)
+      {
+        const auto index = static_cast<std::size_t>(column.metric);
+
+        row.append("<td>");
+        row.append(format_metric(
+          column.metric,
+          summary.p50[index],
+          summary.p95[index]
+        ));
+        row.append("</td>");
+      }
+      row.append("</tr>");
+      response.append(std::move(row));
+    }
+    response.append_static("</table>");
+    end_page(response);
+    request.finish(response);
+  }
+
+  static const char*
+  get_read_later_state_name(ReadLaterState state)
+  {
+    switch (state)
+    {
+      case ReadLaterState::QUEUED:
+        return "Queued";
+
+      case ReadLaterState::FETCHING:
+        return "Fetching";
+
+      case ReadLaterState::SAVED:
+        return "Saved";
+
+      case ReadLaterState::FAILED:
+        return "Failed";
+    }
+
+    return "";
+  }
+
+  /**
+   * Lists pages in the read-later queue, newest first. Saved pages are
+   * linked to their archived copies, so that they can be read offline.
+   */
+  static void
+  page_read_later(MainWindow& window, const InternalRequest& request)
+  {
+    auto& read_later = window.get_read_later();
+    const auto& items = read_later.get_items();
+    InternalResponse response;
+
+    begin_page(response, "Read later");
+    response.append_static("<h1>Read later</h1>");
+    if (items.empty())
+    {
+      response.append_static("<p>Nothing has been queued yet.</p>");
+      end_page(response);
+      request.finish(response);
+      return;
+    }
+    response.append_static(
+      "<table><tr><th class=\"narrow\">#</th><th class=\"wide\">Page</th>"
+      "<th>Size</th><th>State</th></tr>"
+    );
+    for (auto it = items.rbegin(); it != items.rend(); ++it)
+    {
+      const auto archive_uri = read_later.get_archive_uri(it->id);
+      const auto& title = it->title.empty() ? it->uri : it->title;
+      std::string row;
+
+      row.append(
+        it->state == ReadLaterState::FAILED
+          ? "<tr class=\"failed\"><td>"
+          : "<tr><td>"
+      );
+      row.append(std::to_string(it->id));
+      row.append("</td><td title=\"");
+      row.append(Glib::Markup::escape_text(it->uri).raw());
+      row.append("\"><a href=\"");
+      row.append(Glib::Markup::escape_text(
+        archive_uri.empty() ? it->uri : archive_uri
+      ).raw());
+      row.append("\">");
+      row.append(Glib::Markup::escape_text(title).raw());
+      row.append("</a></td><td>");
+      if (it->state == ReadLaterState::SAVED)
+      {
+        row.append(utils::format_size(it->size));
+      }
+      row.append("</td><td>");
+      row.append(get_read_later_state_name(it->state));
+      row.append("</td></tr>");
+      response.append(std::move(row));
+    }
+    response.append_static("</table>");
+    end_page(response);
+    request.finish(response);
+  }
+
+  /**
+   * Returns upper bound of the bucket containing given quantile of the
+   * observations of a histogram, in microseconds, or -1 if the quantile
+   * falls into the unbounded bucket.
+   */
+  static std::int64_t
+  get_histogram_quantile(const metrics::Histogram& histogram, double quantile)
+  {
+    const auto rank = static_cast<std::uint64_t>(
+      std::ceil(histogram.get_count() * quantile)
+    );
+    std::uint64_t cumulative = 0;
+
+    for (std::size_t i = 0; i < metrics::HISTOGRAM_BUCKETS; ++i)
+    {
+      cumulative += histogram.get_bucket(i);
+      if (cumulative >= rank)
+      {
+        return metrics::histogram_bounds[i];
+      }
+    }
+
+    return -1;
+  }
+
+  static std::string
+  format_duration(std::int64_t duration)
+  {
+    char buffer[32];
+
+    if (duration < 0)
+    {
+      return "\u221e";
+    }
+    else if (duration < 1000)
+    {
+      std::snprintf(buffer, sizeof(buffer), "%" PRId64 " \u00b5s", duration);
+    } else {
+      std::snprintf(buffer, sizeof(buffer), "%g ms", duration / 1000.0);
+    }
+
+    return buffer;
+  }
+
+  /**
+   * Lists current values of the internal metrics of the browser. Latency
+   * histograms are summarized by their count, mean and the upper bounds of
+   * the buckets containing the median and the 95th percentile.
+   */
+  static void
+  page_stats(MainWindow&, const InternalRequest& request)
+  {
+    std::vector<const metrics::Metric*> list;
+    InternalResponse response;
+
+    for (auto metric = metrics::get_first();
+         metric;
+         metric = metric->get_next())
+    {
+      list.push_back(metric);
+    }
+    std::sort(
+      std::begin(list),
+      std::end(list),
+      [](const metrics::Metric* a, const metrics::Metric* b)
+      {
+        return std::strcmp(a->get_name(), b->get_name()) < 0;
+      }
+    );
+    begin_page(response, "Statistics");
+    response.append_static(
+      "<h1>Statistics</h1>"
+      "<table><tr><th class=\"wide\">Metric</th><th>Value</th>"
+      "<th>Mean</th><th>p50 \u2264</th><th>p95 \u2264</th></tr>"
+    );
+    for (const auto metric : list)
+    {
+      std::string row;
+
+      row.append("<tr><td title=\"");
+      row.append(Glib::Markup::escape_text(metric->get_name()).raw());
+      row.append("\">");
+      row.append(Glib::Markup::escape_text(metric->get_help()).raw());
+      row.append("</td><td>");
+      switch (metric->get_type())
+      {
+        case metrics::Type::COUNTER:
+          row.append(std::to_string(
+            static_cast<const metrics::Counter*>(metric)->get()
+          ));
+          row.append("</td><td></td><td></td><td></td>");
+          break;
+
+        case metrics::Type::GAUGE:
+          row.append(std::to_string(
+            static_cast<const metrics::Gauge*>(metric)->get()
+          ));
+          row.append("</td><td></td><td></td><td></td>");
+          break;
+
+        case metrics::Type::HISTOGRAM:
+          {
+            const auto histogram =
+              static_cast<const metrics::Histogram*>(metric);
+            const auto count = histogram->get_count();
+
+            row.append(std::to_string(count));
+            row.append("</td><td>");
+            if (count > 0)
+            {
+              row.append(format_duration(
+                static_cast<std::int64_t>(histogram->get_sum() / count)
+              ));
+              row.append("</td><td>");
+              row.append(format_duration(
+                get_histogram_quantile(*histogram, 0.5)
+              ));
+              row.append("</td><td>");
+              row.append(format_duration(
+                get_histogram_quantile(*histogram, 0.95)
+              ));
+            } else {
+              row.append("</td><td></td><td>");
+            }
+            row.append("</td>");
+          }
+          break;
+      }
+      row.append("</tr>");
+      response.append(std::move(row));
+    }
+    response.append_static("</table>");
+    end_page(response);
+    request.finish(response);
+  }
+}
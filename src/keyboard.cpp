@@ -25,6 +25,8 @@
  */
 #include <selain/keyboard.hpp>
 #include <selain/main-window.hpp>
+#include <selain/metrics.hpp>
+#include <selain/trace.hpp>
 
 #include <chrono>
 
@@ -33,6 +35,15 @@ namespace selain
   static const int keypress_timeout = 2;
   static std::shared_ptr<keyboard::Mapping> top_mapping;
 
+  static metrics::Counter key_events(
+    "selain_key_events",
+    "Key presses received by tabs."
+  );
+  static metrics::Histogram key_dispatch_time(
+    "selain_key_dispatch_seconds",
+    "Time spent handling a key press received by a tab."
+  );
+
   static ::gboolean key_event_normal_mode(MainWindow&, Tab&, ::GdkEventKey*);
   static ::gboolean key_event_insert_mode(MainWindow&, ::GdkEventKey*);
   static ::gboolean key_event_hint_mode(MainWindow&, Tab&, ::GdkEventKey*);
@@ -45,12 +56,16 @@ namespace selain
   static void bind_mode_insert(MainWindow&, Tab&);
   static void bind_mode_hint(MainWindow&, Tab&);
   static void bind_mode_hint_new_tab(MainWindow&, Tab&);
+  static void bind_mode_hint_lite_tab(MainWindow&, Tab&);
+  static void bind_mode_hint_read_later(MainWindow&, Tab&);
   static void bind_tab_reload(MainWindow&, Tab&);
   static void bind_tab_reload_bypass_cache(MainWindow&, Tab&);
   static void bind_tab_open(MainWindow&, Tab&);
   static void bind_tab_close(MainWindow&, Tab&);
   static void bind_tab_prev(MainWindow&, Tab&);
   static void bind_tab_next(MainWindow&, Tab&);
+  static void bind_tab_select(MainWindow&, Tab&);
+  static void bind_tab_reopen(MainWindow&, Tab&);
   static void bind_scroll_left(MainWindow&, Tab&);
   static void bind_scroll_down(MainWindow&, Tab&);
   static void bind_scroll_up(MainWindow&, Tab&);
@@ -81,6 +96,8 @@ namespace selain
       add_mapping(U"i", bind_mode_insert);
       add_mapping(U"f", bind_mode_hint);
       add_mapping(U"F", bind_mode_hint_new_tab);
+      add_mapping(U";l", bind_mode_hint_lite_tab);
+      add_mapping(U";r", bind_mode_hint_read_later);
 
       // Tab management.
       add_mapping(U"r", bind_tab_reload);
@@ -89,6 +106,8 @@ namespace selain
       add_mapping(U"x", bind_tab_close);
       add_mapping(U"J", bind_tab_prev);
       add_mapping(U"K", bind_tab_next);
+      add_mapping(U"b", bind_tab_select);
+      add_mapping(U"U", bind_tab_reopen);
 
       // Navigation.
       add_mapping(U"d", bind_scroll_page_down);
@@ -118,11 +137,14 @@ namespace selain
     on_tab_key_press(::WebKitWebView*, ::GdkEventKey* event, Tab* tab)
     {
       const auto window = tab->get_main_window();
+      const metrics::ScopedTimer timer(key_dispatch_time);
+      const trace::Span span("key-press");
 
       if (!window)
       {
         return FALSE;
       }
+      key_events.increment();
       switch (window->get_mode())
       {
         case Mode::NORMAL:
@@ -133,6 +155,8 @@ namespace selain
 
         case Mode::HINT:
         case Mode::HINT_NEW_TAB:
+        case Mode::HINT_LITE_TAB:
+        case Mode::HINT_READ_LATER:
           return key_event_hint_mode(*window, *tab, event);
 
         default:
@@ -325,6 +349,18 @@ namespace selain
     window.set_mode(Mode::HINT_NEW_TAB);
   }
 
+  static void
+  bind_mode_hint_lite_tab(MainWindow& window, Tab&)
+  {
+    window.set_mode(Mode::HINT_LITE_TAB);
+  }
+
+  static void
+  bind_mode_hint_read_later(MainWindow& window, Tab&)
+  {
+    window.set_mode(Mode::HINT_READ_LATER);
+  }
+
   static void
   bind_tab_reload(MainWindow&, Tab& tab)
   {
@@ -340,7 +376,7 @@ namespace selain
   static void
   bind_tab_open(MainWindow& window, Tab&)
   {
-    window.open_tab();
+    window.open_tab("selain://start");
   }
 
   static void
@@ -355,6 +391,25 @@ namespace selain
     window.next_tab();
   }
 
+  static void
+  bind_tab_select(MainWindow& window, Tab&)
+  {
+    window.get_command_entry().set_text(":buffer ");
+    window.set_mode(Mode::COMMAND);
+  }
+
+  static void
+  bind_tab_reopen(MainWindow& window, Tab&)
+  {
+    if (!window.reopen_tab())
+    {
+      window.get_command_entry().show_notification(
+        "Error: No closed tabs.",
+        NotificationType::ERROR
+      );
+    }
+  }
+
   static void
   bind_tab_prev(MainWindow& window, Tab& tab)
   {
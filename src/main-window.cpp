@@ -24,57 +24,248 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 #include <selain/main-window.hpp>
+#include <selain/metrics.hpp>
+#include <selain/startup-timeline.hpp>
 #include <selain/theme.hpp>
+#include <selain/trace.hpp>
+#include <selain/utils.hpp>
+
+#include <cstdio>
+#include <cstdlib>
 
 namespace selain
 {
   static const int DEFAULT_WIDTH = 640;
   static const int DEFAULT_HEIGHT = 480;
 
+  // How long to wait after the last keystroke before incremental search is
+  // performed. Very short search terms tend to match large parts of the page,
+  // so they are given a longer delay.
+  static const unsigned int INCREMENTAL_SEARCH_DELAY = 100;
+  static const unsigned int INCREMENTAL_SEARCH_SHORT_DELAY = 300;
+
+  // Page opened when the browser is started without arguments, unless
+  // configured otherwise.
+  static const char* DEFAULT_HOME_PAGE = "https://duckduckgo.com";
+
+  // How long reopening of a closed tab waits for the scroll position of the
+  // closed page, in milliseconds, before it's reopened at the top.
+  static const unsigned int REOPEN_TAB_TIMEOUT = 500;
+
+  // Maximum disk space used by the full-text index of visited pages.
+  static const std::uint64_t TEXT_INDEX_DISK_BUDGET = 64 * 1024 * 1024;
+
+  static metrics::Gauge open_tab_count(
+    "selain_open_tabs",
+    "Tabs currently open."
+  );
+  static metrics::Counter tabs_opened(
+    "selain_tabs_opened",
+    "Tabs opened."
+  );
+  static metrics::Counter tabs_closed(
+    "selain_tabs_closed",
+    "Tabs closed."
+  );
+  static metrics::Counter tab_switches(
+    "selain_tab_switches",
+    "Switches between tabs."
+  );
+  static metrics::Counter status_updates_dropped(
+    "selain_status_updates_dropped",
+    "Status updates of background tabs which were not displayed."
+  );
+
   MainWindow::MainWindow(const Glib::RefPtr<Gtk::Application>& application)
     : Gtk::ApplicationWindow(application)
     , m_web_context(WebContext::create())
     , m_web_settings(WebSettings::create())
+    , m_lite_web_settings(WebSettings::create(SettingsProfile::LITE))
+    , m_home_page(DEFAULT_HOME_PAGE)
+    , m_read_later(m_web_context)
+    , m_applying_completion(false)
+    , m_tab_completion_stale(true)
+    , m_pending_reopen_count(0)
     , m_mode(Mode::NORMAL)
     , m_box(Gtk::ORIENTATION_VERTICAL)
+    , m_content_box(Gtk::ORIENTATION_VERTICAL)
+    , m_tab_strip(m_notebook)
+    , m_tab_overview(m_notebook, m_tab_snapshots)
   {
+    // Configuration is applied before any tabs are opened, so that the
+    // first page is already loaded with the configured settings.
+    m_config.signal_changed().connect(sigc::mem_fun(
+      this,
+      &MainWindow::on_config_changed
+    ));
+    m_config.open(Config::get_default_path());
     initialize_commands();
+    initialize_completion();
+    initialize_internal_pages();
 
     set_title("Selain");
     set_icon_name("selain");
     set_border_width(0);
     set_default_size(DEFAULT_WIDTH, DEFAULT_HEIGHT);
 
-    m_box.pack_start(m_notebook);
+    // Labels of the tabs are displayed by the tab strip, which only creates
+    // widgets for the tabs that fit on the screen.
+    m_notebook.set_show_tabs(false);
+    m_notebook.set_show_border(false);
+    m_content_box.pack_start(m_tab_strip, Gtk::PACK_SHRINK);
+    m_content_box.pack_start(m_notebook);
+    m_content_box.pack_start(m_tab_overview);
+    m_tab_overview.set_no_show_all(true);
+    m_box.pack_start(m_content_box);
+    m_box.pack_start(m_completion_view, Gtk::PACK_SHRINK);
     m_box.pack_start(m_status_bar, Gtk::PACK_SHRINK);
     m_box.pack_start(m_command_entry, Gtk::PACK_SHRINK);
     add(m_box);
 
+    // Tab which is being switched away from is captured before the
+    // notebook hides it.
+    m_notebook.signal_switch_page().connect(
+      sigc::mem_fun(this, &MainWindow::on_tab_switching),
+      false
+    );
     m_notebook.signal_switch_page().connect(sigc::mem_fun(
       this,
       &MainWindow::on_tab_switch
     ));
+    m_notebook.signal_page_added().connect(sigc::mem_fun(
+      this,
+      &MainWindow::on_tab_list_changed
+    ));
+    m_notebook.signal_page_removed().connect(sigc::mem_fun(
+      this,
+      &MainWindow::on_tab_list_changed
+    ));
+    m_notebook.signal_page_reordered().connect(sigc::mem_fun(
+      this,
+      &MainWindow::on_tab_list_changed
+    ));
+    m_tab_overview.signal_activated().connect(sigc::mem_fun(
+      this,
+      &MainWindow::on_tab_overview_activated
+    ));
+    m_tab_overview.signal_closed().connect(sigc::mem_fun(
+      this,
+      &MainWindow::hide_tab_overview
+    ));
     m_command_entry.signal_key_press_event().connect(sigc::mem_fun(
       this,
       &MainWindow::on_command_entry_key_press
     ));
+    m_command_entry.signal_changed().connect(sigc::mem_fun(
+      this,
+      &MainWindow::on_command_entry_changed
+    ));
     m_command_entry.signal_command_received().connect(sigc::mem_fun(
       this,
       &MainWindow::on_command_received
     ));
+    m_web_context->get_download_manager().signal_finished().connect(
+      sigc::mem_fun(this, &MainWindow::on_download_finished)
+    );
+    m_closed_tabs.signal_scroll_position_received().connect(sigc::mem_fun(
+      this,
+      &MainWindow::on_closed_tab_scroll_position_received
+    ));
 
     m_box.override_background_color(theme::window_background);
 
+    // Loading of the browsing data is deferred until the window has been
+    // painted for the first time, so that it does not delay the startup.
+    m_first_draw_connection = signal_draw().connect(sigc::mem_fun(
+      this,
+      &MainWindow::on_first_draw
+    ));
+
     show_all();
     maximize();
   }
 
+  void
+  MainWindow::initialize_deferred()
+  {
+    m_history.open(utils::get_data_file_path("history"));
+    m_text_index.open(
+      utils::get_data_file_path("text-index"),
+      TEXT_INDEX_DISK_BUDGET
+    );
+    m_bookmarks.open(utils::get_data_file_path("bookmarks"));
+    m_performance_store.open(utils::get_data_file_path("performance"));
+    m_web_context->initialize_deferred();
+    m_read_later.set_web_settings(m_web_settings);
+    m_read_later.open(utils::get_data_file_path("read-later"));
+    startup_timeline::finish("deferred-init");
+  }
+
+  void
+  MainWindow::initialize_completion()
+  {
+    m_tab_completion_source = std::make_shared<TabCompletionSource>();
+    m_completion.set_command_mapping(m_command_mapping);
+    m_completion.add_source(std::make_shared<CommandCompletionSource>(
+      m_command_mapping
+    ));
+    m_completion.add_source(m_tab_completion_source);
+    m_completion.add_source(std::make_shared<BookmarkCompletionSource>(
+      m_bookmarks
+    ));
+    m_completion.add_source(std::make_shared<HistoryCompletionSource>(
+      m_history
+    ));
+    m_completion.signal_results().connect(sigc::mem_fun(
+      this,
+      &MainWindow::on_completion_results
+    ));
+  }
+
+  void
+  MainWindow::update_completion()
+  {
+    const auto text = m_command_entry.get_text();
+
+    if (text.empty() || text[0] != ':')
+    {
+      m_completion.cancel();
+      m_completion_view.clear();
+      return;
+    }
+    m_completion.complete(text);
+  }
+
+  void
+  MainWindow::update_tab_completion()
+  {
+    std::vector<TabCompletionSource::TabInfo> tabs;
+    int index = 0;
+
+    // Tabs are collected once when the command line is opened, instead of
+    // on every key press, so that filtering a large number of tabs doesn't
+    // have to query each one of them again.
+    tabs.reserve(m_notebook.get_n_pages());
+    for (const auto widget : m_notebook.get_children())
+    {
+      const auto tab = static_cast<Tab*>(widget);
+
+      tabs.push_back({ index++, tab->get_uri(), tab->get_title() });
+    }
+    m_tab_completion_source->set_tabs(std::move(tabs));
+    m_tab_completion_stale = false;
+  }
+
   void
   MainWindow::set_mode(Mode mode)
   {
+    const trace::Span span("set-mode");
     const auto tab = get_current_tab();
 
-    if ((m_mode == Mode::HINT || m_mode == Mode::HINT_NEW_TAB) && tab)
+    if ((m_mode == Mode::HINT ||
+         m_mode == Mode::HINT_NEW_TAB ||
+         m_mode == Mode::HINT_LITE_TAB ||
+         m_mode == Mode::HINT_READ_LATER) && tab)
     {
       if (auto& context = tab->get_hint_context())
       {
@@ -83,18 +274,30 @@ namespace selain
       }
     }
     m_status_bar.set_mode(mode);
+    if (mode != Mode::COMMAND)
+    {
+      m_completion.cancel();
+      m_completion_view.clear();
+    }
     switch (m_mode = mode)
     {
       case Mode::COMMAND:
         m_command_entry.grab_focus();
+        update_tab_completion();
+        update_completion();
         break;
 
       case Mode::HINT:
       case Mode::HINT_NEW_TAB:
+      case Mode::HINT_LITE_TAB:
+      case Mode::HINT_READ_LATER:
         if (tab)
         {
           tab->set_hint_context(HintContext::create(
-            m_mode == Mode::HINT_NEW_TAB
+            m_mode == Mode::HINT_NEW_TAB ? HintTarget::NEW_TAB
+            : m_mode == Mode::HINT_LITE_TAB ? HintTarget::LITE_TAB
+            : m_mode == Mode::HINT_READ_LATER ? HintTarget::READ_LATER
+            : HintTarget::CURRENT_TAB
           ));
         }
 
@@ -140,17 +343,54 @@ namespace selain
     return widget ? static_cast<const Tab*>(widget) : nullptr;
   }
 
+  Tab*
+  MainWindow::get_tab_by_id(::guint id)
+  {
+    const auto page_count = m_notebook.get_n_pages();
+
+    for (int i = 0; i < page_count; ++i)
+    {
+      const auto tab = get_nth_tab(i);
+
+      if (tab && tab->get_id() == id)
+      {
+        return tab;
+      }
+    }
+
+    return nullptr;
+  }
+
   Glib::RefPtr<Tab>
-  MainWindow::open_tab(const Glib::ustring& uri, bool focus)
+  MainWindow::open_tab(const Glib::ustring& uri,
+                       bool focus,
+                       SettingsProfile profile)
   {
-    const auto tab = Glib::RefPtr<Tab>(new Tab(m_web_context, m_web_settings));
+    const trace::Span span("open-tab");
+    const auto tab = Glib::RefPtr<Tab>(new Tab(
+      m_web_context,
+      get_web_settings(profile)
+    ));
 
-    m_notebook.append_page(*tab.get(), tab->get_tab_label());
+    m_notebook.append_page(*tab.get());
+    tabs_opened.increment();
+    open_tab_count.set(m_notebook.get_n_pages());
     tab->signal_status_changed().connect(sigc::mem_fun(
       this,
       &MainWindow::on_tab_status_change
     ));
-    show_all_children();
+    tab->signal_find_status_changed().connect(sigc::mem_fun(
+      this,
+      &MainWindow::on_tab_find_status_change
+    ));
+    tab->signal_blocked_count_changed().connect(sigc::mem_fun(
+      this,
+      &MainWindow::on_tab_blocked_count_change
+    ));
+    // Only the new tab is shown, as showing all children of the window would
+    // also walk through every other tab and reveal widgets which are meant
+    // to stay hidden.
+    tab->show();
     if (!uri.empty())
     {
       tab->load_uri(uri);
@@ -164,19 +404,97 @@ namespace selain
     return tab;
   }
 
+  namespace
+  {
+    struct ScrollPositionRequest
+    {
+      ClosedTabStack* closed_tabs;
+      ::guint id;
+    };
+  }
+
+  static void
+  on_scroll_position_received(::GObject* web_view_object,
+                              ::GAsyncResult* result,
+                              ::gpointer data)
+  {
+    const auto request = static_cast<ScrollPositionRequest*>(data);
+    ::GError* error = nullptr;
+    const auto js_result = ::webkit_web_view_run_javascript_finish(
+      WEBKIT_WEB_VIEW(web_view_object),
+      result,
+      &error
+    );
+    int x = 0;
+    int y = 0;
+
+    if (js_result)
+    {
+      const auto value = ::webkit_javascript_result_get_js_value(js_result);
+
+      if (::jsc_value_is_string(value))
+      {
+        const auto text = ::jsc_value_to_string(value);
+
+        if (std::sscanf(text, "%d %d", &x, &y) != 2)
+        {
+          x = y = 0;
+        }
+        ::g_free(text);
+      }
+      ::webkit_javascript_result_unref(js_result);
+    } else {
+      ::g_error_free(error);
+    }
+    // Position is set even when it couldn't be received, so that reopening
+    // of the tab doesn't keep waiting for it.
+    request->closed_tabs->set_scroll_position(request->id, x, y);
+    delete request;
+  }
+
   void
-  MainWindow::close_tab(const Tab& tab)
+  MainWindow::close_tab(Tab& tab)
   {
+    const trace::Span span("close-tab");
     const auto index = m_notebook.page_num(tab);
+    const auto uri = tab.get_uri();
 
     if (index < 0)
     {
       return;
     }
+    if (!uri.empty())
+    {
+      const auto id = m_closed_tabs.push({
+        0,
+        uri,
+        tab.get_title(),
+        tab.get_profile(),
+        0,
+        0,
+        true,
+        tab.get_session_state()
+      });
+
+      // Scroll position isn't part of the session state of the current
+      // page, so it's asked from the page before it goes away.
+      tab.execute_script(
+        "'' + Math.round(window.scrollX) + ' ' + Math.round(window.scrollY)",
+        nullptr,
+        on_scroll_position_received,
+        new ScrollPositionRequest{ &m_closed_tabs, id }
+      );
+    }
+    m_tab_snapshots.remove(tab.get_id());
     m_notebook.remove_page(index);
+    tabs_closed.increment();
+    open_tab_count.set(m_notebook.get_n_pages());
+    // Quitting through the application instead of exit() lets main()
+    // return, so that the history and bookmark writers are flushed and
+    // joined by the destructors.
     if (m_notebook.get_current_page() < 0)
     {
-      std::exit(EXIT_SUCCESS);
+      get_application()->quit();
     }
   }
 
@@ -189,6 +507,88 @@ namespace selain
     }
   }
 
+  bool
+  MainWindow::reopen_tab()
+  {
+    if (m_closed_tabs.empty())
+    {
+      return false;
+    }
+    if (m_pending_reopen_count || m_closed_tabs.is_scroll_pending())
+    {
+      ++m_pending_reopen_count;
+      if (!m_reopen_timeout_connection.connected())
+      {
+        m_reopen_timeout_connection = Glib::signal_timeout().connect(
+          sigc::mem_fun(this, &MainWindow::on_reopen_timeout),
+          REOPEN_TAB_TIMEOUT
+        );
+      }
+
+      return true;
+    }
+
+    return reopen_closed_tab();
+  }
+
+  bool
+  MainWindow::reopen_closed_tab()
+  {
+    ClosedTab closed_tab;
+    Glib::RefPtr<Tab> tab;
+
+    if (!m_closed_tabs.pop(closed_tab))
+    {
+      return false;
+    }
+    tab = open_tab(Glib::ustring(), true, closed_tab.profile);
+    if (!closed_tab.title.empty())
+    {
+      tab->set_label_text(closed_tab.title);
+    }
+    tab->restore_session_state(
+      closed_tab.session_state,
+      closed_tab.uri,
+      closed_tab.scroll_x,
+      closed_tab.scroll_y
+    );
+
+    return true;
+  }
+
+  void
+  MainWindow::reopen_pending_tabs()
+  {
+    m_reopen_timeout_connection.disconnect();
+    for (; m_pending_reopen_count > 0; --m_pending_reopen_count)
+    {
+      if (!reopen_closed_tab())
+      {
+        m_pending_reopen_count = 0;
+        break;
+      }
+    }
+  }
+
+  void
+  MainWindow::on_closed_tab_scroll_position_received(::guint)
+  {
+    if (m_pending_reopen_count && !m_closed_tabs.is_scroll_pending())
+    {
+      reopen_pending_tabs();
+    }
+  }
+
+  bool
+  MainWindow::on_reopen_timeout()
+  {
+    // Page of the closed tab didn't respond in time, so the tab is reopened
+    // without it's scroll position.
+    reopen_pending_tabs();
+
+    return false;
+  }
+
   void
   MainWindow::set_current_tab(const Glib::RefPtr<Tab>& tab)
   {
@@ -200,6 +600,26 @@ namespace selain
     }
   }
 
+  void
+  MainWindow::set_current_tab(int index)
+  {
+    if (index >= 0 && index < m_notebook.get_n_pages())
+    {
+      m_notebook.set_current_page(index);
+    }
+  }
+
+  int
+  MainWindow::find_tab(const Glib::ustring& query)
+  {
+    if (m_tab_completion_stale)
+    {
+      update_tab_completion();
+    }
+
+    return m_tab_completion_source->find(query);
+  }
+
   void
   MainWindow::next_tab()
   {
@@ -212,23 +632,176 @@ namespace selain
     m_notebook.prev_page();
   }
 
+  // Start times of the layout and paint phases of the current frame, for
+  // tracing.
+  static std::int64_t frame_layout_started = 0;
+  static std::int64_t frame_paint_started = 0;
+
+  static void
+  on_frame_layout(::GdkFrameClock*, ::gpointer)
+  {
+    if (trace::is_enabled())
+    {
+      frame_layout_started = ::g_get_monotonic_time();
+    }
+  }
+
+  static void
+  on_frame_paint(::GdkFrameClock*, ::gpointer)
+  {
+    if (!trace::is_enabled())
+    {
+      return;
+    }
+    frame_paint_started = ::g_get_monotonic_time();
+    if (frame_layout_started)
+    {
+      trace::record(
+        "gtk-layout",
+        frame_layout_started,
+        frame_paint_started - frame_layout_started
+      );
+      frame_layout_started = 0;
+    }
+  }
+
+  static void
+  on_frame_after_paint(::GdkFrameClock*, ::gpointer)
+  {
+    if (trace::is_enabled() && frame_paint_started)
+    {
+      trace::record(
+        "gtk-paint",
+        frame_paint_started,
+        ::g_get_monotonic_time() - frame_paint_started
+      );
+      frame_paint_started = 0;
+    }
+  }
+
+  bool
+  MainWindow::on_first_draw(const Cairo::RefPtr<Cairo::Context>&)
+  {
+    const auto frame_clock = get_frame_clock();
+
+    startup_timeline::mark("first-paint");
+    m_first_draw_connection.disconnect();
+    if (frame_clock)
+    {
+      ::g_signal_connect(
+        G_OBJECT(frame_clock->gobj()),
+        "layout",
+        G_CALLBACK(on_frame_layout),
+        nullptr
+      );
+      ::g_signal_connect(
+        G_OBJECT(frame_clock->gobj()),
+        "paint",
+        G_CALLBACK(on_frame_paint),
+        nullptr
+      );
+      ::g_signal_connect(
+        G_OBJECT(frame_clock->gobj()),
+        "after-paint",
+        G_CALLBACK(on_frame_after_paint),
+        nullptr
+      );
+    }
+    Glib::signal_idle().connect_once(sigc::mem_fun(
+      this,
+      &MainWindow::initialize_deferred
+    ));
+
+    return false;
+  }
+
   bool
   MainWindow::on_command_entry_key_press(::GdkEventKey* event)
   {
     if (event->keyval == GDK_KEY_Escape)
     {
+      const auto text = m_command_entry.get_text();
+      const auto tab = get_current_tab();
+
+      // Cancel incremental search.
+      if (tab && !text.empty() && (text[0] == '/' || text[0] == '?'))
+      {
+        tab->search_finish();
+      }
       set_mode(Mode::NORMAL);
 
       return true;
     }
-    else if (event->keyval == GDK_KEY_Tab)
+    else if (event->keyval == GDK_KEY_Tab ||
+             event->keyval == GDK_KEY_ISO_Left_Tab)
     {
+      const auto value = event->keyval == GDK_KEY_Tab
+        ? m_completion_view.select_next()
+        : m_completion_view.select_prev();
+
+      if (!value.empty())
+      {
+        m_applying_completion = true;
+        m_command_entry.set_text(m_completion.get_prefix() + value);
+        m_command_entry.grab_focus();
+        m_applying_completion = false;
+      }
+
       return true;
     }
 
     return false;
   }
 
+  void
+  MainWindow::on_command_entry_changed()
+  {
+    const auto text = m_command_entry.get_text();
+
+    m_incremental_search_connection.disconnect();
+    if (m_mode != Mode::COMMAND || m_applying_completion)
+    {
+      return;
+    }
+    update_completion();
+    if (text.empty() || (text[0] != '/' && text[0] != '?'))
+    {
+      return;
+    }
+    m_incremental_search_connection = Glib::signal_timeout().connect(
+      sigc::mem_fun(*this, &MainWindow::on_incremental_search_timeout),
+      text.length() > 2
+        ? INCREMENTAL_SEARCH_DELAY
+        : INCREMENTAL_SEARCH_SHORT_DELAY
+    );
+  }
+
+  bool
+  MainWindow::on_incremental_search_timeout()
+  {
+    const auto text = m_command_entry.get_text();
+    const auto tab = get_current_tab();
+
+    if (tab &&
+        m_mode == Mode::COMMAND &&
+        !text.empty() &&
+        (text[0] == '/' || text[0] == '?'))
+    {
+      tab->search(text.substr(1), text[0] == '/');
+    }
+
+    return false;
+  }
+
+  void
+  MainWindow::on_completion_results(const std::vector<CompletionItem>& items)
+  {
+    if (m_mode == Mode::COMMAND)
+    {
+      m_completion_view.set_items(items);
+    }
+  }
+
   void
   MainWindow::on_command_received(const Glib::ustring& command)
   {
@@ -248,17 +821,305 @@ namespace selain
     if (current_index >= 0 && tab_index >= 0 && current_index == tab_index)
     {
       m_status_bar.set_status(status);
+    } else {
+      status_updates_dropped.increment();
+    }
+  }
+
+  void
+  MainWindow::on_tab_find_status_change(Tab* tab, const Glib::ustring& status)
+  {
+    const auto current_index = m_notebook.get_current_page();
+    const auto tab_index = m_notebook.page_num(*tab);
+
+    if (current_index >= 0 && tab_index >= 0 && current_index == tab_index)
+    {
+      m_status_bar.set_find_status(status);
+    }
+  }
+
+  void
+  MainWindow::on_tab_blocked_count_change(Tab* tab, ::guint count)
+  {
+    const auto current_index = m_notebook.get_current_page();
+    const auto tab_index = m_notebook.page_num(*tab);
+
+    if (current_index >= 0 && tab_index >= 0 && current_index == tab_index)
+    {
+      m_status_bar.set_blocked_count(count);
+    }
+  }
+
+  void
+  MainWindow::show_tab_overview()
+  {
+    if (const auto tab = get_current_tab())
+    {
+      tab->capture_snapshot();
+    }
+    set_mode(Mode::NORMAL);
+    m_notebook.hide();
+    m_tab_overview.show();
+    m_tab_overview.populate();
+  }
+
+  void
+  MainWindow::hide_tab_overview()
+  {
+    if (!m_tab_overview.get_visible())
+    {
+      return;
+    }
+    m_tab_overview.hide();
+    m_tab_overview.clear();
+    m_notebook.show();
+    if (const auto tab = get_current_tab())
+    {
+      if (const auto snapshot = m_tab_snapshots.get(tab->get_id()))
+      {
+        tab->show_snapshot(snapshot);
+      }
+      tab->grab_focus();
+    }
+  }
+
+  void
+  MainWindow::on_tab_list_changed(Gtk::Widget*, ::guint)
+  {
+    // Indexes of the collected tabs would no longer match the notebook.
+    // While the command line is open the list is collected again right
+    // away, so that the completions stay valid, and otherwise when it's
+    // needed next.
+    if (m_mode == Mode::COMMAND)
+    {
+      update_tab_completion();
+      update_completion();
+    } else {
+      m_tab_completion_stale = true;
+    }
+  }
+
+  void
+  MainWindow::on_tab_overview_activated(::guint id)
+  {
+    const auto tab = get_tab_by_id(id);
+
+    hide_tab_overview();
+    if (tab)
+    {
+      set_current_tab(m_notebook.page_num(*tab));
+    }
+  }
+
+  void
+  MainWindow::on_tab_switching(Gtk::Widget*, ::guint)
+  {
+    if (const auto tab = get_current_tab())
+    {
+      tab->capture_snapshot();
     }
   }
 
   void
   MainWindow::on_tab_switch(Gtk::Widget* widget, ::guint)
   {
+    hide_tab_overview();
+    tab_switches.increment();
     if (widget)
     {
-      m_status_bar.set_status(static_cast<Tab*>(widget)->get_status());
+      const auto tab = static_cast<Tab*>(widget);
+
+      if (const auto snapshot = m_tab_snapshots.get(tab->get_id()))
+      {
+        tab->show_snapshot(snapshot);
+      }
+
+      m_status_bar.set_status(tab->get_status());
+      m_status_bar.set_find_status(tab->get_find_status());
+      m_status_bar.set_blocked_count(tab->get_blocked_count());
     } else {
       m_status_bar.set_status(Glib::ustring());
+      m_status_bar.set_find_status(Glib::ustring());
+      m_status_bar.set_blocked_count(0);
+    }
+  }
+
+  void
+  MainWindow::on_download_finished(const DownloadInfo& info)
+  {
+    if (info.state == DownloadState::FINISHED)
+    {
+      m_command_entry.show_notification("Downloaded " + info.path);
+    }
+    else if (info.state == DownloadState::FAILED)
+    {
+      m_command_entry.show_notification(
+        Glib::ustring::compose(
+          "Error: Download %1 failed: %2",
+          info.id,
+          Glib::ustring(info.error)
+        ),
+        NotificationType::ERROR
+      );
+    }
+  }
+
+  Glib::RefPtr<WebSettings>
+  MainWindow::get_web_settings(const Glib::ustring& uri,
+                               SettingsProfile profile)
+  {
+    const auto rule = m_site_rules.find(uri);
+    std::map<std::string, std::string>::const_iterator profile_option;
+
+    if (!rule)
+    {
+      return get_web_settings(profile);
+    }
+    profile_option = rule->options.find("profile");
+    if (profile_option != std::end(rule->options))
+    {
+      profile = profile_option->second == "lite"
+        ? SettingsProfile::LITE
+        : SettingsProfile::NORMAL;
+    }
+
+    auto& settings = rule->settings[static_cast<int>(profile)];
+
+    // Settings of the rule are built on top of the global options, the first
+    // time a page matching the rule is loaded.
+    if (!settings)
+    {
+      settings = WebSettings::create(profile);
+      for (const auto& option : m_config.get_group("web"))
+      {
+        settings->apply(option.first, option.second);
+      }
+      for (const auto& option : rule->options)
+      {
+        if (option.first != "profile"
+            && !settings->apply(option.first, option.second))
+        {
+          ::g_warning(
+            "Invalid configuration option: site %s.%s = %s",
+            rule->pattern.c_str(),
+            option.first.c_str(),
+            option.second.c_str()
+          );
+        }
+      }
+    }
+
+    return settings;
+  }
+
+  void
+  MainWindow::on_config_changed(const std::string& group,
+                                const std::string& key,
+                                const std::string& value)
+  {
+    bool valid = true;
+
+    if (group == "web")
+    {
+      valid = m_web_settings->apply(key, value);
+      m_lite_web_settings->apply(key, value);
+      m_site_rules.invalidate();
+    }
+    else if (!group.compare(0, 5, "site "))
+    {
+      valid = key != "profile"
+        || value.empty()
+        || value == "normal"
+        || value == "lite";
+      if (valid)
+      {
+        m_site_rules.set_option(group.substr(5), key, value);
+        m_site_rules.invalidate();
+      }
+    }
+    else if (group == "cache" && key == "model")
+    {
+      ::WebKitCacheModel model = WEBKIT_CACHE_MODEL_WEB_BROWSER;
+
+      valid = value.empty() || WebContext::parse_cache_model(value, model);
+      if (valid)
+      {
+        m_web_context->set_cache_model(model);
+      }
+    }
+    else if (group == "cache" && key == "disk-quota")
+    {
+      std::uint64_t quota = WebContext::DEFAULT_DISK_CACHE_QUOTA;
+
+      valid = value.empty() || utils::parse_size(value, quota);
+      if (valid)
+      {
+        m_web_context->set_disk_cache_quota(quota);
+      }
+    }
+    else if (group == "read-later" && key == "disk-quota")
+    {
+      std::uint64_t quota = ReadLater::DEFAULT_DISK_QUOTA;
+
+      valid = value.empty() || utils::parse_size(value, quota);
+      if (valid)
+      {
+        m_read_later.set_disk_quota(quota);
+      }
+    }
+    else if (group == "metrics" && key == "file")
+    {
+      metrics::set_dump_file(utils::expand_path(value));
+    }
+    else if (group == "metrics" && key == "interval")
+    {
+      const auto interval = std::atoi(value.c_str());
+
+      valid = value.empty() || interval > 0;
+      if (valid)
+      {
+        metrics::set_dump_interval(static_cast<unsigned int>(interval));
+      }
+    }
+    else if (group == "general" && key == "home-page")
+    {
+      m_home_page = value.empty() ? DEFAULT_HOME_PAGE : value;
+    }
+    else if (group == "general" && key == "tab-snapshot-memory")
+    {
+      std::uint64_t budget = TabSnapshots::DEFAULT_MEMORY_BUDGET;
+
+      valid = value.empty() || utils::parse_size(value, budget);
+      if (valid)
+      {
+        m_tab_snapshots.set_memory_budget(static_cast<std::size_t>(budget));
+      }
+    }
+    else if (group == "general" && key == "tab-strip")
+    {
+      valid = value.empty() || value == "top" || value == "left";
+      if (valid)
+      {
+        const auto vertical = value == "left";
+
+        m_content_box.set_orientation(
+          vertical ? Gtk::ORIENTATION_HORIZONTAL : Gtk::ORIENTATION_VERTICAL
+        );
+        m_tab_strip.set_orientation(
+          vertical ? Gtk::ORIENTATION_VERTICAL : Gtk::ORIENTATION_HORIZONTAL
+        );
+      }
+    } else {
+      valid = false;
+    }
+    if (!valid)
+    {
+      ::g_warning(
+        "Invalid configuration option: %s.%s = %s",
+        group.c_str(),
+        key.c_str(),
+        value.c_str()
+      );
     }
   }
 }
@@ -25,63 +25,115 @@
  */
 #include <selain/keyboard.hpp>
 #include <selain/main-window.hpp>
+#include <selain/startup-timeline.hpp>
+#include <selain/trace.hpp>
 
 #include <iostream>
+#include <memory>
 
+static void on_startup(
+  const Glib::RefPtr<Gtk::Application>&,
+  std::unique_ptr<selain::MainWindow>*
+);
 static int on_command_line(
   const Glib::RefPtr<Gio::ApplicationCommandLine>&,
   const Glib::RefPtr<Gtk::Application>&,
-  selain::MainWindow*
+  std::unique_ptr<selain::MainWindow>*
 );
 
 int
 main(int argc, char** argv)
 {
+  selain::startup_timeline::mark("main");
+
   const auto app = Gtk::Application::create(
     "pw.rauli.selain",
     Gio::APPLICATION_HANDLES_COMMAND_LINE
   );
-  selain::MainWindow window(app);
+  std::unique_ptr<selain::MainWindow> window;
 
+  selain::startup_timeline::mark("application");
+
+  // The window, and with it GTK and WebKit, is only constructed in the
+  // primary instance. When Selain is already running, the command line is
+  // just forwarded to it over D-Bus.
+  app->signal_startup().connect(
+    sigc::bind(sigc::ptr_fun(&on_startup), app, &window)
+  );
   app->signal_command_line().connect(
     sigc::bind(sigc::ptr_fun(&on_command_line), app, &window),
     false
   );
 
-  return app->run(window, argc, argv);
+  return app->run(argc, argv);
+}
+
+static void
+on_startup(const Glib::RefPtr<Gtk::Application>& app,
+           std::unique_ptr<selain::MainWindow>* window)
+{
+  window->reset(new selain::MainWindow(app));
+  app->add_window(**window);
+  selain::keyboard::initialize();
+  selain::startup_timeline::mark("main-window");
 }
 
 static int
 on_command_line(const Glib::RefPtr<Gio::ApplicationCommandLine>& command_line,
-                const Glib::RefPtr<Gtk::Application>& app,
-                selain::MainWindow* window)
+                const Glib::RefPtr<Gtk::Application>&,
+                std::unique_ptr<selain::MainWindow>* window)
 {
   int argc;
   auto argv = command_line->get_arguments(argc);
   Glib::OptionContext context;
+  Glib::OptionGroup main_group("selain", "Selain options");
   Glib::OptionGroup gtk_group(::gtk_get_option_group(true));
+  Glib::OptionEntry startup_timeline_entry;
+  Glib::OptionEntry trace_file_entry;
+  bool startup_timeline = false;
+  std::string trace_file;
 
+  startup_timeline_entry.set_long_name("startup-timeline");
+  startup_timeline_entry.set_description(
+    "Print duration of each startup phase"
+  );
+  main_group.add_entry(startup_timeline_entry, startup_timeline);
+  trace_file_entry.set_long_name("trace-file");
+  trace_file_entry.set_arg_description("PATH");
+  trace_file_entry.set_description(
+    "Write trace of the UI process into given file on exit"
+  );
+  main_group.add_entry_filename(trace_file_entry, trace_file);
+  context.set_main_group(main_group);
   context.add_group(gtk_group);
 
+  // The command line may come from another instance, so invalid options
+  // must not terminate the one which is running.
   if (!context.parse(argc, argv))
   {
-    std::exit(EXIT_FAILURE);
+    return EXIT_FAILURE;
   }
-
-  app->activate();
-
-  selain::keyboard::initialize();
+  if (startup_timeline)
+  {
+    selain::startup_timeline::enable();
+  }
+  if (!trace_file.empty())
+  {
+    selain::trace::write_on_exit(trace_file);
+  }
+  selain::startup_timeline::mark("command-line");
 
   for (int i = 1; i < argc; ++i)
   {
-    window->open_tab(argv[i]);
+    (*window)->open_tab(argv[i]);
   }
 
   if (argc == 1)
   {
-    // TODO: Make the initial home page URL customizable through settings.
-    window->open_tab("https://duckduckgo.com");
+    (*window)->open_tab((*window)->get_home_page());
   }
+  (*window)->present();
+  selain::startup_timeline::mark("first-tab");
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/metrics.hpp>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <glibmm.h>
+
+namespace selain
+{
+  namespace metrics
+  {
+    const std::int64_t histogram_bounds[HISTOGRAM_BUCKETS] =
+    {
+      100,
+      250,
+      500,
+      1000,
+      2500,
+      5000,
+      10000,
+      25000,
+      100000,
+      250000,
+      1000000,
+      10000000,
+    };
+
+    // Default interval of writing the metrics into the dump file, in
+    // seconds.
+    static const unsigned int DEFAULT_DUMP_INTERVAL = 60;
+
+    // Metrics are registered during static initialization, which is single
+    // threaded, so the list needs no locking.
+    static const Metric* first_metric = nullptr;
+
+    static std::atomic<std::size_t> next_shard(0);
+
+    static std::string dump_path;
+    static unsigned int dump_interval = DEFAULT_DUMP_INTERVAL;
+    static sigc::connection dump_connection;
+
+    Metric::Metric(const char* name, const char* help, Type type)
+      : m_name(name)
+      , m_help(help)
+      , m_type(type)
+      , m_next(first_metric)
+    {
+      first_metric = this;
+    }
+
+    Counter::Counter(const char* name, const char* help)
+      : Metric(name, help, Type::COUNTER)
+    {
+      for (auto& shard : m_shards)
+      {
+        shard.value.store(0, std::memory_order_relaxed);
+      }
+    }
+
+    void
+    Counter::increment(std::uint64_t amount)
+    {
+      static thread_local const auto shard = next_shard.fetch_add(1)
+        % COUNTER_SHARDS;
+
+      m_shards[shard].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    std::uint64_t
+    Counter::get() const
+    {
+      std::uint64_t result = 0;
+
+      for (const auto& shard : m_shards)
+      {
+        result += shard.value.load(std::memory_order_relaxed);
+      }
+
+      return result;
+    }
+
+    Gauge::Gauge(const char* name, const char* help)
+      : Metric(name, help, Type::GAUGE)
+      , m_value(0) {}
+
+    Histogram::Histogram(const char* name, const char* help)
+      : Metric(name, help, Type::HISTOGRAM)
+      , m_count(0)
+      , m_sum(0)
+    {
+      for (auto& bucket : m_buckets)
+      {
+        bucket.store(0, std::memory_order_relaxed);
+      }
+    }
+
+    void
+    Histogram::observe(std::int64_t duration)
+    {
+      const auto bound = std::lower_bound(
+        std::begin(histogram_bounds),
+        std::end(histogram_bounds),
+        duration
+      );
+      const auto index = bound - std::begin(histogram_bounds);
+
+      duration = std::max(duration, static_cast<std::int64_t>(0));
+      m_buckets[index].fetch_add(1, std::memory_order_relaxed);
+      m_count.fetch_add(1, std::memory_order_relaxed);
+      m_sum.fetch_add(
+        static_cast<std::uint64_t>(duration),
+        std::memory_order_relaxed
+      );
+    }
+
+    const Metric*
+    get_first()
+    {
+      return first_metric;
+    }
+
+    static void
+    append_histogram(std::string& output, const Histogram& histogram)
+    {
+      const std::string name(histogram.get_name());
+      std::uint64_t cumulative = 0;
+      char buffer[128];
+
+      for (std::size_t i = 0; i < HISTOGRAM_BUCKETS; ++i)
+      {
+        cumulative += histogram.get_bucket(i);
+        std::snprintf(
+          buffer,
+          sizeof(buffer),
+          "_bucket{le=\"%g\"} %" PRIu64 "\n",
+          static_cast<double>(histogram_bounds[i]) / G_USEC_PER_SEC,
+          cumulative
+        );
+        output.append(name).append(buffer);
+      }
+      cumulative += histogram.get_bucket(HISTOGRAM_BUCKETS);
+      std::snprintf(
+        buffer,
+        sizeof(buffer),
+        "_bucket{le=\"+Inf\"} %" PRIu64 "\n",
+        cumulative
+      );
+      output.append(name).append(buffer);
+      std::snprintf(
+        buffer,
+        sizeof(buffer),
+        "_sum %.6f\n",
+        static_cast<double>(histogram.get_sum()) / G_USEC_PER_SEC
+      );
+      output.append(name).append(buffer);
+      std::snprintf(
+        buffer,
+        sizeof(buffer),
+        "_count %" PRIu64 "\n",
+        histogram.get_count()
+      );
+      output.append(name).append(buffer);
+    }
+
+    std::string
+    format_openmetrics()
+    {
+      std::vector<const Metric*> list;
+      std::string output;
+
+      for (auto metric = first_metric; metric; metric = metric->get_next())
+      {
+        list.push_back(metric);
+      }
+      std::sort(
+        std::begin(list),
+        std::end(list),
+        [](const Metric* a, const Metric* b)
+        {
+          return std::strcmp(a->get_name(), b->get_name()) < 0;
+        }
+      );
+      for (const auto metric : list)
+      {
+        const std::string name(metric->get_name());
+
+        switch (metric->get_type())
+        {
+          case Type::COUNTER:
+            output.append("# TYPE " + name + " counter\n");
+            output.append("# HELP " + name + " " + metric->get_help() + "\n");
+            output.append(name + "_total ");
+            output.append(std::to_string(
+              static_cast<const Counter*>(metric)->get()
+            ));
+            output.append("\n");
+            break;
+
+          case Type::GAUGE:
+            output.append("# TYPE " + name + " gauge\n");
+            output.append("# HELP " + name + " " + metric->get_help() + "\n");
+            output.append(name + " ");
+            output.append(std::to_string(
+              static_cast<const Gauge*>(metric)->get()
+            ));
+            output.append("\n");
+            break;
+
+          case Type::HISTOGRAM:
+            output.append("# TYPE " + name + " histogram\n");
+            output.append("# HELP " + name + " " + metric->get_help() + "\n");
+            append_histogram(output, *static_cast<const Histogram*>(metric));
+            break;
+        }
+      }
+      output.append("# EOF\n");
+
+      return output;
+    }
+
+    static bool
+    on_dump_timeout()
+    {
+      const auto output = format_openmetrics();
+      ::GError* error = nullptr;
+
+      // Contents are replaced atomically, so scrapers never see a partially
+      // written file.
+      if (!::g_file_set_contents(
+        dump_path.c_str(),
+        output.c_str(),
+        static_cast<::gssize>(output.length()),
+        &error
+      ))
+      {
+        ::g_warning(
+          "Unable to write metrics to %s: %s",
+          dump_path.c_str(),
+          error->message
+        );
+        ::g_error_free(error);
+      }
+
+      return true;
+    }
+
+    static void
+    schedule_dump()
+    {
+      dump_connection.disconnect();
+      if (!dump_path.empty() && dump_interval > 0)
+      {
+        dump_connection = Glib::signal_timeout().connect_seconds(
+          sigc::ptr_fun(on_dump_timeout),
+          dump_interval,
+          Glib::PRIORITY_LOW
+        );
+      }
+    }
+
+    void
+    set_dump_file(const std::string& path)
+    {
+      dump_path = path;
+      schedule_dump();
+    }
+
+    void
+    set_dump_interval(unsigned int interval)
+    {
+      dump_interval = interval > 0 ? interval : DEFAULT_DUMP_INTERVAL;
+      schedule_dump();
+    }
+  }
+}
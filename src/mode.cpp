@@ -46,6 +46,12 @@ namespace selain
 
       case Mode::HINT_NEW_TAB:
         return "HINT (NEW TAB)";
+
+      case Mode::HINT_LITE_TAB:
+        return "HINT (LITE TAB)";
+
+      case Mode::HINT_READ_LATER:
+        return "HINT (READ LATER)";
     }
 
     return "UNKNOWN";
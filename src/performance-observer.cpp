@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/main-window.hpp>
+
+#include <cmath>
+#include <ctime>
+#include <limits>
+
+#define SELAIN_JS_STRINGIFY(source) #source
+
+namespace selain
+{
+  static const char* performance_observer_source_code =
+  #include "./performance-observer.js"
+  ;
+
+  static void on_performance_message(
+    ::WebKitUserContentManager*,
+    ::WebKitJavascriptResult*,
+    Tab*
+  );
+
+  /**
+   * Injects script which observes performance of the pages into every frame
+   * loaded by the tab. The script reports the metrics once the page is
+   * hidden or left.
+   */
+  void
+  Tab::initialize_performance_observer()
+  {
+    const auto manager = ::webkit_web_view_get_user_content_manager(
+      m_web_view
+    );
+    const auto script = ::webkit_user_script_new(
+      performance_observer_source_code,
+      WEBKIT_USER_CONTENT_INJECT_ALL_FRAMES,
+      WEBKIT_USER_SCRIPT_INJECT_AT_DOCUMENT_START,
+      nullptr,
+      nullptr
+    );
+
+    ::webkit_user_content_manager_add_script(manager, script);
+    ::webkit_user_script_unref(script);
+    ::g_signal_connect(
+      G_OBJECT(manager),
+      "script-message-received::selainPerformance",
+      G_CALLBACK(on_performance_message),
+      static_cast<::gpointer>(this)
+    );
+    ::webkit_user_content_manager_register_script_message_handler(
+      manager,
+      "selainPerformance"
+    );
+  }
+
+  void
+  Tab::report_performance()
+  {
+    execute_script(
+      "window.SelainPerformanceObserver &&"
+      " window.SelainPerformanceObserver.report();"
+    );
+  }
+
+  static double
+  get_number_property(::JSCValue* object, const char* name)
+  {
+    const auto property = ::jsc_value_object_get_property(object, name);
+    auto result = std::numeric_limits<double>::quiet_NaN();
+
+    if (::jsc_value_is_number(property))
+    {
+      result = ::jsc_value_to_double(property);
+    }
+    ::g_object_unref(property);
+
+    return result;
+  }
+
+  static void
+  on_performance_message(::WebKitUserContentManager*,
+                         ::WebKitJavascriptResult* js_result,
+                         Tab* tab)
+  {
+    const auto value = ::webkit_javascript_result_get_js_value(js_result);
+    const auto window = tab->get_main_window();
+    ::JSCValue* origin;
+    PageMetrics metrics;
+
+    if (!window || !::jsc_value_is_object(value))
+    {
+      return;
+    }
+    origin = ::jsc_value_object_get_property(value, "origin");
+    if (::jsc_value_is_string(origin))
+    {
+      const auto origin_string = ::jsc_value_to_string(origin);
+
+      metrics.timestamp = static_cast<std::int64_t>(std::time(nullptr));
+      for (std::size_t i = 0; i < PAGE_METRIC_COUNT; ++i)
+      {
+        metrics.values[i] = get_number_property(
+          value,
+          get_page_metric_name(static_cast<PageMetric>(i))
+        );
+      }
+      window->get_performance_store().add(origin_string, metrics);
+      ::g_free(origin_string);
+    }
+    ::g_object_unref(origin);
+  }
+}
@@ -0,0 +1,118 @@
+SELAIN_JS_STRINGIFY((() => {
+  if (window.SelainPerformanceObserver ||
+      !window.performance ||
+      !/^https?:$/.test(location.protocol)) {
+    return;
+  }
+
+  const supportedEntryTypes = (
+    window.PerformanceObserver && PerformanceObserver.supportedEntryTypes
+  ) || [];
+  const metrics = {
+    firstContentfulPaint: null,
+    largestContentfulPaint: null,
+    cumulativeLayoutShift: null,
+    longTaskTime: null,
+  };
+  let sessionValue = 0;
+  let sessionStart = 0;
+  let sessionEnd = 0;
+  let reported = false;
+
+  const observe = (type, callback) => {
+    if (supportedEntryTypes.indexOf(type) < 0) {
+      return;
+    }
+    new PerformanceObserver((list) => {
+      list.getEntries().forEach(callback);
+    }).observe({ type, buffered: true });
+  };
+
+  const getNavigationTiming = () => {
+    const entries = performance.getEntriesByType ?
+      performance.getEntriesByType('navigation') : [];
+    const timing = performance.timing;
+
+    if (entries.length > 0) {
+      return {
+        timeToFirstByte: entries[0].responseStart,
+        domContentLoaded: entries[0].domContentLoadedEventEnd || null,
+        load: entries[0].loadEventEnd || null,
+      };
+    } else if (timing) {
+      const relative = (value) => (
+        value > 0 ? value - timing.navigationStart : null
+      );
+
+      return {
+        timeToFirstByte: relative(timing.responseStart),
+        domContentLoaded: relative(timing.domContentLoadedEventEnd),
+        load: relative(timing.loadEventEnd),
+      };
+    }
+
+    return null;
+  };
+
+  const report = () => {
+    const handlers = window.webkit && window.webkit.messageHandlers;
+    const navigationTiming = getNavigationTiming();
+
+    if (reported ||
+        !navigationTiming ||
+        !handlers ||
+        !handlers.selainPerformance) {
+      return;
+    }
+    reported = true;
+    handlers.selainPerformance.postMessage(Object.assign(
+      { origin: location.origin },
+      navigationTiming,
+      metrics
+    ));
+  };
+
+  observe('paint', (entry) => {
+    if (entry.name === 'first-contentful-paint') {
+      metrics.firstContentfulPaint = entry.startTime;
+    }
+  });
+
+  observe('largest-contentful-paint', (entry) => {
+    metrics.largestContentfulPaint = entry.renderTime ||
+      entry.loadTime ||
+      entry.startTime;
+  });
+
+  observe('layout-shift', (entry) => {
+    if (entry.hadRecentInput) {
+      return;
+    }
+    if (sessionValue > 0 &&
+        entry.startTime - sessionEnd < 1000 &&
+        entry.startTime - sessionStart < 5000) {
+      sessionValue += entry.value;
+    } else {
+      sessionValue = entry.value;
+      sessionStart = entry.startTime;
+    }
+    sessionEnd = entry.startTime;
+    metrics.cumulativeLayoutShift = Math.max(
+      metrics.cumulativeLayoutShift || 0,
+      sessionValue
+    );
+  });
+
+  observe('longtask', (entry) => {
+    metrics.longTaskTime = (metrics.longTaskTime || 0) + entry.duration;
+  });
+
+  window.addEventListener('pagehide', report);
+  document.addEventListener('visibilitychange', () => {
+    if (document.visibilityState === 'hidden') {
+      report();
+    }
+  });
+
+  window.SelainPerformanceObserver = { report };
+})();)
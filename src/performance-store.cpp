@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/performance-store.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace selain
+{
+  // Number of the latest page loads kept for each origin.
+  static const std::size_t MAX_SAMPLES_PER_ORIGIN = 100;
+
+  // Number of origins kept in the store. When exceeded, the origin which
+  // has been visited least recently is dropped.
+  static const std::size_t MAX_ORIGINS = 500;
+
+  // Page loads older than this are dropped, in seconds.
+  static const std::int64_t MAX_SAMPLE_AGE = 30 * 24 * 60 * 60;
+
+  // Delay after which unsaved page loads are written to disk, in seconds.
+  static const unsigned int SAVE_INTERVAL = 60;
+
+  static const char* page_metric_names[PAGE_METRIC_COUNT] =
+  {
+    "timeToFirstByte",
+    "firstContentfulPaint",
+    "largestContentfulPaint",
+    "domContentLoaded",
+    "load",
+    "cumulativeLayoutShift",
+    "longTaskTime",
+  };
+
+  const char*
+  get_page_metric_name(PageMetric metric)
+  {
+    return page_metric_names[static_cast<std::size_t>(metric)];
+  }
+
+  /**
+   * Returns value of given percentile using the nearest rank method, or NaN
+   * if there are no values. The values are sorted in place.
+   */
+  static double
+  get_percentile(std::vector<double>& values, double percentile)
+  {
+    std::size_t rank;
+
+    if (values.empty())
+    {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    std::sort(std::begin(values), std::end(values));
+    rank = static_cast<std::size_t>(
+      std::ceil(percentile / 100.0 * values.size())
+    );
+
+    return values[rank > 0 ? rank - 1 : 0];
+  }
+
+  PerformanceStore::PerformanceStore()
+    : m_dirty(false)
+  {
+  }
+
+  PerformanceStore::~PerformanceStore()
+  {
+    m_save_connection.disconnect();
+    if (m_dirty)
+    {
+      save();
+    }
+  }
+
+  void
+  PerformanceStore::open(const std::string& path)
+  {
+    const auto cutoff = static_cast<std::int64_t>(std::time(nullptr))
+      - MAX_SAMPLE_AGE;
+    std::ifstream input(path);
+    std::string line;
+    auto pending = std::move(m_samples);
+
+    // Page loads recorded before the store was opened are newer than the
+    // ones on disk, so they are added after them.
+    m_samples.clear();
+    m_path = path;
+    while (std::getline(input, line))
+    {
+      std::stringstream fields(line);
+      std::string origin;
+      std::string value;
+      PageMetrics metrics;
+
+      if (!std::getline(fields, origin, '\t') ||
+          !std::getline(fields, value, '\t'))
+      {
+        continue;
+      }
+      metrics.timestamp = std::strtoll(value.c_str(), nullptr, 10);
+      if (metrics.timestamp < cutoff)
+      {
+        continue;
+      }
+      for (auto& metric : metrics.values)
+      {
+        metric = std::numeric_limits<double>::quiet_NaN();
+        if (std::getline(fields, value, '\t') && value != "-")
+        {
+          metric = std::strtod(value.c_str(), nullptr);
+        }
+      }
+      add(origin, metrics);
+    }
+    for (const auto& entry : pending)
+    {
+      for (const auto& metrics : entry.second)
+      {
+        add(entry.first, metrics);
+      }
+    }
+    m_dirty = !pending.empty();
+    if (!m_dirty)
+    {
+      m_save_connection.disconnect();
+    }
+  }
+
+  void
+  PerformanceStore::add(const std::string& origin, const PageMetrics& metrics)
+  {
+    auto entry = m_samples.find(origin);
+
+    if (entry == std::end(m_samples))
+    {
+      if (m_samples.size() >= MAX_ORIGINS)
+      {
+        m_samples.erase(std::min_element(
+          std::begin(m_samples),
+          std::end(m_samples),
+          [](const auto& a, const auto& b)
+          {
+            return a.second.back().timestamp < b.second.back().timestamp;
+          }
+        ));
+      }
+      entry = m_samples.emplace(origin, std::deque<PageMetrics>()).first;
+    }
+    entry->second.push_back(metrics);
+    if (entry->second.size() > MAX_SAMPLES_PER_ORIGIN)
+    {
+      entry->second.pop_front();
+    }
+    m_dirty = true;
+    schedule_save();
+  }
+
+  std::vector<PerformanceSummary>
+  PerformanceStore::summarize(const std::string& filter) const
+  {
+    std::vector<PerformanceSummary> result;
+    std::vector<double> values;
+
+    for (const auto& entry : m_samples)
+    {
+      PerformanceSummary summary;
+
+      if (!filter.empty() && entry.first.find(filter) == std::string::npos)
+      {
+        continue;
+      }
+      summary.origin = entry.first;
+      summary.sample_count = entry.second.size();
+      for (std::size_t i = 0; i < PAGE_METRIC_COUNT; ++i)
+      {
+        values.clear();
+        for (const auto& metrics : entry.second)
+        {
+          if (!std::isnan(metrics.values[i]))
+          {
+            values.push_back(metrics.values[i]);
+          }
+        }
+        summary.p50[i] = get_percentile(values, 50);
+        summary.p95[i] = get_percentile(values, 95);
+      }
+      result.push_back(std::move(summary));
+    }
+    std::sort(
+      std::begin(result),
+      std::end(result),
+      [](const PerformanceSummary& a, const PerformanceSummary& b)
+      {
+        if (a.sample_count != b.sample_count)
+        {
+          return a.sample_count > b.sample_count;
+        }
+
+        return a.origin < b.origin;
+      }
+    );
+
+    return result;
+  }
+
+  void
+  PerformanceStore::save() const
+  {
+    std::ofstream output;
+
+    if (m_path.empty())
+    {
+      return;
+    }
+    output.open(m_path);
+    for (const auto& entry : m_samples)
+    {
+      for (const auto& metrics : entry.second)
+      {
+        output << entry.first << '\t' << metrics.timestamp;
+        for (const auto value : metrics.values)
+        {
+          output << '\t';
+          if (std::isnan(value))
+          {
+            output << '-';
+          } else {
+            output << value;
+          }
+        }
+        output << '\n';
+      }
+    }
+  }
+
+  void
+  PerformanceStore::schedule_save()
+  {
+    if (m_path.empty() || m_save_connection.connected())
+    {
+      return;
+    }
+    m_save_connection = Glib::signal_timeout().connect_seconds(
+      sigc::mem_fun(this, &PerformanceStore::on_save_timeout),
+      SAVE_INTERVAL,
+      Glib::PRIORITY_LOW
+    );
+  }
+
+  bool
+  PerformanceStore::on_save_timeout()
+  {
+    save();
+    m_dirty = false;
+
+    return false;
+  }
+}
@@ -0,0 +1,689 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/read-later.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+
+#include <glib/gstdio.h>
+
+namespace selain
+{
+  // How often the queue is checked for pages to fetch, in seconds.
+  static const unsigned int SCHEDULE_INTERVAL = 5;
+
+  // How long the user must have not started loading any pages before
+  // fetching is resumed, in microseconds.
+  static const std::int64_t QUIET_PERIOD = 10 * G_USEC_PER_SEC;
+
+  // Maximum time a single page may take to load, in seconds.
+  static const unsigned int FETCH_TIMEOUT = 60;
+
+  static const char* INDEX_FILE_NAME = "index";
+
+  struct ReadLater::Fetch
+  {
+    ReadLater* owner;
+    ::guint id;
+    ::WebKitWebView* web_view;
+    ::GCancellable* cancellable;
+    bool saving;
+    sigc::connection timeout_connection;
+  };
+
+  static const char*
+  get_state_name(ReadLaterState state)
+  {
+    switch (state)
+    {
+      case ReadLaterState::SAVED:
+        return "saved";
+
+      case ReadLaterState::FAILED:
+        return "failed";
+
+      default:
+        return "queued";
+    }
+  }
+
+  /**
+   * Destroys hidden web view once the main loop is idle, as it may be in the
+   * middle of emitting a signal.
+   */
+  static void
+  destroy_web_view(::WebKitWebView* web_view)
+  {
+    Glib::signal_idle().connect_once([web_view]()
+    {
+      ::gtk_widget_destroy(GTK_WIDGET(web_view));
+      ::g_object_unref(web_view);
+    });
+  }
+
+  ReadLater::ReadLater(const Glib::RefPtr<WebContext>& context)
+    : m_context(context)
+    , m_disk_quota(DEFAULT_DISK_QUOTA)
+    , m_last_id(0)
+    , m_last_activity(0)
+  {
+  }
+
+  ReadLater::~ReadLater()
+  {
+    m_schedule_connection.disconnect();
+    for (auto& fetch : m_fetches)
+    {
+      fetch->timeout_connection.disconnect();
+      ::g_signal_handlers_disconnect_by_data(fetch->web_view, fetch.get());
+      ::webkit_web_view_stop_loading(fetch->web_view);
+      if (fetch->saving)
+      {
+        // Pending save still refers to the fetch, which is freed once the
+        // save has been cancelled.
+        fetch->owner = nullptr;
+        ::g_cancellable_cancel(fetch->cancellable);
+        fetch.release();
+      } else {
+        ::gtk_widget_destroy(GTK_WIDGET(fetch->web_view));
+        ::g_object_unref(fetch->web_view);
+        ::g_object_unref(fetch->cancellable);
+      }
+    }
+  }
+
+  void
+  ReadLater::open(const std::string& directory)
+  {
+    const auto key_file = ::g_key_file_new();
+    const auto index_path = ::g_build_filename(
+      directory.c_str(),
+      INDEX_FILE_NAME,
+      nullptr
+    );
+    ::gchar** groups;
+
+    m_directory = directory;
+    ::g_mkdir_with_parents(m_directory.c_str(), 0700);
+    if (::g_key_file_load_from_file(
+      key_file,
+      index_path,
+      G_KEY_FILE_NONE,
+      nullptr
+    ))
+    {
+      groups = ::g_key_file_get_groups(key_file, nullptr);
+      for (auto group = groups; *group; ++group)
+      {
+        ReadLaterItem item;
+        const auto uri = ::g_key_file_get_string(
+          key_file,
+          *group,
+          "uri",
+          nullptr
+        );
+        const auto title = ::g_key_file_get_string(
+          key_file,
+          *group,
+          "title",
+          nullptr
+        );
+        const auto state = ::g_key_file_get_string(
+          key_file,
+          *group,
+          "state",
+          nullptr
+        );
+
+        item.id = static_cast<::guint>(std::strtoul(*group, nullptr, 10));
+        item.uri = uri ? uri : "";
+        item.title = title ? title : "";
+        item.added = ::g_key_file_get_int64(
+          key_file,
+          *group,
+          "added",
+          nullptr
+        );
+        item.size = ::g_key_file_get_uint64(
+          key_file,
+          *group,
+          "size",
+          nullptr
+        );
+        item.state = ReadLaterState::QUEUED;
+        if (!::g_strcmp0(state, "saved"))
+        {
+          // Archived copy may have been removed behind our back.
+          if (::g_file_test(
+            get_archive_path(item.id).c_str(),
+            G_FILE_TEST_EXISTS
+          ))
+          {
+            item.state = ReadLaterState::SAVED;
+          }
+        }
+        else if (!::g_strcmp0(state, "failed"))
+        {
+          item.state = ReadLaterState::FAILED;
+        }
+        ::g_free(uri);
+        ::g_free(title);
+        ::g_free(state);
+        if (item.id && !item.uri.empty())
+        {
+          m_last_id = std::max(m_last_id, item.id);
+          m_items.push_back(std::move(item));
+        }
+      }
+      ::g_strfreev(groups);
+    }
+    ::g_free(index_path);
+    ::g_key_file_free(key_file);
+    std::sort(
+      std::begin(m_items),
+      std::end(m_items),
+      [](const ReadLaterItem& a, const ReadLaterItem& b)
+      {
+        return a.id < b.id;
+      }
+    );
+    schedule();
+  }
+
+  void
+  ReadLater::set_web_settings(const Glib::RefPtr<WebSettings>& settings)
+  {
+    m_web_settings = settings;
+  }
+
+  void
+  ReadLater::set_disk_quota(std::uint64_t quota)
+  {
+    m_disk_quota = quota;
+    if (!m_directory.empty())
+    {
+      enforce_quota();
+      save_index();
+    }
+  }
+
+  ::guint
+  ReadLater::add(const std::string& uri)
+  {
+    ReadLaterItem item;
+
+    for (auto& existing : m_items)
+    {
+      if (existing.uri == uri)
+      {
+        if (existing.state == ReadLaterState::FAILED)
+        {
+          existing.state = ReadLaterState::QUEUED;
+          save_index();
+          schedule();
+        }
+
+        return existing.id;
+      }
+    }
+    item.id = ++m_last_id;
+    item.uri = uri;
+    item.added = static_cast<std::int64_t>(std::time(nullptr));
+    item.size = 0;
+    item.state = ReadLaterState::QUEUED;
+    m_items.push_back(std::move(item));
+    save_index();
+    schedule();
+
+    return m_last_id;
+  }
+
+  bool
+  ReadLater::remove(::guint id)
+  {
+    const auto it = std::find_if(
+      std::begin(m_items),
+      std::end(m_items),
+      [id](const ReadLaterItem& item)
+      {
+        return item.id == id;
+      }
+    );
+
+    if (it == std::end(m_items))
+    {
+      return false;
+    }
+    for (const auto& fetch : m_fetches)
+    {
+      if (fetch->id == id)
+      {
+        if (fetch->saving)
+        {
+          ::g_cancellable_cancel(fetch->cancellable);
+        } else {
+          finish_fetch(fetch.get(), ReadLaterState::QUEUED);
+        }
+        break;
+      }
+    }
+    ::g_unlink(get_archive_path(id).c_str());
+    m_items.erase(it);
+    save_index();
+
+    return true;
+  }
+
+  std::string
+  ReadLater::get_archive_uri(::guint id) const
+  {
+    const auto it = std::find_if(
+      std::begin(m_items),
+      std::end(m_items),
+      [id](const ReadLaterItem& item)
+      {
+        return item.id == id;
+      }
+    );
+    ::gchar* uri;
+    std::string result;
+
+    if (it == std::end(m_items) || it->state != ReadLaterState::SAVED)
+    {
+      return result;
+    }
+    if ((uri = ::g_filename_to_uri(
+      get_archive_path(id).c_str(),
+      nullptr,
+      nullptr
+    )))
+    {
+      result = uri;
+      ::g_free(uri);
+    }
+
+    return result;
+  }
+
+  void
+  ReadLater::pause()
+  {
+    std::vector<Fetch*> loading;
+
+    m_last_activity = ::g_get_monotonic_time();
+    for (const auto& fetch : m_fetches)
+    {
+      if (fetch->saving)
+      {
+        ::g_cancellable_cancel(fetch->cancellable);
+      } else {
+        loading.push_back(fetch.get());
+      }
+    }
+    for (const auto fetch : loading)
+    {
+      finish_fetch(fetch, ReadLaterState::QUEUED);
+    }
+    schedule();
+  }
+
+  ReadLaterItem*
+  ReadLater::find_item(::guint id)
+  {
+    for (auto& item : m_items)
+    {
+      if (item.id == id)
+      {
+        return &item;
+      }
+    }
+
+    return nullptr;
+  }
+
+  std::string
+  ReadLater::get_archive_path(::guint id) const
+  {
+    const auto name = std::to_string(id) + ".mhtml";
+    const auto path = ::g_build_filename(
+      m_directory.c_str(),
+      name.c_str(),
+      nullptr
+    );
+    const std::string result(path);
+
+    ::g_free(path);
+
+    return result;
+  }
+
+  void
+  ReadLater::schedule()
+  {
+    if (m_directory.empty() || m_schedule_connection.connected())
+    {
+      return;
+    }
+    m_schedule_connection = Glib::signal_timeout().connect_seconds(
+      sigc::mem_fun(this, &ReadLater::on_schedule),
+      SCHEDULE_INTERVAL,
+      Glib::PRIORITY_LOW
+    );
+  }
+
+  bool
+  ReadLater::on_schedule()
+  {
+    bool queued = false;
+
+    if (::g_get_monotonic_time() - m_last_activity < QUIET_PERIOD)
+    {
+      return true;
+    }
+    for (auto& item : m_items)
+    {
+      if (item.state != ReadLaterState::QUEUED)
+      {
+        continue;
+      }
+      else if (m_fetches.size() < MAX_CONCURRENT_FETCHES)
+      {
+        start_fetch(item);
+      } else {
+        queued = true;
+      }
+    }
+
+    // Scheduling is started again when a fetch finishes or pages are added
+    // into the queue.
+    return queued;
+  }
+
+  void
+  ReadLater::start_fetch(ReadLaterItem& item)
+  {
+    const auto fetch = new Fetch();
+
+    fetch->owner = this;
+    fetch->id = item.id;
+    fetch->web_view = m_context->create_web_view();
+    fetch->cancellable = ::g_cancellable_new();
+    fetch->saving = false;
+    ::g_object_ref_sink(fetch->web_view);
+    if (m_web_settings)
+    {
+      m_web_settings->install(fetch->web_view);
+    }
+    ::g_signal_connect(
+      G_OBJECT(fetch->web_view),
+      "load-changed",
+      G_CALLBACK(on_load_changed),
+      static_cast<::gpointer>(fetch)
+    );
+    ::g_signal_connect(
+      G_OBJECT(fetch->web_view),
+      "load-failed",
+      G_CALLBACK(on_load_failed),
+      static_cast<::gpointer>(fetch)
+    );
+    fetch->timeout_connection = Glib::signal_timeout().connect_seconds(
+      sigc::bind(sigc::mem_fun(this, &ReadLater::on_fetch_timeout), item.id),
+      FETCH_TIMEOUT
+    );
+    m_fetches.emplace_back(fetch);
+    item.state = ReadLaterState::FETCHING;
+    ::webkit_web_view_load_uri(fetch->web_view, item.uri.c_str());
+  }
+
+  void
+  ReadLater::finish_fetch(Fetch* fetch, ReadLaterState state)
+  {
+    const auto it = std::find_if(
+      std::begin(m_fetches),
+      std::end(m_fetches),
+      [fetch](const std::unique_ptr<Fetch>& entry)
+      {
+        return entry.get() == fetch;
+      }
+    );
+
+    if (const auto item = find_item(fetch->id))
+    {
+      item->state = state;
+    }
+    fetch->timeout_connection.disconnect();
+    ::g_signal_handlers_disconnect_by_data(fetch->web_view, fetch);
+    ::webkit_web_view_stop_loading(fetch->web_view);
+    destroy_web_view(fetch->web_view);
+    ::g_object_unref(fetch->cancellable);
+    if (it != std::end(m_fetches))
+    {
+      m_fetches.erase(it);
+    }
+  }
+
+  void
+  ReadLater::on_fetch_loaded(Fetch* fetch)
+  {
+    const auto path = get_archive_path(fetch->id) + ".part";
+    const auto file = ::g_file_new_for_path(path.c_str());
+
+    fetch->saving = true;
+    fetch->timeout_connection.disconnect();
+    ::webkit_web_view_save_to_file(
+      fetch->web_view,
+      file,
+      WEBKIT_SAVE_MODE_MHTML,
+      fetch->cancellable,
+      on_save_finished,
+      static_cast<::gpointer>(fetch)
+    );
+    ::g_object_unref(file);
+  }
+
+  void
+  ReadLater::on_fetch_saved(Fetch* fetch, bool success)
+  {
+    const auto path = get_archive_path(fetch->id);
+    const auto part_path = path + ".part";
+    const auto item = find_item(fetch->id);
+    ::GStatBuf info;
+
+    if (!item || !success || ::g_rename(part_path.c_str(), path.c_str()))
+    {
+      ::g_unlink(part_path.c_str());
+      finish_fetch(
+        fetch,
+        ::g_cancellable_is_cancelled(fetch->cancellable)
+          ? ReadLaterState::QUEUED
+          : ReadLaterState::FAILED
+      );
+    } else {
+      const auto title = ::webkit_web_view_get_title(fetch->web_view);
+
+      item->title = title ? title : "";
+      item->size = !::g_stat(path.c_str(), &info) ? info.st_size : 0;
+      finish_fetch(fetch, ReadLaterState::SAVED);
+      enforce_quota();
+    }
+    save_index();
+    schedule();
+  }
+
+  bool
+  ReadLater::on_fetch_timeout(::guint id)
+  {
+    for (const auto& fetch : m_fetches)
+    {
+      if (fetch->id == id && !fetch->saving)
+      {
+        finish_fetch(fetch.get(), ReadLaterState::FAILED);
+        save_index();
+        schedule();
+        break;
+      }
+    }
+
+    return false;
+  }
+
+  void
+  ReadLater::enforce_quota()
+  {
+    std::uint64_t total = 0;
+
+    if (!m_disk_quota)
+    {
+      return;
+    }
+    for (const auto& item : m_items)
+    {
+      if (item.state == ReadLaterState::SAVED)
+      {
+        total += item.size;
+      }
+    }
+    // Oldest saved pages are removed first.
+    for (auto it = std::begin(m_items);
+         total > m_disk_quota && it != std::end(m_items);)
+    {
+      if (it->state == ReadLaterState::SAVED)
+      {
+        total -= it->size;
+        ::g_unlink(get_archive_path(it->id).c_str());
+        it = m_items.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void
+  ReadLater::save_index()
+  {
+    const auto key_file = ::g_key_file_new();
+    const auto index_path = ::g_build_filename(
+      m_directory.c_str(),
+      INDEX_FILE_NAME,
+      nullptr
+    );
+    ::GError* error = nullptr;
+
+    if (m_directory.empty())
+    {
+      ::g_free(index_path);
+      ::g_key_file_free(key_file);
+      return;
+    }
+    for (const auto& item : m_items)
+    {
+      const auto group = std::to_string(item.id);
+
+      ::g_key_file_set_string(
+        key_file,
+        group.c_str(),
+        "uri",
+        item.uri.c_str()
+      );
+      ::g_key_file_set_string(
+        key_file,
+        group.c_str(),
+        "title",
+        item.title.c_str()
+      );
+      ::g_key_file_set_int64(key_file, group.c_str(), "added", item.added);
+      ::g_key_file_set_uint64(key_file, group.c_str(), "size", item.size);
+      ::g_key_file_set_string(
+        key_file,
+        group.c_str(),
+        "state",
+        get_state_name(item.state)
+      );
+    }
+    if (!::g_key_file_save_to_file(key_file, index_path, &error))
+    {
+      ::g_warning("Unable to save read-later queue: %s", error->message);
+      ::g_error_free(error);
+    }
+    ::g_free(index_path);
+    ::g_key_file_free(key_file);
+  }
+
+  void
+  ReadLater::on_load_changed(::WebKitWebView*,
+                             ::WebKitLoadEvent load_event,
+                             Fetch* fetch)
+  {
+    if (load_event == WEBKIT_LOAD_FINISHED)
+    {
+      fetch->owner->on_fetch_loaded(fetch);
+    }
+  }
+
+  ::gboolean
+  ReadLater::on_load_failed(::WebKitWebView*,
+                            ::WebKitLoadEvent,
+                            ::gchar*,
+                            ::GError*,
+                            Fetch* fetch)
+  {
+    const auto owner = fetch->owner;
+
+    owner->finish_fetch(fetch, ReadLaterState::FAILED);
+    owner->save_index();
+    owner->schedule();
+
+    return TRUE;
+  }
+
+  void
+  ReadLater::on_save_finished(::GObject* web_view_object,
+                              ::GAsyncResult* result,
+                              ::gpointer data)
+  {
+    const auto fetch = static_cast<Fetch*>(data);
+    ::GError* error = nullptr;
+    const auto success = ::webkit_web_view_save_to_file_finish(
+      WEBKIT_WEB_VIEW(web_view_object),
+      result,
+      &error
+    );
+
+    if (error)
+    {
+      ::g_error_free(error);
+    }
+    if (fetch->owner)
+    {
+      fetch->owner->on_fetch_saved(fetch, success);
+    } else {
+      destroy_web_view(fetch->web_view);
+      ::g_object_unref(fetch->cancellable);
+      delete fetch;
+    }
+  }
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/main-window.hpp>
+
+#define SELAIN_JS_STRINGIFY(source) #source
+
+namespace selain
+{
+  static const char* reader_source_code =
+  #include "./reader.js"
+  ;
+
+  namespace
+  {
+    struct ReaderRequest
+    {
+      MainWindow* window;
+      std::string uri;
+    };
+  }
+
+  ReaderArticles::ReaderArticles()
+    : m_last_id(0)
+  {
+  }
+
+  ::guint
+  ReaderArticles::add(ReaderArticle&& article)
+  {
+    article.id = ++m_last_id;
+    m_articles.push_back(std::move(article));
+    while (m_articles.size() > MAX_COUNT)
+    {
+      m_articles.pop_front();
+    }
+
+    return m_last_id;
+  }
+
+  const ReaderArticle*
+  ReaderArticles::find(::guint id) const
+  {
+    for (const auto& article : m_articles)
+    {
+      if (article.id == id)
+      {
+        return &article;
+      }
+    }
+
+    return nullptr;
+  }
+
+  static std::string
+  get_string_property(::JSCValue* object, const char* name)
+  {
+    const auto property = ::jsc_value_object_get_property(object, name);
+    std::string result;
+
+    if (::jsc_value_is_string(property))
+    {
+      const auto value = ::jsc_value_to_string(property);
+
+      result = value;
+      ::g_free(value);
+    }
+    ::g_object_unref(property);
+
+    return result;
+  }
+
+  static void
+  on_article_received(::GObject* web_view_object,
+                      ::GAsyncResult* result,
+                      ::gpointer data)
+  {
+    const auto request = static_cast<ReaderRequest*>(data);
+    ::GError* error = nullptr;
+    const auto js_result = ::webkit_web_view_run_javascript_finish(
+      WEBKIT_WEB_VIEW(web_view_object),
+      result,
+      &error
+    );
+
+    if (js_result)
+    {
+      const auto value = ::webkit_javascript_result_get_js_value(js_result);
+      ReaderArticle article;
+
+      if (::jsc_value_is_object(value))
+      {
+        article.uri = request->uri;
+        article.title = get_string_property(value, "title");
+        article.byline = get_string_property(value, "byline");
+        article.content = get_string_property(value, "content");
+      }
+      if (!article.content.empty())
+      {
+        const auto id = request->window->get_reader_articles().add(
+          std::move(article)
+        );
+
+        request->window->open_tab(
+          Glib::ustring::compose("selain://reader?id=%1", id),
+          true,
+          SettingsProfile::LITE
+        );
+      } else {
+        request->window->get_command_entry().show_notification(
+          "Error: No article found on the page.",
+          NotificationType::ERROR
+        );
+      }
+      ::webkit_javascript_result_unref(js_result);
+    } else {
+      request->window->get_command_entry().show_notification(
+        Glib::ustring("Error: ") + error->message,
+        NotificationType::ERROR
+      );
+      ::g_error_free(error);
+    }
+    delete request;
+  }
+
+  bool
+  Tab::open_reader()
+  {
+    const auto window = get_main_window();
+    const auto uri = get_uri();
+
+    if (!window || (
+      uri.compare(0, 7, "http://") && uri.compare(0, 8, "https://")
+    ))
+    {
+      return false;
+    }
+    execute_script(
+      reader_source_code,
+      nullptr,
+      on_article_received,
+      new ReaderRequest{ window, uri }
+    );
+
+    return true;
+  }
+}
@@ -0,0 +1,162 @@
+SELAIN_JS_STRINGIFY((() => {
+  const droppedTagNames = new Set([
+    'AUDIO', 'BUTTON', 'CANVAS', 'EMBED', 'FORM', 'IFRAME', 'INPUT', 'NAV',
+    'NOSCRIPT', 'OBJECT', 'SCRIPT', 'SELECT', 'STYLE', 'SVG', 'TEXTAREA',
+    'VIDEO'
+  ]);
+  const blockTagNames = new Set([
+    'ARTICLE', 'DIV', 'HEADER', 'MAIN', 'SECTION'
+  ]);
+  const allowedTagNames = new Set([
+    'A', 'B', 'BLOCKQUOTE', 'BR', 'CAPTION', 'CODE', 'DD', 'DL', 'DT', 'EM',
+    'FIGCAPTION', 'FIGURE', 'H1', 'H2', 'H3', 'H4', 'H5', 'H6', 'HR', 'I',
+    'IMG', 'LI', 'OL', 'P', 'PRE', 'S', 'SMALL', 'STRONG', 'SUB', 'SUP',
+    'TABLE', 'TBODY', 'TD', 'TH', 'THEAD', 'TR', 'U', 'UL'
+  ]);
+  const negativePattern = new RegExp(
+    'banner|comment|cookie|footer|menu|modal|nav|newsletter|popup|promo|' +
+    'related|share|sidebar|social|sponsor|subscribe|widget',
+    'i'
+  );
+  const positivePattern = /article|body|content|entry|main|post|story|text/i;
+  const httpPattern = /^https?:/i;
+
+  const getClassWeight = (element) => {
+    const names = `${element.getAttribute('class') || ''} ${element.id}`;
+    let weight = 0;
+
+    if (negativePattern.test(names)) {
+      weight -= 25;
+    }
+    if (positivePattern.test(names)) {
+      weight += 25;
+    }
+
+    return weight;
+  };
+
+  const getLinkDensity = (element) => {
+    const length = element.textContent.length;
+    let linkLength = 0;
+
+    if (!length) {
+      return 0;
+    }
+    for (const link of element.getElementsByTagName('a')) {
+      linkLength += link.textContent.length;
+    }
+
+    return linkLength / length;
+  };
+
+  /*
+   * Scores paragraphs by the amount of text in them and propagates the
+   * scores to their ancestors. The ancestor with highest score, adjusted by
+   * the share of text inside links, is taken to contain the article.
+   */
+  const findContent = () => {
+    const scores = new Map();
+    let best = null;
+    let bestScore = 0;
+
+    for (const paragraph of document.querySelectorAll('p, pre, td')) {
+      const text = paragraph.textContent.trim();
+      const score = 1 +
+        text.split(',').length +
+        Math.min(Math.floor(text.length / 100), 3);
+      let element = paragraph.parentElement;
+
+      if (text.length < 25) {
+        continue;
+      }
+      for (let level = 1; element && level <= 3; ++level) {
+        if (!scores.has(element)) {
+          scores.set(element, getClassWeight(element));
+        }
+        scores.set(element, scores.get(element) + score / level);
+        element = element.parentElement;
+      }
+    }
+    for (const [element, score] of scores) {
+      const adjustedScore = score * (1 - getLinkDensity(element));
+
+      if (adjustedScore > bestScore) {
+        best = element;
+        bestScore = adjustedScore;
+      }
+    }
+
+    return best ||
+      document.querySelector('article') ||
+      document.querySelector('main') ||
+      document.body;
+  };
+
+  const isHidden = (element) => element.hidden ||
+    element.getAttribute('aria-hidden') === 'true';
+
+  /*
+   * Copies content of the source element into the target element, keeping
+   * only the elements and attributes needed for reading.
+   */
+  const copyContent = (source, target) => {
+    for (const node of source.childNodes) {
+      const tagName = node.tagName ? node.tagName.toUpperCase() : '';
+      let element;
+
+      if (node.nodeType === Node.TEXT_NODE) {
+        target.appendChild(document.createTextNode(node.textContent));
+        continue;
+      }
+      if (node.nodeType !== Node.ELEMENT_NODE ||
+          droppedTagNames.has(tagName) ||
+          isHidden(node) ||
+          (getClassWeight(node) < 0 && getLinkDensity(node) > 0.3)) {
+        continue;
+      }
+      if (blockTagNames.has(tagName)) {
+        element = document.createElement('div');
+      } else if (!allowedTagNames.has(tagName)) {
+        copyContent(node, target);
+        continue;
+      } else if (tagName === 'IMG') {
+        if (!httpPattern.test(node.src)) {
+          continue;
+        }
+        element = document.createElement('img');
+        element.setAttribute('src', node.src);
+        element.setAttribute('alt', node.alt || '');
+      } else {
+        element = document.createElement(tagName);
+        if (tagName === 'A' && httpPattern.test(node.href)) {
+          element.setAttribute('href', node.href);
+        }
+      }
+      copyContent(node, element);
+      target.appendChild(element);
+    }
+  };
+
+  const getByline = () => {
+    const meta = document.querySelector('meta[name="author"]');
+    const element = document.querySelector('[rel="author"], .byline');
+
+    if (meta && meta.content) {
+      return meta.content.trim();
+    } else if (element) {
+      return element.textContent.trim();
+    }
+
+    return '';
+  };
+
+  const container = document.createElement('div');
+
+  copyContent(findContent(), container);
+
+  return {
+    title: document.title,
+    byline: getByline(),
+    content: container.innerHTML
+  };
+})();)
@@ -0,0 +1,445 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/resource-log.hpp>
+#include <selain/utils.hpp>
+
+#include <cstdio>
+#include <sstream>
+
+namespace selain
+{
+  static void
+  collect_header(const char* name, const char* value, ::gpointer data)
+  {
+    static_cast<ResourceTiming::header_list_type*>(data)->emplace_back(
+      name,
+      value
+    );
+  }
+
+  static void
+  get_headers(::SoupMessageHeaders* headers,
+              ResourceTiming::header_list_type& result)
+  {
+    result.clear();
+    if (headers)
+    {
+      ::soup_message_headers_foreach(
+        headers,
+        collect_header,
+        static_cast<::gpointer>(&result)
+      );
+    }
+  }
+
+  ResourceLog::ResourceLog(std::size_t capacity)
+    : m_capacity(capacity)
+    , m_sequence(0)
+    , m_page_started_time(0)
+    , m_page_started(0)
+    , m_page_finished(0)
+  {
+    m_save_dispatcher.connect(
+      sigc::mem_fun(this, &ResourceLog::on_save_finished)
+    );
+  }
+
+  ResourceLog::~ResourceLog()
+  {
+    if (m_save_thread.joinable())
+    {
+      m_save_thread.join();
+    }
+  }
+
+  void
+  ResourceLog::clear()
+  {
+    m_entries.clear();
+    m_loading.clear();
+    m_sequence = 0;
+    m_page_started_time = ::g_get_real_time();
+    m_page_started = ::g_get_monotonic_time();
+    m_page_finished = 0;
+  }
+
+  void
+  ResourceLog::add(::WebKitWebResource* resource, ::WebKitURIRequest* request)
+  {
+    const auto method = ::webkit_uri_request_get_http_method(request);
+    ResourceTiming timing;
+
+    timing.uri = ::webkit_uri_request_get_uri(request);
+    timing.method = method ? method : "GET";
+    timing.status = 0;
+    timing.size = 0;
+    timing.redirect_count = 0;
+    timing.started_time = ::g_get_real_time();
+    timing.started = ::g_get_monotonic_time();
+    timing.redirected = 0;
+    timing.response_received = 0;
+    timing.finished = 0;
+    timing.failed = false;
+    get_headers(
+      ::webkit_uri_request_get_http_headers(request),
+      timing.request_headers
+    );
+    if (!m_page_started)
+    {
+      m_page_started_time = timing.started_time;
+      m_page_started = timing.started;
+    }
+
+    if (m_entries.size() < m_capacity)
+    {
+      m_entries.push_back(std::move(timing));
+    } else {
+      const auto index = m_sequence % m_capacity;
+
+      for (auto it = std::begin(m_loading); it != std::end(m_loading); ++it)
+      {
+        if (it->second % m_capacity == index)
+        {
+          m_loading.erase(it);
+          break;
+        }
+      }
+      m_entries[index] = std::move(timing);
+    }
+    m_loading[resource] = m_sequence++;
+
+    ::g_signal_connect(
+      G_OBJECT(resource),
+      "sent-request",
+      G_CALLBACK(on_sent_request),
+      static_cast<::gpointer>(this)
+    );
+    ::g_signal_connect(
+      G_OBJECT(resource),
+      "received-data",
+      G_CALLBACK(on_received_data),
+      static_cast<::gpointer>(this)
+    );
+    ::g_signal_connect(
+      G_OBJECT(resource),
+      "notify::response",
+      G_CALLBACK(on_notify_response),
+      static_cast<::gpointer>(this)
+    );
+    ::g_signal_connect(
+      G_OBJECT(resource),
+      "finished",
+      G_CALLBACK(on_finished),
+      static_cast<::gpointer>(this)
+    );
+    ::g_signal_connect(
+      G_OBJECT(resource),
+      "failed",
+      G_CALLBACK(on_failed),
+      static_cast<::gpointer>(this)
+    );
+  }
+
+  void
+  ResourceLog::set_page_finished()
+  {
+    m_page_finished = ::g_get_monotonic_time();
+  }
+
+  std::size_t
+  ResourceLog::size() const
+  {
+    return m_entries.size();
+  }
+
+  void
+  ResourceLog::for_each(
+    const std::function<void(const ResourceTiming&)>& callback
+  ) const
+  {
+    const auto size = m_entries.size();
+    const auto start = size < m_capacity ? 0 : m_sequence % m_capacity;
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      callback(m_entries[(start + i) % size]);
+    }
+  }
+
+  /**
+   * Formats wall clock time given in microseconds since the Unix epoch as
+   * ISO 8601 date and time, as required by HAR.
+   */
+  static std::string
+  format_time(std::int64_t time)
+  {
+    const auto date_time = ::g_date_time_new_from_unix_utc(time / 1000000);
+    const auto formatted = ::g_date_time_format(
+      date_time,
+      "%Y-%m-%dT%H:%M:%S"
+    );
+    char buffer[8];
+    std::string result(formatted);
+
+    std::snprintf(
+      buffer,
+      sizeof(buffer),
+      ".%03dZ",
+      static_cast<int>(time / 1000 % 1000)
+    );
+    result.append(buffer);
+    ::g_free(formatted);
+    ::g_date_time_unref(date_time);
+
+    return result;
+  }
+
+  static std::string
+  quote(const std::string& input)
+  {
+    const Glib::ustring value(input);
+
+    // Header values are not required to be valid UTF-8.
+    return utils::js_quote(value.validate() ? value : Glib::ustring()).raw();
+  }
+
+  /**
+   * Returns time elapsed between given two events in milliseconds, or -1 if
+   * either of them has not happened.
+   */
+  static double
+  get_duration(std::int64_t start, std::int64_t end)
+  {
+    return start && end && end >= start ? (end - start) / 1000.0 : -1;
+  }
+
+  static void
+  export_headers(std::stringstream& output,
+                 const ResourceTiming::header_list_type& headers)
+  {
+    output << '[';
+    for (std::size_t i = 0; i < headers.size(); ++i)
+    {
+      output << (i > 0 ? "," : "")
+             << "{\"name\":" << quote(headers[i].first)
+             << ",\"value\":" << quote(headers[i].second) << '}';
+    }
+    output << ']';
+  }
+
+  std::string
+  ResourceLog::export_har(const Glib::ustring& page_uri,
+                          const Glib::ustring& page_title) const
+  {
+    std::stringstream output;
+    bool first = true;
+
+    output << "{\"log\":{\"version\":\"1.2\","
+           << "\"creator\":{\"name\":\"Selain\",\"version\":\"\"},"
+           << "\"pages\":[{\"id\":\"page_1\","
+           << "\"startedDateTime\":\"" << format_time(m_page_started_time)
+           << "\",\"title\":"
+           << quote(page_title.empty() ? page_uri : page_title)
+           << ",\"pageTimings\":{\"onLoad\":"
+           << get_duration(m_page_started, m_page_finished)
+           << "}}],\"entries\":[";
+    for_each([&output, &first](const ResourceTiming& timing)
+    {
+      const auto wait = get_duration(
+        timing.started,
+        timing.response_received
+      );
+      const auto receive = get_duration(
+        timing.response_received,
+        timing.finished
+      );
+      const auto total = get_duration(timing.started, timing.finished);
+      output << (first ? "" : ",")
+             << "{\"pageref\":\"page_1\",\"startedDateTime\":\""
+             << format_time(timing.started_time) << "\",\"time\":"
+             << (total < 0 ? 0 : total)
+             << ",\"request\":{\"method\":" << quote(timing.method)
+             << ",\"url\":" << quote(timing.uri)
+             << ",\"httpVersion\":\"\",\"cookies\":[],\"headers\":";
+      export_headers(output, timing.request_headers);
+      output << ",\"queryString\":[],\"headersSize\":-1,\"bodySize\":-1}"
+             << ",\"response\":{\"status\":" << timing.status
+             << ",\"statusText\":\"\",\"httpVersion\":\"\","
+             << "\"cookies\":[],\"headers\":";
+      export_headers(output, timing.response_headers);
+      output << ",\"content\":{\"size\":" << timing.size
+             << ",\"mimeType\":" << quote(timing.mime_type)
+             << "},\"redirectURL\":\"\""
+             << ",\"headersSize\":-1,\"bodySize\":" << timing.size
+             << "},\"cache\":{},\"timings\":{\"blocked\":-1"
+             << ",\"dns\":-1,\"connect\":-1,\"send\":0,\"wait\":"
+             << (wait < 0 ? 0 : wait) << ",\"receive\":"
+             << (receive < 0 ? 0 : receive) << ",\"ssl\":-1}";
+      if (timing.failed)
+      {
+        output << ",\"_error\":true";
+      }
+      output << '}';
+      first = false;
+    });
+    output << "]}}";
+
+    return output.str();
+  }
+
+  void
+  ResourceLog::save_har(const std::string& path,
+                        const Glib::ustring& page_uri,
+                        const Glib::ustring& page_title,
+                        const save_callback_type& callback)
+  {
+    if (m_save_thread.joinable())
+    {
+      callback("Another export is already in progress");
+      return;
+    }
+    m_save_callback = callback;
+
+    // The archive is generated in the main thread, as the entries keep
+    // changing while the page is loading, and only written in background.
+    m_save_thread = std::thread(
+      [this, path](const std::string& har)
+      {
+        ::GError* error = nullptr;
+
+        m_save_error.clear();
+        if (!::g_file_set_contents(
+          path.c_str(),
+          har.data(),
+          har.length(),
+          &error
+        ))
+        {
+          m_save_error = error->message;
+          ::g_error_free(error);
+        }
+        m_save_dispatcher.emit();
+      },
+      export_har(page_uri, page_title)
+    );
+  }
+
+  void
+  ResourceLog::on_save_finished()
+  {
+    save_callback_type callback;
+
+    m_save_thread.join();
+    callback.swap(m_save_callback);
+    callback(m_save_error);
+  }
+
+  ResourceTiming*
+  ResourceLog::find(::WebKitWebResource* resource)
+  {
+    const auto entry = m_loading.find(resource);
+
+    if (entry == std::end(m_loading))
+    {
+      return nullptr;
+    }
+
+    return &m_entries[entry->second % m_capacity];
+  }
+
+  void
+  ResourceLog::on_sent_request(::WebKitWebResource* resource,
+                               ::WebKitURIRequest* request,
+                               ::WebKitURIResponse* redirected_response,
+                               ResourceLog* log)
+  {
+    const auto timing = log->find(resource);
+
+    if (!timing || !redirected_response)
+    {
+      return;
+    }
+    timing->uri = ::webkit_uri_request_get_uri(request);
+    timing->redirected = ::g_get_monotonic_time();
+    ++timing->redirect_count;
+  }
+
+  void
+  ResourceLog::on_received_data(::WebKitWebResource* resource,
+                                ::guint64 data_length,
+                                ResourceLog* log)
+  {
+    if (const auto timing = log->find(resource))
+    {
+      timing->size += data_length;
+    }
+  }
+
+  void
+  ResourceLog::on_notify_response(::WebKitWebResource* resource,
+                                  ::GParamSpec*,
+                                  ResourceLog* log)
+  {
+    const auto timing = log->find(resource);
+    ::WebKitURIResponse* response;
+
+    if (!timing || !(response = ::webkit_web_resource_get_response(resource)))
+    {
+      return;
+    }
+    if (const auto mime_type = ::webkit_uri_response_get_mime_type(response))
+    {
+      timing->mime_type = mime_type;
+    }
+    timing->status = ::webkit_uri_response_get_status_code(response);
+    timing->response_received = ::g_get_monotonic_time();
+    get_headers(
+      ::webkit_uri_response_get_http_headers(response),
+      timing->response_headers
+    );
+  }
+
+  void
+  ResourceLog::on_finished(::WebKitWebResource* resource, ResourceLog* log)
+  {
+    if (const auto timing = log->find(resource))
+    {
+      timing->finished = ::g_get_monotonic_time();
+      log->m_loading.erase(resource);
+    }
+  }
+
+  void
+  ResourceLog::on_failed(::WebKitWebResource* resource,
+                         ::GError*,
+                         ResourceLog* log)
+  {
+    if (const auto timing = log->find(resource))
+    {
+      timing->failed = true;
+    }
+  }
+}
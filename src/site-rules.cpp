@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/site-rules.hpp>
+
+#include <algorithm>
+#include <cctype>
+
+namespace selain
+{
+  /**
+   * Normalizes host pattern into lower case, without the "*." prefix or
+   * trailing dot.
+   */
+  static std::string
+  normalize_pattern(const std::string& pattern)
+  {
+    std::string result(pattern);
+
+    std::transform(
+      std::begin(result),
+      std::end(result),
+      std::begin(result),
+      [](unsigned char c) { return std::tolower(c); }
+    );
+    if (!result.compare(0, 2, "*."))
+    {
+      result.erase(0, 2);
+    }
+    while (!result.empty() && result.back() == '.')
+    {
+      result.pop_back();
+    }
+
+    return result;
+  }
+
+  /**
+   * Extracts host name from given URI, or returns empty string if the URI
+   * has no host.
+   */
+  static std::string
+  get_host(const std::string& uri)
+  {
+    const auto scheme_end = uri.find("://");
+    std::string::size_type start;
+    std::string::size_type end;
+
+    if (scheme_end == std::string::npos)
+    {
+      return std::string();
+    }
+    start = scheme_end + 3;
+    end = uri.find_first_of("/?#", start);
+    if (end == std::string::npos)
+    {
+      end = uri.length();
+    }
+    // Skip user information.
+    start = std::max(start, uri.rfind('@', end) + 1);
+    if (start < end && uri[start] == '[')
+    {
+      const auto bracket = uri.find(']', start);
+
+      return bracket != std::string::npos && bracket < end
+        ? uri.substr(start + 1, bracket - start - 1)
+        : std::string();
+    }
+    end = std::min(end, uri.find(':', start));
+
+    return normalize_pattern(uri.substr(start, end - start));
+  }
+
+  SiteRules::SiteRules()
+  {
+    m_root.rule = nullptr;
+  }
+
+  void
+  SiteRules::set_option(const std::string& pattern,
+                        const std::string& key,
+                        const std::string& value)
+  {
+    const auto normalized = normalize_pattern(pattern);
+    auto entry = m_rules.find(normalized);
+
+    if (entry == std::end(m_rules))
+    {
+      if (value.empty())
+      {
+        return;
+      }
+      entry = m_rules.emplace(
+        normalized,
+        std::unique_ptr<SiteRule>(new SiteRule())
+      ).first;
+      entry->second->pattern = normalized;
+      get_node(normalized)->rule = entry->second.get();
+    }
+    if (value.empty())
+    {
+      entry->second->options.erase(key);
+      if (entry->second->options.empty())
+      {
+        get_node(normalized)->rule = nullptr;
+        m_rules.erase(entry);
+      }
+    } else {
+      entry->second->options[key] = value;
+    }
+  }
+
+  SiteRule*
+  SiteRules::find(const std::string& uri)
+  {
+    const auto host = get_host(uri);
+    const Node* node = &m_root;
+    auto result = m_root.rule;
+    auto end = host.length();
+
+    // Walk the labels from the top level domain towards the host, keeping
+    // track of the most specific rule seen so far.
+    while (node && end > 0)
+    {
+      const auto dot = host.rfind('.', end - 1);
+      const auto start = dot == std::string::npos ? 0 : dot + 1;
+      const auto child = node->children.find(
+        host.substr(start, end - start)
+      );
+
+      if (child == std::end(node->children))
+      {
+        break;
+      }
+      node = child->second.get();
+      if (node->rule)
+      {
+        result = node->rule;
+      }
+      if (dot == std::string::npos)
+      {
+        break;
+      }
+      end = dot;
+    }
+
+    return result;
+  }
+
+  void
+  SiteRules::invalidate()
+  {
+    for (const auto& entry : m_rules)
+    {
+      for (auto& settings : entry.second->settings)
+      {
+        settings.reset();
+      }
+    }
+  }
+
+  SiteRules::Node*
+  SiteRules::get_node(const std::string& pattern)
+  {
+    auto node = &m_root;
+    auto end = pattern.length();
+
+    if (pattern == "*")
+    {
+      return node;
+    }
+    while (end > 0)
+    {
+      const auto dot = pattern.rfind('.', end - 1);
+      const auto start = dot == std::string::npos ? 0 : dot + 1;
+      auto& child = node->children[pattern.substr(start, end - start)];
+
+      if (!child)
+      {
+        child.reset(new Node());
+        child->rule = nullptr;
+      }
+      node = child.get();
+      if (dot == std::string::npos)
+      {
+        break;
+      }
+      end = dot;
+    }
+
+    return node;
+  }
+}
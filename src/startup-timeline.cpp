@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/startup-timeline.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include <glib.h>
+
+namespace selain
+{
+  namespace startup_timeline
+  {
+    namespace
+    {
+      struct Phase
+      {
+        const char* name;
+        std::int64_t time;
+      };
+    }
+
+    static std::vector<Phase> phases;
+    static bool enabled = false;
+    static bool finished = false;
+
+    void
+    enable()
+    {
+      enabled = true;
+    }
+
+    void
+    mark(const char* phase)
+    {
+      if (!finished)
+      {
+        phases.push_back({ phase, ::g_get_monotonic_time() });
+      }
+    }
+
+    void
+    finish(const char* phase)
+    {
+      std::int64_t previous;
+      char line[128];
+
+      if (finished)
+      {
+        return;
+      }
+      mark(phase);
+      finished = true;
+      if (!enabled)
+      {
+        return;
+      }
+      previous = phases[0].time;
+      for (const auto& entry : phases)
+      {
+        std::snprintf(
+          line,
+          sizeof(line),
+          "%-20s %8.1f ms %+8.1f ms\n",
+          entry.name,
+          (entry.time - phases[0].time) / 1000.0,
+          (entry.time - previous) / 1000.0
+        );
+        std::cerr << line;
+        previous = entry.time;
+      }
+    }
+  }
+}
@@ -40,6 +40,8 @@ namespace selain
 
     pack_start(m_mode_label, Gtk::PACK_SHRINK);
     pack_start(m_status_label, true, true);
+    pack_start(m_blocked_label, Gtk::PACK_SHRINK);
+    pack_start(m_find_label, Gtk::PACK_SHRINK);
 
     override_background_color(theme::status_bar_background);
 
@@ -57,6 +59,18 @@ namespace selain
     m_status_label.set_justify(Gtk::JUSTIFY_LEFT);
     m_status_label.get_style_context()->add_provider(style_provider, 1000);
 
+    m_blocked_label.override_font(font);
+    m_blocked_label.override_background_color(theme::status_bar_background);
+    m_blocked_label.override_color(theme::status_bar_foreground);
+    m_blocked_label.set_halign(Gtk::ALIGN_END);
+    m_blocked_label.get_style_context()->add_provider(style_provider, 1000);
+
+    m_find_label.override_font(font);
+    m_find_label.override_background_color(theme::status_bar_background);
+    m_find_label.override_color(theme::status_bar_foreground);
+    m_find_label.set_halign(Gtk::ALIGN_END);
+    m_find_label.get_style_context()->add_provider(style_provider, 1000);
+
     show_all_children();
   }
 
@@ -79,4 +93,21 @@ namespace selain
   {
     m_status_label.set_text(status);
   }
+
+  void
+  StatusBar::set_find_status(const Glib::ustring& find_status)
+  {
+    m_find_label.set_text(find_status);
+  }
+
+  void
+  StatusBar::set_blocked_count(::guint count)
+  {
+    if (count > 0)
+    {
+      m_blocked_label.set_text(Glib::ustring::compose("%1 blocked ", count));
+    } else {
+      m_blocked_label.set_text(Glib::ustring());
+    }
+  }
 }
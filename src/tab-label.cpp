@@ -24,6 +24,7 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 #include <selain/tab-label.hpp>
+#include <selain/theme.hpp>
 
 namespace selain
 {
@@ -34,6 +35,9 @@ namespace selain
     m_icon.set_from_icon_name("text-x-generic", Gtk::ICON_SIZE_BUTTON);
     m_icon.set_margin_end(5);
 
+    m_text.override_color(theme::window_foreground);
+    m_text.set_halign(Gtk::ALIGN_START);
+
     m_close_button.set_relief(Gtk::RELIEF_NONE);
     m_close_button.set_focus_on_click(false);
     m_close_button.set_image_from_icon_name(
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <algorithm>
+
+#include <selain/tab.hpp>
+#include <selain/tab-overview.hpp>
+#include <selain/theme.hpp>
+
+namespace selain
+{
+  // Space between and around the tiles, in pixels.
+  static const int TILE_SPACING = 12;
+
+  TabOverview::TabOverview(Gtk::Notebook& notebook, TabSnapshots& snapshots)
+    : m_notebook(notebook)
+    , m_snapshots(snapshots)
+  {
+    m_flow_box.set_selection_mode(Gtk::SELECTION_SINGLE);
+    m_flow_box.set_activate_on_single_click(true);
+    m_flow_box.set_homogeneous(true);
+    m_flow_box.set_valign(Gtk::ALIGN_START);
+    m_flow_box.set_row_spacing(TILE_SPACING);
+    m_flow_box.set_column_spacing(TILE_SPACING);
+    m_flow_box.set_border_width(TILE_SPACING);
+    m_flow_box.signal_child_activated().connect(sigc::mem_fun(
+      this,
+      &TabOverview::on_child_activated
+    ));
+    m_snapshots.signal_updated().connect(sigc::mem_fun(
+      this,
+      &TabOverview::on_snapshot_updated
+    ));
+
+    set_policy(Gtk::POLICY_NEVER, Gtk::POLICY_AUTOMATIC);
+    override_background_color(theme::window_background);
+    add(m_flow_box);
+  }
+
+  void
+  TabOverview::populate()
+  {
+    const auto count = m_notebook.get_n_pages();
+    const auto current = m_notebook.get_current_page();
+
+    clear();
+    for (int i = 0; i < count; ++i)
+    {
+      const auto tab = static_cast<Tab*>(m_notebook.get_nth_page(i));
+      const auto box = Gtk::manage(new Gtk::Box(Gtk::ORIENTATION_VERTICAL));
+      const auto image = Gtk::manage(new Gtk::Image());
+      const auto label = Gtk::manage(new Gtk::Label(tab->get_label_text()));
+
+      image->set_size_request(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT);
+      image->set_valign(Gtk::ALIGN_START);
+      label->set_ellipsize(Pango::ELLIPSIZE_END);
+      label->set_max_width_chars(1);
+      label->set_size_request(THUMBNAIL_WIDTH, -1);
+      label->override_color(theme::window_foreground);
+      box->pack_start(*image, Gtk::PACK_SHRINK);
+      box->pack_start(*label, Gtk::PACK_SHRINK);
+      m_flow_box.add(*box);
+      m_ids.push_back(tab->get_id());
+      m_thumbnails.push_back(image);
+      update_thumbnail(m_ids.size() - 1);
+    }
+    m_flow_box.show_all();
+    if (const auto child = m_flow_box.get_child_at_index(current))
+    {
+      m_flow_box.select_child(*child);
+      child->grab_focus();
+    }
+  }
+
+  void
+  TabOverview::clear()
+  {
+    for (const auto child : m_flow_box.get_children())
+    {
+      m_flow_box.remove(*child);
+    }
+    m_ids.clear();
+    m_thumbnails.clear();
+  }
+
+  bool
+  TabOverview::on_key_press_event(::GdkEventKey* event)
+  {
+    ::GtkMovementStep step = GTK_MOVEMENT_VISUAL_POSITIONS;
+    ::gint count = 0;
+    ::gboolean handled = FALSE;
+
+    switch (event->keyval)
+    {
+      case GDK_KEY_Escape:
+      case GDK_KEY_q:
+        m_signal_closed.emit();
+        return true;
+
+      case GDK_KEY_h:
+        count = -1;
+        break;
+
+      case GDK_KEY_l:
+        count = 1;
+        break;
+
+      case GDK_KEY_k:
+        step = GTK_MOVEMENT_DISPLAY_LINES;
+        count = -1;
+        break;
+
+      case GDK_KEY_j:
+        step = GTK_MOVEMENT_DISPLAY_LINES;
+        count = 1;
+        break;
+
+      default:
+        return Gtk::ScrolledWindow::on_key_press_event(event);
+    }
+    ::g_signal_emit_by_name(
+      G_OBJECT(m_flow_box.gobj()),
+      "move-cursor",
+      step,
+      count,
+      &handled
+    );
+
+    return true;
+  }
+
+  /**
+   * Scales snapshot of the tab down to the width of the tile, cropping it
+   * from the bottom if the snapshot is taller than the tile.
+   */
+  void
+  TabOverview::update_thumbnail(std::size_t index)
+  {
+    const auto image = m_thumbnails[index];
+    const auto snapshot = m_snapshots.get(m_ids[index]);
+    double scale;
+    int height;
+    Cairo::RefPtr<Cairo::ImageSurface> thumbnail;
+    Cairo::RefPtr<Cairo::Context> cr;
+
+    if (!snapshot)
+    {
+      image->clear();
+      return;
+    }
+    scale = static_cast<double>(THUMBNAIL_WIDTH) / snapshot->get_width();
+    height = std::max(static_cast<int>(snapshot->get_height() * scale), 1);
+    if (height > THUMBNAIL_HEIGHT)
+    {
+      height = THUMBNAIL_HEIGHT;
+    }
+    thumbnail = Cairo::ImageSurface::create(
+      Cairo::FORMAT_RGB24,
+      THUMBNAIL_WIDTH,
+      height
+    );
+    cr = Cairo::Context::create(thumbnail);
+    cr->scale(scale, scale);
+    cr->set_source(snapshot, 0, 0);
+    cr->paint();
+    image->set(thumbnail);
+  }
+
+  void
+  TabOverview::on_child_activated(Gtk::FlowBoxChild* child)
+  {
+    const auto index = child->get_index();
+
+    if (index >= 0 && static_cast<std::size_t>(index) < m_ids.size())
+    {
+      m_signal_activated.emit(m_ids[index]);
+    }
+  }
+
+  void
+  TabOverview::on_snapshot_updated(::guint id)
+  {
+    const auto it = std::find(std::begin(m_ids), std::end(m_ids), id);
+
+    if (it != std::end(m_ids))
+    {
+      update_thumbnail(static_cast<std::size_t>(it - std::begin(m_ids)));
+    }
+  }
+}
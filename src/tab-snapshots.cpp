@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/main-window.hpp>
+#include <selain/tab-snapshots.hpp>
+
+#include <algorithm>
+
+namespace selain
+{
+  struct SnapshotRequest
+  {
+    TabSnapshots* snapshots;
+    ::guint id;
+  };
+
+  static void on_snapshot_received(
+    ::GObject* web_view_object,
+    ::GAsyncResult* result,
+    ::gpointer data
+  );
+
+  /**
+   * Returns copy of given image surface scaled down to the maximum width
+   * of snapshots, or null pointer if the surface isn't an image surface.
+   */
+  static ::cairo_surface_t*
+  downscale(::cairo_surface_t* source)
+  {
+    int width;
+    int height;
+    double scale;
+    ::cairo_surface_t* target;
+    ::cairo_t* cr;
+
+    if (::cairo_surface_get_type(source) != CAIRO_SURFACE_TYPE_IMAGE)
+    {
+      return nullptr;
+    }
+    width = ::cairo_image_surface_get_width(source);
+    height = ::cairo_image_surface_get_height(source);
+    if (width < 1 || height < 1)
+    {
+      return nullptr;
+    }
+    scale = width > TabSnapshots::MAX_WIDTH
+      ? static_cast<double>(TabSnapshots::MAX_WIDTH) / width
+      : 1.0;
+    target = ::cairo_image_surface_create(
+      CAIRO_FORMAT_RGB24,
+      std::max(static_cast<int>(width * scale), 1),
+      std::max(static_cast<int>(height * scale), 1)
+    );
+    cr = ::cairo_create(target);
+    ::cairo_scale(cr, scale, scale);
+    ::cairo_set_source_surface(cr, source, 0, 0);
+    ::cairo_pattern_set_filter(::cairo_get_source(cr), CAIRO_FILTER_GOOD);
+    ::cairo_paint(cr);
+    ::cairo_destroy(cr);
+    ::cairo_surface_flush(target);
+
+    return target;
+  }
+
+  TabSnapshots::TabSnapshots()
+    : m_memory_budget(DEFAULT_MEMORY_BUDGET)
+    , m_memory_usage(0)
+    , m_running(false)
+  {
+    m_dispatcher.connect(
+      sigc::mem_fun(this, &TabSnapshots::on_downscale_finished)
+    );
+  }
+
+  TabSnapshots::~TabSnapshots()
+  {
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      m_running = false;
+    }
+    m_condition.notify_one();
+    if (m_thread.joinable())
+    {
+      m_thread.join();
+    }
+    for (const auto& job : m_queue)
+    {
+      ::cairo_surface_destroy(job.second);
+    }
+    for (const auto& result : m_results)
+    {
+      ::cairo_surface_destroy(result.second);
+    }
+  }
+
+  void
+  TabSnapshots::set_memory_budget(std::size_t budget)
+  {
+    m_memory_budget = budget;
+    evict();
+  }
+
+  void
+  TabSnapshots::begin(::guint id)
+  {
+    m_pending.insert(id);
+  }
+
+  void
+  TabSnapshots::add(::guint id, ::cairo_surface_t* surface)
+  {
+    // Scaling a snapshot of a large window takes long enough to be noticed
+    // during tab switching, so it's done in a background thread. The thread
+    // is started when the first snapshot is captured.
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      m_queue.emplace_back(id, surface);
+      if (!m_running)
+      {
+        m_running = true;
+        m_thread = std::thread(&TabSnapshots::run, this);
+      }
+    }
+    m_condition.notify_one();
+  }
+
+  TabSnapshots::surface_type
+  TabSnapshots::get(::guint id)
+  {
+    const auto it = m_index.find(id);
+
+    if (it == std::end(m_index))
+    {
+      return surface_type();
+    }
+    m_entries.splice(std::begin(m_entries), m_entries, it->second);
+
+    return it->second->surface;
+  }
+
+  void
+  TabSnapshots::remove(::guint id)
+  {
+    const auto it = m_index.find(id);
+
+    m_pending.erase(id);
+    if (it != std::end(m_index))
+    {
+      m_memory_usage -= it->second->size;
+      m_entries.erase(it->second);
+      m_index.erase(it);
+    }
+  }
+
+  void
+  TabSnapshots::store(::guint id, const surface_type& surface)
+  {
+    const auto size = static_cast<std::size_t>(
+      surface->get_stride() * surface->get_height()
+    );
+
+    // Tab may have been closed while the snapshot was being captured.
+    if (!m_pending.erase(id))
+    {
+      return;
+    }
+    remove(id);
+    m_entries.push_front({ id, surface, size });
+    m_index[id] = std::begin(m_entries);
+    m_memory_usage += size;
+    evict();
+    m_signal_updated.emit(id);
+  }
+
+  void
+  TabSnapshots::run()
+  {
+    for (;;)
+    {
+      job_list_type jobs;
+
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_condition.wait(lock, [this]()
+        {
+          return !m_running || !m_queue.empty();
+        });
+        if (!m_running)
+        {
+          break;
+        }
+        jobs.swap(m_queue);
+      }
+      for (auto& job : jobs)
+      {
+        const auto scaled = downscale(job.second);
+
+        ::cairo_surface_destroy(job.second);
+        job.second = scaled;
+      }
+      {
+        std::lock_guard<std::mutex> guard(m_mutex);
+
+        for (const auto& job : jobs)
+        {
+          if (job.second)
+          {
+            m_results.push_back(job);
+          }
+        }
+      }
+      m_dispatcher.emit();
+    }
+  }
+
+  void
+  TabSnapshots::on_downscale_finished()
+  {
+    job_list_type results;
+
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      results.swap(m_results);
+    }
+    for (const auto& result : results)
+    {
+      store(
+        result.first,
+        surface_type(new Cairo::ImageSurface(result.second, true))
+      );
+    }
+  }
+
+  void
+  TabSnapshots::evict()
+  {
+    while (m_memory_usage > m_memory_budget && !m_entries.empty())
+    {
+      const auto& entry = m_entries.back();
+
+      m_memory_usage -= entry.size;
+      m_index.erase(entry.id);
+      m_entries.pop_back();
+    }
+  }
+
+  void
+  Tab::capture_snapshot()
+  {
+    const auto window = get_main_window();
+
+    if (!window || get_uri().empty())
+    {
+      return;
+    }
+    window->get_tab_snapshots().begin(m_id);
+    ::webkit_web_view_get_snapshot(
+      m_web_view,
+      WEBKIT_SNAPSHOT_REGION_VISIBLE,
+      WEBKIT_SNAPSHOT_OPTIONS_NONE,
+      nullptr,
+      on_snapshot_received,
+      new SnapshotRequest{ &window->get_tab_snapshots(), m_id }
+    );
+  }
+
+  static void
+  on_snapshot_received(::GObject* web_view_object,
+                       ::GAsyncResult* result,
+                       ::gpointer data)
+  {
+    const auto request = static_cast<SnapshotRequest*>(data);
+    ::GError* error = nullptr;
+    const auto surface = ::webkit_web_view_get_snapshot_finish(
+      WEBKIT_WEB_VIEW(web_view_object),
+      result,
+      &error
+    );
+
+    if (surface)
+    {
+      request->snapshots->add(request->id, surface);
+    } else {
+      // Snapshot fails when the page has nothing to display yet, which
+      // isn't worth a warning. Any previous snapshot would be stale anyway.
+      request->snapshots->remove(request->id);
+      ::g_error_free(error);
+    }
+    delete request;
+  }
+}
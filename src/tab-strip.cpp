@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <algorithm>
+
+#include <selain/main-window.hpp>
+#include <selain/tab-strip.hpp>
+#include <selain/theme.hpp>
+
+namespace selain
+{
+  // Width of a single tab in the horizontal strip, in pixels.
+  static const int HORIZONTAL_ITEM_WIDTH = 200;
+
+  // Width of the vertical strip, in pixels.
+  static const int VERTICAL_STRIP_WIDTH = 250;
+
+  TabStrip::TabStrip(Gtk::Notebook& notebook)
+    : m_notebook(notebook)
+    , m_orientation(Gtk::ORIENTATION_HORIZONTAL)
+    , m_item_height(0)
+    , m_capacity(0)
+    , m_offset(0)
+    , m_current(-1)
+  {
+    TabLabel label;
+    int minimum_height;
+
+    // All labels have the same height, so it's measured only once.
+    label.get_preferred_height(minimum_height, m_item_height);
+    m_item_height = std::max(m_item_height, 1);
+
+    add_events(Gdk::SCROLL_MASK);
+    override_background_color(theme::tab_background);
+    update_size_request();
+
+    m_notebook.signal_page_added().connect(sigc::mem_fun(
+      this,
+      &TabStrip::on_page_added
+    ));
+    m_notebook.signal_page_removed().connect(sigc::mem_fun(
+      this,
+      &TabStrip::on_page_removed
+    ));
+    m_notebook.signal_page_reordered().connect(sigc::mem_fun(
+      this,
+      &TabStrip::on_page_reordered
+    ));
+    m_notebook.signal_switch_page().connect(sigc::mem_fun(
+      this,
+      &TabStrip::on_switch_page
+    ));
+  }
+
+  TabStrip::~TabStrip()
+  {
+    m_update_connection.disconnect();
+  }
+
+  void
+  TabStrip::set_orientation(Gtk::Orientation orientation)
+  {
+    if (m_orientation == orientation)
+    {
+      return;
+    }
+    m_orientation = orientation;
+    update_size_request();
+    for (std::size_t i = 0; i < m_slots.size(); ++i)
+    {
+      auto& event_box = m_slots[i]->event_box;
+      const auto position = static_cast<int>(i);
+
+      event_box.set_size_request(get_item_width(), m_item_height);
+      if (m_orientation == Gtk::ORIENTATION_HORIZONTAL)
+      {
+        move(event_box, position * get_item_width(), 0);
+      } else {
+        move(event_box, 0, position * m_item_height);
+      }
+    }
+    // Number of visible labels is calculated again once the strip has been
+    // allocated it's new size.
+    m_capacity = 0;
+    queue_resize();
+  }
+
+  void
+  TabStrip::update_tab(Tab* tab)
+  {
+    for (const auto& slot : m_slots)
+    {
+      if (slot->tab == tab)
+      {
+        slot->label.set_text(tab->get_label_text());
+        slot->label.set_icon(tab->get_icon());
+        break;
+      }
+    }
+  }
+
+  void
+  TabStrip::on_size_allocate(Gtk::Allocation& allocation)
+  {
+    int capacity;
+
+    Gtk::Layout::on_size_allocate(allocation);
+
+    if (m_orientation == Gtk::ORIENTATION_HORIZONTAL)
+    {
+      capacity = allocation.get_width() / get_item_width();
+    } else {
+      capacity = allocation.get_height() / m_item_height;
+    }
+    capacity = std::max(capacity, 1);
+
+    // Labels cannot be added or removed in the middle of size allocation,
+    // so the pool is resized once the allocation has finished.
+    if (capacity != m_capacity)
+    {
+      m_capacity = capacity;
+      if (!m_update_connection.connected())
+      {
+        m_update_connection = Glib::signal_idle().connect(sigc::mem_fun(
+          this,
+          &TabStrip::update_slots
+        ));
+      }
+    }
+  }
+
+  bool
+  TabStrip::on_scroll_event(::GdkEventScroll* event)
+  {
+    switch (event->direction)
+    {
+      case GDK_SCROLL_UP:
+      case GDK_SCROLL_LEFT:
+        set_offset(m_offset - 1);
+        return true;
+
+      case GDK_SCROLL_DOWN:
+      case GDK_SCROLL_RIGHT:
+        set_offset(m_offset + 1);
+        return true;
+
+      default:
+        return false;
+    }
+  }
+
+  int
+  TabStrip::get_item_width() const
+  {
+    return m_orientation == Gtk::ORIENTATION_HORIZONTAL
+      ? HORIZONTAL_ITEM_WIDTH
+      : VERTICAL_STRIP_WIDTH;
+  }
+
+  void
+  TabStrip::update_size_request()
+  {
+    if (m_orientation == Gtk::ORIENTATION_HORIZONTAL)
+    {
+      set_size_request(-1, m_item_height);
+    } else {
+      set_size_request(VERTICAL_STRIP_WIDTH, -1);
+    }
+  }
+
+  bool
+  TabStrip::update_slots()
+  {
+    const auto capacity = static_cast<std::size_t>(m_capacity);
+
+    while (m_slots.size() > capacity)
+    {
+      remove(m_slots.back()->event_box);
+      m_slots.pop_back();
+    }
+    while (m_slots.size() < capacity)
+    {
+      const auto index = m_slots.size();
+      const auto position = static_cast<int>(index);
+      auto slot = new Slot();
+
+      slot->tab = nullptr;
+      slot->event_box.add(slot->label);
+      // Visibility of the labels is controlled by the strip, so that showing
+      // the whole window doesn't reveal the unused ones.
+      slot->event_box.set_no_show_all(true);
+      slot->event_box.set_size_request(get_item_width(), m_item_height);
+      slot->event_box.signal_button_press_event().connect(sigc::bind(
+        sigc::mem_fun(this, &TabStrip::on_slot_button_press),
+        index
+      ));
+      slot->label.signal_close_button_clicked().connect(sigc::bind(
+        sigc::mem_fun(this, &TabStrip::on_slot_close_button_clicked),
+        index
+      ));
+      if (m_orientation == Gtk::ORIENTATION_HORIZONTAL)
+      {
+        put(slot->event_box, position * get_item_width(), 0);
+      } else {
+        put(slot->event_box, 0, position * m_item_height);
+      }
+      m_slots.emplace_back(slot);
+    }
+    scroll_to(m_current);
+
+    return false;
+  }
+
+  void
+  TabStrip::bind()
+  {
+    const auto tab_count = static_cast<int>(m_tabs.size());
+
+    for (std::size_t i = 0; i < m_slots.size(); ++i)
+    {
+      auto& slot = *m_slots[i];
+      const auto index = m_offset + static_cast<int>(i);
+      const auto tab = index < tab_count ? m_tabs[index] : nullptr;
+
+      if (!tab)
+      {
+        slot.tab = nullptr;
+        slot.event_box.hide();
+        continue;
+      }
+      if (slot.tab != tab)
+      {
+        slot.tab = tab;
+        slot.label.set_text(tab->get_label_text());
+        slot.label.set_icon(tab->get_icon());
+      }
+      slot.event_box.override_background_color(
+        index == m_current
+          ? theme::tab_active_background
+          : theme::tab_background
+      );
+      slot.event_box.show();
+    }
+  }
+
+  void
+  TabStrip::scroll_to(int index)
+  {
+    const auto slot_count = static_cast<int>(m_slots.size());
+    auto offset = m_offset;
+
+    if (index >= 0)
+    {
+      if (index < offset)
+      {
+        offset = index;
+      }
+      else if (index >= offset + slot_count)
+      {
+        offset = index - slot_count + 1;
+      }
+    }
+    set_offset(offset);
+  }
+
+  void
+  TabStrip::set_offset(int offset)
+  {
+    const auto max_offset = static_cast<int>(m_tabs.size() - std::min(
+      m_tabs.size(),
+      m_slots.size()
+    ));
+
+    m_offset = std::max(0, std::min(offset, max_offset));
+    bind();
+  }
+
+  void
+  TabStrip::on_page_added(Gtk::Widget* widget, ::guint page_number)
+  {
+    const auto tab = static_cast<Tab*>(widget);
+    const auto index = static_cast<int>(page_number);
+
+    m_tabs.insert(std::begin(m_tabs) + index, tab);
+    if (m_current >= index)
+    {
+      ++m_current;
+    }
+    tab->signal_label_changed().connect(sigc::mem_fun(
+      this,
+      &TabStrip::update_tab
+    ));
+    set_offset(m_offset);
+  }
+
+  void
+  TabStrip::on_page_removed(Gtk::Widget* widget, ::guint page_number)
+  {
+    const auto tab = static_cast<Tab*>(widget);
+    const auto index = static_cast<int>(page_number);
+
+    m_tabs.erase(std::begin(m_tabs) + index);
+    // The tab is about to be destroyed, and a new tab may be allocated at
+    // the same address, which bind() would mistake for this one.
+    for (const auto& slot : m_slots)
+    {
+      if (slot->tab == tab)
+      {
+        slot->tab = nullptr;
+      }
+    }
+    // When the current tab is removed, the notebook switches to another tab
+    // before the removal.
+    if (m_current > index)
+    {
+      --m_current;
+    }
+    else if (m_current == index)
+    {
+      m_current = -1;
+    }
+    scroll_to(m_current);
+  }
+
+  void
+  TabStrip::on_page_reordered(Gtk::Widget* widget, ::guint page_number)
+  {
+    const auto tab = static_cast<Tab*>(widget);
+    const auto it = std::find(std::begin(m_tabs), std::end(m_tabs), tab);
+
+    if (it != std::end(m_tabs))
+    {
+      m_tabs.erase(it);
+    }
+    m_tabs.insert(std::begin(m_tabs) + page_number, tab);
+    m_current = m_notebook.get_current_page();
+    for (const auto& slot : m_slots)
+    {
+      slot->tab = nullptr;
+    }
+    scroll_to(m_current);
+  }
+
+  void
+  TabStrip::on_switch_page(Gtk::Widget*, ::guint page_number)
+  {
+    m_current = static_cast<int>(page_number);
+    scroll_to(m_current);
+  }
+
+  bool
+  TabStrip::on_slot_button_press(::GdkEventButton* event, std::size_t index)
+  {
+    const auto tab_index = m_offset + static_cast<int>(index);
+
+    if (event->type != GDK_BUTTON_PRESS ||
+        tab_index >= static_cast<int>(m_tabs.size()))
+    {
+      return false;
+    }
+    if (event->button == 1)
+    {
+      m_notebook.set_current_page(tab_index);
+
+      return true;
+    }
+    else if (event->button == 2)
+    {
+      on_slot_close_button_clicked(index);
+
+      return true;
+    }
+
+    return false;
+  }
+
+  void
+  TabStrip::on_slot_close_button_clicked(std::size_t index)
+  {
+    const auto tab = index < m_slots.size() ? m_slots[index]->tab : nullptr;
+
+    if (!tab)
+    {
+      return;
+    }
+    if (const auto window = tab->get_main_window())
+    {
+      window->close_tab(*tab);
+    }
+  }
+}
@@ -24,7 +24,12 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 #include <selain/main-window.hpp>
+#include <selain/metrics.hpp>
 #include <selain/theme.hpp>
+#include <selain/trace.hpp>
+
+#include <cstdio>
+#include <cstring>
 
 namespace selain
 {
@@ -55,6 +60,62 @@ namespace selain
     ::GParamSpec*,
     Tab*
   );
+  static void on_resource_load_started(
+    ::WebKitWebView*,
+    ::WebKitWebResource*,
+    ::WebKitURIRequest*,
+    Tab*
+  );
+  static void on_resource_failed(
+    ::WebKitWebResource*,
+    ::GError*,
+    Tab*
+  );
+  static void index_page_content(Tab*);
+  static void record_cache_usage(Tab*);
+
+  // Maximum number of characters of page text which are indexed for
+  // full-text history search.
+  static const int MAX_INDEXED_TEXT_LENGTH = 256 * 1024;
+
+  // Error code of WebKit policy errors for requests blocked by the content
+  // filter. It's missing from the public WebKitPolicyError enumeration.
+  static const int POLICY_ERROR_BLOCKED_BY_CONTENT_FILTER = 104;
+
+  // Maximum number of resources whose timing is recorded for each tab.
+  static const std::size_t RESOURCE_LOG_CAPACITY = 1024;
+
+  static ::guint last_tab_id = 0;
+
+  static metrics::Counter page_loads_started(
+    "selain_page_loads_started",
+    "Page loads started by tabs."
+  );
+  static metrics::Histogram page_load_time(
+    "selain_page_load_seconds",
+    "Time from request of the main resource until the page has loaded."
+  );
+  static metrics::Histogram script_round_trip_time(
+    "selain_script_round_trip_seconds",
+    "Time until result of a script run in a page has been received."
+  );
+
+  /**
+   * Wraps callback of a script run in a page, so that the time it takes to
+   * receive the result can be measured.
+   */
+  struct ScriptRequest
+  {
+    std::int64_t started;
+    ::GAsyncReadyCallback callback;
+    ::gpointer user_data;
+  };
+
+  static void on_script_finished(
+    ::GObject* source_object,
+    ::GAsyncResult* result,
+    ::gpointer data
+  );
 
   namespace keyboard
   {
@@ -66,13 +127,20 @@ namespace selain
 
   Tab::Tab(const Glib::RefPtr<WebContext>& context,
            const Glib::RefPtr<WebSettings>& settings)
-    : m_web_view(context->create_web_view())
+    : m_id(++last_tab_id)
+    , m_resource_log(RESOURCE_LOG_CAPACITY)
+    , m_label_text("Untitled")
+    , m_web_context(context)
+    , m_profile(settings->get_profile())
+    , m_web_view(context->create_web_view())
     , m_web_view_widget(Glib::wrap(GTK_WIDGET(m_web_view)))
+    , m_find_forwards(true)
+    , m_find_regex(false)
+    , m_find_complete(true)
+    , m_find_match_index(0)
+    , m_find_match_count(0)
+    , m_blocked_count(0)
   {
-    m_tab_label.signal_close_button_clicked().connect(sigc::mem_fun(
-      this,
-      &Tab::on_close_button_clicked
-    ));
     ::g_signal_connect(
       G_OBJECT(m_web_view),
       "load-changed",
@@ -85,6 +153,12 @@ namespace selain
       G_CALLBACK(on_decide_policy),
       static_cast<::gpointer>(this)
     );
+    ::g_signal_connect(
+      G_OBJECT(m_web_view),
+      "resource-load-started",
+      G_CALLBACK(on_resource_load_started),
+      static_cast<::gpointer>(this)
+    );
     ::g_signal_connect(
       G_OBJECT(m_web_view),
       "mouse-target-changed",
@@ -110,7 +184,19 @@ namespace selain
       static_cast<::gpointer>(this)
     );
 
-    add(*m_web_view_widget.get());
+    // Snapshot of the tab is displayed in an overlay above the web view
+    // while the web view catches up after being switched to. Input goes
+    // through it to the web view.
+    m_snapshot_area.set_no_show_all(true);
+    m_snapshot_area.signal_draw().connect(
+      sigc::mem_fun(this, &Tab::on_snapshot_draw)
+    );
+    m_overlay.add(*m_web_view_widget.get());
+    m_overlay.add_overlay(m_snapshot_area);
+    m_overlay.set_overlay_pass_through(m_snapshot_area, true);
+    m_web_view_widget->show();
+    m_overlay.show();
+    add(m_overlay);
 
     override_background_color(theme::window_background);
     ::webkit_web_view_set_background_color(
@@ -118,7 +204,10 @@ namespace selain
       theme::window_background.gobj()
     );
 
-    settings->install(m_web_view);
+    install_web_settings(settings);
+
+    initialize_find();
+    initialize_performance_observer();
   }
 
   void
@@ -164,6 +253,57 @@ namespace selain
     return uri;
   }
 
+  void
+  Tab::set_profile(SettingsProfile profile)
+  {
+    m_profile = profile;
+    update_web_settings(get_uri());
+    if (!get_uri().empty())
+    {
+      reload();
+    }
+  }
+
+  void
+  Tab::update_web_settings(const Glib::ustring& uri)
+  {
+    const auto window = get_main_window();
+
+    if (window)
+    {
+      const auto settings = window->get_web_settings(uri, m_profile);
+
+      if (settings != m_web_settings)
+      {
+        install_web_settings(settings);
+      }
+    }
+  }
+
+  void
+  Tab::install_web_settings(const Glib::RefPtr<WebSettings>& settings)
+  {
+    m_web_settings = settings;
+    settings->install(m_web_view);
+    m_web_context->set_lite(
+      m_web_view,
+      settings->get_profile() == SettingsProfile::LITE
+    );
+  }
+
+  Glib::ustring
+  Tab::get_title() const
+  {
+    const auto title = ::webkit_web_view_get_title(m_web_view);
+
+    if (!title || !*title)
+    {
+      return Glib::ustring();
+    }
+
+    return title;
+  }
+
   void
   Tab::load_uri(const Glib::ustring& uri)
   {
@@ -173,9 +313,11 @@ namespace selain
     }
     if (auto scheme = ::g_uri_parse_scheme(uri.c_str()))
     {
+      update_web_settings(uri);
       ::webkit_web_view_load_uri(m_web_view, uri.c_str());
       ::g_free(scheme);
     } else {
+      update_web_settings("http://" + uri);
       ::webkit_web_view_load_uri(m_web_view, ("http://" + uri).c_str());
     }
   }
@@ -203,15 +345,52 @@ namespace selain
                       ::GAsyncReadyCallback callback,
                       void* user_data)
   {
+    if (!callback)
+    {
+      ::webkit_web_view_run_javascript(
+        m_web_view,
+        script.c_str(),
+        cancellable,
+        nullptr,
+        nullptr
+      );
+      return;
+    }
     ::webkit_web_view_run_javascript(
       m_web_view,
       script.c_str(),
       cancellable,
-      callback,
-      static_cast<::gpointer>(user_data)
+      on_script_finished,
+      new ScriptRequest{
+        ::g_get_monotonic_time(),
+        callback,
+        static_cast<::gpointer>(user_data)
+      }
     );
   }
 
+  static void
+  on_script_finished(::GObject* source_object,
+                     ::GAsyncResult* result,
+                     ::gpointer data)
+  {
+    const auto request = static_cast<ScriptRequest*>(data);
+    const auto finished = ::g_get_monotonic_time();
+    const trace::Span span("run-javascript-callback");
+
+    script_round_trip_time.observe(finished - request->started);
+    if (trace::is_enabled())
+    {
+      trace::record(
+        "run-javascript",
+        request->started,
+        finished - request->started
+      );
+    }
+    request->callback(source_object, result, request->user_data);
+    delete request;
+  }
+
   void
   Tab::go_back()
   {
@@ -224,42 +403,110 @@ namespace selain
     ::webkit_web_view_go_forward(m_web_view);
   }
 
-  void
-  Tab::search(const Glib::ustring& text, bool forwards)
+  std::string
+  Tab::get_session_state() const
   {
-    auto controller = ::webkit_web_view_get_find_controller(m_web_view);
-    ::guint32 options = WEBKIT_FIND_OPTIONS_CASE_INSENSITIVE;
+    const auto state = ::webkit_web_view_get_session_state(m_web_view);
+    const auto bytes = ::webkit_web_view_session_state_serialize(state);
+    ::gsize size = 0;
+    const auto data = ::g_bytes_get_data(bytes, &size);
+    std::string result(static_cast<const char*>(data), size);
+
+    ::g_bytes_unref(bytes);
+    ::webkit_web_view_session_state_unref(state);
+
+    return result;
+  }
 
-    if (text.empty())
+  namespace
+  {
+    struct ScrollRestore
     {
-      return;
-    }
-    if (!forwards)
+      int x;
+      int y;
+      ::gulong handler_id;
+    };
+  }
+
+  static void
+  free_scroll_restore(::gpointer data, ::GClosure*)
+  {
+    delete static_cast<ScrollRestore*>(data);
+  }
+
+  static void
+  on_restored_load_changed(::WebKitWebView* web_view,
+                           ::WebKitLoadEvent load_event,
+                           ScrollRestore* restore)
+  {
+    if (load_event != WEBKIT_LOAD_FINISHED)
     {
-      options |= WEBKIT_FIND_OPTIONS_BACKWARDS;
+      return;
     }
-    ::webkit_find_controller_search(
-      controller,
-      text.c_str(),
-      options,
-      150
+    ::webkit_web_view_run_javascript(
+      web_view,
+      Glib::ustring::compose(
+        "window.scrollTo(%1, %2);",
+        restore->x,
+        restore->y
+      ).c_str(),
+      nullptr,
+      nullptr,
+      nullptr
     );
+    // Also frees the restore data.
+    ::g_signal_handler_disconnect(web_view, restore->handler_id);
   }
 
   void
-  Tab::search_next()
+  Tab::restore_session_state(const std::string& session_state,
+                             const Glib::ustring& uri,
+                             int scroll_x,
+                             int scroll_y)
   {
-    ::webkit_find_controller_search_next(
-      ::webkit_web_view_get_find_controller(m_web_view)
+    const auto bytes = ::g_bytes_new(
+      session_state.data(),
+      session_state.length()
     );
+    const auto state = ::webkit_web_view_session_state_new(bytes);
+    ::WebKitBackForwardListItem* item = nullptr;
+
+    ::g_bytes_unref(bytes);
+    if (state)
+    {
+      ::webkit_web_view_restore_session_state(m_web_view, state);
+      ::webkit_web_view_session_state_unref(state);
+      item = ::webkit_back_forward_list_get_current_item(
+        ::webkit_web_view_get_back_forward_list(m_web_view)
+      );
+    }
+    if (!item)
+    {
+      load_uri(uri);
+      return;
+    }
+    if (scroll_x > 0 || scroll_y > 0)
+    {
+      const auto restore = new ScrollRestore{ scroll_x, scroll_y, 0 };
+
+      restore->handler_id = ::g_signal_connect_data(
+        G_OBJECT(m_web_view),
+        "load-changed",
+        G_CALLBACK(on_restored_load_changed),
+        static_cast<::gpointer>(restore),
+        free_scroll_restore,
+        static_cast<::GConnectFlags>(0)
+      );
+    }
+    update_web_settings(::webkit_back_forward_list_item_get_uri(item));
+    ::webkit_web_view_go_to_back_forward_list_item(m_web_view, item);
   }
 
   void
-  Tab::search_prev()
+  Tab::set_blocked_count(::guint count)
   {
-    ::webkit_find_controller_search_previous(
-      ::webkit_web_view_get_find_controller(m_web_view)
-    );
+    m_blocked_count = count;
+    m_signal_blocked_count_changed.emit(this, count);
   }
 
   void
@@ -275,6 +522,74 @@ namespace selain
     }
   }
 
+  void
+  Tab::show_snapshot(const Cairo::RefPtr<Cairo::ImageSurface>& snapshot)
+  {
+    if (!snapshot)
+    {
+      hide_snapshot();
+      return;
+    }
+    m_snapshot_idle_connection.disconnect();
+    m_snapshot = snapshot;
+    m_snapshot_area.show();
+    m_snapshot_area.queue_draw();
+
+    // A page which is still loading would be repainted with partial
+    // content, so it's snapshot is kept until the load-changed signal
+    // tells that the page has finished loading.
+    if (!::webkit_web_view_is_loading(m_web_view)
+        && !m_web_view_draw_connection.connected())
+    {
+      m_web_view_draw_connection = m_web_view_widget->signal_draw().connect(
+        sigc::mem_fun(this, &Tab::on_web_view_draw),
+        true
+      );
+    }
+  }
+
+  void
+  Tab::hide_snapshot()
+  {
+    m_web_view_draw_connection.disconnect();
+    m_snapshot_idle_connection.disconnect();
+    if (m_snapshot)
+    {
+      m_snapshot.reset();
+      m_snapshot_area.hide();
+    }
+  }
+
+  bool
+  Tab::on_snapshot_draw(const Cairo::RefPtr<Cairo::Context>& cr)
+  {
+    if (m_snapshot)
+    {
+      const auto scale = static_cast<double>(
+        m_snapshot_area.get_allocated_width()
+      ) / m_snapshot->get_width();
+
+      cr->scale(scale, scale);
+      cr->set_source(m_snapshot, 0, 0);
+      cr->paint();
+    }
+
+    return true;
+  }
+
+  bool
+  Tab::on_web_view_draw(const Cairo::RefPtr<Cairo::Context>&)
+  {
+    // The web view has painted itself. Widgets cannot be hidden while they
+    // are being drawn, so the snapshot is removed once the frame is done.
+    m_web_view_draw_connection.disconnect();
+    m_snapshot_idle_connection = Glib::signal_idle().connect(
+      sigc::bind_return(sigc::mem_fun(this, &Tab::hide_snapshot), false)
+    );
+
+    return false;
+  }
+
   const Glib::ustring&
   Tab::get_status() const
   {
@@ -303,12 +618,17 @@ namespace selain
   }
 
   void
-  Tab::on_close_button_clicked()
+  Tab::set_label_text(const Glib::ustring& text)
   {
-    if (const auto window = get_main_window())
-    {
-      window->close_tab(*this);
-    }
+    m_label_text = text;
+    m_signal_label_changed.emit(this);
+  }
+
+  void
+  Tab::set_icon(const Glib::RefPtr<Gdk::Pixbuf>& icon)
+  {
+    m_icon = icon;
+    m_signal_label_changed.emit(this);
   }
 
   static void
@@ -316,21 +636,45 @@ namespace selain
                   ::WebKitLoadEvent load_event,
                   Tab* tab)
   {
+    static const char* phase_names[] =
+    {
+      "load-started",
+      "load-redirected",
+      "load-committed",
+      "load-finished",
+    };
+    const trace::Span span(phase_names[load_event]);
+
     switch (load_event)
     {
       case WEBKIT_LOAD_STARTED:
-        tab->get_tab_label().set_text("Loading\xe2\x80\xa6");
+        page_loads_started.increment();
+        // Previous page is still loaded until the new one is committed.
+        tab->report_performance();
+        tab->search_finish();
+        tab->set_blocked_count(0);
+        tab->set_label_text("Loading\xe2\x80\xa6");
+        if (const auto window = tab->get_main_window())
+        {
+          // Background fetching of the read-later queue yields to pages the
+          // user is actually waiting for.
+          window->get_read_later().pause();
+        }
         if (auto uri = ::webkit_web_view_get_uri(web_view))
         {
+          // Navigations started by the page itself are matched against the
+          // site rules here, before the load is committed.
+          tab->update_web_settings(uri);
           tab->set_status(uri, true);
           tab->set_status(Glib::ustring("Loading ") + uri + U'\u2026');
         }
         break;
 
       case WEBKIT_LOAD_REDIRECTED:
-        tab->get_tab_label().set_text("Redirecting\xe2\x80\xa6");
+        tab->set_label_text("Redirecting\xe2\x80\xa6");
         if (auto uri = ::webkit_web_view_get_uri(web_view))
         {
+          tab->update_web_settings(uri);
           tab->set_status(Glib::ustring("Redirecting to ") + uri + U'\u2026');
         }
         break;
@@ -338,16 +682,228 @@ namespace selain
       case WEBKIT_LOAD_COMMITTED:
         if (auto uri = ::webkit_web_view_get_uri(web_view))
         {
+          const auto window = tab->get_main_window();
+
           tab->set_status(uri, true);
+          // Internal pages are not recorded into the browsing history.
+          if (window && std::strncmp(uri, "selain:", 7))
+          {
+            window->get_history().add_visit(uri);
+          }
         }
         break;
 
       case WEBKIT_LOAD_FINISHED:
+        tab->hide_snapshot();
         tab->set_status(Glib::ustring());
+        tab->get_resource_log().set_page_finished();
+        page_load_time.observe(
+          tab->get_resource_log().get_page_finished()
+          - tab->get_resource_log().get_page_started()
+        );
+        if (trace::is_enabled())
+        {
+          trace::record(
+            "page-load",
+            tab->get_resource_log().get_page_started(),
+            tab->get_resource_log().get_page_finished()
+            - tab->get_resource_log().get_page_started()
+          );
+        }
+        index_page_content(tab);
+        record_cache_usage(tab);
         break;
     }
   }
 
+  static void
+  on_resource_load_started(::WebKitWebView* web_view,
+                           ::WebKitWebResource* resource,
+                           ::WebKitURIRequest* request,
+                           Tab* tab)
+  {
+    auto& resource_log = tab->get_resource_log();
+
+    // Main resource of a page is requested before the page is committed,
+    // so the recording for a new page is started from here rather than from
+    // the load-changed signal.
+    if (resource == ::webkit_web_view_get_main_resource(web_view))
+    {
+      resource_log.clear();
+    }
+    resource_log.add(resource, request);
+    ::g_signal_connect(
+      G_OBJECT(resource),
+      "failed",
+      G_CALLBACK(on_resource_failed),
+      static_cast<::gpointer>(tab)
+    );
+    if (const auto window = tab->get_main_window())
+    {
+      window->get_web_context()->get_disk_cache().record_access(
+        ::webkit_uri_request_get_uri(request)
+      );
+    }
+  }
+
+  static void
+  on_resource_failed(::WebKitWebResource*, ::GError* error, Tab* tab)
+  {
+    if (error->domain == WEBKIT_POLICY_ERROR &&
+        error->code == POLICY_ERROR_BLOCKED_BY_CONTENT_FILTER)
+    {
+      tab->set_blocked_count(tab->get_blocked_count() + 1);
+    }
+  }
+
+  namespace
+  {
+    struct IndexRequest
+    {
+      TextIndex* index;
+      std::string uri;
+      std::string title;
+    };
+  }
+
+  static void
+  on_page_content_received(::GObject* web_view_object,
+                           ::GAsyncResult* result,
+                           ::gpointer data)
+  {
+    const auto request = static_cast<IndexRequest*>(data);
+    ::GError* error = nullptr;
+    const auto js_result = ::webkit_web_view_run_javascript_finish(
+      WEBKIT_WEB_VIEW(web_view_object),
+      result,
+      &error
+    );
+
+    if (js_result)
+    {
+      const auto value = ::webkit_javascript_result_get_js_value(js_result);
+
+      if (::jsc_value_is_string(value))
+      {
+        const auto text = ::jsc_value_to_string(value);
+
+        request->index->add_document(request->uri, request->title, text);
+        ::g_free(text);
+      }
+      ::webkit_javascript_result_unref(js_result);
+    } else {
+      ::g_error_free(error);
+    }
+    delete request;
+  }
+
+  /**
+   * Extracts text content of the page loaded in given tab and passes it to
+   * the full-text index of the browsing history. Tokenization and indexing
+   * are done in a background thread.
+   */
+  static void
+  index_page_content(Tab* tab)
+  {
+    const auto window = tab->get_main_window();
+    const auto uri = tab->get_uri();
+
+    if (!window || (
+      uri.compare(0, 7, "http://") && uri.compare(0, 8, "https://")
+    ))
+    {
+      return;
+    }
+    tab->execute_script(
+      Glib::ustring::compose(
+        "(function () {"
+        "  var body = document.body;"
+        "  return body ? body.innerText.slice(0, %1) : '';"
+        "})();",
+        MAX_INDEXED_TEXT_LENGTH
+      ),
+      nullptr,
+      on_page_content_received,
+      new IndexRequest{ &window->get_text_index(), uri, tab->get_title() }
+    );
+  }
+
+  static void
+  on_cache_usage_received(::GObject* web_view_object,
+                          ::GAsyncResult* result,
+                          ::gpointer data)
+  {
+    const auto cache = static_cast<DiskCache*>(data);
+    ::GError* error = nullptr;
+    const auto js_result = ::webkit_web_view_run_javascript_finish(
+      WEBKIT_WEB_VIEW(web_view_object),
+      result,
+      &error
+    );
+
+    if (js_result)
+    {
+      const auto value = ::webkit_javascript_result_get_js_value(js_result);
+
+      if (::jsc_value_is_string(value))
+      {
+        const auto text = ::jsc_value_to_string(value);
+        unsigned long hits = 0;
+        unsigned long misses = 0;
+
+        if (std::sscanf(text, "%lu %lu", &hits, &misses) == 2)
+        {
+          cache->record_requests(hits, misses);
+        }
+        ::g_free(text);
+      }
+      ::webkit_javascript_result_unref(js_result);
+    } else {
+      ::g_error_free(error);
+    }
+  }
+
+  /**
+   * Counts resources of the page loaded in given tab which were served from
+   * the HTTP cache and from network, using the Resource Timing API. Resources
+   * with no transferred bytes but non-empty body came from the cache. Lite
+   * tabs are skipped, as most of their subresources are blocked.
+   */
+  static void
+  record_cache_usage(Tab* tab)
+  {
+    const auto window = tab->get_main_window();
+    const auto uri = tab->get_uri();
+
+    if (!window || tab->get_profile() == SettingsProfile::LITE || (
+      uri.compare(0, 7, "http://") && uri.compare(0, 8, "https://")
+    ))
+    {
+      return;
+    }
+    tab->execute_script(
+      "(function () {"
+      "  var hits = 0, misses = 0;"
+      "  if (!window.performance || !performance.getEntriesByType) {"
+      "    return '0 0';"
+      "  }"
+      "  ['navigation', 'resource'].forEach(function (type) {"
+      "    performance.getEntriesByType(type).forEach(function (entry) {"
+      "      if (entry.transferSize > 0) {"
+      "        ++misses;"
+      "      } else if (entry.decodedBodySize > 0) {"
+      "        ++hits;"
+      "      }"
+      "    });"
+      "  });"
+      "  return hits + ' ' + misses;"
+      "})();",
+      nullptr,
+      on_cache_usage_received,
+      &window->get_web_context()->get_disk_cache()
+    );
+  }
+
   static ::gboolean
   on_decide_policy(::WebKitWebView* web_view,
                    ::WebKitPolicyDecision* decision,
@@ -403,6 +959,36 @@ namespace selain
         ::webkit_policy_decision_ignore(decision);
       }
     }
+    // Download responses which cannot be displayed or which the server
+    // wants to be saved. The download is taken over by the download
+    // manager of the web context.
+    else if (decision_type == WEBKIT_POLICY_DECISION_TYPE_RESPONSE)
+    {
+      auto response_decision = WEBKIT_RESPONSE_POLICY_DECISION(decision);
+      auto response = ::webkit_response_policy_decision_get_response(
+        response_decision
+      );
+      auto headers = ::webkit_uri_response_get_http_headers(response);
+      char* disposition = nullptr;
+      bool attachment = false;
+
+      if (headers && ::soup_message_headers_get_content_disposition(
+        headers,
+        &disposition,
+        nullptr
+      ))
+      {
+        attachment = !::g_ascii_strcasecmp(disposition, "attachment");
+        ::g_free(disposition);
+      }
+      if (attachment ||
+          !::webkit_response_policy_decision_is_mime_type_supported(
+            response_decision
+          ))
+      {
+        ::webkit_policy_decision_download(decision);
+      }
+    }
 
     return true;
   }
@@ -422,14 +1008,21 @@ namespace selain
   on_notify_title(::WebKitWebView* web_view, ::GParamSpec*, Tab* tab)
   {
     const auto title = ::webkit_web_view_get_title(web_view);
+    const auto uri = ::webkit_web_view_get_uri(web_view);
 
-    tab->get_tab_label().set_text(title && *title ? title : "Untitled");
+    tab->set_label_text(title && *title ? title : "Untitled");
+    if (title && *title && uri)
+    {
+      if (const auto window = tab->get_main_window())
+      {
+        window->get_history().set_title(uri, title);
+      }
+    }
   }
 
   static void
   on_notify_favicon(::WebKitWebView* web_view, ::GParamSpec*, Tab* tab)
   {
-    auto& tab_label = tab->get_tab_label();
     const auto surface = ::webkit_web_view_get_favicon(web_view);
     int width;
     int height;
@@ -444,13 +1037,13 @@ namespace selain
         ::cairo_image_surface_get_height(surface)
       );
 
-      tab_label.set_icon(pixbuf->scale_simple(
+      tab->set_icon(pixbuf->scale_simple(
         width,
         height,
         Gdk::INTERP_BILINEAR
       ));
     } else {
-      tab_label.set_icon(Glib::RefPtr<Gdk::Pixbuf>());
+      tab->set_icon(Glib::RefPtr<Gdk::Pixbuf>());
     }
   }
 }
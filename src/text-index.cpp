@@ -0,0 +1,1673 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/text-index.hpp>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+namespace selain
+{
+  static const char SEGMENT_MAGIC[8] =
+  {
+    'S', 'E', 'L', 'A', 'I', 'N', 'T', 'I'
+  };
+
+  // Version of the segment file format. Segments with other versions are
+  // ignored.
+  static const std::uint32_t SEGMENT_VERSION = 1;
+
+  // Number of postings between skip pointers.
+  static const std::uint32_t SKIP_INTERVAL = 128;
+
+  // The buffer is written to disk as a new segment when it contains this
+  // many pages or this many bytes of text, or when no pages have been
+  // indexed for a while.
+  static const std::size_t FLUSH_DOCUMENTS = 256;
+  static const std::size_t FLUSH_SIZE = 8 * 1024 * 1024;
+  static const std::chrono::seconds FLUSH_INTERVAL(60);
+
+  // Newest segment is merged into the one before it when it has grown to at
+  // least half of it's size, which keeps the number of segments logarithmic
+  // to the number of pages.
+  static const std::uint64_t MERGE_FACTOR = 2;
+  static const std::size_t MAX_SEGMENTS = 16;
+
+  // When the index exceeds it's disk budget, this fraction of the pages in
+  // the oldest segment is dropped at a time.
+  static const std::uint32_t BUDGET_DROP_DIVISOR = 4;
+
+  static const std::size_t MIN_TERM_LENGTH = 2;
+  static const std::size_t MAX_TERM_LENGTH = 64;
+  static const std::size_t MAX_QUERY_TERMS = 16;
+
+  // Size of the chunks in which segments are written to disk.
+  static const std::size_t WRITE_CHUNK_SIZE = 1024 * 1024;
+
+  // Parameters of the Okapi BM25 ranking function.
+  static const double BM25_K1 = 1.2;
+  static const double BM25_B = 0.75;
+
+  namespace
+  {
+    struct SegmentHeader
+    {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t document_count;
+      std::uint32_t term_count;
+      std::uint32_t skip_count;
+      /** Documents sorted by their identifier. */
+      std::uint64_t documents_offset;
+      /** Delta and varint encoded posting lists of all terms. */
+      std::uint64_t postings_offset;
+      std::uint64_t postings_length;
+      std::uint64_t skips_offset;
+      /** Terms sorted by their text. */
+      std::uint64_t terms_offset;
+      std::uint64_t strings_offset;
+      std::uint64_t strings_length;
+      /** Total number of words in all documents. */
+      std::uint64_t total_length;
+    };
+
+    struct SegmentDocument
+    {
+      std::uint32_t id;
+      /** Number of words in the document. */
+      std::uint32_t length;
+      std::uint32_t uri_offset;
+      std::uint32_t uri_length;
+      std::uint32_t title_offset;
+      std::uint32_t title_length;
+    };
+
+    struct SegmentTerm
+    {
+      std::uint32_t text_offset;
+      std::uint32_t text_length;
+      std::uint32_t document_frequency;
+      std::uint32_t skip_offset;
+      std::uint32_t skip_count;
+      std::uint32_t postings_length;
+      std::uint64_t postings_offset;
+    };
+
+    /**
+     * Skip pointer to the beginning of a block of postings. Contains the
+     * last document preceding the block, which is the base of the first
+     * delta in the block.
+     */
+    struct SegmentSkip
+    {
+      std::uint32_t document;
+      std::uint32_t offset;
+    };
+  }
+
+  static inline void
+  encode_varint(std::string& output, std::uint32_t value)
+  {
+    while (value >= 0x80)
+    {
+      output.append(1, static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    output.append(1, static_cast<char>(value));
+  }
+
+  static inline bool
+  decode_varint(const unsigned char*& position,
+                const unsigned char* end,
+                std::uint32_t& value)
+  {
+    value = 0;
+    for (unsigned int shift = 0; shift < 35 && position < end; shift += 7)
+    {
+      const auto byte = *position++;
+
+      value |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  static inline bool
+  is_word_char(unsigned char c)
+  {
+    return (c >= 'a' && c <= 'z')
+      || (c >= 'A' && c <= 'Z')
+      || (c >= '0' && c <= '9')
+      || c >= 0x80;
+  }
+
+  /**
+   * Splits given text into lower case words. Bytes of multibyte UTF-8
+   * sequences are treated as word characters, so words written in other
+   * than Latin alphabets are kept intact, although they are not case
+   * folded.
+   */
+  template<class Callback>
+  static void
+  tokenize(const std::string& text, Callback callback)
+  {
+    std::string term;
+
+    for (const auto c : text)
+    {
+      const auto byte = static_cast<unsigned char>(c);
+
+      if (is_word_char(byte))
+      {
+        term.append(1, static_cast<char>(
+          byte >= 'A' && byte <= 'Z' ? byte + ('a' - 'A') : byte
+        ));
+        continue;
+      }
+      if (term.length() >= MIN_TERM_LENGTH && term.length() <= MAX_TERM_LENGTH)
+      {
+        callback(term);
+      }
+      term.clear();
+    }
+    if (term.length() >= MIN_TERM_LENGTH && term.length() <= MAX_TERM_LENGTH)
+    {
+      callback(term);
+    }
+  }
+
+  template<class T>
+  static inline bool
+  is_valid_section(std::size_t length,
+                   std::uint64_t offset,
+                   std::uint64_t count)
+  {
+    return offset <= length
+      && !(offset % alignof(T))
+      && count <= (length - offset) / sizeof(T);
+  }
+
+  /**
+   * Immutable segment of the index, either mapped from a file or held in
+   * memory.
+   */
+  class TextIndexSegment
+  {
+  public:
+    static std::unique_ptr<TextIndexSegment> open(const std::string& path)
+    {
+      ::GError* error = nullptr;
+      const auto file = ::g_mapped_file_new(path.c_str(), FALSE, &error);
+      std::unique_ptr<TextIndexSegment> segment;
+
+      if (!file)
+      {
+        ::g_warning("Unable to open index segment: %s", error->message);
+        ::g_error_free(error);
+
+        return nullptr;
+      }
+      segment.reset(new TextIndexSegment(
+        path,
+        file,
+        ::g_mapped_file_get_contents(file),
+        ::g_mapped_file_get_length(file)
+      ));
+      if (!segment->is_valid())
+      {
+        ::g_warning("Ignoring invalid index segment: %s", path.c_str());
+
+        return nullptr;
+      }
+
+      return segment;
+    }
+
+    static std::unique_ptr<TextIndexSegment> create(std::string&& image)
+    {
+      std::unique_ptr<TextIndexSegment> segment(new TextIndexSegment(
+        std::string(),
+        nullptr,
+        nullptr,
+        image.length()
+      ));
+
+      segment->m_image = std::move(image);
+      segment->m_data = segment->m_image.data();
+
+      return segment->is_valid() ? std::move(segment) : nullptr;
+    }
+
+    ~TextIndexSegment()
+    {
+      if (m_file)
+      {
+        ::g_mapped_file_unref(m_file);
+      }
+    }
+
+    TextIndexSegment(const TextIndexSegment&) = delete;
+    TextIndexSegment& operator=(const TextIndexSegment&) = delete;
+
+    inline const std::string& get_path() const
+    {
+      return m_path;
+    }
+
+    inline std::size_t get_size() const
+    {
+      return m_length;
+    }
+
+    inline const SegmentHeader& get_header() const
+    {
+      return *reinterpret_cast<const SegmentHeader*>(m_data);
+    }
+
+    inline std::uint32_t get_document_count() const
+    {
+      return get_header().document_count;
+    }
+
+    inline const SegmentDocument& get_document(std::uint32_t index) const
+    {
+      return reinterpret_cast<const SegmentDocument*>(
+        m_data + get_header().documents_offset
+      )[index];
+    }
+
+    inline std::uint32_t get_term_count() const
+    {
+      return get_header().term_count;
+    }
+
+    inline const SegmentTerm& get_term(std::uint32_t index) const
+    {
+      return reinterpret_cast<const SegmentTerm*>(
+        m_data + get_header().terms_offset
+      )[index];
+    }
+
+    inline const SegmentSkip* get_skips() const
+    {
+      return reinterpret_cast<const SegmentSkip*>(
+        m_data + get_header().skips_offset
+      );
+    }
+
+    inline const unsigned char* get_postings() const
+    {
+      return reinterpret_cast<const unsigned char*>(
+        m_data + get_header().postings_offset
+      );
+    }
+
+    std::string_view get_string(std::uint32_t offset,
+                                std::uint32_t length) const
+    {
+      const auto& header = get_header();
+
+      if (static_cast<std::uint64_t>(offset) + length > header.strings_length)
+      {
+        return std::string_view();
+      }
+
+      return std::string_view(m_data + header.strings_offset + offset, length);
+    }
+
+    inline std::string_view get_term_text(const SegmentTerm& term) const
+    {
+      return get_string(term.text_offset, term.text_length);
+    }
+
+    inline std::string get_uri(const SegmentDocument& document) const
+    {
+      return std::string(get_string(
+        document.uri_offset,
+        document.uri_length
+      ));
+    }
+
+    inline std::string get_title(const SegmentDocument& document) const
+    {
+      return std::string(get_string(
+        document.title_offset,
+        document.title_length
+      ));
+    }
+
+    /**
+     * Looks up document with given identifier.
+     */
+    const SegmentDocument* find_document(std::uint32_t id) const
+    {
+      const auto begin = &get_document(0);
+      const auto end = begin + get_document_count();
+      const auto it = std::lower_bound(
+        begin,
+        end,
+        id,
+        [](const SegmentDocument& a, std::uint32_t b)
+        {
+          return a.id < b;
+        }
+      );
+
+      return it != end && it->id == id ? it : nullptr;
+    }
+
+    /**
+     * Looks up term with given text. Returns null pointer if the segment
+     * does not contain the term or if it's posting list is corrupted.
+     */
+    const SegmentTerm* find_term(const std::string& text) const
+    {
+      const auto begin = &get_term(0);
+      const auto end = begin + get_term_count();
+      const auto it = std::lower_bound(
+        begin,
+        end,
+        text,
+        [this](const SegmentTerm& a, const std::string& b)
+        {
+          return get_term_text(a) < b;
+        }
+      );
+
+      if (it == end || get_term_text(*it) != text || !is_valid_term(*it))
+      {
+        return nullptr;
+      }
+
+      return it;
+    }
+
+    /**
+     * Tests whether posting list and skip pointers of given term are within
+     * bounds of the segment.
+     */
+    bool is_valid_term(const SegmentTerm& term) const
+    {
+      const auto& header = get_header();
+
+      return term.postings_offset + term.postings_length
+          <= header.postings_length
+        && static_cast<std::uint64_t>(term.skip_offset) + term.skip_count
+          <= header.skip_count;
+    }
+
+  private:
+    explicit TextIndexSegment(const std::string& path,
+                              ::GMappedFile* file,
+                              const char* data,
+                              std::size_t length)
+      : m_path(path)
+      , m_file(file)
+      , m_data(data)
+      , m_length(length) {}
+
+    bool is_valid() const
+    {
+      const SegmentHeader* header;
+
+      if (!m_data || m_length < sizeof(SegmentHeader))
+      {
+        return false;
+      }
+      header = &get_header();
+
+      return !std::memcmp(
+        header->magic,
+        SEGMENT_MAGIC,
+        sizeof(SEGMENT_MAGIC)
+      )
+        && header->version == SEGMENT_VERSION
+        && is_valid_section<SegmentDocument>(
+          m_length,
+          header->documents_offset,
+          header->document_count
+        )
+        && is_valid_section<char>(
+          m_length,
+          header->postings_offset,
+          header->postings_length
+        )
+        && is_valid_section<SegmentSkip>(
+          m_length,
+          header->skips_offset,
+          header->skip_count
+        )
+        && is_valid_section<SegmentTerm>(
+          m_length,
+          header->terms_offset,
+          header->term_count
+        )
+        && is_valid_section<char>(
+          m_length,
+          header->strings_offset,
+          header->strings_length
+        );
+    }
+
+  private:
+    const std::string m_path;
+    ::GMappedFile* m_file;
+    std::string m_image;
+    const char* m_data;
+    const std::size_t m_length;
+  };
+
+  /**
+   * Iterates posting list of a single term in a segment.
+   */
+  class PostingIterator
+  {
+  public:
+    explicit PostingIterator(const TextIndexSegment& segment,
+                             const SegmentTerm& term)
+      : m_begin(segment.get_postings() + term.postings_offset)
+      , m_position(m_begin)
+      , m_end(m_begin + term.postings_length)
+      , m_skips(segment.get_skips() + term.skip_offset)
+      , m_skip_count(term.skip_count)
+      , m_document(0)
+      , m_frequency(0)
+      , m_valid(true)
+    {
+      next();
+    }
+
+    inline bool is_valid() const
+    {
+      return m_valid;
+    }
+
+    inline std::uint32_t get_document() const
+    {
+      return m_document;
+    }
+
+    inline std::uint32_t get_frequency() const
+    {
+      return m_frequency;
+    }
+
+    bool next()
+    {
+      std::uint32_t delta;
+
+      if (!m_valid
+          || !decode_varint(m_position, m_end, delta)
+          || !decode_varint(m_position, m_end, m_frequency))
+      {
+        return m_valid = false;
+      }
+      m_document += delta;
+
+      return true;
+    }
+
+    /**
+     * Advances to the first document which is equal to or greater than
+     * given document, skipping whole blocks of postings when possible.
+     */
+    bool advance(std::uint32_t target)
+    {
+      const SegmentSkip* skip;
+
+      if (!m_valid || m_document >= target)
+      {
+        return m_valid;
+      }
+      skip = std::lower_bound(
+        m_skips,
+        m_skips + m_skip_count,
+        target,
+        [](const SegmentSkip& a, std::uint32_t b)
+        {
+          return a.document < b;
+        }
+      );
+      if (skip != m_skips)
+      {
+        --skip;
+        if (skip->offset <= static_cast<std::size_t>(m_end - m_begin)
+            && m_begin + skip->offset > m_position)
+        {
+          m_position = m_begin + skip->offset;
+          m_document = skip->document;
+          next();
+        }
+      }
+      while (m_valid && m_document < target)
+      {
+        next();
+      }
+
+      return m_valid;
+    }
+
+  private:
+    const unsigned char* const m_begin;
+    const unsigned char* m_position;
+    const unsigned char* const m_end;
+    const SegmentSkip* const m_skips;
+    const std::uint32_t m_skip_count;
+    std::uint32_t m_document;
+    std::uint32_t m_frequency;
+    bool m_valid;
+  };
+
+  /**
+   * Writes a new segment, either into a file or into memory. All documents
+   * must be added before the terms, and the terms must be added in sorted
+   * order.
+   */
+  class TextIndexSegmentWriter
+  {
+  public:
+    explicit TextIndexSegmentWriter(std::FILE* file = nullptr)
+      : m_file(file)
+      , m_offset(0)
+      , m_failed(false)
+      , m_document_count(0)
+      , m_total_length(0)
+      , m_postings_offset(0)
+      , m_term_started(false)
+    {
+      SegmentHeader header;
+
+      std::memset(&header, 0, sizeof(header));
+      write(&header, sizeof(header));
+    }
+
+    void add_document(std::uint32_t id,
+                      std::uint32_t length,
+                      const std::string& uri,
+                      const std::string& title)
+    {
+      const SegmentDocument document =
+      {
+        id,
+        length,
+        add_string(uri),
+        static_cast<std::uint32_t>(uri.length()),
+        add_string(title),
+        static_cast<std::uint32_t>(title.length())
+      };
+
+      write(&document, sizeof(document));
+      ++m_document_count;
+      m_total_length += length;
+    }
+
+    void begin_term(const std::string& text)
+    {
+      if (!m_term_started)
+      {
+        m_term_started = true;
+        m_postings_offset = m_offset;
+      }
+      m_term_text = text;
+      m_term = {
+        0,
+        static_cast<std::uint32_t>(text.length()),
+        0,
+        static_cast<std::uint32_t>(m_skips.size()),
+        0,
+        0,
+        m_offset - m_postings_offset
+      };
+      m_last_document = 0;
+    }
+
+    void add_posting(std::uint32_t document, std::uint32_t frequency)
+    {
+      const auto term_offset = m_offset - m_postings_offset
+        - m_term.postings_offset;
+
+      if (m_term.document_frequency
+          && !(m_term.document_frequency % SKIP_INTERVAL))
+      {
+        m_skips.push_back({
+          m_last_document,
+          static_cast<std::uint32_t>(term_offset)
+        });
+        ++m_term.skip_count;
+      }
+      m_encoded.clear();
+      encode_varint(m_encoded, document - m_last_document);
+      encode_varint(m_encoded, frequency);
+      write(m_encoded.data(), m_encoded.length());
+      m_last_document = document;
+      ++m_term.document_frequency;
+    }
+
+    void end_term()
+    {
+      if (!m_term.document_frequency)
+      {
+        return;
+      }
+      m_term.text_offset = add_string(m_term_text);
+      m_term.postings_length = static_cast<std::uint32_t>(
+        m_offset - m_postings_offset - m_term.postings_offset
+      );
+      m_terms.push_back(m_term);
+    }
+
+    /**
+     * Writes rest of the segment. When writing into memory, the segment is
+     * stored into given string.
+     */
+    bool finish(std::string* image = nullptr)
+    {
+      SegmentHeader header;
+
+      std::memset(&header, 0, sizeof(header));
+      std::memcpy(header.magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+      header.version = SEGMENT_VERSION;
+      header.document_count = m_document_count;
+      header.term_count = static_cast<std::uint32_t>(m_terms.size());
+      header.skip_count = static_cast<std::uint32_t>(m_skips.size());
+      header.documents_offset = sizeof(SegmentHeader);
+      header.postings_offset = m_term_started ? m_postings_offset : m_offset;
+      header.postings_length = m_offset - header.postings_offset;
+      align(alignof(std::uint64_t));
+      header.skips_offset = m_offset;
+      write(m_skips.data(), m_skips.size() * sizeof(SegmentSkip));
+      align(alignof(std::uint64_t));
+      header.terms_offset = m_offset;
+      write(m_terms.data(), m_terms.size() * sizeof(SegmentTerm));
+      header.strings_offset = m_offset;
+      header.strings_length = m_strings.length();
+      write(m_strings.data(), m_strings.length());
+      header.total_length = m_total_length;
+      if (m_strings.length() > std::numeric_limits<std::uint32_t>::max())
+      {
+        m_failed = true;
+      }
+
+      if (!m_file)
+      {
+        std::memcpy(&m_buffer[0], &header, sizeof(header));
+        if (image)
+        {
+          *image = std::move(m_buffer);
+        }
+
+        return !m_failed;
+      }
+      flush_buffer();
+
+      return !m_failed
+        && !std::fseek(m_file, 0, SEEK_SET)
+        && std::fwrite(&header, sizeof(header), 1, m_file) == 1
+        && !std::fflush(m_file)
+        && !::fsync(::fileno(m_file));
+    }
+
+  private:
+    void write(const void* data, std::size_t length)
+    {
+      m_buffer.append(static_cast<const char*>(data), length);
+      m_offset += length;
+      if (m_file && m_buffer.length() >= WRITE_CHUNK_SIZE)
+      {
+        flush_buffer();
+      }
+    }
+
+    void align(std::size_t alignment)
+    {
+      static const char padding[8] = { 0 };
+
+      if (m_offset % alignment)
+      {
+        write(padding, alignment - m_offset % alignment);
+      }
+    }
+
+    void flush_buffer()
+    {
+      if (!m_buffer.empty() && std::fwrite(
+        m_buffer.data(),
+        1,
+        m_buffer.length(),
+        m_file
+      ) != m_buffer.length())
+      {
+        m_failed = true;
+      }
+      m_buffer.clear();
+    }
+
+    std::uint32_t add_string(const std::string& input)
+    {
+      const auto offset = static_cast<std::uint32_t>(m_strings.length());
+
+      m_strings.append(input);
+
+      return offset;
+    }
+
+  private:
+    std::FILE* m_file;
+    std::string m_buffer;
+    std::uint64_t m_offset;
+    bool m_failed;
+    std::uint32_t m_document_count;
+    std::uint64_t m_total_length;
+    std::uint64_t m_postings_offset;
+    bool m_term_started;
+    std::string m_term_text;
+    SegmentTerm m_term;
+    std::uint32_t m_last_document;
+    std::string m_encoded;
+    std::vector<SegmentSkip> m_skips;
+    std::vector<SegmentTerm> m_terms;
+    std::string m_strings;
+  };
+
+  static inline bool
+  compare_results(const TextSearchResult& a, const TextSearchResult& b)
+  {
+    return a.score > b.score;
+  }
+
+  TextIndex::TextIndex()
+    : m_disk_budget(0)
+    , m_next_generation(0)
+    , m_next_document(0)
+    , m_buffer_size(0)
+    , m_loaded(false)
+    , m_running(false)
+  {
+    m_dispatcher.connect(
+      sigc::mem_fun(this, &TextIndex::on_search_finished)
+    );
+  }
+
+  TextIndex::~TextIndex()
+  {
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      m_running = false;
+    }
+    m_condition.notify_one();
+    if (m_thread.joinable())
+    {
+      m_thread.join();
+    }
+  }
+
+  void
+  TextIndex::open(const std::string& directory, std::uint64_t disk_budget)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    if (m_running)
+    {
+      return;
+    }
+    m_directory = directory;
+    m_disk_budget = disk_budget;
+    m_running = true;
+    m_thread = std::thread(&TextIndex::run, this);
+  }
+
+  void
+  TextIndex::add_document(const std::string& uri,
+                          const std::string& title,
+                          const std::string& text)
+  {
+    // Pages are queued even before open(), as the index is opened only
+    // after the window has been displayed.
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      m_queue.push_back({ uri, title, text });
+    }
+    m_condition.notify_one();
+  }
+
+  void
+  TextIndex::search(const std::string& query,
+                    std::size_t limit,
+                    const search_callback_type& callback)
+  {
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      m_searches.push_back({ query, limit, callback });
+    }
+    m_condition.notify_one();
+  }
+
+  void
+  TextIndex::run()
+  {
+    load();
+
+    for (;;)
+    {
+      PendingSearch search;
+      PendingDocument document;
+      bool has_search = false;
+      bool has_document = false;
+
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_condition.wait_for(lock, FLUSH_INTERVAL, [this]()
+        {
+          return !m_running || !m_queue.empty() || !m_searches.empty();
+        });
+
+        // Searches are processed before indexing, since someone is waiting
+        // for them.
+        if (!m_searches.empty())
+        {
+          search = std::move(m_searches.front());
+          m_searches.pop_front();
+          has_search = true;
+        }
+        else if (!m_queue.empty())
+        {
+          document = std::move(m_queue.front());
+          m_queue.pop_front();
+          has_document = true;
+        }
+        else if (!m_running)
+        {
+          break;
+        }
+      }
+
+      if (has_search)
+      {
+        FinishedSearch finished;
+
+        finished.callback = std::move(search.callback);
+        if (m_loaded)
+        {
+          finished.results = execute_search(search.query, search.limit);
+        } else {
+          finished.error = "Unable to open the full-text index.";
+        }
+        {
+          std::lock_guard<std::mutex> guard(m_mutex);
+
+          m_results.push_back(std::move(finished));
+        }
+        m_dispatcher.emit();
+      }
+      else if (has_document)
+      {
+        index_document(document);
+        if (m_buffer_documents.size() >= FLUSH_DOCUMENTS
+            || m_buffer_size >= FLUSH_SIZE)
+        {
+          flush();
+        }
+      } else {
+        flush();
+      }
+    }
+
+    flush();
+  }
+
+  void
+  TextIndex::on_search_finished()
+  {
+    std::deque<FinishedSearch> results;
+
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      results.swap(m_results);
+    }
+    for (const auto& finished : results)
+    {
+      finished.callback(finished.results, finished.error);
+    }
+  }
+
+  void
+  TextIndex::load()
+  {
+    struct Candidate
+    {
+      std::uint32_t generation;
+      std::string path;
+    };
+    std::vector<Candidate> candidates;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> ranges;
+    ::GDir* dir;
+    const char* name;
+
+    if (::g_mkdir_with_parents(m_directory.c_str(), 0700)
+        || !(dir = ::g_dir_open(m_directory.c_str(), 0, nullptr)))
+    {
+      ::g_warning("Unable to open index directory: %s", m_directory.c_str());
+      return;
+    }
+    m_loaded = true;
+    while ((name = ::g_dir_read_name(dir)))
+    {
+      const auto path = ::g_build_filename(
+        m_directory.c_str(),
+        name,
+        nullptr
+      );
+      char* end;
+      unsigned long generation;
+
+      if (!std::strncmp(name, "segment-", 8))
+      {
+        generation = std::strtoul(name + 8, &end, 16);
+        if (!*end)
+        {
+          candidates.push_back({
+            static_cast<std::uint32_t>(generation),
+            path
+          });
+        }
+        else if (!std::strcmp(end, ".tmp"))
+        {
+          // Left behind by an interrupted write.
+          ::g_unlink(path);
+        }
+      }
+      ::g_free(path);
+    }
+    ::g_dir_close(dir);
+
+    // Inputs of a merge are deleted only after the merged segment has been
+    // written, so an interrupted merge can leave both behind. Newer segments
+    // take precedence over older ones containing the same pages.
+    std::sort(
+      std::begin(candidates),
+      std::end(candidates),
+      [](const Candidate& a, const Candidate& b)
+      {
+        return a.generation > b.generation;
+      }
+    );
+    for (const auto& candidate : candidates)
+    {
+      auto segment = TextIndexSegment::open(candidate.path);
+      std::uint32_t first;
+      std::uint32_t last;
+
+      m_next_generation = std::max(
+        m_next_generation,
+        candidate.generation + 1
+      );
+      if (!segment || !segment->get_document_count())
+      {
+        segment.reset();
+        ::g_unlink(candidate.path.c_str());
+        continue;
+      }
+      first = segment->get_document(0).id;
+      last = segment->get_document(segment->get_document_count() - 1).id;
+      if (std::any_of(
+        std::begin(ranges),
+        std::end(ranges),
+        [first, last](const std::pair<std::uint32_t, std::uint32_t>& range)
+        {
+          return first <= range.second && range.first <= last;
+        }
+      ))
+      {
+        segment.reset();
+        ::g_unlink(candidate.path.c_str());
+        continue;
+      }
+      ranges.emplace_back(first, last);
+      m_next_document = std::max(m_next_document, last + 1);
+      m_segments.push_back(std::move(segment));
+    }
+
+    // Segments are kept in order of the documents they contain.
+    std::sort(
+      std::begin(m_segments),
+      std::end(m_segments),
+      [](const std::unique_ptr<TextIndexSegment>& a,
+         const std::unique_ptr<TextIndexSegment>& b)
+      {
+        return a->get_document(0).id < b->get_document(0).id;
+      }
+    );
+    for (const auto& segment : m_segments)
+    {
+      const auto count = segment->get_document_count();
+
+      for (std::uint32_t i = 0; i < count; ++i)
+      {
+        const auto& document = segment->get_document(i);
+
+        m_latest[segment->get_uri(document)] = document.id;
+      }
+    }
+
+    enforce_budget();
+  }
+
+  void
+  TextIndex::index_document(const PendingDocument& document)
+  {
+    std::unordered_map<std::string, std::uint32_t> frequencies;
+    std::uint32_t length = 0;
+    const auto add_term = [&frequencies, &length](const std::string& term)
+    {
+      ++frequencies[term];
+      ++length;
+    };
+    std::uint32_t id;
+
+    tokenize(document.title, add_term);
+    tokenize(document.text, add_term);
+    if (frequencies.empty())
+    {
+      return;
+    }
+    id = m_next_document++;
+    m_buffer_documents.push_back({ id, length, document.uri, document.title });
+    for (const auto& entry : frequencies)
+    {
+      m_buffer_postings[entry.first].push_back({ id, entry.second });
+    }
+    m_buffer_size += document.title.length() + document.text.length();
+    m_latest[document.uri] = id;
+  }
+
+  std::vector<TextSearchResult>
+  TextIndex::execute_search(const std::string& query, std::size_t limit)
+  {
+    std::vector<std::string> terms;
+    std::vector<const TextIndexSegment*> segments;
+    std::unique_ptr<TextIndexSegment> buffer;
+    std::vector<TextSearchResult> results;
+    std::uint64_t document_count = 0;
+    std::uint64_t total_length = 0;
+    double average_length;
+
+    tokenize(query, [&terms](const std::string& term)
+    {
+      if (terms.size() < MAX_QUERY_TERMS
+          && std::find(std::begin(terms), std::end(terms), term)
+            == std::end(terms))
+      {
+        terms.push_back(term);
+      }
+    });
+    if (terms.empty() || !limit)
+    {
+      return results;
+    }
+
+    // Pages which have not been written to disk yet are searched through
+    // an in-memory segment.
+    if (!m_buffer_documents.empty())
+    {
+      TextIndexSegmentWriter writer;
+      std::string image;
+
+      write_buffer(writer);
+      if (writer.finish(&image))
+      {
+        buffer = TextIndexSegment::create(std::move(image));
+      }
+    }
+    for (const auto& segment : m_segments)
+    {
+      segments.push_back(segment.get());
+    }
+    if (buffer)
+    {
+      segments.push_back(buffer.get());
+    }
+    for (const auto segment : segments)
+    {
+      document_count += segment->get_header().document_count;
+      total_length += segment->get_header().total_length;
+    }
+    average_length = document_count
+      ? static_cast<double>(total_length) / document_count
+      : 1.0;
+
+    const auto score_document = [&](
+      const TextIndexSegment& segment,
+      std::uint32_t id,
+      const std::vector<PostingIterator>& iterators,
+      const std::vector<double>& weights
+    )
+    {
+      const auto document = segment.find_document(id);
+      double length_ratio;
+      double score = 0.0;
+
+      if (!document || !is_live(id, segment.get_uri(*document)))
+      {
+        return;
+      }
+      length_ratio = document->length / average_length;
+      for (std::size_t i = 0; i < iterators.size(); ++i)
+      {
+        const auto frequency = static_cast<double>(
+          iterators[i].get_frequency()
+        );
+
+        score += weights[i] * frequency * (BM25_K1 + 1.0) / (
+          frequency + BM25_K1 * (1.0 - BM25_B + BM25_B * length_ratio)
+        );
+      }
+
+      // Results are kept in a heap where the result with lowest score is
+      // first.
+      if (results.size() < limit)
+      {
+        results.push_back({
+          segment.get_uri(*document),
+          segment.get_title(*document),
+          score
+        });
+        std::push_heap(
+          std::begin(results),
+          std::end(results),
+          compare_results
+        );
+      }
+      else if (score > results.front().score)
+      {
+        std::pop_heap(
+          std::begin(results),
+          std::end(results),
+          compare_results
+        );
+        results.back() = {
+          segment.get_uri(*document),
+          segment.get_title(*document),
+          score
+        };
+        std::push_heap(
+          std::begin(results),
+          std::end(results),
+          compare_results
+        );
+      }
+    };
+
+    results.reserve(limit);
+    for (const auto segment : segments)
+    {
+      std::vector<const SegmentTerm*> segment_terms;
+      std::vector<PostingIterator> iterators;
+      std::vector<double> weights;
+
+      iterators.reserve(terms.size());
+      for (const auto& term : terms)
+      {
+        if (const auto entry = segment->find_term(term))
+        {
+          segment_terms.push_back(entry);
+        } else {
+          break;
+        }
+      }
+      if (segment_terms.size() != terms.size())
+      {
+        continue;
+      }
+
+      // Intersection is driven by the rarest term.
+      std::sort(
+        std::begin(segment_terms),
+        std::end(segment_terms),
+        [](const SegmentTerm* a, const SegmentTerm* b)
+        {
+          return a->document_frequency < b->document_frequency;
+        }
+      );
+      for (const auto term : segment_terms)
+      {
+        const auto frequency = static_cast<double>(term->document_frequency);
+
+        iterators.emplace_back(*segment, *term);
+        weights.push_back(std::log(
+          1.0 + (document_count - frequency + 0.5) / (frequency + 0.5)
+        ));
+      }
+
+      while (iterators[0].is_valid())
+      {
+        auto target = iterators[0].get_document();
+        auto matched = true;
+        auto exhausted = false;
+
+        // Leapfrog intersection: each list is advanced to the current
+        // candidate, and the first list that overshoots it provides the
+        // next candidate.
+        for (std::size_t i = 1; i < iterators.size(); ++i)
+        {
+          if (!iterators[i].advance(target))
+          {
+            exhausted = true;
+            break;
+          }
+          else if (iterators[i].get_document() != target)
+          {
+            target = iterators[i].get_document();
+            matched = false;
+            break;
+          }
+        }
+        if (exhausted)
+        {
+          break;
+        }
+        else if (!matched)
+        {
+          iterators[0].advance(target);
+          continue;
+        }
+        score_document(*segment, target, iterators, weights);
+        iterators[0].next();
+      }
+    }
+    std::sort_heap(std::begin(results), std::end(results), compare_results);
+
+    return results;
+  }
+
+  void
+  TextIndex::flush()
+  {
+    std::unique_ptr<TextIndexSegment> segment;
+
+    if (m_buffer_documents.empty())
+    {
+      return;
+    }
+    segment = write_segment([this](TextIndexSegmentWriter& writer)
+    {
+      write_buffer(writer);
+    });
+    if (!segment)
+    {
+      return;
+    }
+    m_segments.push_back(std::move(segment));
+    m_buffer_documents.clear();
+    m_buffer_postings.clear();
+    m_buffer_size = 0;
+    merge_segments();
+    enforce_budget();
+  }
+
+  void
+  TextIndex::merge_segments()
+  {
+    while (m_segments.size() >= 2)
+    {
+      const auto count = m_segments.size();
+      const auto& previous = *m_segments[count - 2];
+      const auto& last = *m_segments[count - 1];
+      std::unique_ptr<TextIndexSegment> merged;
+
+      if (count <= MAX_SEGMENTS
+          && last.get_size() * MERGE_FACTOR < previous.get_size())
+      {
+        break;
+      }
+      if (!(merged = merge({ &previous, &last }, 0)))
+      {
+        break;
+      }
+      replace_segments(count - 2, 2, std::move(merged));
+    }
+  }
+
+  void
+  TextIndex::enforce_budget()
+  {
+    for (;;)
+    {
+      std::uint64_t total_size = 0;
+      std::uint32_t count;
+      std::unique_ptr<TextIndexSegment> replacement;
+
+      for (const auto& segment : m_segments)
+      {
+        total_size += segment->get_size();
+      }
+      if (total_size <= m_disk_budget || m_segments.empty())
+      {
+        return;
+      }
+
+      // Oldest pages are dropped by rewriting the oldest segment without
+      // them, or by deleting the segment if it is already small.
+      const auto& oldest = *m_segments.front();
+
+      count = oldest.get_document_count();
+      if (count >= BUDGET_DROP_DIVISOR)
+      {
+        replacement = merge(
+          { &oldest },
+          oldest.get_document(count / BUDGET_DROP_DIVISOR).id
+        );
+        if (replacement && replacement->get_size() >= oldest.get_size())
+        {
+          ::g_unlink(replacement->get_path().c_str());
+          replacement.reset();
+        }
+      }
+      if (!replacement)
+      {
+        forget_documents(oldest);
+      }
+      replace_segments(0, 1, std::move(replacement));
+    }
+  }
+
+  void
+  TextIndex::write_buffer(TextIndexSegmentWriter& writer) const
+  {
+    std::vector<const std::string*> terms;
+
+    for (const auto& document : m_buffer_documents)
+    {
+      writer.add_document(
+        document.id,
+        document.length,
+        document.uri,
+        document.title
+      );
+    }
+    terms.reserve(m_buffer_postings.size());
+    for (const auto& entry : m_buffer_postings)
+    {
+      terms.push_back(&entry.first);
+    }
+    std::sort(
+      std::begin(terms),
+      std::end(terms),
+      [](const std::string* a, const std::string* b)
+      {
+        return *a < *b;
+      }
+    );
+    for (const auto term : terms)
+    {
+      writer.begin_term(*term);
+      for (const auto& posting : m_buffer_postings.at(*term))
+      {
+        writer.add_posting(posting.document, posting.frequency);
+      }
+      writer.end_term();
+    }
+  }
+
+  std::unique_ptr<TextIndexSegment>
+  TextIndex::write_segment(
+    const std::function<void(TextIndexSegmentWriter&)>& callback
+  )
+  {
+    const auto name = ::g_strdup_printf(
+      "segment-%08x",
+      static_cast<unsigned int>(m_next_generation++)
+    );
+    const auto path_buffer = ::g_build_filename(
+      m_directory.c_str(),
+      name,
+      nullptr
+    );
+    const std::string path(path_buffer);
+    const auto temporary_path = path + ".tmp";
+    std::FILE* file;
+    bool success;
+
+    ::g_free(name);
+    ::g_free(path_buffer);
+    if (!(file = std::fopen(temporary_path.c_str(), "wb")))
+    {
+      ::g_warning("Unable to write index segment: %s", path.c_str());
+
+      return nullptr;
+    }
+    {
+      TextIndexSegmentWriter writer(file);
+
+      callback(writer);
+      success = writer.finish();
+    }
+    if (std::fclose(file) || !success
+        || std::rename(temporary_path.c_str(), path.c_str()))
+    {
+      ::g_warning("Unable to write index segment: %s", path.c_str());
+      ::g_unlink(temporary_path.c_str());
+
+      return nullptr;
+    }
+
+    return TextIndexSegment::open(path);
+  }
+
+  std::unique_ptr<TextIndexSegment>
+  TextIndex::merge(const std::vector<const TextIndexSegment*>& segments,
+                   std::uint32_t min_document)
+  {
+    const auto first = segments.front()->get_document(0).id;
+    const auto& last_segment = *segments.back();
+    const auto last = last_segment.get_document(
+      last_segment.get_document_count() - 1
+    ).id;
+    std::vector<bool> kept(last - first + 1, false);
+
+    for (const auto segment : segments)
+    {
+      const auto count = segment->get_document_count();
+
+      for (std::uint32_t i = 0; i < count; ++i)
+      {
+        const auto& document = segment->get_document(i);
+        const auto uri = segment->get_uri(document);
+
+        if (document.id < first || document.id > last)
+        {
+          continue;
+        }
+        else if (document.id >= min_document)
+        {
+          kept[document.id - first] = is_live(document.id, uri);
+        }
+        else if (is_live(document.id, uri))
+        {
+          m_latest.erase(uri);
+        }
+      }
+    }
+
+    return write_segment([&](TextIndexSegmentWriter& writer)
+    {
+      std::vector<std::uint32_t> cursors(segments.size(), 0);
+
+      for (const auto segment : segments)
+      {
+        const auto count = segment->get_document_count();
+
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+          const auto& document = segment->get_document(i);
+
+          if (document.id >= first
+              && document.id <= last
+              && kept[document.id - first])
+          {
+            writer.add_document(
+              document.id,
+              document.length,
+              segment->get_uri(document),
+              segment->get_title(document)
+            );
+          }
+        }
+      }
+
+      // Term dictionaries of the segments are merged in sorted order.
+      // Segments contain consecutive ranges of documents, so posting lists
+      // of each term can simply be concatenated.
+      for (;;)
+      {
+        std::string_view term;
+        bool found = false;
+
+        for (std::size_t i = 0; i < segments.size(); ++i)
+        {
+          if (cursors[i] < segments[i]->get_term_count())
+          {
+            const auto text = segments[i]->get_term_text(
+              segments[i]->get_term(cursors[i])
+            );
+
+            if (!found || text < term)
+            {
+              term = text;
+              found = true;
+            }
+          }
+        }
+        if (!found)
+        {
+          break;
+        }
+        writer.begin_term(std::string(term));
+        for (std::size_t i = 0; i < segments.size(); ++i)
+        {
+          const auto segment = segments[i];
+
+          if (cursors[i] >= segment->get_term_count()
+              || segment->get_term_text(segment->get_term(cursors[i])) != term)
+          {
+            continue;
+          }
+          const auto& entry = segment->get_term(cursors[i]++);
+
+          if (!segment->is_valid_term(entry))
+          {
+            continue;
+          }
+          for (PostingIterator it(*segment, entry); it.is_valid(); it.next())
+          {
+            const auto document = it.get_document();
+
+            if (document >= first
+                && document <= last
+                && kept[document - first])
+            {
+              writer.add_posting(document, it.get_frequency());
+            }
+          }
+        }
+        writer.end_term();
+      }
+    });
+  }
+
+  void
+  TextIndex::replace_segments(std::size_t index,
+                              std::size_t count,
+                              std::unique_ptr<TextIndexSegment>&& replacement)
+  {
+    std::vector<std::string> paths;
+    const auto begin = std::begin(m_segments) + index;
+
+    for (auto it = begin; it != begin + count; ++it)
+    {
+      paths.push_back((*it)->get_path());
+    }
+    m_segments.erase(begin, begin + count);
+    if (replacement)
+    {
+      if (replacement->get_document_count())
+      {
+        m_segments.insert(
+          std::begin(m_segments) + index,
+          std::move(replacement)
+        );
+      } else {
+        paths.push_back(replacement->get_path());
+      }
+    }
+    for (const auto& path : paths)
+    {
+      ::g_unlink(path.c_str());
+    }
+  }
+
+  void
+  TextIndex::forget_documents(const TextIndexSegment& segment)
+  {
+    const auto count = segment.get_document_count();
+
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+      const auto& document = segment.get_document(i);
+      const auto uri = segment.get_uri(document);
+
+      if (is_live(document.id, uri))
+      {
+        m_latest.erase(uri);
+      }
+    }
+  }
+
+  bool
+  TextIndex::is_live(std::uint32_t document, const std::string& uri) const
+  {
+    const auto it = m_latest.find(uri);
+
+    return it != std::end(m_latest) && it->second == document;
+  }
+}
@@ -42,6 +42,8 @@ namespace selain
     const Gdk::RGBA mode_bar_normal_foreground("#282828");
     const Gdk::RGBA mode_bar_insert_background("#d7d75f");
     const Gdk::RGBA mode_bar_insert_foreground("#262626");
+    const Gdk::RGBA tab_background("#303030");
+    const Gdk::RGBA tab_active_background("#4e4e4e");
 
     const Glib::RefPtr<Gtk::CssProvider>&
     get_status_bar_style_provider()
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2019, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <selain/trace.hpp>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#include <unistd.h>
+
+namespace selain
+{
+  namespace trace
+  {
+    namespace
+    {
+      struct Event
+      {
+        const char* name;
+        std::int64_t start;
+        std::int64_t duration;
+      };
+
+      /**
+       * Ring buffer of events recorded by a single thread. The mutex is
+       * only contended while the trace is being written.
+       */
+      struct Buffer
+      {
+        std::mutex mutex;
+        std::vector<Event> events;
+        /** Position of the oldest event once the buffer is full. */
+        std::size_t next;
+        unsigned int thread_id;
+        bool main_thread;
+      };
+    }
+
+    std::atomic<bool> enabled(false);
+
+    // Buffers are never freed, so events of threads which have exited can
+    // still be written.
+    static std::mutex buffers_mutex;
+    static std::vector<Buffer*> buffers;
+    static std::string exit_path;
+
+    static Buffer*
+    get_buffer()
+    {
+      static thread_local Buffer* buffer = nullptr;
+
+      if (!buffer)
+      {
+        std::lock_guard<std::mutex> guard(buffers_mutex);
+
+        buffer = new Buffer();
+        buffer->next = 0;
+        buffer->thread_id = static_cast<unsigned int>(buffers.size() + 1);
+        buffer->main_thread = ::g_main_context_is_owner(
+          ::g_main_context_default()
+        );
+        buffers.push_back(buffer);
+      }
+
+      return buffer;
+    }
+
+    void
+    start()
+    {
+      std::lock_guard<std::mutex> guard(buffers_mutex);
+
+      for (const auto buffer : buffers)
+      {
+        std::lock_guard<std::mutex> buffer_guard(buffer->mutex);
+
+        buffer->events.clear();
+        buffer->next = 0;
+      }
+      enabled.store(true, std::memory_order_relaxed);
+    }
+
+    void
+    stop()
+    {
+      enabled.store(false, std::memory_order_relaxed);
+    }
+
+    void
+    record(const char* name, std::int64_t start, std::int64_t duration)
+    {
+      const auto buffer = get_buffer();
+      std::lock_guard<std::mutex> guard(buffer->mutex);
+
+      if (buffer->events.size() < BUFFER_CAPACITY)
+      {
+        buffer->events.push_back({ name, start, duration });
+      } else {
+        buffer->events[buffer->next] = { name, start, duration };
+        buffer->next = (buffer->next + 1) % BUFFER_CAPACITY;
+      }
+    }
+
+    static void
+    append_string(std::string& output, const char* value)
+    {
+      output.append(1, '"');
+      for (auto c = value; *c; ++c)
+      {
+        if (*c == '"' || *c == '\\')
+        {
+          output.append(1, '\\');
+        }
+        output.append(1, *c);
+      }
+      output.append(1, '"');
+    }
+
+    bool
+    write(const std::string& path, std::string& error)
+    {
+      const auto pid = static_cast<long>(::getpid());
+      std::string output("{\"traceEvents\":[");
+      bool first = true;
+      char line[128];
+      ::GError* gerror = nullptr;
+
+      {
+        std::lock_guard<std::mutex> guard(buffers_mutex);
+
+        for (const auto buffer : buffers)
+        {
+          std::lock_guard<std::mutex> buffer_guard(buffer->mutex);
+          const auto size = buffer->events.size();
+
+          std::snprintf(
+            line,
+            sizeof(line),
+            "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,"
+            "\"tid\":%u,\"args\":{\"name\":",
+            first ? "" : ",",
+            pid,
+            buffer->thread_id
+          );
+          output.append(line);
+          output.append(
+            buffer->main_thread
+              ? "\"main\"}}"
+              : "\"thread " + std::to_string(buffer->thread_id) + "\"}}"
+          );
+          first = false;
+          for (std::size_t i = 0; i < size; ++i)
+          {
+            const auto& event = buffer->events[(buffer->next + i) % size];
+
+            output.append(",\n{\"name\":");
+            append_string(output, event.name);
+            std::snprintf(
+              line,
+              sizeof(line),
+              ",\"cat\":\"selain\",\"ph\":\"X\",\"ts\":%" PRId64
+              ",\"dur\":%" PRId64 ",\"pid\":%ld,\"tid\":%u}",
+              event.start,
+              event.duration,
+              pid,
+              buffer->thread_id
+            );
+            output.append(line);
+          }
+        }
+      }
+      output.append("\n],\"displayTimeUnit\":\"ms\"}\n");
+
+      if (!::g_file_set_contents(
+        path.c_str(),
+        output.c_str(),
+        static_cast<::gssize>(output.length()),
+        &gerror
+      ))
+      {
+        error = gerror->message;
+        ::g_error_free(gerror);
+
+        return false;
+      }
+
+      return true;
+    }
+
+    static void
+    on_exit()
+    {
+      std::string error;
+
+      stop();
+      if (!write(exit_path, error))
+      {
+        std::fprintf(
+          stderr,
+          "Unable to write trace to %s: %s\n",
+          exit_path.c_str(),
+          error.c_str()
+        );
+      }
+    }
+
+    void
+    write_on_exit(const std::string& path)
+    {
+      if (exit_path.empty())
+      {
+        std::atexit(on_exit);
+      }
+      exit_path = path;
+      start();
+    }
+  }
+}
@@ -25,6 +25,11 @@
  */
 #include <selain/utils.hpp>
 
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+
 namespace selain
 {
   namespace utils
@@ -42,5 +47,123 @@ namespace selain
 
       return font;
     }
+
+    std::string
+    get_data_file_path(const std::string& name)
+    {
+      const auto directory = ::g_build_filename(
+        ::g_get_user_data_dir(),
+        "selain",
+        nullptr
+      );
+      const auto path = ::g_build_filename(directory, name.c_str(), nullptr);
+      const std::string result(path);
+
+      ::g_mkdir_with_parents(directory, 0700);
+      ::g_free(directory);
+      ::g_free(path);
+
+      return result;
+    }
+
+    std::string
+    expand_path(const std::string& path)
+    {
+      if (path == "~" || !path.compare(0, 2, "~/"))
+      {
+        return ::g_get_home_dir() + path.substr(1);
+      }
+
+      return path;
+    }
+
+    bool
+    parse_size(const std::string& input, std::uint64_t& result)
+    {
+      const char* start = input.c_str();
+      char* end;
+      unsigned long long value;
+      std::uint64_t multiplier = 1;
+
+      if (!std::isdigit(*start))
+      {
+        return false;
+      }
+      value = std::strtoull(start, &end, 10);
+      switch (std::toupper(*end))
+      {
+        case 'G':
+          multiplier *= 1024;
+          // fallthrough
+
+        case 'M':
+          multiplier *= 1024;
+          // fallthrough
+
+        case 'K':
+          multiplier *= 1024;
+          ++end;
+          break;
+      }
+      if (*end == 'B' || *end == 'b')
+      {
+        ++end;
+      }
+      if (*end ||
+          value > std::numeric_limits<std::uint64_t>::max() / multiplier)
+      {
+        return false;
+      }
+      result = value * multiplier;
+
+      return true;
+    }
+
+    std::string
+    format_size(std::uint64_t size)
+    {
+      const auto formatted = ::g_format_size_full(
+        size,
+        G_FORMAT_SIZE_IEC_UNITS
+      );
+      const std::string result(formatted);
+
+      ::g_free(formatted);
+
+      return result;
+    }
+
+    Glib::ustring
+    js_quote(const Glib::ustring& input)
+    {
+      Glib::ustring result;
+      char buffer[7];
+
+      result.reserve(input.bytes() + 2);
+      result.append(1, '"');
+      for (const auto c : input)
+      {
+        if (c < 0x80 && (std::isalnum(static_cast<unsigned char>(c))
+            || c == ' '))
+        {
+          result.append(1, c);
+        }
+        else if (c > 0xffff)
+        {
+          const auto offset = c - 0x10000;
+
+          std::snprintf(buffer, 7, "\\u%04x", 0xd800 + (offset >> 10));
+          result.append(buffer);
+          std::snprintf(buffer, 7, "\\u%04x", 0xdc00 + (offset & 0x3ff));
+          result.append(buffer);
+        } else {
+          std::snprintf(buffer, 7, "\\u%04x", static_cast<unsigned int>(c));
+          result.append(buffer);
+        }
+      }
+      result.append(1, '"');
+
+      return result;
+    }
   }
 }
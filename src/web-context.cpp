@@ -29,6 +29,17 @@ namespace selain
 {
   static ::WebKitWebContext* create_web_context();
 
+  static const struct
+  {
+    const char* name;
+    ::WebKitCacheModel model;
+  } cache_model_list[] =
+  {
+    { "document-viewer", WEBKIT_CACHE_MODEL_DOCUMENT_VIEWER },
+    { "web-browser", WEBKIT_CACHE_MODEL_WEB_BROWSER },
+    { "document-browser", WEBKIT_CACHE_MODEL_DOCUMENT_BROWSER },
+  };
+
   Glib::RefPtr<WebContext>
   WebContext::create()
   {
@@ -37,14 +48,142 @@ namespace selain
 
   WebContext::WebContext()
     : m_context(create_web_context())
+    , m_disk_cache(new DiskCache(
+        ::webkit_web_context_get_website_data_manager(m_context)
+      ))
+    , m_content_filter(new ContentFilter())
+    , m_download_manager(new DownloadManager(m_context))
+    , m_disk_cache_quota(DEFAULT_DISK_CACHE_QUOTA)
+    , m_initialized(false)
   {
     initialize(G_OBJECT(m_context));
+
+    // Internal pages are registered as local, so that web pages cannot link
+    // to them.
+    ::webkit_web_context_register_uri_scheme(
+      m_context,
+      "selain",
+      on_internal_request,
+      static_cast<::gpointer>(this),
+      nullptr
+    );
+    ::webkit_security_manager_register_uri_scheme_as_local(
+      ::webkit_web_context_get_security_manager(m_context),
+      "selain"
+    );
+  }
+
+  void
+  WebContext::initialize_deferred()
+  {
+    m_initialized = true;
+    m_disk_cache->set_quota(m_disk_cache_quota);
+    m_content_filter->load();
   }
 
   ::WebKitWebView*
   WebContext::create_web_view()
   {
-    return WEBKIT_WEB_VIEW(::webkit_web_view_new_with_context(m_context));
+    const auto manager = ::webkit_user_content_manager_new();
+    const auto web_view = ::g_object_new(
+      WEBKIT_TYPE_WEB_VIEW,
+      "web-context",
+      m_context,
+      "user-content-manager",
+      manager,
+      nullptr
+    );
+
+    m_content_filter->install(manager);
+    ::g_object_unref(manager);
+
+    return WEBKIT_WEB_VIEW(web_view);
+  }
+
+  void
+  WebContext::set_lite(::WebKitWebView* web_view, bool lite)
+  {
+    m_content_filter->set_lite(
+      ::webkit_web_view_get_user_content_manager(web_view),
+      lite
+    );
+  }
+
+  void
+  WebContext::register_internal_page(const std::string& name,
+                                     const internal_page_handler_type& handler)
+  {
+    m_pages[name] = handler;
+  }
+
+  void
+  WebContext::on_internal_request(::WebKitURISchemeRequest* request,
+                                  ::gpointer data)
+  {
+    const auto& pages = static_cast<WebContext*>(data)->m_pages;
+    const InternalRequest internal_request(request);
+    const auto page = pages.find(internal_request.get_page());
+
+    if (page != std::end(pages))
+    {
+      page->second(internal_request);
+    } else {
+      internal_request.finish_error(
+        "No such page: " + internal_request.get_page()
+      );
+    }
+  }
+
+  ::WebKitCacheModel
+  WebContext::get_cache_model() const
+  {
+    return ::webkit_web_context_get_cache_model(m_context);
+  }
+
+  void
+  WebContext::set_cache_model(::WebKitCacheModel model)
+  {
+    ::webkit_web_context_set_cache_model(m_context, model);
+  }
+
+  bool
+  WebContext::parse_cache_model(const std::string& name,
+                                ::WebKitCacheModel& model)
+  {
+    for (const auto& entry : cache_model_list)
+    {
+      if (!name.compare(entry.name))
+      {
+        model = entry.model;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  const char*
+  WebContext::get_cache_model_name(::WebKitCacheModel model)
+  {
+    for (const auto& entry : cache_model_list)
+    {
+      if (entry.model == model)
+      {
+        return entry.name;
+      }
+    }
+
+    return "";
+  }
+
+  void
+  WebContext::set_disk_cache_quota(std::uint64_t quota)
+  {
+    m_disk_cache_quota = quota;
+    if (m_initialized)
+    {
+      m_disk_cache->set_quota(quota);
+    }
   }
 
   static inline void
@@ -147,6 +286,11 @@ namespace selain
       )
     );
 
+    ::webkit_web_context_set_cache_model(
+      context,
+      WEBKIT_CACHE_MODEL_WEB_BROWSER
+    );
+
     ::webkit_web_context_set_favicon_database_directory(
       context,
       favicon_cache_dir
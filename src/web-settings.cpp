@@ -26,32 +26,194 @@
 #include <selain/web-settings.hpp>
 #include <selain/version.hpp>
 
+#include <cstdlib>
+
 namespace selain
 {
-  Glib::RefPtr<WebSettings>
-  WebSettings::create()
+  // Properties which are disabled by the lite profile. Those missing from
+  // older versions of WebKit are skipped. Only scripts of the page itself
+  // are disabled, as hints, find and other features of the browser are
+  // implemented by running JavaScript in the page.
+  static const char* lite_property_list[] =
   {
-    return Glib::RefPtr<WebSettings>(new WebSettings());
-  }
+    "auto-load-images",
+    "enable-javascript-markup",
+    "enable-media",
+    "enable-mediasource",
+    "enable-webaudio",
+    "enable-webgl",
+  };
 
-  WebSettings::WebSettings()
-    : m_settings(::webkit_settings_new())
+  static bool
+  is_lite_property(const std::string& name)
   {
-    initialize(G_OBJECT(m_settings));
+    for (const auto property : lite_property_list)
+    {
+      if (!name.compare(property))
+      {
+        return true;
+      }
+    }
 
-    ::webkit_settings_set_enable_java(m_settings, false);
-    ::webkit_settings_set_enable_plugins(m_settings, false);
-    ::webkit_settings_set_enable_developer_extras(m_settings, true);
+    return false;
+  }
+
+  /**
+   * Sets the values which Selain uses instead of the defaults of WebKit.
+   * These are what an option is reset to when it's removed from the
+   * configuration.
+   */
+  static void
+  set_base_values(::WebKitSettings* settings)
+  {
+    ::webkit_settings_set_enable_java(settings, false);
+    ::webkit_settings_set_enable_plugins(settings, false);
+    ::webkit_settings_set_enable_developer_extras(settings, true);
     ::webkit_settings_set_user_agent_with_application_details(
-      m_settings,
+      settings,
       "Selain",
       SELAIN_VERSION
     );
   }
 
+  Glib::RefPtr<WebSettings>
+  WebSettings::create(SettingsProfile profile)
+  {
+    return Glib::RefPtr<WebSettings>(new WebSettings(profile));
+  }
+
+  WebSettings::WebSettings(SettingsProfile profile)
+    : m_profile(profile)
+    , m_settings(::webkit_settings_new())
+  {
+    initialize(G_OBJECT(m_settings));
+    set_base_values(m_settings);
+
+    if (m_profile == SettingsProfile::LITE)
+    {
+      for (const auto property : lite_property_list)
+      {
+        if (::g_object_class_find_property(
+          G_OBJECT_GET_CLASS(m_settings),
+          property
+        ))
+        {
+          ::g_object_set(G_OBJECT(m_settings), property, FALSE, nullptr);
+        }
+      }
+    }
+  }
+
   void
   WebSettings::install(::WebKitWebView* view)
   {
     ::webkit_web_view_set_settings(view, m_settings);
   }
+
+  /**
+   * Parses given string into a value of the type which the GValue has been
+   * initialized to. Booleans, unsigned integers, strings and enumerations
+   * are supported, which covers all of the writable WebKit settings.
+   */
+  static bool
+  parse_value(const std::string& input, ::GValue* value)
+  {
+    const auto type = G_VALUE_TYPE(value);
+
+    if (type == G_TYPE_BOOLEAN)
+    {
+      if (input == "true" || input == "false")
+      {
+        ::g_value_set_boolean(value, input == "true");
+        return true;
+      }
+    }
+    else if (type == G_TYPE_UINT)
+    {
+      char* end = nullptr;
+      const auto number = std::strtoul(input.c_str(), &end, 10);
+
+      if (end && !*end)
+      {
+        ::g_value_set_uint(value, static_cast<::guint>(number));
+        return true;
+      }
+    }
+    else if (type == G_TYPE_STRING)
+    {
+      ::g_value_set_string(value, input.c_str());
+      return true;
+    }
+    else if (G_TYPE_IS_ENUM(type))
+    {
+      const auto enum_class = static_cast<::GEnumClass*>(
+        ::g_type_class_ref(type)
+      );
+      const auto enum_value = ::g_enum_get_value_by_nick(
+        enum_class,
+        input.c_str()
+      );
+
+      if (enum_value)
+      {
+        ::g_value_set_enum(value, enum_value->value);
+      }
+      ::g_type_class_unref(enum_class);
+
+      return enum_value != nullptr;
+    }
+
+    return false;
+  }
+
+  bool
+  WebSettings::apply(const std::string& name, const std::string& value)
+  {
+    const auto pspec = ::g_object_class_find_property(
+      G_OBJECT_GET_CLASS(m_settings),
+      name.c_str()
+    );
+    ::GValue property_value = G_VALUE_INIT;
+    bool result = true;
+
+    if (!pspec
+        || !(pspec->flags & G_PARAM_WRITABLE)
+        || (pspec->flags & G_PARAM_CONSTRUCT_ONLY))
+    {
+      return false;
+    }
+    else if (m_profile == SettingsProfile::LITE && is_lite_property(name))
+    {
+      return true;
+    }
+    ::g_value_init(&property_value, pspec->value_type);
+    if (value.empty())
+    {
+      // Value is taken from fresh settings with the base values, as those
+      // of WebKit differ from them, and the default user agent depends on
+      // the version of WebKit.
+      const auto base_settings = ::webkit_settings_new();
+
+      set_base_values(base_settings);
+      ::g_object_get_property(
+        G_OBJECT(base_settings),
+        name.c_str(),
+        &property_value
+      );
+      ::g_object_unref(base_settings);
+    } else {
+      result = parse_value(value, &property_value);
+    }
+    if (result)
+    {
+      ::g_object_set_property(
+        G_OBJECT(m_settings),
+        name.c_str(),
+        &property_value
+      );
+    }
+    ::g_value_unset(&property_value);
+
+    return result;
+  }
 }